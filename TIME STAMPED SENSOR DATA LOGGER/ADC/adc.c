@@ -9,12 +9,23 @@ Features:
 - ADC pin configuration
 - ADC initialization
 - Reading ADC digital value and equivalent analog voltage
+- Interrupt driven conversions: start now, collect the
+  result later while the CPU does other work
+- Simultaneous conversion of one AD0 and one AD1 channel,
+  started together by the global start register (LPC2148)
+- Burst scan of a channel set on both blocks, for the sensor
+  table
 ------------------------------------------------------------*/
 
 #include <LPC21xx.h>      // LPC21xx register definitions
 #include "types.h"        // User-defined data types
 #include "delay.h"        // Delay routines
 #include "adc_defines.h"  // ADC control macros and definitions
+#include "adc.h"          // ADC prototypes
+#include "vic.h"          // Interrupt registration and ISR macros
+#include "clock.h"        // Current PCLK
+#include "ramcode.h"      // RAMFUNC, code placement
+#include "timer.h"        // Deadlines for bounded waits
 
 //------------------------------------------------------------
 // Lookup table for ADC channel pin selection
@@ -27,6 +38,21 @@ u32 adcChSel[4] = {
         AIN3_PIN_0_30    // ADC Channel 3 on P0.30
 };
 
+//------------------------------------------------------------
+// Result handed over by the conversion-complete interrupt
+//------------------------------------------------------------
+static volatile u32 adcResult;
+static volatile u32 adcDone;
+static u32 adcStartAt;         // Timer0 time of the last start
+static u32 adcIrqOn;
+static u32 adcLast;            // Last good result of Read_ADC
+
+//------------------------------------------------------------
+// AD1 powered (Init_ADC1), AD0 / AD1 pair of Init_ADC_Pair
+//------------------------------------------------------------
+static u32 ad1On, pairCh0, pairCh1;
+static u32 pairLast0, pairLast1;   // Last good results
+
 /*------------------------------------------------------------
 Function: Init_ADC
 Purpose :
@@ -56,7 +82,235 @@ void Init_ADC(u32 chNo)
         // - Enable ADC (PDN bit)
         // - Set ADC clock divider
         //----------------------------------------------------------
-        ADCR |= (1 << PDN_BIT) | (CLKDIV << CLKDIV_BITS);
+        ADCR |= (1 << PDN_BIT);
+        ADCSetPclk(ClockPclk());
+}
+
+/*------------------------------------------------------------
+Function: ADCSetPclk
+Purpose :
+Sets the ADC clock divider so the ADC clock is as close to
+ADCCLK as possible without exceeding it (divide by 5 at
+15 MHz PCLK, by 2 at 6 MHz). AD1 gets the same divider once
+Init_ADC1 has powered it.
+------------------------------------------------------------*/
+void ADCSetPclk(u32 pclk)
+{
+        u32 div = (pclk + ADCCLK - 1) / ADCCLK - 1;
+
+        ADCR = (ADCR & ~(CLKDIV_MASK << CLKDIV_BITS)) | (div << CLKDIV_BITS);
+        if (ad1On)
+                AD1CR = (AD1CR & ~(CLKDIV_MASK << CLKDIV_BITS)) | (div << CLKDIV_BITS);
+}
+
+/*------------------------------------------------------------
+Function: Init_ADC_Pair
+Purpose :
+Prepares simultaneous sampling of an AD0 channel (0-3) and
+an AD1 channel (AD1_CH6 on P0.21 or AD1_CH7 on P0.22). AD1
+is powered and clocked with the same divider as AD0, so both
+conversions take the same number of the same clocks.
+------------------------------------------------------------*/
+void Init_ADC_Pair(u32 ch0, u32 ch1)
+{
+        Init_ADC(ch0);
+        Init_ADC1(ch1);
+
+        pairCh0 = ch0;
+        pairCh1 = ch1;
+}
+
+/*------------------------------------------------------------
+Function: Init_ADC1
+Purpose :
+Powers AD1 with the same clock divider as AD0 and selects
+the analog function of AD1_CH6 (P0.21) or AD1_CH7 (P0.22).
+------------------------------------------------------------*/
+void Init_ADC1(u32 ch1)
+{
+        PCONP |= PCONP_PCAD1;
+        if (ch1 == AD1_CH6)
+                PINSEL1 = (PINSEL1 & ~AD1_6_MASK) | AD1_6_PIN_0_21;
+        else
+                PINSEL1 = (PINSEL1 & ~AD1_7_MASK) | AD1_7_PIN_0_22;
+
+        if (!ad1On)
+                AD1CR = 1 << PDN_BIT;
+        ad1On = 1;
+        ADCSetPclk(ClockPclk());
+}
+
+/*------------------------------------------------------------
+Function: Read_ADC_Scan
+Purpose :
+Converts a set of channels on AD0 and AD1 in one burst. Both
+blocks get their channel bits and are put in burst mode
+together through ADGSR; each then converts its channels in
+turn, so a scan of n channels costs about n conversion times
+of the larger set, not n separate start/wait cycles. Each
+result is taken from its own data register the first time
+its DONE flag is seen.
+
+As in Read_ADC_Pair, a conversion of Read_ADC_Start still
+running is let finish first and the AD0 interrupt is masked
+during the scan. Stopping the burst lets the conversion
+under way complete; its result is discarded and the global
+DONE flag cleared, so ADC_ISR does not see it.
+
+Return  : 1 -> every selected channel converted
+          0 -> timed out; unconverted channels keep their
+               value and the timeout is counted under WAIT_ADC
+------------------------------------------------------------*/
+u32 Read_ADC_Scan(u32 sel0, u32 sel1, u16 *val)
+{
+        u32 dl, d, n, left0 = sel0, left1 = sel1, ok = 1;
+
+        dl = DeadlineSet(ADC_TIMEOUT_US);
+        while (ADCR & ADC_START_MASK)
+                if (DeadlinePassed(dl))
+                {
+                        ok = 0;
+                        break;
+                }
+
+        if (ok)
+        {
+                if (adcIrqOn)
+                        VICDisable(VIC_SRC_AD0);
+
+                ADCR = (ADCR & ~(ADC_START_MASK | 0xFF)) | sel0;
+                if (sel1)
+                        AD1CR = (AD1CR & ~(ADC_START_MASK | 0xFF)) | sel1;
+
+                // Drop results left from earlier conversions
+                for (n = 0; n < 8; n++)
+                {
+                        if (sel0 & (1 << n))
+                                (void)AD0DRN(n);
+                        if (sel1 & (1 << n))
+                                (void)AD1DRN(n);
+                }
+
+                ADGSR = ADGSR_BURST;
+
+                dl = DeadlineSet(ADC_SCAN_TIMEOUT_US);
+                while (left0 | left1)
+                {
+                        for (n = 0; n < 8; n++)
+                        {
+                                if ((left0 & (1 << n)) && ((d = AD0DRN(n)) & ADC_DONE))
+                                {
+                                        val[n] = (d >> DIGITAL_DATA_BITS) & 1023;
+                                        left0 &= ~(1 << n);
+                                }
+                                if ((left1 & (1 << n)) && ((d = AD1DRN(n)) & ADC_DONE))
+                                {
+                                        val[ADC_SCAN_AD1 + n] = (d >> DIGITAL_DATA_BITS) & 1023;
+                                        left1 &= ~(1 << n);
+                                }
+                        }
+                        if (DeadlinePassed(dl))
+                        {
+                                ok = 0;
+                                break;
+                        }
+                }
+
+                //--------------------------------------------------
+                // Stop the burst, let the last conversion end and
+                // clear what it left behind
+                //--------------------------------------------------
+                ADGSR = 0;
+                delay_us(ADC_CONV_US);
+                ADCR &= ~0xFF;
+                if (sel1)
+                        AD1CR &= ~0xFF;
+                (void)ADDR;
+
+                if (adcIrqOn)
+                        VICEnable(VIC_SRC_AD0);
+        }
+
+        if (!ok)
+                WaitTimeout(WAIT_ADC);
+        return ok;
+}
+
+/*------------------------------------------------------------
+Function: Read_ADC_Pair
+Purpose :
+Converts the two channels of Init_ADC_Pair at one instant.
+Both blocks are armed with START = 0 and started together
+through ADGSR, so there is no skew between the two values
+and the pair costs one conversion time instead of two.
+
+A conversion of Read_ADC_Start still running is let finish
+first. The AD0 interrupt is masked meanwhile so ADC_ISR does
+not take the AD0 result; reading ADDR clears the request.
+
+Return  : 1 -> new results
+          0 -> timed out; the last good pair is returned and
+               the timeout is counted under WAIT_ADC
+------------------------------------------------------------*/
+u32 Read_ADC_Pair(u32 *val0, u32 *val1)
+{
+        u32 dl, d0 = 0, d1 = 0, ok = 1;
+
+        dl = DeadlineSet(ADC_TIMEOUT_US);
+        while (ADCR & ADC_START_MASK)
+                if (DeadlinePassed(dl))
+                {
+                        ok = 0;
+                        break;
+                }
+
+        if (ok)
+        {
+                if (adcIrqOn)
+                        VICDisable(VIC_SRC_AD0);
+
+                ADCR = (ADCR & ~(ADC_START_MASK | 0xFF)) | (1 << pairCh0);
+                AD1CR = (AD1CR & ~(ADC_START_MASK | 0xFF)) | (1 << pairCh1);
+                ADGSR = ADGSR_START_NOW;
+
+                //--------------------------------------------------
+                // Reading a data register clears its DONE flag, so
+                // each value is kept once its flag has been seen
+                //--------------------------------------------------
+                dl = DeadlineSet(ADC_TIMEOUT_US);
+                for (;;)
+                {
+                        if (!(d0 & ADC_DONE))
+                                d0 = ADDR;
+                        if (!(d1 & ADC_DONE))
+                                d1 = AD1GDR;
+                        if ((d0 & ADC_DONE) && (d1 & ADC_DONE))
+                                break;
+                        if (DeadlinePassed(dl))
+                        {
+                                ok = 0;
+                                break;
+                        }
+                }
+                ADGSR = 0;
+
+                if (ok)
+                {
+                        pairLast0 = (d0 >> DIGITAL_DATA_BITS) & 1023;
+                        pairLast1 = (d1 >> DIGITAL_DATA_BITS) & 1023;
+                }
+                else
+                        ADCR &= ~0xFF;   // Writing ADCR clears DONE
+
+                if (adcIrqOn)
+                        VICEnable(VIC_SRC_AD0);
+        }
+
+        if (!ok)
+                WaitTimeout(WAIT_ADC);
+        *val0 = pairLast0;
+        *val1 = pairLast1;
+        return ok;
 }
 
 /*------------------------------------------------------------
@@ -72,11 +326,36 @@ adcDVal  : Pointer to store raw digital ADC value
 Operation:
 - Select ADC channel
 - Start ADC conversion
-- Wait for conversion completion
+- Wait for conversion completion, at most ADC_TIMEOUT_US
 - Read digital output and compute analog voltage
+
+Return  : 1 -> new result
+          0 -> timed out; the last good result is returned and
+               the timeout is counted under WAIT_ADC
 ------------------------------------------------------------*/
-void Read_ADC(u32 chNo, f32 *eAR, u32 *adcDVal)
+CODE_ARM
+RAMFUNC u32 Read_ADC(u32 chNo, f32 *eAR, u32 *adcDVal)
 {
+        u32 dl, ok = 1;
+
+        //----------------------------------------------------------
+        // With the interrupt on, the ISR consumes DONE, so wait
+        // for its hand-over instead of polling ADDR
+        //----------------------------------------------------------
+        if (adcIrqOn)
+        {
+                Read_ADC_Start(chNo);
+                dl = DeadlineSet(ADC_TIMEOUT_US);
+                while (!Read_ADC_Done(&adcLast))
+                        if (DeadlinePassed(dl))
+                        {
+                                ADCR &= ~ADC_START_MASK;
+                                ok = 0;
+                                break;
+                        }
+                goto done;
+        }
+
         //----------------------------------------------------------
         // Clear any previously selected ADC channel
         //----------------------------------------------------------
@@ -95,7 +374,13 @@ void Read_ADC(u32 chNo, f32 *eAR, u32 *adcDVal)
         //----------------------------------------------------------
         // Wait until conversion is completed (DONE bit set)
         //----------------------------------------------------------
-        while (((ADDR >> DONE_BIT) & 1) == 0);
+        dl = DeadlineSet(ADC_TIMEOUT_US);
+        while (((ADDR >> DONE_BIT) & 1) == 0)
+                if (DeadlinePassed(dl))
+                {
+                        ok = 0;
+                        break;
+                }
 
         //----------------------------------------------------------
         // Stop ADC conversion
@@ -105,11 +390,96 @@ void Read_ADC(u32 chNo, f32 *eAR, u32 *adcDVal)
         //----------------------------------------------------------
         // Read 10-bit ADC digital data
         //----------------------------------------------------------
-        *adcDVal = ((ADDR >> DIGITAL_DATA_BITS) & 1023);
+        if (ok)
+                adcLast = ((ADDR >> DIGITAL_DATA_BITS) & 1023);
+
+done:
+        if (!ok)
+                WaitTimeout(WAIT_ADC);
+        *adcDVal = adcLast;
 
         //----------------------------------------------------------
         // Convert digital value to equivalent analog voltage
         // Assuming reference voltage = 3.3V
         //----------------------------------------------------------
         *eAR = *adcDVal * (3.3 / 1023);
+        return ok;
+}
+CODE_END
+
+/*------------------------------------------------------------
+Function: ADC_ISR
+Purpose :
+Conversion-complete interrupt. Reading ADDR clears DONE and
+the interrupt request; the result is stored for Read_ADC_Done.
+------------------------------------------------------------*/
+CODE_ARM
+RAMFUNC void ADC_ISR(void) __irq
+{
+        u32 val;
+
+        VIC_ISR_ENTER();
+        VIC_ISR_LATENCY(VIC_SRC_AD0, adcStartAt + ADC_CONV_US);
+
+        val = ADDR;
+        ADCR &= ~ADC_START_MASK;
+        adcResult = (val >> DIGITAL_DATA_BITS) & 1023;
+        adcDone = 1;
+
+        VIC_ISR_EXIT(VIC_SRC_AD0);
+}
+CODE_END
+
+/*------------------------------------------------------------
+Function: Init_ADC_Irq
+Purpose :
+Enables the conversion-complete interrupt at priority
+VIC_PRIO_ADC. Call after Init_ADC.
+------------------------------------------------------------*/
+void Init_ADC_Irq(void)
+{
+        adcDone = 0;
+        adcIrqOn = 1;
+
+#ifdef AD0INTEN
+        AD0INTEN = 1 << ADGINTEN_BIT;
+#endif
+
+        VICRegister(VIC_SRC_AD0, VIC_PRIO_ADC, (u32)ADC_ISR);
+}
+
+/*------------------------------------------------------------
+Function: Read_ADC_Start
+Purpose :
+Selects a channel and starts one conversion, then returns
+at once. The result is collected with Read_ADC_Done.
+------------------------------------------------------------*/
+CODE_ARM
+RAMFUNC void Read_ADC_Start(u32 chNo)
+{
+        adcDone = 0;
+        adcStartAt = T0TC;
+        ADCR = (ADCR & ~(ADC_START_MASK | 0xFF)) |
+               (1 << ADC_CONV_START_BIT) | (1 << chNo);
+}
+CODE_END
+
+/*------------------------------------------------------------
+Function: Read_ADC_Done
+Purpose :
+Checks whether the conversion started by Read_ADC_Start has
+finished.
+Return  : 1 -> *adcDVal holds the 10-bit result
+          0 -> still converting
+------------------------------------------------------------*/
+CODE_ARM
+RAMFUNC u32 Read_ADC_Done(u32 *adcDVal)
+{
+        if (!adcDone)
+                return 0;
+
+        *adcDVal = adcResult;
+        adcDone = 0;
+        return 1;
 }
+CODE_END
@@ -7,6 +7,9 @@ functions used with LPC21xx / LPC214x microcontrollers.
 This file provides:
 - ADC initialization
 - ADC channel reading function
+- Interrupt driven start/collect conversion functions
+- Simultaneous sampling of one AD0 and one AD1 channel
+- Burst scan of several AD0 and AD1 channels at once
 ------------------------------------------------------------*/
 
 #ifndef __ADC_H__
@@ -28,6 +31,13 @@ Input   : chNo - ADC channel number (e.g., 0 to 7 depending on MCU)
 ------------------------------------------------------------*/
 void Init_ADC(u32 chNo);
 
+/*------------------------------------------------------------
+Function: ADCSetPclk
+Purpose : Recomputes the ADC clock divider after a change of
+          peripheral clock (Hz)
+------------------------------------------------------------*/
+void ADCSetPclk(u32 pclk);
+
 /*------------------------------------------------------------
 Function: Read_ADC
 Purpose : Reads analog value from specified ADC channel
@@ -43,10 +53,122 @@ Inputs  :
           eAR     - Pointer to store equivalent analog result (float)
           adcDVal - Pointer to store raw ADC digital value (integer)
 
+Return  : 1 -> new result, 0 -> conversion timed out and
+          the last good result is returned
+
 Notes   :
           Digital value range depends on ADC resolution
           (e.g., 10-bit ADC ? 0 to 1023)
 ------------------------------------------------------------*/
-void Read_ADC(u32 chNo, f32 *eAR, u32 *adcDVal);
+u32 Read_ADC(u32 chNo, f32 *eAR, u32 *adcDVal);
+
+/*------------------------------------------------------------
+Function: Init_ADC1
+Purpose : Powers AD1 and makes one of its channels an analog
+          input (LPC2148 only)
+Input   : ch1 - AD1 channel (AD1_CH6 or AD1_CH7)
+------------------------------------------------------------*/
+void Init_ADC1(u32 ch1);
+
+/*------------------------------------------------------------
+Function: Read_ADC_Scan
+Purpose : Converts every selected channel of both blocks in
+          one burst, AD0 and AD1 started together
+Inputs  :
+          sel0 - AD0 channels (bit n -> channel n)
+          sel1 - AD1 channels
+Output  :
+          val  - ADC_SCAN_LEN raw 10-bit values: val[n] for
+                 AD0 channel n, val[ADC_SCAN_AD1 + n] for AD1;
+                 a channel not converted keeps its old value
+Return  : 1 -> all selected channels converted, 0 -> timed out
+------------------------------------------------------------*/
+u32 Read_ADC_Scan(u32 sel0, u32 sel1, u16 *val);
+
+/*------------------------------------------------------------
+Function: Init_ADC_Pair
+Purpose : Prepares simultaneous conversions of an AD0 and an
+          AD1 channel (LPC2148 only)
+Inputs  :
+          ch0 - AD0 channel (CH0 to CH3)
+          ch1 - AD1 channel (AD1_CH6 or AD1_CH7)
+------------------------------------------------------------*/
+void Init_ADC_Pair(u32 ch0, u32 ch1);
+
+/*------------------------------------------------------------
+Function: Read_ADC_Pair
+Purpose : Converts both channels of Init_ADC_Pair at the same
+          instant, started together by ADGSR
+Outputs :
+          val0 - raw 10-bit value of the AD0 channel
+          val1 - raw 10-bit value of the AD1 channel
+Return  : 1 -> new results, 0 -> timed out and the last good
+          pair is returned
+------------------------------------------------------------*/
+u32 Read_ADC_Pair(u32 *val0, u32 *val1);
+
+/*------------------------------------------------------------
+Function: Init_ADC_Irq
+Purpose : Enables the ADC conversion-complete interrupt
+          (AD0 at priority VIC_PRIO_ADC)
+Notes   : Call after Init_ADC. Read_ADC keeps working and
+          waits for the interrupt instead of polling ADDR.
+------------------------------------------------------------*/
+void Init_ADC_Irq(void);
+
+/*------------------------------------------------------------
+Function: Read_ADC_Start
+Purpose : Starts one conversion on a channel and returns
+          without waiting
+Input   : chNo - ADC channel number
+------------------------------------------------------------*/
+void Read_ADC_Start(u32 chNo);
+
+/*------------------------------------------------------------
+Function: Read_ADC_Done
+Purpose : Collects the result of Read_ADC_Start
+Output  : adcDVal - raw 10-bit ADC value
+Return  : 1 -> result stored, 0 -> conversion still running
+------------------------------------------------------------*/
+u32 Read_ADC_Done(u32 *adcDVal);
+
+#ifdef HOST_BUILD
+//------------------------------------------------------------
+// Virtual ADC counters (adc_sim.c)
+//------------------------------------------------------------
+typedef struct
+{
+        u32 started;    // Read_ADC_Start calls
+        u32 collected;  // Results taken by Read_ADC_Done
+        u32 polls;      // Read_ADC_Done calls while converting
+        u32 blockedUs;  // Time the caller spent waiting on the ADC
+        u32 hiddenUs;   // Conversion time spent doing other work
+        u32 runUs;      // Sum of start-to-collect times
+        u32 runMax;     // Longest start-to-collect time
+} ADCSimStats;
+
+extern ADCSimStats adcSimStats;
+
+//------------------------------------------------------------
+// Function: ADCSimInit
+// Purpose : Set the conversion time (us) and clear counters
+//------------------------------------------------------------
+void ADCSimInit(u32 convUs);
+
+//------------------------------------------------------------
+// Function: ADCSimSet
+// Purpose : Set the count every channel converts to
+//------------------------------------------------------------
+void ADCSimSet(u32 count);
+
+//------------------------------------------------------------
+// Function: ADCSimBusy / ADCSimWait
+// Purpose : 1 while a started conversion is not collected /
+//           advance the virtual Timer0 to its end, as a
+//           blocking read would wait
+//------------------------------------------------------------
+u32 ADCSimBusy(void);
+void ADCSimWait(void);
+#endif
 
 #endif
@@ -6,25 +6,24 @@ Contains macros and definitions for ADC configuration
 for LPC21xx microcontroller.
 
 This file defines:
-- System and peripheral clocks
+- ADC clock and conversion timing
 - ADC control register bit positions
 - ADC channel pin selection
 - ADC channel numbers
+- Second ADC block (AD1) and simultaneous start
+- Per-channel data registers for burst scans
 ------------------------------------------------------------*/
 
 //------------------------------------------------------------
-// System Clock and Peripheral Clock Definitions
+// ADC clock (divider is derived from the current PCLK)
 //------------------------------------------------------------
-#define FOSC 12000000          // External crystal frequency = 12 MHz
-#define CCLK (FOSC*5)          // CPU clock = FOSC * 5 (PLL multiplier)
-#define PCLK (CCLK/4)          // Peripheral clock = CCLK / 4
-#define ADCCLK 3000000         // Desired ADC clock frequency = 3 MHz
-#define CLKDIV ((PCLK/ADCCLK)-1)  // ADC clock divider (for ADCR register)
+#define ADCCLK 3000000         // Highest ADC clock frequency = 3 MHz
 
 //------------------------------------------------------------
 // ADCR (ADC Control Register) Bit Positions
 //------------------------------------------------------------
 #define CLKDIV_BITS        8   // Bits 815: Clock divider value
+#define CLKDIV_MASK        0xFF
 #define PDN_BIT            21  // Bit 21: ADC Power Down control (1 = ADC enabled)
 #define ADC_CONV_START_BIT 24  // Bit 24: Start conversion control
 
@@ -33,6 +32,19 @@ This file defines:
 //------------------------------------------------------------
 #define DIGITAL_DATA_BITS 6    // Bits 615: 10-bit ADC result
 #define DONE_BIT          31   // Bit 31: Conversion done flag
+#define ADC_DONE          (1u << DONE_BIT)
+
+//------------------------------------------------------------
+// ADC conversion-complete interrupt
+//------------------------------------------------------------
+#define ADGINTEN_BIT      8    // AD0INTEN bit 8: interrupt on global DONE
+#define ADC_START_MASK    (7 << ADC_CONV_START_BIT)  // START field
+
+// Conversion time: 11 ADC clocks, rounded up to whole us
+#define ADC_CONV_US       ((11*1000000 + ADCCLK - 1) / ADCCLK)
+
+// Longest wait for a conversion before it is given up
+#define ADC_TIMEOUT_US    100
 
 //------------------------------------------------------------
 // ADC Pin Selection (PINSEL1 configuration for AIN0AIN3)
@@ -51,6 +63,48 @@ This file defines:
 #define CH2 2
 #define CH3 3
 
+//------------------------------------------------------------
+// Second ADC block (LPC2148). LPC21xx.h only knows the one
+// converter of the older parts, so the AD1 registers and the
+// global start register are given here.
+//------------------------------------------------------------
+#ifndef ADGSR
+#define ADGSR   (*((volatile unsigned long *) 0xE0034008))
+#define AD1CR   (*((volatile unsigned long *) 0xE0060000))
+#define AD1GDR  (*((volatile unsigned long *) 0xE0060004))
+#endif
+
+#define ADGSR_START_NOW   (1 << ADC_CONV_START_BIT)  // Start AD0 and AD1
+#define ADGSR_BURST       (1 << 16)                  // Burst on AD0 and AD1
+#define PCONP_PCAD1       (1 << 20)                  // AD1 power
+
+//------------------------------------------------------------
+// Per-channel data registers (DONE is cleared by reading)
+//------------------------------------------------------------
+#ifndef AD0DRN
+#define AD0DRN(n)  (*((volatile unsigned long *) (0xE0034010 + 4 * (n))))
+#define AD1DRN(n)  (*((volatile unsigned long *) (0xE0060010 + 4 * (n))))
+#endif
+
+//------------------------------------------------------------
+// Burst scan: results of AD1 channels follow the eight AD0
+// ones; longest wait for a whole scan
+//------------------------------------------------------------
+#define ADC_SCAN_AD1      8
+#define ADC_SCAN_LEN      16
+#define ADC_SCAN_TIMEOUT_US (8 * ADC_TIMEOUT_US)
+
+//------------------------------------------------------------
+// AD1 channels on port 0 pins that are free on this board
+// (PINSEL1 value and field mask)
+//------------------------------------------------------------
+#define AD1_CH6           6    // P0.21
+#define AD1_CH7           7    // P0.22
+#define AD1_6_PIN_0_21    0x00000800
+#define AD1_6_MASK        0x00000C00
+#define AD1_7_PIN_0_22    0x00001000
+#define AD1_7_MASK        0x00003000
+
 //------------------------------------------------------------
 // Note:
 // Additional ADC channels and configurations can be added
@@ -0,0 +1,189 @@
+//adc_sim.c
+/*------------------------------------------------------------
+File: adc_sim.c
+Purpose:
+Virtual ADC for host builds (HOST_BUILD).
+
+Stands in for adc.c so the sampling pipeline can run on a PC
+against the virtual Timer0 of timer_sim.c: a conversion
+started with Read_ADC_Start completes ADCSimSetConv()
+microseconds later (ADCSimInit), as the conversion-complete
+interrupt would report it, and returns the count set with
+ADCSimSet().
+
+Features:
+- Start/collect conversions timed on Timer0
+- Blocking reads that advance the virtual clock by the
+  conversion time, like the polling wait they replace
+- Counters of the time from start to collect, i.e. how long
+  the conversion ran while the caller did something else
+
+NOTE:
+Every channel reads the same count.
+------------------------------------------------------------*/
+
+#ifdef HOST_BUILD
+
+#include "types.h"            // User-defined data types
+#include "adc.h"              // ADC prototypes
+#include "adc_defines.h"      // ADC_CONV_US, ADC_SCAN_AD1
+#include "timer.h"            // Timer0Now, TimerSimAdvance
+
+//------------------------------------------------------------
+// Counters
+//------------------------------------------------------------
+ADCSimStats adcSimStats;
+
+//------------------------------------------------------------
+// Input and conversion in progress
+//------------------------------------------------------------
+static u32 simCount;
+static u32 simConvUs = ADC_CONV_US;
+static u32 simBusy;
+static u32 simStartAt;
+static u32 simBlocked;        // Part of it spent in ADCSimWait
+
+//------------------------------------------------------------
+// Function: ADCSimInit
+// Purpose : Set the conversion time in microseconds, drop any
+//           conversion in progress and clear the counters
+//------------------------------------------------------------
+void ADCSimInit(u32 convUs)
+{
+        simConvUs = convUs;
+        simBusy = 0;
+        adcSimStats.started = adcSimStats.collected = 0;
+        adcSimStats.polls = adcSimStats.blockedUs = 0;
+        adcSimStats.hiddenUs = 0;
+        adcSimStats.runUs = adcSimStats.runMax = 0;
+}
+
+//------------------------------------------------------------
+// Function: ADCSimSet
+// Purpose : Count every channel converts to from now on
+//------------------------------------------------------------
+void ADCSimSet(u32 count)
+{
+        simCount = count & 0x3FF;
+}
+
+//------------------------------------------------------------
+// Function: ADCSimBusy
+// Purpose : 1 while a started conversion is not collected
+//------------------------------------------------------------
+u32 ADCSimBusy(void)
+{
+        return simBusy;
+}
+
+//------------------------------------------------------------
+// Function: ADCSimWait
+// Purpose : Advance the virtual clock to the end of the
+//           conversion in progress, counting it as blocked
+//------------------------------------------------------------
+void ADCSimWait(void)
+{
+        s32 left;
+
+        if (!simBusy)
+                return;
+        left = (s32)(simStartAt + simConvUs - Timer0Now());
+        if (left > 0)
+        {
+                TimerSimAdvance(left);
+                adcSimStats.blockedUs += left;
+                simBlocked += left;
+        }
+}
+
+void Init_ADC(u32 chNo)
+{
+        (void)chNo;
+}
+
+void ADCSetPclk(u32 pclk)
+{
+        (void)pclk;
+}
+
+void Init_ADC1(u32 ch1)
+{
+        (void)ch1;
+}
+
+void Init_ADC_Pair(u32 ch0, u32 ch1)
+{
+        (void)ch0;
+        (void)ch1;
+}
+
+void Init_ADC_Irq(void)
+{
+}
+
+u32 Read_ADC(u32 chNo, f32 *eAR, u32 *adcDVal)
+{
+        (void)chNo;
+        TimerSimAdvance(simConvUs);
+        adcSimStats.blockedUs += simConvUs;
+        *adcDVal = simCount;
+        *eAR = simCount * (3.3 / 1023);
+        return 1;
+}
+
+u32 Read_ADC_Pair(u32 *val0, u32 *val1)
+{
+        TimerSimAdvance(simConvUs);
+        adcSimStats.blockedUs += simConvUs;
+        *val0 = *val1 = simCount;
+        return 1;
+}
+
+u32 Read_ADC_Scan(u32 sel0, u32 sel1, u16 *val)
+{
+        u32 i;
+
+        for (i = 0; i < ADC_SCAN_AD1; i++)
+        {
+                if (sel0 & (1 << i))
+                        val[i] = simCount;
+                if (sel1 & (1 << i))
+                        val[ADC_SCAN_AD1 + i] = simCount;
+        }
+        return 1;
+}
+
+void Read_ADC_Start(u32 chNo)
+{
+        (void)chNo;
+        simBusy = 1;
+        simStartAt = Timer0Now();
+        simBlocked = 0;
+        adcSimStats.started++;
+}
+
+u32 Read_ADC_Done(u32 *adcDVal)
+{
+        u32 run;
+
+        if (!simBusy)
+                return 0;
+
+        run = Timer0Now() - simStartAt;
+        if (run < simConvUs)
+        {
+                adcSimStats.polls++;
+                return 0;
+        }
+
+        simBusy = 0;
+        *adcDVal = simCount;
+        adcSimStats.collected++;
+        adcSimStats.hiddenUs += simConvUs - simBlocked;
+        adcSimStats.runUs += run;
+        if (run > adcSimStats.runMax)
+                adcSimStats.runMax = run;
+        return 1;
+}
+
+#endif
@@ -0,0 +1,55 @@
+//blkdev.h
+/*------------------------------------------------------------
+File: blkdev.h
+Purpose:
+Block device interface used by the append log.
+
+A block device stores 512-byte sectors. Writes are started
+with write() and finish in the background; the log only
+starts a new write when busy() returns 0.
+
+Backends:
+- blkDevSpi  : SPI NOR flash on the SSP port (target)
+- blkDevFile : regular file (HOST_BUILD only)
+------------------------------------------------------------*/
+
+#ifndef __BLKDEV_H__
+#define __BLKDEV_H__
+
+#include "types.h"
+
+//------------------------------------------------------------
+// Block device operations
+//------------------------------------------------------------
+typedef struct
+{
+        u32 sectors;                                      // Size in sectors
+        void (*read)(u32 lba, u32 off, u8 *buf, u32 len); // Blocking read
+        u32  (*write)(u32 lba, const u8 *buf);            // Start write, 0 if busy
+        u32  (*busy)(void);                               // 1 while writing
+        void (*service)(void);                            // Advance background work
+} BlkDev;
+
+//------------------------------------------------------------
+// Available backends
+//------------------------------------------------------------
+#ifdef HOST_BUILD
+extern BlkDev blkDevFile;
+
+//------------------------------------------------------------
+// Function: BlkDevFileOpen
+// Purpose : Back blkDevFile with a file of the given size
+// Return  : 1 -> opened, 0 -> failed
+//------------------------------------------------------------
+u32 BlkDevFileOpen(const char *path, u32 sectors);
+#else
+extern BlkDev blkDevSpi;
+
+//------------------------------------------------------------
+// Function: InitBlkDevSpi
+// Purpose : Configure SSP pins/clock and the drain interrupt
+//------------------------------------------------------------
+void InitBlkDevSpi(void);
+#endif
+
+#endif
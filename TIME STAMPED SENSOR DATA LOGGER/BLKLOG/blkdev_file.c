@@ -0,0 +1,98 @@
+//blkdev_file.c
+/*------------------------------------------------------------
+File: blkdev_file.c
+Purpose:
+File-backed block device for host builds (HOST_BUILD).
+
+Lets the append log run unchanged on a PC so that write
+throughput and boot recovery time can be measured against
+a disk image instead of the SPI flash.
+
+NOTE:
+Writes complete synchronously, busy() is always 0. A fresh
+image is filled with 0xFF to look like erased flash.
+------------------------------------------------------------*/
+
+#ifdef HOST_BUILD
+
+#include <stdio.h>             // FILE, fopen, fread, fwrite
+#include <string.h>            // memset
+#include "types.h"             // User-defined data types
+#include "blkdev.h"            // Block device interface
+#include "blklog_defines.h"    // Sector size
+
+static FILE *imgFile;
+
+//------------------------------------------------------------
+// Function: FileRead
+// Purpose : Read part of a sector from the image
+//------------------------------------------------------------
+static void FileRead(u32 lba, u32 off, u8 *buf, u32 len)
+{
+        fseek(imgFile, (long)lba * BLK_SECTOR_SIZE + off, SEEK_SET);
+        if (fread(buf, 1, len, imgFile) != len)
+                memset(buf, 0xFF, len);
+}
+
+//------------------------------------------------------------
+// Function: FileWrite
+// Purpose : Write one whole sector to the image
+//------------------------------------------------------------
+static u32 FileWrite(u32 lba, const u8 *buf)
+{
+        fseek(imgFile, (long)lba * BLK_SECTOR_SIZE, SEEK_SET);
+        fwrite(buf, 1, BLK_SECTOR_SIZE, imgFile);
+        return 1;
+}
+
+static u32 FileBusy(void)
+{
+        return 0;
+}
+
+static void FileService(void)
+{
+        fflush(imgFile);
+}
+
+//------------------------------------------------------------
+// File-backed block device
+//------------------------------------------------------------
+BlkDev blkDevFile =
+{
+        0,
+        FileRead,
+        FileWrite,
+        FileBusy,
+        FileService
+};
+
+/*------------------------------------------------------------
+Function: BlkDevFileOpen
+Purpose :
+Opens an existing image, or creates an erased one of the
+requested size.
+------------------------------------------------------------*/
+u32 BlkDevFileOpen(const char *path, u32 sectors)
+{
+        u8 erased[BLK_SECTOR_SIZE];
+        u32 i;
+
+        imgFile = fopen(path, "r+b");
+        if (imgFile == NULL)
+        {
+                imgFile = fopen(path, "w+b");
+                if (imgFile == NULL)
+                        return 0;
+
+                memset(erased, 0xFF, sizeof(erased));
+                for (i = 0; i < sectors; i++)
+                        fwrite(erased, 1, sizeof(erased), imgFile);
+                fflush(imgFile);
+        }
+
+        blkDevFile.sectors = sectors;
+        return 1;
+}
+
+#endif
@@ -0,0 +1,302 @@
+//blkdev_spi.c
+/*------------------------------------------------------------
+File: blkdev_spi.c
+Purpose:
+SPI NOR flash block device on the LPC214x SSP (SPI1) port.
+
+Features:
+- 512-byte sector writes as two 256-byte page programs
+- 4 KB erase issued when a write enters a new erase block
+- Page data pumped through the SSP FIFO from its interrupt,
+  so the main loop never waits for the 260-byte transfer
+- Short status/enable commands done from BlkDev.service()
+
+NOTE:
+read() is blocking and intended for the boot recovery scan.
+------------------------------------------------------------*/
+
+#include <lpc214x.h>           // LPC214x register definitions
+#include "types.h"             // User-defined data types
+#include "blkdev.h"            // Block device interface
+#include "blklog_defines.h"    // SSP and flash definitions
+#include "vic.h"               // Interrupt registration and ISR macros
+#include "timer.h"             // Deadlines for bounded waits
+#include "ramcode.h"           // RAMFUNC, code placement
+
+//------------------------------------------------------------
+// Background write states
+//------------------------------------------------------------
+#define ST_IDLE        0       // No write in progress
+#define ST_ERASE_WAIT  1       // Erase issued, polling busy
+#define ST_PROG        2       // Page bytes being pumped by ISR
+#define ST_PROG_WAIT   3       // Page sent, polling busy
+
+static volatile u32 spiState = ST_IDLE;
+
+//------------------------------------------------------------
+// Current write
+//------------------------------------------------------------
+static const u8 *wrBuf;        // Sector being written
+static u32 wrAddr;             // Flash address of the sector
+static u32 wrPage;             // Page index within the sector
+
+//------------------------------------------------------------
+// ISR transfer: 4 command bytes followed by page data
+//------------------------------------------------------------
+static u8 xfHdr[4];
+static const u8 *xfData;
+static volatile u32 xfTx, xfRx, xfLen;
+
+//------------------------------------------------------------
+// Function: SspWait
+// Purpose : Wait until (SSPSR & mask) == want, at most
+//           SSP_TIMEOUT_US
+// Return  : 1 -> condition met, 0 -> timed out (counted)
+//------------------------------------------------------------
+static u32 SspWait(u32 mask, u32 want)
+{
+        u32 dl = DeadlineSet(SSP_TIMEOUT_US);
+
+        while ((SSPSR & mask) != want)
+                if (DeadlinePassed(dl))
+                {
+                        WaitTimeout(WAIT_SSP);
+                        return 0;
+                }
+        return 1;
+}
+
+//------------------------------------------------------------
+// Function: SpiByte
+// Purpose : Exchange one byte on SSP (polled)
+// Return  : Byte received, 0xFF when SSP is stuck (reads as
+//           a busy flash, so the write simply does not move on)
+//------------------------------------------------------------
+static u8 SpiByte(u8 b)
+{
+        if (!SspWait(SSP_SR_TNF, SSP_SR_TNF))
+                return 0xFF;
+        SSPDR = b;
+        if (!SspWait(SSP_SR_RNE, SSP_SR_RNE))
+                return 0xFF;
+        return SSPDR;
+}
+
+//------------------------------------------------------------
+// Function: FlashCmd
+// Purpose : Send a 1-byte command, optionally with address
+//------------------------------------------------------------
+static void FlashCmd(u8 cmd, u32 addr, u32 withAddr)
+{
+        IOCLR0 = 1 << FLASH_CS;
+        SpiByte(cmd);
+        if (withAddr)
+        {
+                SpiByte(addr >> 16);
+                SpiByte(addr >> 8);
+                SpiByte(addr);
+        }
+        IOSET0 = 1 << FLASH_CS;
+}
+
+//------------------------------------------------------------
+// Function: FlashBusy
+// Purpose : Read status register, return 1 while busy
+//------------------------------------------------------------
+static u32 FlashBusy(void)
+{
+        u8 sr;
+
+        IOCLR0 = 1 << FLASH_CS;
+        SpiByte(FLASH_CMD_RDSR);
+        sr = SpiByte(0);
+        IOSET0 = 1 << FLASH_CS;
+
+        return (sr & FLASH_SR_BUSY);
+}
+
+//------------------------------------------------------------
+// Function: StartPage
+// Purpose : Enable writes and hand one page to the ISR
+//------------------------------------------------------------
+static void StartPage(void)
+{
+        u32 a = wrAddr + (wrPage * FLASH_PAGE_SIZE);
+
+        FlashCmd(FLASH_CMD_WREN, 0, 0);
+
+        xfHdr[0] = FLASH_CMD_PP;
+        xfHdr[1] = a >> 16;
+        xfHdr[2] = a >> 8;
+        xfHdr[3] = a;
+        xfData = wrBuf + (wrPage * FLASH_PAGE_SIZE);
+        xfTx = xfRx = 0;
+        xfLen = 4 + FLASH_PAGE_SIZE;
+
+        spiState = ST_PROG;
+        IOCLR0 = 1 << FLASH_CS;
+
+        // TX half-empty starts the pump at once
+        SSPIMSC = SSP_IM_TX | SSP_IM_RX | SSP_IM_RT;
+}
+
+/*------------------------------------------------------------
+Function: SSP_ISR
+Purpose :
+Drains received bytes and refills the TX FIFO, keeping at
+most SSP_FIFO_DEPTH bytes in flight so RX cannot overrun.
+Ends the page transfer once every byte has been clocked.
+------------------------------------------------------------*/
+CODE_ARM
+RAMFUNC void SSP_ISR(void) __irq
+{
+        VIC_ISR_ENTER();
+
+        while (SSPSR & SSP_SR_RNE)
+        {
+                (void)SSPDR;
+                xfRx++;
+        }
+
+        while ((SSPSR & SSP_SR_TNF) && xfTx < xfLen &&
+               (xfTx - xfRx) < SSP_FIFO_DEPTH)
+        {
+                SSPDR = (xfTx < 4) ? xfHdr[xfTx] : xfData[xfTx - 4];
+                xfTx++;
+        }
+
+        //----------------------------------------------------------
+        // Stop TX interrupts once everything is queued, otherwise
+        // the empty FIFO keeps the request asserted
+        //----------------------------------------------------------
+        if (xfTx == xfLen)
+                SSPIMSC = SSP_IM_RX | SSP_IM_RT;
+
+        if (xfRx == xfLen)
+        {
+                SspWait(SSP_SR_BSY, 0);
+                IOSET0 = 1 << FLASH_CS;
+                SSPIMSC = 0;
+                spiState = ST_PROG_WAIT;
+        }
+
+        SSPICR = SSP_ICR_RT;
+        VIC_ISR_EXIT(VIC_SRC_SSP);
+}
+CODE_END
+
+//------------------------------------------------------------
+// Function: SpiService
+// Purpose : Move a write on once the flash is no longer busy
+//------------------------------------------------------------
+static void SpiService(void)
+{
+        if (spiState == ST_ERASE_WAIT && !FlashBusy())
+        {
+                wrPage = 0;
+                StartPage();
+        }
+        else if (spiState == ST_PROG_WAIT && !FlashBusy())
+        {
+                if (++wrPage < (BLK_SECTOR_SIZE / FLASH_PAGE_SIZE))
+                        StartPage();
+                else
+                        spiState = ST_IDLE;
+        }
+}
+
+//------------------------------------------------------------
+// Function: SpiBusy
+// Purpose : Report whether a sector write is in progress
+//------------------------------------------------------------
+static u32 SpiBusy(void)
+{
+        return (spiState != ST_IDLE);
+}
+
+//------------------------------------------------------------
+// Function: SpiWrite
+// Purpose : Start writing one sector; erase first when the
+//           sector opens a new erase block
+//------------------------------------------------------------
+static u32 SpiWrite(u32 lba, const u8 *buf)
+{
+        if (spiState != ST_IDLE)
+                return 0;
+
+        wrBuf  = buf;
+        wrAddr = lba * BLK_SECTOR_SIZE;
+        wrPage = 0;
+
+        if ((wrAddr % FLASH_ERASE_SIZE) == 0)
+        {
+                FlashCmd(FLASH_CMD_WREN, 0, 0);
+                FlashCmd(FLASH_CMD_SE, wrAddr, 1);
+                spiState = ST_ERASE_WAIT;
+        }
+        else
+                StartPage();
+
+        return 1;
+}
+
+//------------------------------------------------------------
+// Function: SpiRead
+// Purpose : Blocking read of part of a sector
+//------------------------------------------------------------
+static void SpiRead(u32 lba, u32 off, u8 *buf, u32 len)
+{
+        u32 a = (lba * BLK_SECTOR_SIZE) + off;
+
+        while (spiState != ST_IDLE)
+                SpiService();
+
+        IOCLR0 = 1 << FLASH_CS;
+        SpiByte(FLASH_CMD_READ);
+        SpiByte(a >> 16);
+        SpiByte(a >> 8);
+        SpiByte(a);
+        while (len--)
+                *buf++ = SpiByte(0);
+        IOSET0 = 1 << FLASH_CS;
+}
+
+//------------------------------------------------------------
+// SPI flash block device
+//------------------------------------------------------------
+BlkDev blkDevSpi =
+{
+        FLASH_SIZE / BLK_SECTOR_SIZE,
+        SpiRead,
+        SpiWrite,
+        SpiBusy,
+        SpiService
+};
+
+/*------------------------------------------------------------
+Function: InitBlkDevSpi
+Purpose :
+Configures SSP pins, clock and the vectored drain interrupt.
+------------------------------------------------------------*/
+void InitBlkDevSpi(void)
+{
+        //----------------------------------------------------------
+        // SCK1/MISO1/MOSI1 on P0.17P0.19, CS as GPIO output
+        //----------------------------------------------------------
+        PINSEL1 = (PINSEL1 & ~SSP_PINSEL1_MASK) | SSP_PINSEL1_VAL;
+        IODIR0 |= 1 << FLASH_CS;
+        IOSET0 = 1 << FLASH_CS;
+
+        //----------------------------------------------------------
+        // 8-bit SPI mode 0, master, 7.5 MHz
+        //----------------------------------------------------------
+        SSPCR0  = SSP_CR0_8BIT;
+        SSPCPSR = SSP_CPSR;
+        SSPIMSC = 0;
+        SSPCR1  = SSP_CR1_SSE;
+
+        //----------------------------------------------------------
+        // Route the SSP interrupt to its vectored slot
+        //----------------------------------------------------------
+        VICRegister(VIC_SRC_SSP, VIC_PRIO_SSP, (u32)SSP_ISR);
+}
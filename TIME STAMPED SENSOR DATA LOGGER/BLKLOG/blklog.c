@@ -0,0 +1,261 @@
+//blklog.c
+/*------------------------------------------------------------
+File: blklog.c
+Purpose:
+Implements a FAT-free append log on a block device.
+
+Sector layout (little-endian):
+- bytes 03   : BLK_MAGIC
+- bytes 47   : sector sequence number
+- bytes 89   : number of records in the sector
+- bytes 1011 : CRC-16 of bytes 09 and the records
+- bytes 1215 : reserved (0)
+- bytes 16..  : up to BLK_RECS_PER_SEC LogRec records
+
+The device is used as a ring. Sequence numbers increase by
+one per sector, so after a reset the write position is the
+end of the run of sectors whose sequence equals that of
+sector 0 plus their index.
+
+Records are collected in one of two sector buffers while
+the other is written by the device in the background. A
+sector is sealed as soon as its last record is in (or, if
+the other buffer is still busy, as soon as that is free).
+A sector that is still partly filled BLK_SEAL_S seconds
+after its first record is sealed and written as it is, so a
+power loss costs at most that much of a slow log; the age
+is counted on the RTC second interrupt.
+------------------------------------------------------------*/
+
+#include <string.h>            // memcpy, memset
+#include "types.h"             // User-defined data types
+#include "crc.h"               // Crc16Update
+#include "blkdev.h"            // Block device interface
+#include "blklog.h"            // Log prototypes and record type
+#include "blklog_defines.h"    // Layout constants
+#include "rtc.h"               // RTCSecondCount
+
+#define NO_BUF 2               // Buffer index meaning "none"
+
+//------------------------------------------------------------
+// Counters and position
+//------------------------------------------------------------
+BlkLogStats blkLogStats;
+
+//------------------------------------------------------------
+// Double buffer (u32 for word alignment)
+//------------------------------------------------------------
+static u32 secBuf[2][BLK_SECTOR_SIZE / 4];
+static u32 active;             // Buffer being filled
+static u32 fill;               // Records in the active buffer
+static u32 openEdge;           // RTC second count at its first record
+static u32 sealed;             // Buffer waiting to be written
+static u32 sealedLba;          // Where the sealed buffer goes
+static u32 writing;            // Buffer owned by the device
+static BlkDev *logDev;
+
+//------------------------------------------------------------
+// Little-endian field helpers
+//------------------------------------------------------------
+static void Put32(u8 *p, u32 v)
+{
+        p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static u32 Get32(const u8 *p)
+{
+        return p[0] | (p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+//------------------------------------------------------------
+// Function: SectorCrc
+// Purpose : CRC over header bytes 09 and the records
+//------------------------------------------------------------
+static u16 SectorCrc(const u8 *s, u32 count)
+{
+        u16 crc = CRC16_INIT;
+        u32 i;
+
+        for (i = 0; i < 10; i++)
+                crc = Crc16Update(crc, s[i]);
+        for (i = 0; i < count * BLK_REC_SIZE; i++)
+                crc = Crc16Update(crc, s[BLK_HDR_SIZE + i]);
+
+        return crc;
+}
+
+//------------------------------------------------------------
+// Function: SectorValid
+// Purpose : Read a sector and check magic, count and CRC
+// Return  : 1 -> valid (sequence stored in *seq), 0 -> not
+//------------------------------------------------------------
+static u32 SectorValid(u32 lba, u32 *seq)
+{
+        u8 *s = (u8 *)secBuf[1];
+        u32 count;
+
+        blkLogStats.scanReads++;
+        logDev->read(lba, 0, s, BLK_SECTOR_SIZE);
+
+        count = s[8] | (s[9] << 8);
+        if (Get32(s) != BLK_MAGIC || count > BLK_RECS_PER_SEC)
+                return 0;
+        if (SectorCrc(s, count) != (u16)(s[10] | (s[11] << 8)))
+                return 0;
+
+        *seq = Get32(s + 4);
+        return 1;
+}
+
+/*------------------------------------------------------------
+Function: InitBlkLog
+Purpose :
+Recovers the write position after reset.
+
+- Sector 0 invalid: either an empty device, or the ring just
+  wrapped and erased block 0; the last sector tells which
+- Otherwise binary search for the last sector whose sequence
+  is seq(0) + index; everything after it is erased, torn or
+  from the previous lap
+------------------------------------------------------------*/
+void InitBlkLog(BlkDev *dev)
+{
+        u32 s0, s, lo, hi, mid;
+
+        logDev = dev;
+        active = 0;
+        fill = 0;
+        sealed = NO_BUF;
+        writing = NO_BUF;
+        blkLogStats.written = blkLogStats.dropped = 0;
+        blkLogStats.scanReads = 0;
+
+        if (!SectorValid(0, &s0))
+        {
+                blkLogStats.head = 0;
+                blkLogStats.seq = SectorValid(dev->sectors - 1, &s) ? s + 1 : 0;
+                return;
+        }
+
+        lo = 0;
+        hi = dev->sectors;
+        while (hi - lo > 1)
+        {
+                mid = lo + ((hi - lo) / 2);
+                if (SectorValid(mid, &s) && s == s0 + mid)
+                        lo = mid;
+                else
+                        hi = mid;
+        }
+
+        blkLogStats.head = (lo + 1) % dev->sectors;
+        blkLogStats.seq = s0 + lo + 1;
+}
+
+//------------------------------------------------------------
+// Function: Seal
+// Purpose : Finish the header of the active buffer, queue it
+//           for writing and switch to the other buffer
+//------------------------------------------------------------
+static void Seal(void)
+{
+        u8 *s = (u8 *)secBuf[active];
+        u16 crc;
+
+        Put32(s, BLK_MAGIC);
+        Put32(s + 4, blkLogStats.seq);
+        s[8] = fill;
+        s[9] = fill >> 8;
+        Put32(s + 12, 0);
+        crc = SectorCrc(s, fill);
+        s[10] = crc;
+        s[11] = crc >> 8;
+
+        sealed = active;
+        sealedLba = blkLogStats.head;
+        blkLogStats.head = (blkLogStats.head + 1) % logDev->sectors;
+        blkLogStats.seq++;
+
+        active ^= 1;
+        fill = 0;
+}
+
+/*------------------------------------------------------------
+Function: BlkLogAppend
+Purpose :
+Stores one record and seals the sector it fills. A sector
+that could not be sealed then (the other buffer still queued
+or being written) is sealed before the next record; if that
+is still not possible the record is dropped and counted.
+------------------------------------------------------------*/
+u32 BlkLogAppend(const LogRec *rec)
+{
+        if (fill == BLK_RECS_PER_SEC)
+        {
+                if (sealed != NO_BUF || writing == (active ^ 1))
+                {
+                        blkLogStats.dropped++;
+                        return 0;
+                }
+                Seal();
+        }
+
+        if (fill == 0)
+        {
+                memset(secBuf[active], 0xFF, BLK_SECTOR_SIZE);
+                openEdge = RTCSecondCount();
+        }
+
+        memcpy((u8 *)secBuf[active] + BLK_HDR_SIZE + (fill * BLK_REC_SIZE),
+               rec, BLK_REC_SIZE);
+        fill++;
+
+        if (fill == BLK_RECS_PER_SEC)
+                BlkLogFlush();
+
+        return 1;
+}
+
+/*------------------------------------------------------------
+Function: BlkLogFlush
+Purpose :
+Seals the active sector early (e.g. before a planned power
+off). The rest of that sector stays unused.
+------------------------------------------------------------*/
+void BlkLogFlush(void)
+{
+        if (fill != 0 && sealed == NO_BUF && writing != (active ^ 1))
+                Seal();
+}
+
+/*------------------------------------------------------------
+Function: BlkLogService
+Purpose :
+Lets the device make progress, releases the buffer of a
+finished write and starts the sealed one. The active sector
+is sealed once the other buffer is free if it is full, or
+once it has been open for BLK_SEAL_S.
+------------------------------------------------------------*/
+void BlkLogService(void)
+{
+        logDev->service();
+
+        if (writing != NO_BUF && !logDev->busy())
+        {
+                writing = NO_BUF;
+                blkLogStats.written++;
+        }
+
+        if (fill == BLK_RECS_PER_SEC ||
+            (fill != 0 && RTCSecondCount() - openEdge >= BLK_SEAL_S))
+                BlkLogFlush();
+
+        if (writing == NO_BUF && sealed != NO_BUF)
+        {
+                if (logDev->write(sealedLba, (u8 *)secBuf[sealed]))
+                {
+                        writing = sealed;
+                        sealed = NO_BUF;
+                }
+        }
+}
@@ -0,0 +1,83 @@
+//blklog.h
+/*------------------------------------------------------------
+File: blklog.h
+Purpose:
+Header file for the FAT-free append log on a block device.
+
+This file provides:
+- Fixed 16-byte log record
+- Double-buffered, sector-aligned appends
+- Boot-time recovery of the write position
+------------------------------------------------------------*/
+
+#ifndef __BLKLOG_H__
+#define __BLKLOG_H__
+
+#include "types.h"
+#include "blkdev.h"
+#include "blklog_defines.h"
+
+//------------------------------------------------------------
+// One log record (BLK_REC_SIZE bytes, no padding)
+// Temperatures are in tenths of a degree Celsius
+//------------------------------------------------------------
+typedef struct
+{
+        u32 time;      // Seconds since 01/01/2000
+        u8  type;      // BLK_REC_MINUTE / BLK_REC_ALERT
+        u8  ch;        // ADC channel
+        u16 n;         // Raw samples behind the record
+        s16 mean;      // Mean value
+        s16 min;       // Lowest value
+        s16 max;       // Highest value
+        u16 ms;        // Milliseconds within time (0 in old logs)
+} LogRec;
+
+//------------------------------------------------------------
+// Log state and counters
+//------------------------------------------------------------
+typedef struct
+{
+        u32 head;      // Next sector to be written
+        u32 seq;       // Sequence number of the next sector
+        u32 written;   // Sectors written since boot
+        u32 dropped;   // Records lost because both buffers were full
+        u32 scanReads; // Sectors read by the recovery scan
+} BlkLogStats;
+
+extern BlkLogStats blkLogStats;
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: InitBlkLog
+// Purpose : Attach the log to a device and find the newest
+//           valid sector (binary search, O(log sectors))
+//------------------------------------------------------------
+void InitBlkLog(BlkDev *dev);
+
+//------------------------------------------------------------
+// Function: BlkLogAppend
+// Purpose : Copy one record into the active sector buffer
+// Return  : 1 -> stored, 0 -> dropped (device too slow)
+//------------------------------------------------------------
+u32 BlkLogAppend(const LogRec *rec);
+
+//------------------------------------------------------------
+// Function: BlkLogFlush
+// Purpose : Seal a partly filled sector so it gets written
+//------------------------------------------------------------
+void BlkLogFlush(void);
+
+//------------------------------------------------------------
+// Function: BlkLogService
+// Purpose : Start the next sector write when the device is
+//           free, and seal a full sector that is waiting for
+//           a buffer or one open for BLK_SEAL_S; call from the
+//           main loop
+//------------------------------------------------------------
+void BlkLogService(void);
+
+#endif
@@ -0,0 +1,85 @@
+//blklog_defines.h
+/*------------------------------------------------------------
+File: blklog_defines.h
+Purpose:
+Contains macros for the block-device append log and its
+SPI flash backend on LPC214x.
+
+This file defines:
+- On-media sector and record layout
+- Time limit for a partly filled sector
+- SSP (SPI1) pin, clock and interrupt settings
+- SPI NOR flash commands and geometry
+------------------------------------------------------------*/
+
+#ifndef BLKLOG_DEFINES_H
+#define BLKLOG_DEFINES_H
+
+//------------------------------------------------------------
+// Log layout
+// Every 512-byte sector = 16-byte header + 31 records of 16
+// bytes. Sectors are written whole, so the layout is the same
+// on SD cards and on NOR flash.
+//------------------------------------------------------------
+#define BLK_SECTOR_SIZE   512
+#define BLK_HDR_SIZE      16
+#define BLK_REC_SIZE      16
+#define BLK_RECS_PER_SEC  ((BLK_SECTOR_SIZE-BLK_HDR_SIZE)/BLK_REC_SIZE)
+#define BLK_MAGIC         0x474C5354UL   // "TSLG" little-endian
+
+//------------------------------------------------------------
+// Longest time a partly filled sector is kept in RAM before
+// it is written anyway (seconds). Minute records alone fill
+// a sector in 31 minutes; sealing early bounds the loss at a
+// power failure at the cost of unused sector space.
+//------------------------------------------------------------
+#define BLK_SEAL_S        600
+
+//------------------------------------------------------------
+// Record types
+//------------------------------------------------------------
+#define BLK_REC_MINUTE    1     // Per-minute aggregate
+#define BLK_REC_ALERT     2     // Per-second over-temperature
+
+//------------------------------------------------------------
+// SSP (SPI1) pins: P0.17 SCK1, P0.18 MISO1, P0.19 MOSI1,
+// P0.20 used as GPIO chip select
+// NOTE: P0.17/P0.18 are the buzzer and EDIT switch on the
+// base board. The log is only built with SPI_FLASH_LOG,
+// which must be defined only on hardware where both have
+// been moved off those pins.
+//------------------------------------------------------------
+#define SSP_PINSEL1_MASK  0x000000FC   // P0.17P0.19 function bits
+#define SSP_PINSEL1_VAL   0x000000A8   // 10b = SSP on each pin
+#define FLASH_CS          20           // P0.20
+
+//------------------------------------------------------------
+// SSP registers
+//------------------------------------------------------------
+#define SSP_CR0_8BIT      0x07         // 8-bit, SPI frame, mode 0
+#define SSP_CR1_SSE       (1<<1)       // SSP enable (master)
+#define SSP_CPSR          2            // 15 MHz / 2 = 7.5 MHz
+#define SSP_SR_TNF        (1<<1)       // TX FIFO not full
+#define SSP_SR_RNE        (1<<2)       // RX FIFO not empty
+#define SSP_SR_BSY        (1<<4)       // SSP busy
+#define SSP_IM_RT         (1<<1)       // RX timeout interrupt
+#define SSP_IM_RX         (1<<2)       // RX FIFO half full
+#define SSP_IM_TX         (1<<3)       // TX FIFO half empty
+#define SSP_ICR_RT        (1<<1)       // Clear RX timeout
+#define SSP_FIFO_DEPTH    8
+#define SSP_TIMEOUT_US    100          // Longest wait on an SSP flag
+
+//------------------------------------------------------------
+// SPI NOR flash (W25Qxx / AT25 compatible)
+//------------------------------------------------------------
+#define FLASH_CMD_WREN    0x06
+#define FLASH_CMD_RDSR    0x05
+#define FLASH_CMD_READ    0x03
+#define FLASH_CMD_PP      0x02         // Page program
+#define FLASH_CMD_SE      0x20         // 4 KB sector erase
+#define FLASH_SR_BUSY     0x01
+#define FLASH_PAGE_SIZE   256
+#define FLASH_ERASE_SIZE  4096
+#define FLASH_SIZE        (4UL*1024*1024)  // 32 Mbit part
+
+#endif
@@ -0,0 +1,139 @@
+//bus.c
+/*------------------------------------------------------------
+File: bus.c
+Purpose:
+Implements the sample bus: fan-out of published samples to
+the attached sinks.
+
+Features:
+- A sample is copied once per subscribed sink into that
+  sink's BUS_DEPTH ring; nothing is formatted or read again
+- Rate limit per sink on the sample time stamp
+- Full ring: drop the oldest (keepNewest) or the new sample
+- Delivery from the main loop with a fixed budget per sink,
+  in publish order
+------------------------------------------------------------*/
+
+#include "types.h"          // User-defined data types
+#include "bus.h"            // Sample, BusSink and prototypes
+#include "bus_defines.h"    // Kinds, sizes, budget
+
+//------------------------------------------------------------
+// Per-sink counters
+//------------------------------------------------------------
+BusSinkStats busStats[BUS_MAX_SINKS];
+
+//------------------------------------------------------------
+// Attached sinks and their backlogs
+//------------------------------------------------------------
+typedef struct
+{
+        const BusSink *sink;
+        Sample q[BUS_DEPTH];
+        u32 head, tail;        // Write / read counts
+        u32 lastSec;           // Time of the last sample taken
+        u32 any;               // A sample has been taken
+} BusSlot;
+
+static BusSlot slots[BUS_MAX_SINKS];
+static u32 numSinks;
+
+/*------------------------------------------------------------
+Function: InitBus
+Purpose :
+Detaches every sink and clears the counters.
+------------------------------------------------------------*/
+void InitBus(void)
+{
+        u32 i;
+
+        numSinks = 0;
+        for (i = 0; i < BUS_MAX_SINKS; i++)
+        {
+                busStats[i].taken = busStats[i].limited = 0;
+                busStats[i].dropped = busStats[i].delivered = 0;
+        }
+}
+
+/*------------------------------------------------------------
+Function: BusAttach
+Purpose :
+Adds a sink with an empty backlog.
+------------------------------------------------------------*/
+s32 BusAttach(const BusSink *sink)
+{
+        BusSlot *b;
+
+        if (numSinks == BUS_MAX_SINKS)
+                return -1;
+
+        b = &slots[numSinks];
+        b->sink = sink;
+        b->head = b->tail = 0;
+        b->any = 0;
+        return numSinks++;
+}
+
+/*------------------------------------------------------------
+Function: BusPublish
+Purpose :
+Queues the sample for each sink that takes its kind and is
+outside its rate limit. A full backlog drops the oldest
+queued sample or the new one, as the sink asks.
+------------------------------------------------------------*/
+void BusPublish(const Sample *s)
+{
+        BusSlot *b;
+        u32 i;
+
+        for (i = 0; i < numSinks; i++)
+        {
+                b = &slots[i];
+
+                if (!(s->kind & b->sink->kinds))
+                        continue;
+
+                if (b->any && b->sink->gapSec != 0 &&
+                    s->at.sec - b->lastSec < b->sink->gapSec)
+                {
+                        busStats[i].limited++;
+                        continue;
+                }
+
+                if (b->head - b->tail == BUS_DEPTH)
+                {
+                        busStats[i].dropped++;
+                        if (!b->sink->keepNewest)
+                                continue;
+                        b->tail++;
+                }
+
+                b->q[b->head++ & BUS_MASK] = *s;
+                b->lastSec = s->at.sec;
+                b->any = 1;
+                busStats[i].taken++;
+        }
+}
+
+/*------------------------------------------------------------
+Function: BusService
+Purpose :
+Hands queued samples to their sinks, at most BUS_BUDGET per
+sink per call.
+------------------------------------------------------------*/
+void BusService(void)
+{
+        BusSlot *b;
+        u32 i, n;
+
+        for (i = 0; i < numSinks; i++)
+        {
+                b = &slots[i];
+                for (n = 0; n < BUS_BUDGET && b->tail != b->head; n++)
+                {
+                        b->sink->put(&b->q[b->tail & BUS_MASK]);
+                        b->tail++;
+                        busStats[i].delivered++;
+                }
+        }
+}
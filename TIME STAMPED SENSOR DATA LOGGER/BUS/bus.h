@@ -0,0 +1,96 @@
+//bus.h
+/*------------------------------------------------------------
+File: bus.h
+Purpose:
+Header file for the sample bus.
+
+The producer builds one Sample per acquisition (time stamp
+and pipeline record, read once) and publishes it. Every
+attached sink that subscribes to its kind gets its own copy
+in a small backlog, delivered later by BusService(), so a
+slow sink (UART, flash) never holds up the producer or the
+other sinks.
+
+Per sink:
+- kinds      : which samples it takes
+- gapSec     : rate limit, samples closer than this many
+               seconds to the last one taken are skipped
+- keepNewest : full backlog policy, 1 -> drop the oldest
+               sample (displays), 0 -> drop the new one
+               (logs, which must stay in order)
+------------------------------------------------------------*/
+
+#ifndef __BUS_H__
+#define __BUS_H__
+
+#include "types.h"
+#include "rtc.h"
+#include "pipeline.h"
+#include "bus_defines.h"
+
+//------------------------------------------------------------
+// One acquisition; never changed once published
+//------------------------------------------------------------
+typedef struct
+{
+        u32 kind;      // BUS_SECOND / BUS_PERIOD, | BUS_ALERT
+        u32 ch;        // ADC channel
+        RTCStamp at;   // When the record was produced
+        PipeRec rec;   // Temperatures in tenths of a degree
+} Sample;
+
+//------------------------------------------------------------
+// Sink description (usually const)
+//------------------------------------------------------------
+typedef struct
+{
+        u32 kinds;                      // Sample kinds taken
+        u32 gapSec;                     // 0 -> no rate limit
+        u32 keepNewest;                 // Backlog full policy
+        void (*put)(const Sample *s);   // Deliver one sample
+} BusSink;
+
+//------------------------------------------------------------
+// Per-sink counters
+//------------------------------------------------------------
+typedef struct
+{
+        u32 taken;     // Samples queued
+        u32 limited;   // Skipped by the rate limit
+        u32 dropped;   // Lost to a full backlog
+        u32 delivered; // Passed to put()
+} BusSinkStats;
+
+extern BusSinkStats busStats[BUS_MAX_SINKS];
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: InitBus
+// Purpose : Detach all sinks and clear the counters
+//------------------------------------------------------------
+void InitBus(void);
+
+//------------------------------------------------------------
+// Function: BusAttach
+// Purpose : Add a sink
+// Return  : Sink index (for busStats), -1 when all are used
+//------------------------------------------------------------
+s32 BusAttach(const BusSink *sink);
+
+//------------------------------------------------------------
+// Function: BusPublish
+// Purpose : Queue a sample for every sink that takes it
+//------------------------------------------------------------
+void BusPublish(const Sample *s);
+
+//------------------------------------------------------------
+// Function: BusService
+// Purpose : Deliver up to BUS_BUDGET queued samples to each
+//           sink; call from the main loop
+//------------------------------------------------------------
+void BusService(void);
+
+#endif
@@ -0,0 +1,45 @@
+//bus_defines.h
+/*------------------------------------------------------------
+File: bus_defines.h
+Purpose:
+Contains macros for the sample bus.
+
+This file defines:
+- Sample kinds a sink can subscribe to
+- Number of sinks and backlog depth per sink
+- Delivery budget per BusService() call
+- Frame format of the binary UART sink (SINK_BINARY)
+------------------------------------------------------------*/
+
+#ifndef BUS_DEFINES_H
+#define BUS_DEFINES_H
+
+//------------------------------------------------------------
+// Sample kinds (bit mask; a sample can carry several)
+//------------------------------------------------------------
+#define BUS_SECOND     (1<<0)  // Per-second record
+#define BUS_PERIOD     (1<<1)  // Per-log-period record
+#define BUS_ALERT      (1<<2)  // Peak over the set point
+
+//------------------------------------------------------------
+// Sinks and backlog (samples per sink, power of two)
+//------------------------------------------------------------
+#define BUS_MAX_SINKS  6
+#define BUS_DEPTH      8
+#define BUS_MASK       (BUS_DEPTH-1)
+
+//------------------------------------------------------------
+// Samples delivered to each sink per BusService() call
+//------------------------------------------------------------
+#define BUS_BUDGET     1
+
+//------------------------------------------------------------
+// Binary sink frame: start byte, payload length, escape byte
+// and the least time between two frames (seconds)
+//------------------------------------------------------------
+#define SINK_SOF           0xA5
+#define SINK_FRAME_LEN     16
+#define SINK_ESC           0x1B
+#define SINK_BINARY_GAP_S  0
+
+#endif
@@ -0,0 +1,198 @@
+//clock.c
+/*------------------------------------------------------------
+File: clock.c
+Purpose:
+Configures the PLL, VPB divider and Memory Accelerator
+Module (MAM) of the LPC214x, and switches clock profiles at
+run time.
+
+Features:
+- Table of profiles: PLL multiplier, VPB divider, MAM timing
+- Safe ordering: MAM timing is raised before the CPU clock
+  goes up and lowered after it comes down
+- After a switch every clock-derived divider is recomputed
+- A PLL that does not lock leaves the CPU on the crystal
+------------------------------------------------------------*/
+
+#include <lpc214x.h>          // LPC214x register definitions
+#include "types.h"            // User-defined data types
+#include "clock.h"            // Clock prototypes
+#include "clock_defines.h"    // PLL, VPB and MAM values
+#include "uart.h"             // UARTSetPclk, UARTFlush
+#include "adc.h"              // ADCSetPclk
+#include "timer.h"            // Timer0/1SetPclk, deadlines
+#include "rtc.h"              // RTCSetPclk
+
+//------------------------------------------------------------
+// Profile table
+//------------------------------------------------------------
+typedef struct
+{
+        u32 pllM;      // PLL multiplier, 1 -> PLL off
+        u32 pllPsel;   // PLL divider code
+        u32 vpbdiv;    // VPBDIV value
+        u32 pclkDiv;   // CCLK / PCLK
+        u32 mamtim;    // MAM fetch cycles
+} ClockProfileDef;
+
+static const ClockProfileDef profiles[CLK_PROFILES] =
+{
+        { PLL_M_PERF, PLL_PSEL_PERF, VPB_DIV4, 4, MAMTIM_PERF },   // CLK_PERF
+        { 1,          0,             VPB_DIV2, 2, MAMTIM_LOW  }    // CLK_LOW
+};
+
+static u32 curProfile = CLK_PROFILES;   // None programmed yet
+static u32 cclk = FOSC, pclk = FOSC / 4; // Reset state
+
+//------------------------------------------------------------
+// Function: PllFeed
+// Purpose : Commit PLLCON/PLLCFG writes
+//------------------------------------------------------------
+static void PllFeed(void)
+{
+        PLLFEED = PLL_FEED1;
+        PLLFEED = PLL_FEED2;
+}
+
+//------------------------------------------------------------
+// Function: SetMam
+// Purpose : Change MAM timing (MAM must be off meanwhile)
+//------------------------------------------------------------
+static void SetMam(u32 mamtim)
+{
+        MAMCR = MAM_OFF;
+        MAMTIM = mamtim;
+        MAMCR = MAM_FULL;
+}
+
+/*------------------------------------------------------------
+Function: ApplyProfile
+Purpose :
+Programs the registers of a profile. The PLL is always
+disconnected first, so this works from any starting state.
+Timer1 still counts with the old prescaler while the lock is
+awaited, so the timeout is only approximate.
+------------------------------------------------------------*/
+static void ApplyProfile(const ClockProfileDef *p)
+{
+        u32 newCclk = FOSC * p->pllM;
+        u32 dl;
+
+        // Going up: slow the flash accesses down first
+        if (newCclk > cclk)
+                SetMam(p->mamtim);
+
+        //----------------------------------------------------------
+        // Run from the crystal while the PLL is changed
+        //----------------------------------------------------------
+        PLLCON = PLLCON_PLLE & PLLCON;
+        PllFeed();
+        PLLCON = 0;
+        PllFeed();
+
+        VPBDIV = p->vpbdiv;
+
+        if (p->pllM > 1)
+        {
+                PLLCFG = PLLCFG_VAL(p->pllM, p->pllPsel);
+                PLLCON = PLLCON_PLLE;
+                PllFeed();
+
+                dl = DeadlineSet(PLL_LOCK_TIMEOUT_US);
+                while (!(PLLSTAT & PLLSTAT_PLOCK))
+                        if (DeadlinePassed(dl))
+                                break;
+
+                if (PLLSTAT & PLLSTAT_PLOCK)
+                {
+                        PLLCON = PLLCON_PLLE | PLLCON_PLLC;
+                        PllFeed();
+                }
+                else
+                {
+                        // Stay on the crystal rather than hang
+                        WaitTimeout(WAIT_PLL);
+                        PLLCON = 0;
+                        PllFeed();
+                        newCclk = FOSC;
+                }
+        }
+
+        // Going down (or first setup): MAM timing for new clock
+        if (newCclk <= cclk)
+                SetMam(p->mamtim);
+
+        cclk = newCclk;
+        pclk = newCclk / p->pclkDiv;
+}
+
+/*------------------------------------------------------------
+Function: InitClock
+Purpose :
+Programs the clocks for a profile at boot. Drivers are not
+running yet, so nothing is recomputed here; they take
+ClockPclk() when they are initialized. Timer1 is started
+before this (it bounds the PLL lock wait) and is the one
+divider brought up to date here.
+------------------------------------------------------------*/
+void InitClock(u32 profile)
+{
+        if (profile >= CLK_PROFILES)
+                profile = CLK_PERF;
+
+        ApplyProfile(&profiles[profile]);
+        curProfile = profile;
+        Timer1SetPclk(pclk);
+}
+
+/*------------------------------------------------------------
+Function: ClockSetProfile
+Purpose :
+Switches profile at run time. The UARTs are allowed to
+drain so no character is sent at a mixed rate, and all
+interrupts are masked until every divider matches the new
+clock.
+------------------------------------------------------------*/
+u32 ClockSetProfile(u32 profile)
+{
+        u32 irq;
+
+        if (profile >= CLK_PROFILES || profile == curProfile)
+                return 0;
+
+        UARTFlush();
+
+        irq = VICIntEnable;
+        VICIntEnClr = 0xFFFFFFFF;
+
+        ApplyProfile(&profiles[profile]);
+        curProfile = profile;
+
+        UARTSetPclk(pclk);
+        ADCSetPclk(pclk);
+        Timer0SetPclk(pclk);
+        Timer1SetPclk(pclk);
+        RTCSetPclk(pclk);
+
+        VICIntEnable = irq;
+        return 1;
+}
+
+//------------------------------------------------------------
+// Function: ClockProfile / ClockCclk / ClockPclk
+// Purpose : Current profile and clocks
+//------------------------------------------------------------
+u32 ClockProfile(void)
+{
+        return curProfile;
+}
+
+u32 ClockCclk(void)
+{
+        return cclk;
+}
+
+u32 ClockPclk(void)
+{
+        return pclk;
+}
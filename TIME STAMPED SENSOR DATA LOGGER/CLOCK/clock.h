@@ -0,0 +1,55 @@
+//clock.h
+/*------------------------------------------------------------
+File: clock.h
+Purpose:
+Header file for clock management (PLL, VPB divider, MAM).
+
+This file provides:
+- Setting up the clocks at boot
+- Switching between the performance and low-power profile
+  at run time
+- The current CPU and peripheral clock for drivers that
+  derive dividers from it
+------------------------------------------------------------*/
+
+#ifndef __CLOCK_H__
+#define __CLOCK_H__
+
+#include "types.h"
+#include "clock_defines.h"
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: InitClock
+// Purpose : Program PLL, VPBDIV and MAM for a profile
+// Note    : Call first in main() after InitTimer1; drivers
+//           read ClockPclk() when they are initialized
+//------------------------------------------------------------
+void InitClock(u32 profile);
+
+//------------------------------------------------------------
+// Function: ClockSetProfile
+// Purpose : Switch profile at run time and recompute the
+//           UART baud divisors, ADC clock divider and the
+//           Timer0, Timer1 and RTC prescalers
+// Return  : 1 -> switched, 0 -> bad or current profile
+// Note    : Waits for the UARTs to finish sending;
+//           interrupts are masked during the switch.
+//           Called on every rate level change, so the clock
+//           follows the sampling rate (DisplayInformation.c)
+//------------------------------------------------------------
+u32 ClockSetProfile(u32 profile);
+
+//------------------------------------------------------------
+// Function: ClockProfile / ClockCclk / ClockPclk
+// Purpose : Current profile, CPU clock and peripheral clock
+//           (Hz)
+//------------------------------------------------------------
+u32 ClockProfile(void);
+u32 ClockCclk(void);
+u32 ClockPclk(void);
+
+#endif
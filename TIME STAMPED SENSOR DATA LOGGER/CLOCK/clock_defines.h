@@ -0,0 +1,60 @@
+//clock_defines.h
+/*------------------------------------------------------------
+File: clock_defines.h
+Purpose:
+Contains macros for the PLL, VPB divider and Memory
+Accelerator Module (MAM) of the LPC214x microcontroller.
+
+This file defines:
+- Crystal frequency and the clock profiles
+- PLL, VPBDIV and MAM register values and bits
+------------------------------------------------------------*/
+
+#ifndef CLOCK_DEFINES_H
+#define CLOCK_DEFINES_H
+
+//------------------------------------------------------------
+// External crystal
+//------------------------------------------------------------
+#define FOSC            12000000     // 12 MHz
+
+//------------------------------------------------------------
+// Clock profiles
+// CLK_PERF : PLL x5 -> CCLK 60 MHz, PCLK = CCLK/4 = 15 MHz
+// CLK_LOW  : PLL off -> CCLK 12 MHz, PCLK = CCLK/2 = 6 MHz
+//------------------------------------------------------------
+#define CLK_PERF        0
+#define CLK_LOW         1
+#define CLK_PROFILES    2
+
+//------------------------------------------------------------
+// PLL (Fcco = CCLK * 2 * P must be 156 - 320 MHz)
+//------------------------------------------------------------
+#define PLL_M_PERF      5            // 12 MHz * 5 = 60 MHz
+#define PLL_PSEL_PERF   1            // P = 2 -> Fcco = 240 MHz
+#define PLLCFG_VAL(m, psel)  (((m) - 1) | ((psel) << 5))
+
+#define PLLCON_PLLE     (1<<0)       // PLL enable
+#define PLLCON_PLLC     (1<<1)       // PLL connect
+#define PLLSTAT_PLOCK   (1<<10)      // PLL locked
+#define PLL_FEED1       0xAA
+#define PLL_FEED2       0x55
+#define PLL_LOCK_TIMEOUT_US    2000  // Lock takes ~100 us
+
+//------------------------------------------------------------
+// VPBDIV values
+//------------------------------------------------------------
+#define VPB_DIV4        0            // PCLK = CCLK / 4
+#define VPB_DIV1        1            // PCLK = CCLK
+#define VPB_DIV2        2            // PCLK = CCLK / 2
+
+//------------------------------------------------------------
+// MAM: fetch cycles by CCLK (1 below 20 MHz, 2 below 40 MHz,
+// 3 above), fully enabled in both profiles
+//------------------------------------------------------------
+#define MAM_OFF         0
+#define MAM_FULL        2
+#define MAMTIM_PERF     3
+#define MAMTIM_LOW      1
+
+#endif
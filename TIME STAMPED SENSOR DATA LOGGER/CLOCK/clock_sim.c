@@ -0,0 +1,73 @@
+//clock_sim.c
+/*------------------------------------------------------------
+File: clock_sim.c
+Purpose:
+Clock profiles for host builds (HOST_BUILD).
+
+Stands in for clock.c: the profile and its clocks are only
+recorded, so code that switches profiles or derives dividers
+from ClockPclk() can run on a PC. The virtual Timer0/Timer1
+and RTC do not depend on PCLK.
+------------------------------------------------------------*/
+
+#ifdef HOST_BUILD
+
+#include "types.h"            // User-defined data types
+#include "clock.h"            // Clock prototypes
+#include "clock_defines.h"    // Profiles, FOSC
+#include "uart.h"             // UARTSetPclk
+
+static u32 curProfile = CLK_PROFILES;
+static u32 cclk = FOSC, pclk = FOSC / 4;
+
+//------------------------------------------------------------
+// Function: SetClocks
+// Purpose : CCLK and PCLK of a profile, as in clock.c
+//------------------------------------------------------------
+static void SetClocks(u32 profile)
+{
+        if (profile == CLK_PERF)
+        {
+                cclk = FOSC * PLL_M_PERF;
+                pclk = cclk / 4;
+        }
+        else
+        {
+                cclk = FOSC;
+                pclk = cclk / 2;
+        }
+        curProfile = profile;
+}
+
+void InitClock(u32 profile)
+{
+        SetClocks(profile < CLK_PROFILES ? profile : CLK_PERF);
+}
+
+u32 ClockSetProfile(u32 profile)
+{
+        if (profile >= CLK_PROFILES || profile == curProfile)
+                return 0;
+
+        UARTFlush();
+        SetClocks(profile);
+        UARTSetPclk(pclk);
+        return 1;
+}
+
+u32 ClockProfile(void)
+{
+        return curProfile;
+}
+
+u32 ClockCclk(void)
+{
+        return cclk;
+}
+
+u32 ClockPclk(void)
+{
+        return pclk;
+}
+
+#endif
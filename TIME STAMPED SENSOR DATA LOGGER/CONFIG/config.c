@@ -0,0 +1,179 @@
+//config.c
+/*------------------------------------------------------------
+File: config.c
+Purpose:
+Keeps the configuration (set point, sample rates, deadband
+logging) in the on-chip flash of the LPC2148 so it survives
+reset and power loss.
+
+Features:
+- Slots are written in turn through one flash sector, so
+  the sector is erased once every CFG_SLOTS saves
+- Newest slot found by sequence number, checked by CRC
+- IAP boot ROM calls with all interrupts masked at the VIC
+- Changes are marked by ConfigSaveLater and written by the
+  main loop, so the masked time never falls in the middle of
+  an edit, a capture or a resend
+------------------------------------------------------------*/
+
+#include <lpc214x.h>          // LPC214x register definitions
+#include "types.h"            // User-defined data types
+#include "crc.h"              // Crc16
+#include "clock.h"            // Current CCLK for IAP
+#include "config.h"           // Config record and prototypes
+#include "config_defines.h"   // Flash layout, IAP, defaults
+
+//------------------------------------------------------------
+// Current configuration
+//------------------------------------------------------------
+Config config;
+
+//------------------------------------------------------------
+// IAP entry and its word-aligned RAM source buffer
+//------------------------------------------------------------
+typedef void (*IAP)(u32 *cmd, u32 *res);
+static const IAP iapEntry = (IAP)IAP_LOCATION;
+static u32 slotBuf[CFG_SLOT_SIZE / 4];
+
+static s32 cfgSlot = -1;      // Slot of the loaded record
+static u32 cfgPending;        // Changed, not yet saved
+
+//------------------------------------------------------------
+// Function: SlotPtr
+// Purpose : Flash address of slot i
+//------------------------------------------------------------
+static const Config *SlotPtr(u32 i)
+{
+        return (const Config *)(CFG_ADDR + i * CFG_SLOT_SIZE);
+}
+
+//------------------------------------------------------------
+// Function: CfgCrc
+// Purpose : CRC of a record, without its crc field
+//------------------------------------------------------------
+static u32 CfgCrc(const Config *c)
+{
+        return Crc16((const u8 *)c, sizeof(Config) - sizeof(u32));
+}
+
+/*------------------------------------------------------------
+Function: InitConfig
+Purpose :
+Scans the slots for the valid record with the highest
+sequence number. Falls back to the defaults.
+------------------------------------------------------------*/
+u32 InitConfig(void)
+{
+        const Config *c;
+        u32 i;
+
+        cfgSlot = -1;
+        for (i = 0; i < CFG_SLOTS; i++)
+        {
+                c = SlotPtr(i);
+                if (c->magic != CFG_MAGIC || c->crc != CfgCrc(c))
+                        continue;
+                if (cfgSlot < 0 || c->seq > config.seq)
+                {
+                        config = *c;
+                        cfgSlot = i;
+                }
+        }
+
+        if (cfgSlot >= 0)
+                return 1;
+
+        config.magic    = CFG_MAGIC;
+        config.seq      = 0;
+        config.setPoint = CFG_DEF_SET_POINT;
+        config.sampleHz = CFG_DEF_SAMPLE_HZ;
+        config.sampleHzMin = CFG_DEF_SAMPLE_HZ_MIN;
+        config.deadband = CFG_DEF_DEADBAND;
+        config.heartbeat = CFG_DEF_HEARTBEAT;
+        return 0;
+}
+
+//------------------------------------------------------------
+// Function: IapCall
+// Purpose : Run one IAP command with interrupts masked
+// Return  : IAP status code
+//------------------------------------------------------------
+static u32 IapCall(u32 c0, u32 c1, u32 c2, u32 c3, u32 c4)
+{
+        u32 cmd[5], res[3], irq;
+
+        cmd[0] = c0; cmd[1] = c1; cmd[2] = c2; cmd[3] = c3; cmd[4] = c4;
+
+        irq = VICIntEnable;
+        VICIntEnClr = 0xFFFFFFFF;
+        iapEntry(cmd, res);
+        VICIntEnable = irq;
+
+        return res[0];
+}
+
+/*------------------------------------------------------------
+Function: ConfigSave
+Purpose :
+Writes the configuration to the slot after the current one.
+A slot that is not blank (all 0xFF) forces a sector erase
+first, then writing restarts at slot 0.
+------------------------------------------------------------*/
+u32 ConfigSave(void)
+{
+        u32 i, slot, blank = 1;
+        const u32 *p;
+        Config *c = (Config *)slotBuf;
+
+        cfgPending = 0;
+
+        slot = (cfgSlot < 0) ? 0 : (u32)(cfgSlot + 1);
+        if (slot < CFG_SLOTS)
+        {
+                p = (const u32 *)SlotPtr(slot);
+                for (i = 0; i < CFG_SLOT_SIZE / 4; i++)
+                        if (p[i] != CFG_BLANK)
+                                blank = 0;
+        }
+
+        if (slot >= CFG_SLOTS || !blank)
+        {
+                if (IapCall(IAP_PREPARE, CFG_SECTOR, CFG_SECTOR, 0, 0) != IAP_SUCCESS ||
+                    IapCall(IAP_ERASE, CFG_SECTOR, CFG_SECTOR, CCLK_KHZ, 0) != IAP_SUCCESS)
+                        return 0;
+                slot = 0;
+        }
+
+        //----------------------------------------------------------
+        // Build the slot image in RAM; the rest stays erased
+        //----------------------------------------------------------
+        for (i = 0; i < CFG_SLOT_SIZE / 4; i++)
+                slotBuf[i] = CFG_BLANK;
+
+        config.magic = CFG_MAGIC;
+        config.seq++;
+        config.crc = CfgCrc(&config);
+        *c = config;
+
+        if (IapCall(IAP_PREPARE, CFG_SECTOR, CFG_SECTOR, 0, 0) != IAP_SUCCESS ||
+            IapCall(IAP_COPY, CFG_ADDR + slot * CFG_SLOT_SIZE, (u32)slotBuf,
+                    CFG_SLOT_SIZE, CCLK_KHZ) != IAP_SUCCESS)
+                return 0;
+
+        cfgSlot = slot;
+        return SlotPtr(slot)->crc == config.crc;
+}
+
+//------------------------------------------------------------
+// Function: ConfigSaveLater / ConfigPending
+// Purpose : Mark a change / check for an unsaved one
+//------------------------------------------------------------
+void ConfigSaveLater(void)
+{
+        cfgPending = 1;
+}
+
+u32 ConfigPending(void)
+{
+        return cfgPending;
+}
@@ -0,0 +1,71 @@
+//config.h
+/*------------------------------------------------------------
+File: config.h
+Purpose:
+Header file for the non-volatile configuration.
+
+This file provides:
+- The configuration record kept in on-chip flash
+- Restoring it at boot and saving it after a change
+------------------------------------------------------------*/
+
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+#include "types.h"
+#include "config_defines.h"
+
+//------------------------------------------------------------
+// Configuration record (one flash slot)
+//------------------------------------------------------------
+typedef struct
+{
+        u32 magic;      // CFG_MAGIC
+        u32 seq;        // Save count; highest valid slot wins
+        u32 setPoint;   // Temperature limit (C)
+        u32 sampleHz;   // Pipeline fast stage rate near the set point
+        u32 sampleHzMin; // Rate far from the set point (adaptive floor)
+        u32 deadband;   // Period record change threshold (0.1 C), 0 -> off
+        u32 heartbeat;  // Longest silence between period records (s)
+        u32 crc;        // CRC-16 of the fields above
+} Config;
+
+extern Config config;
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: InitConfig
+// Purpose : Load the newest valid record from flash, or the
+//           defaults when there is none
+// Return  : 1 -> restored from flash, 0 -> defaults
+//------------------------------------------------------------
+u32 InitConfig(void);
+
+//------------------------------------------------------------
+// Function: ConfigSave
+// Purpose : Write config to the next blank slot (erasing the
+//           sector when it is full)
+// Return  : 1 -> written and verified, 0 -> IAP error
+// Note    : Interrupts are masked while the flash is busy
+//           (about 1 ms per write, 400 ms for an erase), so
+//           callers outside start-up use ConfigSaveLater
+//------------------------------------------------------------
+u32 ConfigSave(void);
+
+//------------------------------------------------------------
+// Function: ConfigSaveLater
+// Purpose : Mark config as changed; the main loop saves it
+//           with ConfigSave when nothing time-critical runs
+//------------------------------------------------------------
+void ConfigSaveLater(void);
+
+//------------------------------------------------------------
+// Function: ConfigPending
+// Return  : 1 -> changed since the last ConfigSave
+//------------------------------------------------------------
+u32 ConfigPending(void);
+
+#endif
@@ -0,0 +1,57 @@
+//config_defines.h
+/*------------------------------------------------------------
+File: config_defines.h
+Purpose:
+Contains macros for keeping the configuration in the on-chip
+flash of the LPC2148 through the IAP boot ROM calls.
+
+This file defines:
+- The flash sector and slot layout used for configuration
+- IAP entry point, command codes and clock argument
+- Default configuration values
+------------------------------------------------------------*/
+
+#ifndef CONFIG_DEFINES_H
+#define CONFIG_DEFINES_H
+
+//------------------------------------------------------------
+// IAP needs the current CPU clock in kHz
+//------------------------------------------------------------
+#define CCLK_KHZ (ClockCclk()/1000)
+
+//------------------------------------------------------------
+// Flash layout: sector 26 (4 KB, just below the boot block),
+// split into 256-byte slots. Each save goes to the next blank
+// slot; the sector is erased only when all slots are used.
+// The linker must not place code in this sector.
+//------------------------------------------------------------
+#define CFG_SECTOR       26
+#define CFG_ADDR         0x0007C000
+#define CFG_SECTOR_SIZE  4096
+#define CFG_SLOT_SIZE    256      // Smallest IAP write
+#define CFG_SLOTS        (CFG_SECTOR_SIZE/CFG_SLOT_SIZE)
+
+#define CFG_MAGIC        0x33474643   // "CFG3" (adds deadband, heartbeat)
+#define CFG_BLANK        0xFFFFFFFF
+
+//------------------------------------------------------------
+// IAP (In-Application Programming) boot ROM interface
+// IAP uses the top 32 bytes of on-chip RAM; the stacks must
+// stay clear of them.
+//------------------------------------------------------------
+#define IAP_LOCATION     0x7FFFFFF1   // Thumb entry
+#define IAP_PREPARE      50
+#define IAP_COPY         51
+#define IAP_ERASE        52
+#define IAP_SUCCESS      0
+
+//------------------------------------------------------------
+// Defaults used when no valid configuration is stored
+//------------------------------------------------------------
+#define CFG_DEF_SET_POINT  45     // Temperature limit (C)
+#define CFG_DEF_SAMPLE_HZ  1000   // Pipeline fast stage rate (maximum)
+#define CFG_DEF_SAMPLE_HZ_MIN 50  // Adaptive rate floor
+#define CFG_DEF_DEADBAND   10     // Log on a 1.0 C change...
+#define CFG_DEF_HEARTBEAT  900    // ...or every 15 minutes
+
+#endif
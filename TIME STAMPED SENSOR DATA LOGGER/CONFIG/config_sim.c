@@ -0,0 +1,65 @@
+//config_sim.c
+/*------------------------------------------------------------
+File: config_sim.c
+Purpose:
+Configuration for host builds (HOST_BUILD).
+
+Stands in for config.c, which reads and writes the on-chip
+flash through the IAP boot ROM: InitConfig always loads the
+defaults and ConfigSave only counts the saves.
+------------------------------------------------------------*/
+
+#ifdef HOST_BUILD
+
+#include "types.h"            // User-defined data types
+#include "config.h"           // Config record and prototypes
+#include "config_defines.h"   // Defaults
+
+Config config;
+
+static u32 cfgPending;        // Changed, not yet saved
+
+//------------------------------------------------------------
+// Function: InitConfig
+// Purpose : Load the defaults
+// Return  : 0 -> defaults
+//------------------------------------------------------------
+u32 InitConfig(void)
+{
+        config.magic    = CFG_MAGIC;
+        config.seq      = 0;
+        config.setPoint = CFG_DEF_SET_POINT;
+        config.sampleHz = CFG_DEF_SAMPLE_HZ;
+        config.sampleHzMin = CFG_DEF_SAMPLE_HZ_MIN;
+        config.deadband = CFG_DEF_DEADBAND;
+        config.heartbeat = CFG_DEF_HEARTBEAT;
+        return 0;
+}
+
+//------------------------------------------------------------
+// Function: ConfigSave
+// Purpose : Count a save (config.seq)
+// Return  : 1 -> "written"
+//------------------------------------------------------------
+u32 ConfigSave(void)
+{
+        cfgPending = 0;
+        config.seq++;
+        return 1;
+}
+
+//------------------------------------------------------------
+// Function: ConfigSaveLater / ConfigPending
+// Purpose : Mark a change / check for an unsaved one
+//------------------------------------------------------------
+void ConfigSaveLater(void)
+{
+        cfgPending = 1;
+}
+
+u32 ConfigPending(void)
+{
+        return cfgPending;
+}
+
+#endif
@@ -0,0 +1,49 @@
+//crc.c
+/*------------------------------------------------------------
+File: crc.c
+Purpose:
+Implements CRC-16/CCITT with a 16-entry nibble table.
+
+The nibble table keeps the code small (32 bytes of const
+data) while taking two table steps per byte instead of
+eight shift/xor steps.
+------------------------------------------------------------*/
+
+#include "types.h"   // User-defined data types
+#include "crc.h"     // CRC prototypes
+
+//------------------------------------------------------------
+// CRC of each 4-bit value for polynomial 0x1021
+//------------------------------------------------------------
+static const u16 crcNib[16] =
+{
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/*------------------------------------------------------------
+Function: Crc16Update
+Purpose :
+Folds one byte into the CRC, high nibble first.
+------------------------------------------------------------*/
+u16 Crc16Update(u16 crc, u8 b)
+{
+        crc = (crc << 4) ^ crcNib[(crc >> 12) ^ (b >> 4)];
+        crc = (crc << 4) ^ crcNib[(crc >> 12) ^ (b & 0x0F)];
+        return crc;
+}
+
+/*------------------------------------------------------------
+Function: Crc16
+Purpose :
+Returns the CRC of len bytes starting at buf.
+------------------------------------------------------------*/
+u16 Crc16(const u8 *buf, u32 len)
+{
+        u16 crc = CRC16_INIT;
+
+        while (len--)
+                crc = Crc16Update(crc, *buf++);
+
+        return crc;
+}
@@ -0,0 +1,32 @@
+//crc.h
+/*------------------------------------------------------------
+File: crc.h
+Purpose:
+Header file for CRC-16/CCITT (poly 0x1021, init 0xFFFF)
+used to protect logged records.
+------------------------------------------------------------*/
+
+#ifndef __CRC_H__
+#define __CRC_H__
+
+#include "types.h"
+
+#define CRC16_INIT 0xFFFF
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: Crc16Update
+// Purpose : Fold one byte into a running CRC
+//------------------------------------------------------------
+u16 Crc16Update(u16 crc, u8 b);
+
+//------------------------------------------------------------
+// Function: Crc16
+// Purpose : CRC of a buffer, starting from CRC16_INIT
+//------------------------------------------------------------
+u16 Crc16(const u8 *buf, u32 len);
+
+#endif
@@ -2,8 +2,8 @@
 /*------------------------------------------------------------
 File: delay.c
 Purpose:
-Provides software delay functions for LPC214x ARM7
-microcontroller using simple loop-based timing.
+Provides delay functions for LPC214x ARM7 microcontroller,
+timed by the free-running 1 us count of Timer1.
 
 These delay routines are useful for:
 - Creating small time delays
@@ -12,11 +12,13 @@ These delay routines are useful for:
 - Keypad debounce delays
 
 NOTE:
-These delays are approximate and depend on CPU clock
-frequency and compiler optimization.
+InitTimer1 must run before the first delay. The delays are
+exact to 1 us and do not depend on the CPU clock or compiler
+optimization; interrupts can only make them longer.
 ------------------------------------------------------------*/
 
 #include "types.h"   // User-defined data types
+#include "timer.h"   // Timer1 microsecond count
 
 //------------------------------------------------------------
 // Function: delay_us
@@ -25,13 +27,13 @@ frequency and compiler optimization.
 //   tdly -> Delay time in microseconds
 //
 // Working:
-// - Multiplies delay count based on CPU clock (12 MHz)
-// - Uses a simple decrementing loop
+// - Waits until Timer1 has advanced by tdly counts
 //------------------------------------------------------------
 void delay_us(unsigned int tdly)
 {
-        tdly *= 12;          // Adjust loop count for 1 s delay
-        while(tdly--);       // Busy-wait loop
+        u32 start = Timer1Now();
+
+        while ((Timer1Now() - start) < tdly);   // Busy-wait on Timer1
 }
 
 //------------------------------------------------------------
@@ -41,13 +43,13 @@ void delay_us(unsigned int tdly)
 //   tdly -> Delay time in milliseconds
 //
 // Working:
-// - Multiplies delay count based on CPU clock
-// - Calls a busy-wait loop for approximate timing
+// - One 1000 us delay per count, so long delays cannot
+//   overflow the microsecond count
 //------------------------------------------------------------
 void delay_ms(unsigned int tdly)
 {
-        tdly *= 12000;       // Adjust loop count for 1 ms delay
-        while(tdly--);       // Busy-wait loop
+        while(tdly--)
+                delay_us(1000);
 }
 
 //------------------------------------------------------------
@@ -57,11 +59,10 @@ void delay_ms(unsigned int tdly)
 //   tdly -> Delay time in seconds
 //
 // Working:
-// - Multiplies delay count based on CPU clock
-// - Uses a busy-wait loop (not CPU efficient)
+// - One 1000 ms delay per count (not CPU efficient)
 //------------------------------------------------------------
 void delay_s(unsigned int tdly)
 {
-        tdly *= 12000000;    // Adjust loop count for 1 second delay
-        while(tdly--);       // Busy-wait loop
+        while(tdly--)        // One second per count
+                delay_ms(1000);
 }
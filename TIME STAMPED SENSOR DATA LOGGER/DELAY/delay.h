@@ -6,7 +6,7 @@ Header file for delay functions for LPC21xx microcontroller.
 
 This file provides:
 - Microsecond, millisecond, and second delays
-- Functions typically implemented using Timer0 or software loops
+- Timed by Timer1 (call InitTimer1 first)
 ------------------------------------------------------------*/
 
 #include "types.h"   // User-defined data types
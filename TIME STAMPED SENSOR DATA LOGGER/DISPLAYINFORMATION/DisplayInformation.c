@@ -7,32 +7,594 @@ information on LCD and UART for LPC21xx microcontroller.
 
 This file provides:
 - Initializing RTC and default values
-- Displaying time, date, day, and temperature
+- Producing one sample record per second and per log period
+  and publishing it on the sample bus
+- Early [WARN] records from the time-to-threshold forecast
+- Sinks on the bus: LCD, UART text, UART binary (SINK_BINARY),
+  flash log and statistics windows
 - Editing RTC and temperature set-point via keypad
-- Helper functions for numeric input and date validation
+- Helper function for numeric input
+
+Period records are sent by exception when deadband logging
+is configured: only after the mean has moved by the deadband
+since the last record sent, or as a heartbeat once the
+heartbeat interval has passed without one. HOST/expand.c
+rebuilds the full series from them.
+
+The edit menus are protothreads (pt.h): each key wait and
+pause returns to the main loop, which keeps sampling, logging
+and serving the bus while the user types. The LCD sink stays
+off the display while edit mode owns it. Edit mode is left
+without changes once no key has been pressed for
+EDIT_IDLE_MS.
 ------------------------------------------------------------*/
 
 #include <lpc214x.h>
 #include "types.h"
 #include "rtc.h"
+#include "rtc_defines.h"
 #include "lcd.h"
 #include "uart.h"
 #include "lm35.h"
 #include "macros.h"
 #include "KeyPd.h"
-#include "delay.h"
+#include "pt.h"
+#include "adc_defines.h"
+#include "stats.h"
+#include "pipeline.h"
+#include "rate.h"
+#include "sensor.h"
+#include "trend.h"
+#include "bus.h"
+#include "crc.h"
+#include "blklog.h"
+#include "seqlog.h"
+#include "config.h"
+#include "timer.h"
+#include "clock.h"
 #include "DisplayInformation.h"
 
 
 //------------------------------------------------------------
-// External flags and set-point
+// External flags
 //------------------------------------------------------------
-extern u32 edit_flag, set_point;
+extern u32 edit_flag;
 
 //------------------------------------------------------------
-// Local variables for menu choices and value input
+// Value entered by ReadNumber
 //------------------------------------------------------------
-u32 choice, choice1, value;
+u32 value;
+
+//------------------------------------------------------------
+// Edit threads: menu, sub-menu and number entry, the key
+// read, the shared key / delay deadline, and the number and
+// RTC field being entered. Statics, since a protothread
+// loses its locals at every wait.
+//------------------------------------------------------------
+static Pt editPt, subPt, numPt;
+static u8 editKey;
+static u32 editDl;
+static u32 numVal, numCount, rtcField;
+
+//------------------------------------------------------------
+// Set when a key wait in edit mode timed out
+//------------------------------------------------------------
+static u32 editIdle;
+
+//------------------------------------------------------------
+// Wait for a key stroke; sets editIdle after EDIT_IDLE_MS
+// without one
+//------------------------------------------------------------
+#define EDIT_WAIT_KEY(p)  do { editDl = DeadlineSet(EDIT_IDLE_MS * 1000); \
+                               PT_WAIT_UNTIL(p, EditKey()); } while (0)
+
+//------------------------------------------------------------
+// Summaries of windows closed by the latest sample
+//------------------------------------------------------------
+StatSummary statSum[STATS_NUM_WIN];
+
+//------------------------------------------------------------
+// Set while the latest per-second peak is over the set point
+//------------------------------------------------------------
+u32 alert = 0;
+
+//------------------------------------------------------------
+// Time stamp of the record being logged
+//------------------------------------------------------------
+static RTCStamp stamp;
+
+//------------------------------------------------------------
+// Last period record sent (deadband logging)
+//------------------------------------------------------------
+static s32 dbMean;
+static u32 dbSec, dbValid;
+
+//------------------------------------------------------------
+// Function: UARTTxTenths
+// Purpose : Send a value in tenths as "[-]X.Y" via UART
+//------------------------------------------------------------
+static void UARTTxTenths(s32 val)
+{
+        if (val < 0)
+        {
+                UARTTxChar('-');
+                val = -val;
+        }
+        UARTTxU32(val / 10);
+        UARTTxChar('.');
+        UARTTxChar((val % 10) + 48);
+}
+
+//------------------------------------------------------------
+// Function: UARTTxDegrees
+// Purpose : Send a value in tenths as whole degrees "[-]N"
+//           via UART, rounded toward zero
+//------------------------------------------------------------
+static void UARTTxDegrees(s32 val)
+{
+        val /= 10;
+        if (val < 0)
+        {
+                UARTTxChar('-');
+                val = -val;
+        }
+        UARTTxU32(val);
+}
+
+//------------------------------------------------------------
+// Function: LogStatsSummary
+// Purpose : Send one closed statistics window via the bulk
+//           UART
+// Format  : [STAT] CH1 60s n:N min:X.Y max:X.Y mean:X.Y
+//           var:V.VV @HH:MM:SS.mmm DD/MM/YYYY
+//------------------------------------------------------------
+static void LogStatsSummary(StatSummary *ss, const RTCStamp *at)
+{
+        u32 prev = UARTSelect(UART_BULK);
+
+        SeqLogBegin();
+        UARTTxStr("[STAT] CH");
+        UARTTxU32(ss->ch);
+        UARTTxChar(' ');
+        UARTTxU32(ss->len);
+        UARTTxStr("s n:");
+        UARTTxU32(ss->n);
+        UARTTxStr(" min:");
+        UARTTxTenths(ss->min);
+        UARTTxStr(" max:");
+        UARTTxTenths(ss->max);
+        UARTTxStr(" mean:");
+        UARTTxTenths(ss->mean >> STATS_MEAN_FRAC);
+
+        // Samples are in tenths, so variance is in 0.01 C^2 units
+        UARTTxStr(" var:");
+        UARTTxU32(ss->var / 100);
+        UARTTxChar('.');
+        UARTTxChar(((ss->var % 100) / 10) + 48);
+        UARTTxChar((ss->var % 10) + 48);
+        UARTTxStr(" @");
+        DisplayUARTStamp(at);
+        SeqLogEnd();
+        UARTSelect(prev);
+}
+
+//------------------------------------------------------------
+// Function: LogTimeouts
+// Purpose : Send the wait timeout counters via the bulk UART
+//           when any of them has grown since the last report
+// Format  : [WAIT] adc:N uart-tx:N uart-rx:N ssp:N key:N pll:N
+//           usb:N
+//------------------------------------------------------------
+static void LogTimeouts(void)
+{
+        static const char *name[WAIT_SOURCES] =
+                { " adc:", " uart-tx:", " uart-rx:", " ssp:", " key:", " pll:",
+                  " usb:" };
+        static u32 reported;
+        u32 i, prev, total = 0;
+
+        for (i = 0; i < WAIT_SOURCES; i++)
+                total += waitTimeouts[i];
+        if (total == reported)
+                return;
+        reported = total;
+
+        prev = UARTSelect(UART_BULK);
+        SeqLogBegin();
+        UARTTxStr("[WAIT]");
+        for (i = 0; i < WAIT_SOURCES; i++)
+        {
+                UARTTxStr((s8 *)name[i]);
+                UARTTxU32(waitTimeouts[i]);
+        }
+        SeqLogEnd();
+        UARTSelect(prev);
+}
+
+//------------------------------------------------------------
+// Function: LogRate
+// Purpose : Send the rate scheduler state via the bulk UART
+//           at start-up and after a level change
+// Format  : [RATE] L:N hz:N log:Ns up:N down:N held:N
+//           t:S0/S1/../Sn clk:PERF|LOW @HH:MM:SS.mmm DD/MM/YYYY
+//           (Sx -> seconds spent at level x)
+//------------------------------------------------------------
+static void LogRate(void)
+{
+        u32 i, prev = UARTSelect(UART_BULK);
+
+        SeqLogBegin();
+        UARTTxStr("[RATE] L:");
+        UARTTxU32(rateStats.level);
+        UARTTxStr(" hz:");
+        UARTTxU32(rateStats.hz);
+        UARTTxStr(" log:");
+        UARTTxU32(rateStats.logSec);
+        UARTTxStr("s up:");
+        UARTTxU32(rateStats.up);
+        UARTTxStr(" down:");
+        UARTTxU32(rateStats.down);
+        UARTTxStr(" held:");
+        UARTTxU32(rateStats.held);
+        UARTTxStr(" t:");
+        for (i = 0; i < RATE_LEVELS; i++)
+        {
+                if (i)
+                        UARTTxChar('/');
+                UARTTxU32(rateStats.secs[i]);
+        }
+        UARTTxStr(ClockProfile() == CLK_LOW ? " clk:LOW @" : " clk:PERF @");
+        DisplayUARTStamp(&stamp);
+        SeqLogEnd();
+        UARTSelect(prev);
+}
+
+/*------------------------------------------------------------
+Function: ClockFollowRate
+Purpose :
+Runs the CPU from the crystal (CLK_LOW) while the rate
+scheduler is at RATE_CLK_LOW_MAX or below, and with the PLL
+(CLK_PERF) above it. ClockSetProfile brings the UART, ADC,
+timer and RTC dividers up to date.
+NOTE: USB needs CCLK of 18 MHz or more, so with USB_CDC the
+clock stays at CLK_PERF.
+------------------------------------------------------------*/
+static void ClockFollowRate(void)
+{
+#ifndef USB_CDC
+        if (rateStats.level <= RATE_CLK_LOW_MAX)
+                ClockSetProfile(CLK_LOW);
+        else
+#endif
+                ClockSetProfile(CLK_PERF);
+}
+
+//------------------------------------------------------------
+// Function: LogWarn
+// Purpose : Send an early over-temperature warning via the
+//           console UART when the trend reaches the set point
+//           within TREND_WARN_S
+// Format  : [WARN] Temp:X.YC rise:X.YC/min limit in:Ns
+//           @HH:MM:SS.mmm DD/MM/YYYY
+//------------------------------------------------------------
+static void LogWarn(void)
+{
+        u32 prev = UARTSelect(UART_CONSOLE);
+
+        SeqLogBegin();
+        UARTTxStr("[WARN] Temp:");
+        UARTTxTenths(trendStats.fit);
+        UARTTxStr("C rise:");
+        UARTTxTenths(trendStats.rise);
+        UARTTxStr("C/min limit in:");
+        UARTTxU32(trendStats.eta);
+        UARTTxStr("s @");
+        DisplayUARTStamp(&stamp);
+        SeqLogEnd();
+        UARTSelect(prev);
+}
+
+//------------------------------------------------------------
+// Function: LogCapture
+// Purpose : Send a completed alert capture via the bulk UART,
+//           one record per call so the main loop keeps going
+// Format  : [CAPT] CHn id:N hz:R pre:P len:L level:C
+//           @HH:MM:SS.mmm DD/MM/YYYY
+//           then [CAPD] id:N off:K XXXXXX... records of up to
+//           CAP_CHUNK raw counts, 3 hex digits each
+//------------------------------------------------------------
+#define CAP_CHUNK 30
+
+static void LogCapture(void)
+{
+        static const s8 hex[] = "0123456789ABCDEF";
+        static u32 off, started;
+        const PipeCapture *c = PipelineCapture();
+        u32 i, v, prev;
+
+        if (c == 0)
+                return;
+
+        prev = UARTSelect(UART_BULK);
+        SeqLogBegin();
+        if (!started)
+        {
+                UARTTxStr("[CAPT] CH");
+                UARTTxU32(c->ch);
+                UARTTxStr(" id:");
+                UARTTxU32(c->id);
+                UARTTxStr(" hz:");
+                UARTTxU32(c->hz);
+                UARTTxStr(" pre:");
+                UARTTxU32(c->pre);
+                UARTTxStr(" len:");
+                UARTTxU32(c->len);
+                UARTTxStr(" level:");
+                UARTTxU32(c->level);
+                UARTTxStr(" @");
+                DisplayUARTStamp(&c->at);
+                started = 1;
+                off = 0;
+        }
+        else
+        {
+                UARTTxStr("[CAPD] id:");
+                UARTTxU32(c->id);
+                UARTTxStr(" off:");
+                UARTTxU32(off);
+                UARTTxChar(' ');
+                for (i = 0; i < CAP_CHUNK && off < c->len; i++, off++)
+                {
+                        v = c->buf[off];
+                        UARTTxChar(hex[(v >> 8) & 0xF]);
+                        UARTTxChar(hex[(v >> 4) & 0xF]);
+                        UARTTxChar(hex[v & 0xF]);
+                }
+        }
+        SeqLogEnd();
+        UARTSelect(prev);
+
+        if (started && off == c->len)
+        {
+                started = 0;
+                PipelineCaptureDone();
+        }
+}
+
+//------------------------------------------------------------
+// Function: DeadbandPass
+// Purpose : Decide whether a period record is sent
+// Return  : 1 -> send (moved by the deadband, heartbeat due,
+//           first record, or deadband off), 0 -> suppress
+//------------------------------------------------------------
+static u32 DeadbandPass(s32 mean, u32 now)
+{
+        s32 d = mean - dbMean;
+
+        if (config.deadband != 0 && dbValid &&
+            (d < 0 ? -d : d) < (s32)config.deadband &&
+            now - dbSec < config.heartbeat)
+                return 0;
+
+        dbMean = mean;
+        dbSec = now;
+        dbValid = 1;
+        return 1;
+}
+
+//------------------------------------------------------------
+// Function: LcdSink
+// Purpose : Show time, date, day and temperature of a sample;
+//           the calendar fields come from its time stamp
+//------------------------------------------------------------
+static void LcdSink(const Sample *s)
+{
+        u32 t0 = s->at.ctime0, t1 = s->at.ctime1;
+
+        // The edit menus own the display
+        if (edit_flag)
+                return;
+
+        DisplayRTCTime((t0 >> 16) & 0x1F, (t0 >> 8) & 0x3F, t0 & 0x3F);
+        DisplayRTCDate(t1 & 0x1F, (t1 >> 8) & 0x0F, (t1 >> 16) & 0xFFF);
+        DisplayRTCDay((t0 >> 24) & 0x07);
+
+        // Mean temperature of the second, in Celsius
+        TempDisplay(s->rec.mean / 10);
+}
+
+//------------------------------------------------------------
+// Function: TxChannel
+// Purpose : Name the input of a sample not from sensor 0
+// Format  : "CHn " on AD0, "AD1CHn " on AD1
+//------------------------------------------------------------
+static void TxChannel(u32 ch)
+{
+        if (ch == sens.ch[0])
+                return;
+        if (ch & SENS_AD1)
+                UARTTxStr("AD1");
+        UARTTxStr("CH");
+        UARTTxU32(ch & ~SENS_AD1);
+        UARTTxChar(' ');
+}
+
+//------------------------------------------------------------
+// Function: TextSink
+// Purpose : Text records: ALERT seconds on the console, period
+//           records as INFO on the bulk port while within limits
+// Format  : [ALERT] Temp:NC @HH:MM:SS.mmm DD/MM/YYYY-OVER TEMP!
+//           [INFO] Temp:NC @HH:MM:SS.mmm DD/MM/YYYY
+//           with the input before "Temp:" for sensors 1 and up
+//------------------------------------------------------------
+static void TextSink(const Sample *s)
+{
+        u32 prev;
+
+        if (s->kind & BUS_PERIOD)
+        {
+                if (s->kind & BUS_ALERT)
+                        return;
+
+                prev = UARTSelect(UART_BULK);
+                SeqLogBegin();
+                UARTTxStr("[INFO] ");
+                TxChannel(s->ch);
+                UARTTxStr("Temp:");
+                UARTTxDegrees(s->rec.mean);
+                UARTTxStr("C @");
+                DisplayUARTStamp(&s->at);
+                SeqLogEnd();
+                UARTSelect(prev);
+                return;
+        }
+
+        prev = UARTSelect(UART_CONSOLE);
+        SeqLogBegin();
+        UARTTxStr("[ALERT] ");
+        TxChannel(s->ch);
+        UARTTxStr("Temp:");
+        UARTTxDegrees(s->rec.max);
+        UARTTxStr("C @");
+        DisplayUARTStamp(&s->at);
+        UARTTxStr("-OVER TEMP!");
+        SeqLogEnd();
+        UARTSelect(prev);
+}
+
+#ifdef SPI_FLASH_LOG
+//------------------------------------------------------------
+// Function: FlashSink
+// Purpose : Append ALERT seconds and period records to the
+//           flash log
+//------------------------------------------------------------
+static void FlashSink(const Sample *s)
+{
+        LogRec lr;
+
+        lr.time  = s->at.sec;
+        lr.type  = (s->kind & BUS_PERIOD) ? BLK_REC_MINUTE : BLK_REC_ALERT;
+        lr.ch    = s->ch;
+        lr.n     = (s->rec.n > 0xFFFF) ? 0xFFFF : s->rec.n;
+        lr.mean  = s->rec.mean;
+        lr.min   = s->rec.min;
+        lr.max   = s->rec.max;
+        lr.ms    = s->at.us / 1000;
+
+        BlkLogAppend(&lr);
+}
+#endif
+
+//------------------------------------------------------------
+// Function: StatsSink
+// Purpose : Fold each second (in tenths of a degree) into the
+//           minute/hour/day windows and log any that closed
+//------------------------------------------------------------
+static void StatsSink(const Sample *s)
+{
+        u32 i, n;
+
+        n = StatsAddSample(s->ch, s->rec.mean, s->at.sec, statSum);
+        for (i = 0; i < n; i++)
+                LogStatsSummary(&statSum[i], &s->at);
+}
+
+#ifdef SINK_BINARY
+//------------------------------------------------------------
+// Function: TxEscaped
+// Purpose : Send a frame byte; CR, LF and ESC are sent as
+//           ESC, byte ^ 0x20 so the frame stays one line
+//------------------------------------------------------------
+static void TxEscaped(u8 b)
+{
+        if (b == '\r' || b == '\n' || b == SINK_ESC)
+        {
+                UARTTxChar(SINK_ESC);
+                b ^= 0x20;
+        }
+        UARTTxChar(b);
+}
+
+//------------------------------------------------------------
+// Function: BinarySink
+// Purpose : Send period records as compact binary frames on
+//           the bulk port
+// Format  : SINK_SOF, 16 payload bytes, CRC-16 (big endian),
+//           all escaped, then CR LF. Payload, little endian:
+//           kind u8, ch u8, sec u32, ms u16, mean s16,
+//           min s16, max s16, n u16 (tenths of a degree)
+//------------------------------------------------------------
+static void BinarySink(const Sample *s)
+{
+        u8 f[SINK_FRAME_LEN];
+        u32 i, prev, ms = s->at.us / 1000;
+        u32 n = (s->rec.n > 0xFFFF) ? 0xFFFF : s->rec.n;
+        u16 crc;
+
+        f[0]  = s->kind;
+        f[1]  = s->ch;
+        f[2]  = s->at.sec;
+        f[3]  = s->at.sec >> 8;
+        f[4]  = s->at.sec >> 16;
+        f[5]  = s->at.sec >> 24;
+        f[6]  = ms;
+        f[7]  = ms >> 8;
+        f[8]  = s->rec.mean;
+        f[9]  = s->rec.mean >> 8;
+        f[10] = s->rec.min;
+        f[11] = s->rec.min >> 8;
+        f[12] = s->rec.max;
+        f[13] = s->rec.max >> 8;
+        f[14] = n;
+        f[15] = n >> 8;
+        crc = Crc16(f, SINK_FRAME_LEN);
+
+        prev = UARTSelect(UART_BULK);
+        UARTTxChar(SINK_SOF);
+        for (i = 0; i < SINK_FRAME_LEN; i++)
+                TxEscaped(f[i]);
+        TxEscaped(crc >> 8);
+        TxEscaped(crc);
+        UARTTxStr("\r\n");
+        UARTSelect(prev);
+}
+#endif
+
+//------------------------------------------------------------
+// Sinks: kinds taken, rate limit (s), keep newest on overflow
+//------------------------------------------------------------
+static const BusSink lcdSink   = { BUS_SECOND, 0, 1, LcdSink };
+static const BusSink statsSink = { BUS_SECOND, 0, 0, StatsSink };
+static const BusSink textSink  = { BUS_ALERT | BUS_PERIOD, 0, 0, TextSink };
+#ifdef SPI_FLASH_LOG
+static const BusSink flashSink = { BUS_ALERT | BUS_PERIOD, 0, 0, FlashSink };
+#endif
+#ifdef SINK_BINARY
+static const BusSink binSink   = { BUS_PERIOD, SINK_BINARY_GAP_S, 0, BinarySink };
+#endif
+
+//------------------------------------------------------------
+// Function: InitSampleBus
+// Purpose : Attach the display and logging sinks, and report
+//           the starting rate level so that the log states its
+//           period before the first change
+//------------------------------------------------------------
+void InitSampleBus(void)
+{
+        InitBus();
+        BusAttach(&lcdSink);
+        BusAttach(&statsSink);
+        BusAttach(&textSink);
+#ifdef SPI_FLASH_LOG
+        BusAttach(&flashSink);
+#endif
+#ifdef SINK_BINARY
+        BusAttach(&binSink);
+#endif
+
+        GetRTCStamp(&stamp);
+        LogRate();
+}
 
 //------------------------------------------------------------
 // Function: SetInformation
@@ -47,127 +609,234 @@ void SetInformation()
 
 //------------------------------------------------------------
 // Function: DisplayInformation
-// Purpose : Display current RTC info, day, and temperature
-//           on LCD and send alerts/info via UART
+// Purpose : Run the sampling pipeline; once per second check
+//           the set point, adapt the sampling rate and publish
+//           the second on the sample bus, once per log period
+//           publish the period record; then let the sinks
+//           (display, UART, flash, statistics) take their share
 //------------------------------------------------------------
 void DisplayInformation()
 {
-        GetRTCTimeInfo(&hour, &min, &sec);
-        DisplayRTCTime(hour, min, sec);
+        Sample smp;
 
-        GetRTCDateInfo(&date, &month, &year);
-        DisplayRTCDate(date, month, year);
+        // Let the sampling stages do their bounded share of work
+        PipelineRun();
 
-        GetRTCDay(&day);
-        DisplayRTCDay(day);
+        // Scan and log the other sensors when due
+        SensorRun();
 
-        // Read temperature from LM35 sensor in Celsius
-        temp = Read_LM35('C');
-        TempDisplay(temp);
+        // Stream out an alert capture, a record at a time
+        LogCapture();
 
-        // Check against set-point and control outputs
-        if(temp < set_point)
+        smp.ch = sens.ch[0];
+
+        // Alerting and rate control at the decimated rate
+        if(PipelineSecond(&smp.rec))
         {
-                IOSET0 = (1 << 16);  // LED ON
-                IOSET0 = (1 << 17);  // Buzzer ON (or indicator)
+                GetRTCStamp(&stamp);
+
+                // Check the peak of the second so short spikes alert too
+                alert = SensorAlarm(0, smp.rec.max);
+                sens.value[0] = smp.rec.mean;
+                if(alert)
+                        dbValid = 0;         // Report the first record after it
+
+                // Warn while the limit is still ahead but near
+                if(TrendUpdate(smp.rec.mean, sens.setPoint[0]) && !alert)
+                        LogWarn();
+
+                // Indicators follow the alarms of all sensors
+                if(!sens.alarms)
+                {
+                        IOSET0 = (1 << 16);  // LED ON
+                        IOSET0 = (1 << 17);  // Buzzer ON (or indicator)
+                }
+                else
+                {
+                        IOCLR0 = (1 << 16);  // LED OFF
+                        IOCLR0 = 1 << 17;    // Buzzer OFF
+                }
+
+                smp.kind = BUS_SECOND | (alert ? BUS_ALERT : 0);
+                smp.at = stamp;
+                BusPublish(&smp);
 
-                // Periodic UART update every minute
-                if(min == check && sec == SECOND)
-                //if(min == check)
+                // Sample and log faster while close to the limit
+                // and clock the CPU down while far from it
+                if (RateUpdate(&smp.rec, sens.setPoint[0]))
                 {
-                        UARTTxStr("[INFO] ");
-                        UARTTxStr("Temp:");
-                        UARTTxU32(temp);
-                        UARTTxStr("C @");
-                        DisplayUARTTime(hour, min, sec);
-                        DisplayUARTDate(date, month, year);
-                        UARTTxStr("\r\n");
-
-                        check++;
-                        if(check > 59)
-                                check = 0;
+                        ClockFollowRate();
+                        LogRate();
                 }
         }
-        else
+
+        // One aggregated record per log period, unless the
+        // deadband holds it back
+        if(PipelineMinute(&smp.rec))
         {
-                IOCLR0 = (1 << 16);  // LED OFF
-                IOCLR0 = 1 << 17;    // Buzzer OFF
+                GetRTCStamp(&stamp);
+                if(DeadbandPass(smp.rec.mean, stamp.sec))
+                {
+                        smp.kind = BUS_PERIOD | (alert ? BUS_ALERT : 0);
+                        smp.at = stamp;
+                        BusPublish(&smp);
+                }
 
-                UARTTxStr("[ALERT] ");
-                UARTTxStr("Temp:");
-                UARTTxU32(temp);
-                UARTTxStr("C @");
-                DisplayUARTTime(hour, min, sec);
-                DisplayUARTDate(date, month, year);
-                UARTTxStr("-OVER TEMP!\r\n");
+                // Peripheral waits that gave up during the period
+                LogTimeouts();
         }
+
+        BusService();
 }
 
 //------------------------------------------------------------
-// Function: EditMode
-// Purpose : Display menu for editing RTC and set-point
-//           Allows user to select option via keypad
+// Function: EditKey
+// Purpose : Wait condition of the edit threads: a key stroke,
+//           or EDIT_IDLE_MS since editDl was set
+// Return  : 1 -> editKey holds a key, or editIdle is set
 //------------------------------------------------------------
-void EditMode()
+static u32 EditKey(void)
 {
-        // Display menu on LCD
+        if (KeyPoll(&editKey))
+                return 1;
+        if (DeadlinePassed(editDl))
+        {
+                editIdle = 1;      // caller must drop the edit
+                return 1;
+        }
+        return 0;
+}
+
+//------------------------------------------------------------
+// Function: EditMenu
+// Purpose : Show the edit menu
+//------------------------------------------------------------
+static void EditMenu(void)
+{
+        CmdLCD(0x80);
         StrLCD("1.EDIT RTC INFO");
         CmdLCD(0xC0);
         StrLCD("2.SET POINT");
         CmdLCD(0xCB);
         StrLCD("3.EXIT");
+}
+
+//------------------------------------------------------------
+// Function: EditThread
+// Purpose : Edit menu: run the chosen sub-menu, leave on EXIT
+//           or once idle here or in a sub-menu
+//------------------------------------------------------------
+static u8 EditThread(Pt *p)
+{
+        PT_BEGIN(p);
+
+        editIdle = 0;
+        CmdLCD(0x01);
+        EditMenu();
 
         UARTTxStr("***Time editing Mode Activated***\r\n");
 
         while(1)
         {
-                while(ColStat());       // wait for key press
-                delay_ms(10);           // debounce
-                choice = KeyVal();      // get user choice
-                while(!ColStat());      // wait for key release
+                EDIT_WAIT_KEY(p);
+                if(editIdle || editKey == 3)
+                        break;
+
+                if(editKey == 1)
+                        PT_SPAWN(p, &subPt, RTCedit(&subPt));
+                else if(editKey == 2)
+                        PT_SPAWN(p, &subPt, EditSetPoint(&subPt));
+                else
+                        continue;
 
-                switch(choice)
-                {
-                        case 1:
-                                RTCedit();
-                                // Redisplay menu
-                                CmdLCD(0x01); CmdLCD(0x80);
-                                StrLCD("1.EDIT RTC INFO");
-                                CmdLCD(0xC0);
-                                StrLCD("2.SET POINT");
-                                CmdLCD(0xCB);
-                                StrLCD("3.EXIT");
-                                break;
-
-                        case 2:
-                                EditSetPoint();
-                                // Redisplay menu
-                                CmdLCD(0x01); CmdLCD(0x80);
-                                StrLCD("1.EDIT RTC INFO");
-                                CmdLCD(0xC0);
-                                StrLCD("2.SET POINT");
-                                CmdLCD(0xCB);
-                                StrLCD("3.EXIT");
-                                break;
-
-                        case 3:
-                                edit_flag = 0;       // Exit edit mode
-                                return;
-
-                        default:
-                                break;
-                }
+                if(editIdle)
+                        break;
+
+                // Redisplay menu
+                CmdLCD(0x01);
+                EditMenu();
+        }
+
+        CmdLCD(0x01);
+        edit_flag = 0;             // Exit edit mode
+
+        PT_END(p);
+}
+
+//------------------------------------------------------------
+// Function: EditMode
+// Purpose : Run the edit menu for one step; clears edit_flag
+//           once it is left
+//------------------------------------------------------------
+void EditMode(void)
+{
+        EditThread(&editPt);
+}
+
+//------------------------------------------------------------
+// Function: RTCFieldSet
+// Purpose : Store an entered value in RTC field 1..7 if it is
+//           valid for the current date
+// Return  : 1 -> stored, 0 -> rejected
+//------------------------------------------------------------
+static u32 RTCFieldSet(u32 field, u32 v)
+{
+        switch(field)
+        {
+                case 1: if(v >= 24) return 0; HOUR = v; break;
+                case 2: if(v >= 60) return 0; MIN = v; break;
+                case 3: if(v >= 60) return 0; SEC = v; break;
+
+                case 4: // Date must exist in this month
+                        if(v < 1 || v > GetMaxDays(MONTH, YEAR))
+                                return 0;
+                        DOM = v;
+                        break;
+
+                case 5: // Month must hold the current date
+                        if(v < 1 || v > 12 || DOM > GetMaxDays(v, YEAR))
+                                return 0;
+                        MONTH = v;
+                        break;
+
+                case 6: // Year in RTC range, holding the current date (29/02)
+                        if(v < RTC_YEAR_MIN || v > RTC_YEAR_MAX ||
+                           DOM > GetMaxDays(MONTH, v))
+                                return 0;
+                        YEAR = v;
+                        break;
+
+                case 7: if(v > 6) return 0; DOW = v; break;
+
+                default:
+                        return 0;
         }
+        return 1;
 }
 
+//------------------------------------------------------------
+// RTC edit prompts and rejection messages, fields 1..7
+//------------------------------------------------------------
+static u8 *const rtcPrompt[7] =
+{
+        (u8 *)"Enter hour: ", (u8 *)"Enter minute:", (u8 *)"Enter second:",
+        (u8 *)"Enter date:", (u8 *)"Enter month:", (u8 *)"Enter year: ",
+        (u8 *)"Enter day:"
+};
+static u8 *const rtcReject[7] =
+{
+        (u8 *)"INVALID INPUT", (u8 *)"INVALID INPUT", (u8 *)"INVALID INPUT",
+        (u8 *)"NOT UPDATED", (u8 *)"INVALID INPUT", (u8 *)"NOT UPDATED",
+        (u8 *)"NOT UPDATED"
+};
+
 //------------------------------------------------------------
 // Function: RTCedit
 // Purpose : Edit RTC time/date/day via keypad input
 //------------------------------------------------------------
-void RTCedit(void)
+u8 RTCedit(Pt *p)
 {
-        unsigned char choice1;
-        unsigned int value;
+        PT_BEGIN(p);
 
         // Display RTC edit menu
         CmdLCD(0x80);
@@ -177,201 +846,104 @@ void RTCedit(void)
 
         while(1)
         {
-                while(ColStat());      // wait for key press
-                choice1 = KeyVal();    // read key
-                delay_ms(10);          // debounce
-                while(!ColStat());     // wait for release
+                EDIT_WAIT_KEY(p);
+                if(editIdle || editKey == 8)
+                        PT_EXIT(p);        // idle: give up editing
+
+                rtcField = editKey;
                 CmdLCD(0x01);          // clear LCD
 
-                switch(choice1)
+                if(rtcField >= 1 && rtcField <= 7)
                 {
-                        case 1: // Hour
-                                StrLCD("Enter hour: ");
-                                value = ReadNumber();
-                                if(value < 24)
-                                        HOUR = value;
-                                else
-                                {
-                                        CmdLCD(0x01);
-                                        StrLCD("INVALID INPUT");
-                                }
-                                break;
-
-                        case 2: // Minute
-                                StrLCD("Enter minute:");
-                                value = ReadNumber();
-                                if(value < 60)
-                                        MIN = value;
-                                else
-                                {
-                                        CmdLCD(0x01);
-                                        StrLCD("INVALID INPUT");
-                                }
-                                break;
-
-                        case 3: // Second
-                                StrLCD("Enter second:");
-                                value = ReadNumber();
-                                if(value < 60)
-                                        SEC = value;
-                                else
-                                {
-                                        CmdLCD(0x01);
-                                        StrLCD("INVALID INPUT");
-                                }
-                                break;
-
-                        case 4: // Date
-                                StrLCD("Enter date:");
-                                value = ReadNumber();
-                                if(value >= 1 && value <= GetMaxDays(MONTH, YEAR))
-                                        DOM = value;
-                                else
-                                {
-                                        CmdLCD(0x01);
-                                        StrLCD("NOT UPDATED");
-                                        delay_ms(300);
-                                }
-                                break;
-
-                        case 5: // Month
-                                StrLCD("Enter month:");
-                                value = ReadNumber();
-                                if(value >= 1 && value <= 12)
-                                {
-                                        if(DOM <= GetMaxDays(value, YEAR))
-                                                MONTH = value;
-                                        else
-                                                goto DOWN;
-                                }
-                                else
-                                DOWN: {
-                                                                CmdLCD(0x01);
-                                                                StrLCD("INVALID INPUT");
-                                                                delay_ms(300);
-                                                        }
-                                break;
-
-                        case 6: // Year
-                                StrLCD("Enter year: ");
-                                value = ReadNumber();
-                //      if(value >=1000 && value <= 2099)   // Accept only 4-digit year
-
-                                if(DOM <= GetMaxDays(MONTH, value))
-                                        YEAR = value;
-                else
-                                {
-                                        CmdLCD(0x01);
-                                        StrLCD("NOT UPDATED");
-                                        delay_ms(300);
-                                }
-                                break;
-
-                        case 7: // Day of week
-                                StrLCD("Enter day:");
-                                value = ReadNumber();
-                                if(value <= 6)
-                                        DOW = value;
-                                else
-                                {
-                                        CmdLCD(0x01);
-                                        StrLCD("NOT UPDATED");
-                                        delay_ms(300);
-                                }
-
-                                break;
-
-                        case 8: // Exit
-                                return;
-
-                        default:
-                                break;
+                        StrLCD(rtcPrompt[rtcField - 1]);
+                        PT_SPAWN(p, &numPt, ReadNumber(&numPt));
+                        if(editIdle)
+                                PT_EXIT(p);
+
+                        if(!RTCFieldSet(rtcField, value))
+                        {
+                                CmdLCD(0x01);
+                                StrLCD(rtcReject[rtcField - 1]);
+                                PT_DELAY_MS(p, editDl, 300);
+                        }
                 }
 
                 // Redisplay menu after each edit
-                delay_ms(1000);
+                PT_DELAY_MS(p, editDl, 1000);
                 CmdLCD(0x80); StrLCD("1.H 2.M 3.S 4.D");
                 CmdLCD(0xC0); StrLCD("5.M 6.Y 7.DY8.E");
         }
+
+        PT_END(p);
 }
 
 //------------------------------------------------------------
 // Function: ReadNumber
 // Purpose : Read multi-digit numeric input from keypad
-// Return  : Entered number as u32
+//           into value
 //------------------------------------------------------------
-u32 ReadNumber(void)
+u8 ReadNumber(Pt *p)
 {
-        u8 key;
-        u32 num = 0, count;
+        PT_BEGIN(p);
+
+        numVal = 0;
+        numCount = 0;
 
         while(1)
         {
-                while(ColStat());     // wait for key press
-                delay_ms(10);
-                key = KeyVal();       // read key
-                while(!ColStat());    // wait for release
+                EDIT_WAIT_KEY(p);
+                if(editIdle)
+                {
+                        value = 0;        // caller must drop the value
+                        PT_EXIT(p);
+                }
 
-                if(key == 14) break;  // CONFIRM key pressed
+                if(editKey == 14) break;  // CONFIRM key pressed
 
-                if(key <= 9)           // numeric key
+                if(editKey <= 9)           // numeric key
                 {
-                        count++;
-                        num = num * 10 + key;
-                        CharLCD(key + '0'); // display digit
+                        numCount++;
+                        numVal = numVal * 10 + editKey;
+                        CharLCD(editKey + '0'); // display digit
                 }
 
-                if(key == 15 && count > 0) // BACKSPACE key
+                if(editKey == 15 && numCount > 0) // BACKSPACE key
                 {
-                        num /= 10;
-                        count--;
+                        numVal /= 10;
+                        numCount--;
                         CmdLCD(0x10); CharLCD(' '); CmdLCD(0x10);
                 }
         }
 
-        delay_ms(300);
-        return num;
+        PT_DELAY_MS(p, editDl, 300);
+        value = numVal;
+
+        PT_END(p);
 }
 
 //------------------------------------------------------------
 // Function: EditSetPoint
 // Purpose : Update temperature set-point via keypad
 //------------------------------------------------------------
-void EditSetPoint(void)
+u8 EditSetPoint(Pt *p)
 {
+        PT_BEGIN(p);
+
         CmdLCD(0x01);
         StrLCD("SET TEMP LIM:");
-        set_point = ReadNumber();
+        PT_SPAWN(p, &numPt, ReadNumber(&numPt));
+        if(editIdle)
+                PT_EXIT(p);
+        SensorSetPoint(0, value * 10);
+        PipelineSetTrigger(sens.setPoint[0]);
         CmdLCD(0x01);
-        StrLCD("LIMIT UPDATED");
-        delay_ms(800);
-}
 
-//------------------------------------------------------------
-// Function: GetMaxDays
-// Purpose : Return maximum days in a month considering leap year
-//------------------------------------------------------------
-u8 GetMaxDays(u32 m, u32 y)
-{
-        switch(m)
-        {
-                case 1: case 3: case 5: case 7:
-                case 8: case 10: case 12: return 31;
-                case 4: case 6: case 9: case 11: return 30;
-                case 2: return IsLeapYear(y) ? 29 : 28;
-                default: return 31;
-        }
-}
+        // Keep the new limit across resets; the main loop
+        // writes it to flash when nothing time-critical runs
+        config.setPoint = sens.setPoint[0] / 10;
+        ConfigSaveLater();
+        StrLCD("LIMIT UPDATED");
+        PT_DELAY_MS(p, editDl, 800);
 
-//------------------------------------------------------------
-// Function: IsLeapYear
-// Purpose : Check if given year is a leap year
-// Return  : 1 -> Leap year, 0 -> Not a leap year
-//------------------------------------------------------------
-u8 IsLeapYear(u32 y)
-{
-        if((y % 400) == 0) return 1;
-        if((y % 100) == 0) return 0;
-        if((y % 4) == 0)   return 1;
-        return 0;
+        PT_END(p);
 }
@@ -7,10 +7,15 @@ temperature, and set-point information for LPC21xx.
 
 This file provides:
 - Function prototypes for displaying and editing RTC and temperature
-- Utility functions for numeric input and date validation
+- Utility function for numeric input
+- The edit flows as protothreads, so they never block the
+  main loop
+
+Date validation uses GetMaxDays/IsLeapYear from rtc.h.
 ------------------------------------------------------------*/
 
 #include "types.h"   // User-defined data types
+#include "pt.h"      // Protothreads for the edit menu
 
 //------------------------------------------------------------
 // Function Prototypes
@@ -18,11 +23,19 @@ This file provides:
 
 //------------------------------------------------------------
 // Function: DisplayInformation
-// Purpose : Display current RTC time, date, day, and temperature
-//           on LCD and send updates via UART if required
+// Purpose : Publish the current temperature records on the
+//           sample bus and service its sinks
 //------------------------------------------------------------
 void DisplayInformation(void);
 
+//------------------------------------------------------------
+// Function: InitSampleBus
+// Purpose : Attach the LCD, UART, flash and statistics sinks
+//           to the sample bus and send the starting [RATE]
+//           record
+//------------------------------------------------------------
+void InitSampleBus(void);
+
 //------------------------------------------------------------
 // Function: SetInformation
 // Purpose : Initialize RTC with default time, date, and day
@@ -31,47 +44,33 @@ void SetInformation(void);
 
 //------------------------------------------------------------
 // Function: EditMode
-// Purpose : Provide menu interface for editing RTC info and
-//           temperature set-point using keypad
+// Purpose : Run one step of the keypad menu for editing RTC
+//           info and the temperature set-point; call on every
+//           main loop pass while edit_flag is set, it clears
+//           edit_flag once the menu is left
 //------------------------------------------------------------
 void EditMode(void);
 
+//------------------------------------------------------------
+// Protothreads of the edit menu (spawned by EditMode)
+//------------------------------------------------------------
+
 //------------------------------------------------------------
 // Function: ReadNumber
-// Purpose : Read multi-digit numeric input from keypad
-// Return  : Entered number as u32
+// Purpose : Read multi-digit numeric input from keypad into
+//           value (0 if edit mode went idle)
 //------------------------------------------------------------
-u32 ReadNumber(void);
+u8 ReadNumber(Pt *p);
 
 //------------------------------------------------------------
 // Function: RTCedit
 // Purpose : Edit individual RTC fields (hour, minute, second,
 //           date, month, year, day) via keypad input
 //------------------------------------------------------------
-void RTCedit(void);
+u8 RTCedit(Pt *p);
 
 //------------------------------------------------------------
 // Function: EditSetPoint
 // Purpose : Update temperature set-point via keypad input
 //------------------------------------------------------------
-void EditSetPoint(void);
-
-//------------------------------------------------------------
-// Function: GetMaxDays
-// Purpose : Return maximum days in a given month considering
-//           leap year
-// Parameters:
-//   m -> Month (112)
-//   y -> Year (4-digit)
-// Return : Maximum number of days in the month
-//------------------------------------------------------------
-u8 GetMaxDays(u32 m, u32 y);
-
-//------------------------------------------------------------
-// Function: IsLeapYear
-// Purpose : Check if a given year is a leap year
-// Parameter:
-//   y -> Year (4-digit)
-// Return : 1 -> Leap year, 0 -> Not a leap year
-//------------------------------------------------------------
-u8 IsLeapYear(u32 y);
+u8 EditSetPoint(Pt *p);
@@ -0,0 +1,243 @@
+//blklog_bench.c
+/*------------------------------------------------------------
+File: blklog_bench.c
+Purpose:
+Host benchmark for the flash append log.
+
+Runs the firmware's log (blklog.c) on a disk image
+(blkdev_file.c) with the virtual RTC (rtc_sim.c) as its time
+base, and measures what the SPI flash log costs:
+
+- Write throughput: records appended and sectors written per
+  wall-clock second, with BlkLogService() after every record
+  as from the main loop
+- Recovery time: InitBlkLog() after a reset with the write
+  position at several points of the ring, including a
+  wrapped one; reports sectors read and time taken, and
+  checks the position found
+- Seal timeout: a single record is written to the device
+  once BLK_SEAL_S has passed, and not before
+- Seal when full: a sector is written as soon as its last
+  record is in, without waiting for another record or the
+  timeout
+
+Exit status is 1 if any check failed.
+
+Build:
+cc -O2 -Wall -DHOST_BUILD -I../TYPES -I../BLKLOG -I../CRC -I../RTC -o blklog_bench blklog_bench.c ../BLKLOG/blklog.c ../BLKLOG/blkdev_file.c ../CRC/crc.c ../RTC/rtc_cal.c ../RTC/rtc_sim.c
+
+Usage:
+blklog_bench [-i image] [-s sectors] [-n records]
+  image   : image file, recreated (default blklog.img)
+  sectors : device size (default FLASH_SIZE / BLK_SECTOR_SIZE)
+  records : records for the throughput run (default 1000000)
+------------------------------------------------------------*/
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "types.h"
+#include "blkdev.h"
+#include "blklog.h"
+#include "blklog_defines.h"
+#include "rtc.h"
+
+static unsigned fails;
+
+//------------------------------------------------------------
+// Function: WallSeconds
+// Purpose : Monotonic wall-clock time
+//------------------------------------------------------------
+static double WallSeconds(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//------------------------------------------------------------
+// Function: Append
+// Purpose : Append n minute records, serviced as in main()
+// Return  : Records dropped
+//------------------------------------------------------------
+static u32 Append(u32 n)
+{
+        LogRec r;
+        u32 i, dropped = 0;
+
+        memset(&r, 0, sizeof(r));
+        r.type = BLK_REC_MINUTE;
+        r.ch = 1;
+        for (i = 0; i < n; i++)
+        {
+                r.time = GetRTCSeconds();
+                r.mean = r.min = r.max = (s16)(i & 0x3FF);
+                if (!BlkLogAppend(&r))
+                        dropped++;
+                BlkLogService();
+        }
+        BlkLogService();
+        BlkLogService();
+        return dropped;
+}
+
+//------------------------------------------------------------
+// Function: Throughput
+//------------------------------------------------------------
+static void Throughput(u32 n)
+{
+        u32 dropped;
+        double wall;
+
+        InitBlkLog(&blkDevFile);
+        wall = WallSeconds();
+        dropped = Append(n);
+        wall = WallSeconds() - wall;
+
+        printf("write   : %lu records, %lu sectors in %.3f s: %.0f records/s, %.2f MB/s, %lu dropped\n",
+               (unsigned long)n, (unsigned long)blkLogStats.written, wall, n / wall,
+               blkLogStats.written * (double)BLK_SECTOR_SIZE / wall / 1e6,
+               (unsigned long)dropped);
+        if (dropped)
+        {
+                printf("FAIL records dropped with a synchronous device\n");
+                fails++;
+        }
+}
+
+//------------------------------------------------------------
+// Function: Recovery
+// Purpose : Reset with the ring filled to a given sector and
+//           time InitBlkLog
+//------------------------------------------------------------
+static void Recovery(u32 sectors, u32 target)
+{
+        u32 head, seq, reads;
+        double wall;
+
+        // Sectors written so far are kept; go on until head
+        // reaches the target, wrapping if needed
+        InitBlkLog(&blkDevFile);
+        do
+                Append(BLK_RECS_PER_SEC);
+        while (blkLogStats.head != target % sectors);
+        head = blkLogStats.head;
+        seq = blkLogStats.seq;
+
+        wall = WallSeconds();
+        InitBlkLog(&blkDevFile);
+        wall = WallSeconds() - wall;
+        reads = blkLogStats.scanReads;
+
+        printf("recover : head %5lu seq %6lu: %2lu sectors read, %7.1f us %s\n",
+               (unsigned long)head, (unsigned long)seq, (unsigned long)reads,
+               wall * 1e6,
+               (blkLogStats.head == head && blkLogStats.seq == seq) ? "ok" : "FAIL");
+        if (blkLogStats.head != head || blkLogStats.seq != seq)
+                fails++;
+}
+
+//------------------------------------------------------------
+// Function: SealTimeout
+// Purpose : One record must reach the device after
+//           BLK_SEAL_S, not before
+//------------------------------------------------------------
+static void SealTimeout(void)
+{
+        u32 head, early, late;
+
+        InitBlkLog(&blkDevFile);
+        head = blkLogStats.head;
+        Append(1);
+
+        RTCSimAdvance((BLK_SEAL_S - 1) * 1000000);
+        BlkLogService();
+        BlkLogService();
+        early = blkLogStats.written;
+
+        RTCSimAdvance(1000000);
+        BlkLogService();
+        BlkLogService();
+        late = blkLogStats.written;
+
+        InitBlkLog(&blkDevFile);
+        printf("seal    : 1 record written after %u s: %s\n", BLK_SEAL_S,
+               (early == 0 && late == 1 && blkLogStats.head != head) ? "ok" : "FAIL");
+        if (early != 0 || late != 1 || blkLogStats.head == head)
+                fails++;
+}
+
+//------------------------------------------------------------
+// Function: SealFull
+// Purpose : A full sector must reach the device with no
+//           further record and no time passing
+//------------------------------------------------------------
+static void SealFull(void)
+{
+        InitBlkLog(&blkDevFile);
+        Append(BLK_RECS_PER_SEC);
+
+        printf("seal    : full sector written at once: %s\n",
+               blkLogStats.written == 1 ? "ok" : "FAIL");
+        if (blkLogStats.written != 1)
+                fails++;
+}
+
+//------------------------------------------------------------
+// Function: main
+//------------------------------------------------------------
+int main(int argc, char **argv)
+{
+        const char *path = "blklog.img";
+        unsigned long sectors = FLASH_SIZE / BLK_SECTOR_SIZE, n = 1000000;
+        int i;
+
+        for (i = 1; i < argc; i++)
+        {
+                if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+                        path = argv[++i];
+                else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+                        sectors = strtoul(argv[++i], NULL, 10);
+                else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+                        n = strtoul(argv[++i], NULL, 10);
+                else
+                        break;
+        }
+        if (i < argc || sectors < 4 || n == 0)
+        {
+                fprintf(stderr, "usage: %s [-i image] [-s sectors] [-n records]\n", argv[0]);
+                return 2;
+        }
+
+        remove(path);
+        if (!BlkDevFileOpen(path, sectors))
+        {
+                fprintf(stderr, "%s: cannot create %s\n", argv[0], path);
+                return 2;
+        }
+
+        RTC_Init();
+        SetRTCDateInfo(1, 1, 2025);
+        InitRTCStamp();
+
+        //----------------------------------------------------------
+        // Recovery on a fresh image first, at a few fill levels
+        // and once the ring has wrapped
+        //----------------------------------------------------------
+        Recovery(sectors, 1);
+        Recovery(sectors, sectors / 3);
+        Recovery(sectors, sectors - 1);
+        Recovery(sectors, sectors + sectors / 2);
+
+        SealTimeout();
+        SealFull();
+        Throughput(n);
+
+        remove(path);
+        printf("%u check(s) failed\n", fails);
+        return fails ? 1 : 0;
+}
@@ -0,0 +1,835 @@
+//collector.c
+/*------------------------------------------------------------
+File: collector.c
+Purpose:
+Host (Linux) daemon that collects the serial log of many
+data loggers into one rotating local archive.
+
+Features:
+- Any number of serial ports, all non-blocking on one epoll
+- Optional pseudo-terminals as local stand-ins for ports
+- Splits the stream into records: text lines such as
+  [INFO]/[ALERT]/[STAT], or escaped binary data
+- Records are batched in memory and written with one large
+  write() per batch to <prefix>.<NNNNNN>.log
+- Archive rotates when a file reaches the size limit
+- Throughput and latency counters printed periodically,
+  on SIGUSR1, and optionally written to a stats file
+- Checks the " #seq*CRC" trailer of each record, drops bad
+  or duplicate copies and asks the device for missing ones
+  with "NAK a b" (retried every second, up to NAK_RETRIES)
+
+Archive line format:
+<unix time ms> <port index> <record text>
+
+Build:
+cc -O2 -Wall -o collector collector.c
+
+Usage:
+collector [-o prefix] [-r rotate_MB] [-b baud] [-i secs]
+          [-S statsfile] [-p n_ptys] [port ...]
+------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+//------------------------------------------------------------
+// Limits and defaults
+//------------------------------------------------------------
+#define MAX_PORTS      1024
+#define LINE_MAX_LEN   512             // Longer lines are split
+#define READ_CHUNK     65536
+#define BATCH_SIZE     (1024*1024)     // Archive buffer
+#define BATCH_FLUSH    (256*1024)      // Flush when this full
+#define DEF_ROTATE_MB  64
+#define DEF_INTERVAL   10              // Stats period (seconds)
+#define MISS_WINDOW    64              // Missing records tracked per port
+#define NAK_RETRIES    3               // Requests before giving up
+
+//------------------------------------------------------------
+// Record classes counted separately
+//------------------------------------------------------------
+enum { REC_INFO, REC_ALERT, REC_STAT, REC_OTHER, REC_BINARY, REC_CLASSES };
+static const char *recName[REC_CLASSES] =
+        { "info", "alert", "stat", "other", "binary" };
+
+//------------------------------------------------------------
+// One input port
+//------------------------------------------------------------
+typedef struct
+{
+        int  fd;                       // -1 while disconnected
+        char path[128];                // Device (or pty slave) name
+        char line[LINE_MAX_LEN];       // Partial record
+        int  len;                      // Bytes in line[]
+        int  binary;                   // Partial record has binary bytes
+        int  isPty;                    // Stand-in port, never reopened
+        unsigned long long lineStart;  // Arrival time of first byte (us)
+        int  seqValid;                 // A numbered record was seen
+        unsigned expect;               // Next sequence number expected
+        unsigned missLo;               // Sequence of bit 0 of missMask
+        unsigned long long missMask;   // Bit i -> missLo+i still missing
+        int  nakTries;                 // Requests sent for current gap
+        unsigned long long nakAt;      // Time of last request (us)
+} Port;
+
+//------------------------------------------------------------
+// Counters
+//------------------------------------------------------------
+typedef struct
+{
+        unsigned long long bytesIn;
+        unsigned long long bytesOut;
+        unsigned long long records[REC_CLASSES];
+        unsigned long long writes;
+        unsigned long long latSum;     // Sum of record latencies (us)
+        unsigned long long latMax;     // Worst record latency (us)
+        unsigned long long latCount;
+        unsigned long long rotations;
+        unsigned long long reopens;
+        unsigned long long crcErrors;  // Records failing the CRC
+        unsigned long long gaps;       // Records found missing
+        unsigned long long naks;       // Resend requests sent
+        unsigned long long recovered;  // Missing records received
+        unsigned long long lost;       // Given up or reported [GONE]
+        unsigned long long dups;       // Copies already archived
+        unsigned long long resets;     // Numbering restarted at 0
+} Counters;
+
+static Port ports[MAX_PORTS];
+static int nPorts;
+static Counters cnt, cntLast;
+
+//------------------------------------------------------------
+// Archive state
+//------------------------------------------------------------
+static char *batch;
+static size_t batchLen;
+static unsigned long long batchOldest;  // Arrival of oldest record
+static unsigned long long batchRecs;    // Records in the batch
+static unsigned long long batchArrSum;  // Sum of their arrival times
+static const char *prefix = "archive";
+static unsigned long long rotateBytes = (unsigned long long)DEF_ROTATE_MB << 20;
+static int archFd = -1;
+static unsigned long long archSize;
+static unsigned archIndex;
+
+static const char *statsPath;
+static volatile sig_atomic_t dumpStats, stopNow;
+static speed_t baud = B9600;
+
+//------------------------------------------------------------
+// Function: NowUs
+// Purpose : Monotonic time in microseconds
+//------------------------------------------------------------
+static unsigned long long NowUs(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (unsigned long long)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+//------------------------------------------------------------
+// Function: WallMs
+// Purpose : Wall clock time in milliseconds (archive stamp)
+//------------------------------------------------------------
+static unsigned long long WallMs(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return (unsigned long long)ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+//------------------------------------------------------------
+// Function: OpenArchive
+// Purpose : Open the next archive file in sequence
+//------------------------------------------------------------
+static void OpenArchive(void)
+{
+        char name[512];
+
+        if (archFd >= 0)
+        {
+                close(archFd);
+                cnt.rotations++;
+        }
+
+        for (;;)
+        {
+                snprintf(name, sizeof(name), "%s.%06u.log", prefix, archIndex++);
+                archFd = open(name, O_WRONLY | O_CREAT | O_EXCL | O_APPEND, 0644);
+                if (archFd >= 0 || errno != EEXIST)
+                        break;
+        }
+
+        if (archFd < 0)
+        {
+                perror(name);
+                exit(1);
+        }
+        archSize = 0;
+}
+
+/*------------------------------------------------------------
+Function: FlushBatch
+Purpose :
+Writes the whole batch with as few write() calls as the
+kernel allows and folds its latency into the counters.
+Latency of a record = time from its first byte arriving to
+the batch holding it being handed to the kernel.
+------------------------------------------------------------*/
+static void FlushBatch(void)
+{
+        size_t off = 0;
+        ssize_t n;
+        unsigned long long now, lat;
+
+        if (batchLen == 0)
+                return;
+
+        if (archFd < 0 || archSize + batchLen > rotateBytes)
+                OpenArchive();
+
+        while (off < batchLen)
+        {
+                n = write(archFd, batch + off, batchLen - off);
+                if (n < 0)
+                {
+                        if (errno == EINTR)
+                                continue;
+                        perror("archive write");
+                        exit(1);
+                }
+                off += n;
+                cnt.writes++;
+        }
+
+        now = NowUs();
+        lat = now - batchOldest;
+        if (lat > cnt.latMax)
+                cnt.latMax = lat;
+        cnt.latSum += now * batchRecs - batchArrSum;
+        cnt.latCount += batchRecs;
+
+        cnt.bytesOut += batchLen;
+        archSize += batchLen;
+        batchLen = 0;
+        batchRecs = 0;
+        batchArrSum = 0;
+}
+
+//------------------------------------------------------------
+// Function: Classify
+// Purpose : Pick the counter class of a text record
+//------------------------------------------------------------
+static int Classify(const char *s, int len)
+{
+        if (len >= 6 && memcmp(s, "[INFO]", 6) == 0)  return REC_INFO;
+        if (len >= 7 && memcmp(s, "[ALERT]", 7) == 0) return REC_ALERT;
+        if (len >= 6 && memcmp(s, "[STAT]", 6) == 0)  return REC_STAT;
+        return REC_OTHER;
+}
+
+/*------------------------------------------------------------
+Function: EmitRecord
+Purpose :
+Appends one finished record to the batch. Bytes outside
+printable ASCII are written as \xNN so the archive stays one
+record per line.
+------------------------------------------------------------*/
+static void EmitRecord(int idx, Port *p)
+{
+        static const char hex[] = "0123456789abcdef";
+        unsigned char c;
+        char *o;
+        int i;
+
+        if (p->len == 0)
+                return;
+
+        if (batchLen + 32 + (size_t)p->len * 4 + 1 > BATCH_SIZE)
+                FlushBatch();
+
+        if (batchRecs == 0)
+                batchOldest = p->lineStart;
+        batchRecs++;
+        batchArrSum += p->lineStart;
+
+        o = batch + batchLen;
+        o += sprintf(o, "%llu %d ", WallMs(), idx);
+        for (i = 0; i < p->len; i++)
+        {
+                c = p->line[i];
+                if (c >= 0x20 && c < 0x7F && c != '\\')
+                        *o++ = c;
+                else
+                {
+                        *o++ = '\\';
+                        *o++ = 'x';
+                        *o++ = hex[c >> 4];
+                        *o++ = hex[c & 15];
+                }
+        }
+        *o++ = '\n';
+        batchLen = o - batch;
+
+        cnt.records[p->binary ? REC_BINARY : Classify(p->line, p->len)]++;
+        p->len = 0;
+        p->binary = 0;
+
+        if (batchLen >= BATCH_FLUSH)
+                FlushBatch();
+}
+
+//------------------------------------------------------------
+// Function: Crc16
+// Purpose : CRC-16/CCITT (poly 0x1021, init 0xFFFF) as sent
+//           by the device in the record trailer
+//------------------------------------------------------------
+static unsigned Crc16(const unsigned char *buf, int len)
+{
+        unsigned crc = 0xFFFF;
+        int i;
+
+        while (len--)
+        {
+                crc ^= (unsigned)*buf++ << 8;
+                for (i = 0; i < 8; i++)
+                        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+        return crc & 0xFFFF;
+}
+
+/*------------------------------------------------------------
+Function: ParseTrailer
+Purpose :
+Finds " #<seq>*<XXXX>" at the end of a record.
+Return  : 1 -> numbered record, CRC good
+          0 -> no trailer (unnumbered line)
+         -1 -> trailer present but CRC does not match
+------------------------------------------------------------*/
+static int ParseTrailer(const char *s, int len, unsigned *seq)
+{
+        const char *star, *p;
+        unsigned crc = 0, v = 0;
+        int i;
+
+        if (len < 8 || s[len - 5] != '*')
+                return 0;
+        star = s + len - 5;
+
+        for (i = 1; i <= 4; i++)
+        {
+                p = star + i;
+                if (*p >= '0' && *p <= '9')      crc = crc * 16 + (*p - '0');
+                else if (*p >= 'A' && *p <= 'F') crc = crc * 16 + (*p - 'A' + 10);
+                else return 0;
+        }
+
+        for (p = star; p > s && p[-1] >= '0' && p[-1] <= '9'; p--)
+                ;
+        if (p == star || p - s < 2 || p[-1] != '#' || p[-2] != ' ')
+                return 0;
+        for (; p < star; p++)
+                v = v * 10 + (*p - '0');
+
+        if (Crc16((const unsigned char *)s, star - s) != crc)
+                return -1;
+        *seq = v;
+        return 1;
+}
+
+//------------------------------------------------------------
+// Function: MissNormalize
+// Purpose : Move missLo up to the oldest record still missing
+//------------------------------------------------------------
+static void MissNormalize(Port *p)
+{
+        if (p->missMask == 0)
+        {
+                p->nakTries = 0;
+                return;
+        }
+        while ((p->missMask & 1) == 0)
+        {
+                p->missMask >>= 1;
+                p->missLo++;
+        }
+}
+
+//------------------------------------------------------------
+// Function: SendNak
+// Purpose : Ask the device for the current missing range
+//------------------------------------------------------------
+static void SendNak(Port *p, unsigned long long now)
+{
+        char req[48];
+        unsigned hi = p->missLo + 63;
+        int len;
+
+        while (!(p->missMask >> (hi - p->missLo) & 1))
+                hi--;
+
+        len = snprintf(req, sizeof(req), "NAK %u %u\r\n", p->missLo, hi);
+        if (p->fd >= 0 && write(p->fd, req, len) == len)
+                cnt.naks++;
+        p->nakTries++;
+        p->nakAt = now;
+}
+
+/*------------------------------------------------------------
+Function: CheckSequence
+Purpose :
+Tracks the sequence numbers of one port.
+Return  : 1 -> archive the record, 0 -> drop it (bad CRC or a
+          copy of a record already archived)
+Gaps are added to the missing window and requested at once.
+A record numbered 0 that was not asked for means the device
+restarted. Only the last MISS_WINDOW numbers can be pending;
+older ones are counted as lost.
+------------------------------------------------------------*/
+static int CheckSequence(Port *p, unsigned long long now)
+{
+        unsigned seq, a, b, bit;
+        int r;
+
+        r = ParseTrailer(p->line, p->len, &seq);
+        if (r == 0)
+        {
+                // "[GONE] #a-b": the device no longer holds a..b
+                if (p->missMask && sscanf(p->line, "[GONE] #%u-%u", &a, &b) == 2)
+                        for (; a <= b && a - p->missLo < MISS_WINDOW; a++)
+                                if (a >= p->missLo && (p->missMask >> (a - p->missLo) & 1))
+                                {
+                                        p->missMask &= ~(1ULL << (a - p->missLo));
+                                        cnt.lost++;
+                                }
+                MissNormalize(p);
+                return 1;
+        }
+        if (r < 0)
+        {
+                cnt.crcErrors++;
+                return 0;
+        }
+
+        bit = seq - p->missLo;
+        if (p->missMask && seq >= p->missLo && bit < MISS_WINDOW &&
+            (p->missMask >> bit & 1))
+        {
+                p->missMask &= ~(1ULL << bit);
+                cnt.recovered++;
+                MissNormalize(p);
+                return 1;
+        }
+
+        if (!p->seqValid || (seq == 0 && p->expect > 1))
+        {
+                if (p->seqValid)
+                        cnt.resets++;
+                cnt.lost += __builtin_popcountll(p->missMask);
+                p->missMask = 0;
+                p->nakTries = 0;
+                p->seqValid = 1;
+                p->expect = seq + 1;
+                return 1;
+        }
+
+        if (seq < p->expect)
+        {
+                cnt.dups++;
+                return 0;
+        }
+
+        //----------------------------------------------------------
+        // New record; anything between expect and seq is missing
+        //----------------------------------------------------------
+        if (seq > p->expect)
+        {
+                cnt.gaps += seq - p->expect;
+                if (p->missMask == 0)
+                        p->missLo = p->expect;
+                for (a = p->expect; a < seq; a++)
+                {
+                        while (a - p->missLo >= MISS_WINDOW)
+                        {
+                                if (p->missMask & 1)
+                                        cnt.lost++;
+                                p->missMask >>= 1;
+                                p->missLo++;
+                        }
+                        p->missMask |= 1ULL << (a - p->missLo);
+                }
+                MissNormalize(p);
+                p->nakTries = 0;
+                SendNak(p, now);
+        }
+        p->expect = seq + 1;
+        return 1;
+}
+
+//------------------------------------------------------------
+// Function: Consume
+// Purpose : Split received bytes of one port into records
+//------------------------------------------------------------
+static void Consume(int idx, const unsigned char *buf, ssize_t n, unsigned long long now)
+{
+        Port *p = &ports[idx];
+        unsigned char c;
+        ssize_t i;
+
+        for (i = 0; i < n; i++)
+        {
+                c = buf[i];
+
+                if (c == '\n' || c == '\r')
+                {
+                        if (p->len > 0 && !p->binary && !CheckSequence(p, now))
+                                p->len = 0;
+                        EmitRecord(idx, p);
+                        continue;
+                }
+
+                if (p->len == 0)
+                        p->lineStart = now;
+                if (c < 0x20 || c >= 0x7F)
+                        p->binary = 1;
+
+                p->line[p->len++] = c;
+                if (p->len == LINE_MAX_LEN)
+                        EmitRecord(idx, p);
+        }
+}
+
+//------------------------------------------------------------
+// Function: SetRaw
+// Purpose : Raw 8N1 mode at the selected baud rate
+//------------------------------------------------------------
+static void SetRaw(int fd)
+{
+        struct termios t;
+
+        if (tcgetattr(fd, &t) != 0)
+                return;                 // Not a tty (e.g. a FIFO)
+        cfmakeraw(&t);
+        cfsetispeed(&t, baud);
+        cfsetospeed(&t, baud);
+        t.c_cflag |= CLOCAL | CREAD;
+        t.c_cc[VMIN] = 0;
+        t.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &t);
+}
+
+//------------------------------------------------------------
+// Function: OpenPort
+// Purpose : Open (or reopen) a port and add it to epoll
+//------------------------------------------------------------
+static void OpenPort(int ep, int idx)
+{
+        struct epoll_event ev;
+        Port *p = &ports[idx];
+
+        p->fd = open(p->path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (p->fd < 0)
+                return;
+
+        SetRaw(p->fd);
+        ev.events = EPOLLIN;
+        ev.data.u32 = idx;
+        epoll_ctl(ep, EPOLL_CTL_ADD, p->fd, &ev);
+}
+
+//------------------------------------------------------------
+// Function: ClosePort
+// Purpose : Drop a port after hang-up; retried on stats tick
+//------------------------------------------------------------
+static void ClosePort(int ep, int idx)
+{
+        Port *p = &ports[idx];
+
+        EmitRecord(idx, p);
+        epoll_ctl(ep, EPOLL_CTL_DEL, p->fd, NULL);
+        close(p->fd);
+        p->fd = -1;
+}
+
+//------------------------------------------------------------
+// Function: AddPty
+// Purpose : Create a pty; its slave name stands in for a port
+//------------------------------------------------------------
+static void AddPty(void)
+{
+        Port *p = &ports[nPorts];
+        int fd;
+
+        fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0)
+        {
+                perror("pty");
+                exit(1);
+        }
+
+        // Keep the master; print the slave for a simulator to open.
+        // One slave descriptor is held open here so the master does
+        // not report hang-up while no simulator is attached.
+        snprintf(p->path, sizeof(p->path), "%s", ptsname(fd));
+        p->fd = fd;
+        p->isPty = 1;
+        if (open(p->path, O_RDWR | O_NOCTTY) < 0)
+        {
+                perror(p->path);
+                exit(1);
+        }
+        SetRaw(p->fd);
+        printf("port %d: %s\n", nPorts, p->path);
+        nPorts++;
+}
+
+/*------------------------------------------------------------
+Function: ReportStats
+Purpose :
+Prints totals and rates since the last report to stderr and
+rewrites the stats file when one was given.
+------------------------------------------------------------*/
+static void ReportStats(double secs)
+{
+        char out[1024];
+        unsigned long long recs = 0, recsLast = 0;
+        int i, len;
+        FILE *f;
+
+        for (i = 0; i < REC_CLASSES; i++)
+        {
+                recs += cnt.records[i];
+                recsLast += cntLast.records[i];
+        }
+
+        len = snprintf(out, sizeof(out),
+                "ports=%d bytes_in=%llu bytes_out=%llu records=%llu writes=%llu "
+                "rotations=%llu reopens=%llu rate_rec_s=%.1f rate_in_Bs=%.1f "
+                "lat_avg_ms=%.3f lat_max_ms=%.3f crc_errors=%llu gaps=%llu "
+                "naks=%llu recovered=%llu lost=%llu dups=%llu resets=%llu",
+                nPorts, cnt.bytesIn, cnt.bytesOut, recs, cnt.writes,
+                cnt.rotations, cnt.reopens,
+                secs > 0 ? (recs - recsLast) / secs : 0.0,
+                secs > 0 ? (cnt.bytesIn - cntLast.bytesIn) / secs : 0.0,
+                cnt.latCount ? cnt.latSum / 1000.0 / cnt.latCount : 0.0,
+                cnt.latMax / 1000.0, cnt.crcErrors, cnt.gaps, cnt.naks,
+                cnt.recovered, cnt.lost, cnt.dups, cnt.resets);
+        for (i = 0; i < REC_CLASSES && len < (int)sizeof(out) - 32; i++)
+                len += snprintf(out + len, sizeof(out) - len, " %s=%llu",
+                                recName[i], cnt.records[i]);
+
+        fprintf(stderr, "%s\n", out);
+        if (statsPath && (f = fopen(statsPath, "w")) != NULL)
+        {
+                fprintf(f, "%s\n", out);
+                fclose(f);
+        }
+        cntLast = cnt;
+}
+
+static void OnSignal(int sig)
+{
+        if (sig == SIGUSR1)
+                dumpStats = 1;
+        else
+                stopNow = 1;
+}
+
+/*------------------------------------------------------------
+Function: main
+Purpose :
+Parses options, opens every port and runs the epoll loop.
+A 1 s timer flushes idle batches and reopens lost ports.
+------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+        static unsigned char buf[READ_CHUNK];
+        struct epoll_event ev, evs[256];
+        struct itimerspec its;
+        unsigned long long tick, lastReport, now;
+        int ep, tfd, n, i, idx, opt, interval = DEF_INTERVAL, ptys = 0;
+        ssize_t r;
+
+        while ((opt = getopt(argc, argv, "o:r:b:i:S:p:")) != -1)
+        {
+                switch (opt)
+                {
+                        case 'o': prefix = optarg; break;
+                        case 'r': rotateBytes = strtoull(optarg, NULL, 10) << 20; break;
+                        case 'i': interval = atoi(optarg); break;
+                        case 'S': statsPath = optarg; break;
+                        case 'p': ptys = atoi(optarg); break;
+                        case 'b':
+                                switch (atoi(optarg))
+                                {
+                                        case 9600:   baud = B9600;   break;
+                                        case 19200:  baud = B19200;  break;
+                                        case 38400:  baud = B38400;  break;
+                                        case 57600:  baud = B57600;  break;
+                                        case 115200: baud = B115200; break;
+                                        case 230400: baud = B230400; break;
+                                        default: fprintf(stderr, "bad baud\n"); return 1;
+                                }
+                                break;
+                        default:
+                                fprintf(stderr, "usage: %s [-o prefix] [-r rotate_MB] "
+                                        "[-b baud] [-i secs] [-S statsfile] [-p n_ptys] "
+                                        "[port ...]\n", argv[0]);
+                                return 1;
+                }
+        }
+
+        batch = malloc(BATCH_SIZE);
+        ep = epoll_create1(0);
+        if (batch == NULL || ep < 0)
+        {
+                perror("init");
+                return 1;
+        }
+
+        //----------------------------------------------------------
+        // Ports: real devices first, then stand-in ptys
+        //----------------------------------------------------------
+        for (i = optind; i < argc && nPorts < MAX_PORTS; i++)
+        {
+                snprintf(ports[nPorts].path, sizeof(ports[nPorts].path), "%s", argv[i]);
+                OpenPort(ep, nPorts);
+                if (ports[nPorts].fd < 0)
+                        fprintf(stderr, "%s: %s (will retry)\n", argv[i], strerror(errno));
+                nPorts++;
+        }
+        for (i = 0; i < ptys && nPorts < MAX_PORTS; i++)
+        {
+                AddPty();
+                ev.events = EPOLLIN;
+                ev.data.u32 = nPorts - 1;
+                epoll_ctl(ep, EPOLL_CTL_ADD, ports[nPorts - 1].fd, &ev);
+        }
+        fflush(stdout);
+
+        if (nPorts == 0)
+        {
+                fprintf(stderr, "no ports\n");
+                return 1;
+        }
+
+        //----------------------------------------------------------
+        // 1 s housekeeping timer (index MAX_PORTS marks it)
+        //----------------------------------------------------------
+        tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+        memset(&its, 0, sizeof(its));
+        its.it_value.tv_sec = 1;
+        its.it_interval.tv_sec = 1;
+        timerfd_settime(tfd, 0, &its, NULL);
+        ev.events = EPOLLIN;
+        ev.data.u32 = MAX_PORTS;
+        epoll_ctl(ep, EPOLL_CTL_ADD, tfd, &ev);
+
+        signal(SIGUSR1, OnSignal);
+        signal(SIGINT, OnSignal);
+        signal(SIGTERM, OnSignal);
+        lastReport = NowUs();
+
+        while (!stopNow)
+        {
+                n = epoll_wait(ep, evs, 256, -1);
+                if (n < 0 && errno != EINTR)
+                {
+                        perror("epoll_wait");
+                        break;
+                }
+
+                now = NowUs();
+                for (i = 0; i < n; i++)
+                {
+                        idx = evs[i].data.u32;
+
+                        if (idx == MAX_PORTS)
+                        {
+                                if (read(tfd, &tick, sizeof(tick)) < 0)
+                                        continue;
+
+                                // Do not hold a partial batch for long
+                                FlushBatch();
+
+                                for (idx = 0; idx < nPorts; idx++)
+                                        if (ports[idx].fd < 0)
+                                        {
+                                                OpenPort(ep, idx);
+                                                if (ports[idx].fd >= 0)
+                                                        cnt.reopens++;
+                                        }
+
+                                // Repeat unanswered resend requests, then give up
+                                for (idx = 0; idx < nPorts; idx++)
+                                {
+                                        Port *p = &ports[idx];
+
+                                        if (p->missMask == 0 || now - p->nakAt < 1000000ULL)
+                                                continue;
+                                        if (p->nakTries < NAK_RETRIES)
+                                                SendNak(p, now);
+                                        else
+                                        {
+                                                cnt.lost += __builtin_popcountll(p->missMask);
+                                                p->missMask = 0;
+                                                p->nakTries = 0;
+                                        }
+                                }
+
+                                if (interval > 0 && now - lastReport >= (unsigned long long)interval * 1000000ULL)
+                                {
+                                        ReportStats((now - lastReport) / 1e6);
+                                        lastReport = now;
+                                }
+                                continue;
+                        }
+
+                        //--------------------------------------------------
+                        // Drain the port completely (level-triggered, but
+                        // one pass per wakeup keeps syscalls low)
+                        //--------------------------------------------------
+                        while ((r = read(ports[idx].fd, buf, sizeof(buf))) > 0)
+                        {
+                                cnt.bytesIn += r;
+                                Consume(idx, buf, r, now);
+                        }
+                        if (!ports[idx].isPty &&
+                            (r == 0 || (r < 0 && errno != EAGAIN && errno != EINTR)))
+                                ClosePort(ep, idx);
+                }
+
+                if (dumpStats)
+                {
+                        dumpStats = 0;
+                        ReportStats((NowUs() - lastReport) / 1e6);
+                        lastReport = NowUs();
+                }
+        }
+
+        //----------------------------------------------------------
+        // Shutdown: finish partial records and write everything
+        //----------------------------------------------------------
+        for (idx = 0; idx < nPorts; idx++)
+                EmitRecord(idx, &ports[idx]);
+        FlushBatch();
+        ReportStats((NowUs() - lastReport) / 1e6);
+        if (archFd >= 0)
+                close(archFd);
+
+        return 0;
+}
@@ -0,0 +1,392 @@
+//collector_load.c
+/*------------------------------------------------------------
+File: collector_load.c
+Purpose:
+Host load test of the collector daemon (collector.c).
+
+Starts the collector with one pseudo-terminal per sender and
+opens the slave side of each. Every sender writes numbered
+records "[INFO] S<sender> n:<k> ... #<k>*<CRC>" followed by
+one unterminated line "[INFO] S<sender> end". All senders
+write at once: in each round, in a new random order, each
+writes a chunk of random length, so the collector mostly
+reads parts of lines and has to keep each port's partial
+record apart from the others. When the collector has read
+every byte it is stopped with SIGTERM, which must archive
+the unterminated lines as well.
+
+Checks, from the archive and the collector's stats file:
+- Every record is archived under the port of the sender
+  named in it (no misattribution)
+- Each sender's records are all there, once, in order, and
+  its unterminated last line is archived
+- The collector counted no CRC errors, gaps, NAKs, lost or
+  duplicate records
+- The collector exits with status 0
+
+Exit status is 1 if any check failed.
+
+Build (collector built first, as ./collector):
+cc -O2 -Wall -o collector_load collector_load.c
+
+Usage:
+collector_load [-n senders] [-r records] [-x collector_path]
+  senders : concurrent senders (default 300, at most 1000)
+  records : numbered records per sender (default 200)
+------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/wait.h>
+
+#define LOAD_SENDERS_MAX 1000      // collector takes up to 1024 ports
+#define LOAD_CHUNK_MAX   96        // Longest single write (bytes)
+#define LOAD_ROUND_US    200       // Pause between write rounds
+#define LOAD_IDLE_S      30        // Give up when the collector reads nothing this long
+#define LOAD_LINE_LEN    1024
+
+//------------------------------------------------------------
+// One sender and what the archive showed of it
+//------------------------------------------------------------
+typedef struct
+{
+        int      fd;               // Slave side of the collector's pty
+        char    *buf;              // Everything this sender writes
+        size_t   len;              // Bytes in buf
+        size_t   off;              // Bytes written so far
+        unsigned next;             // Next record expected in the archive
+        int      tail;             // Unterminated last line archived
+} Sender;
+
+static Sender *snd;
+
+//------------------------------------------------------------
+// Function: Crc16
+// Purpose : CRC-16/CCITT (poly 0x1021, init 0xFFFF) of the
+//           record trailer, as the device and collector use
+//------------------------------------------------------------
+static unsigned Crc16(const unsigned char *buf, int len)
+{
+        unsigned crc = 0xFFFF;
+        int i;
+
+        while (len--)
+        {
+                crc ^= (unsigned)*buf++ << 8;
+                for (i = 0; i < 8; i++)
+                        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+        return crc & 0xFFFF;
+}
+
+/*------------------------------------------------------------
+Function: BuildStream
+Purpose :
+Fills in everything one sender writes: its numbered records,
+of varying length, and the unterminated last line.
+------------------------------------------------------------*/
+static int BuildStream(Sender *s, unsigned idx, unsigned records)
+{
+        static const char fill[] = "................................";
+        char rec[LOAD_LINE_LEN];
+        size_t cap = (size_t)records * 96 + 64;
+        unsigned k;
+        int len;
+
+        if ((s->buf = malloc(cap)) == NULL)
+                return -1;
+        s->len = 0;
+        for (k = 0; k < records; k++)
+        {
+                len = snprintf(rec, sizeof(rec), "[INFO] S%u n:%u Temp:%uC %.*s #%u",
+                               idx, k, 20 + k % 10, (int)((idx + k) % 32), fill, k);
+                len += snprintf(rec + len, sizeof(rec) - len, "*%04X\r\n",
+                                Crc16((const unsigned char *)rec, len));
+                memcpy(s->buf + s->len, rec, len);
+                s->len += len;
+        }
+        s->len += sprintf(s->buf + s->len, "[INFO] S%u end", idx);
+        return 0;
+}
+
+//------------------------------------------------------------
+// Function: StatValue
+// Purpose : Value of "name=" in a collector stats line, or
+//           ~0 when it is missing
+//------------------------------------------------------------
+static unsigned long long StatValue(const char *line, const char *name)
+{
+        char key[32];
+        const char *p;
+        int n;
+
+        n = snprintf(key, sizeof(key), "%s=", name);
+        for (p = line; (p = strstr(p, key)) != NULL; p += n)
+                if (p == line || p[-1] == ' ')
+                        return strtoull(p + n, NULL, 10);
+        return ~0ULL;
+}
+
+//------------------------------------------------------------
+// Function: ReadStats
+// Purpose : Last stats line the collector wrote; 0 if none
+//------------------------------------------------------------
+static int ReadStats(const char *path, char *line, int size)
+{
+        FILE *f;
+        int ok;
+
+        if ((f = fopen(path, "r")) == NULL)
+                return 0;
+        ok = fgets(line, size, f) != NULL;
+        fclose(f);
+        return ok;
+}
+
+int main(int argc, char **argv)
+{
+        char dir[] = "/tmp/collloadXXXXXX";
+        char prefix[64], stats[64], name[96], arg[16], path[128];
+        char line[LOAD_LINE_LEN], junk[256];
+        const char *collector = "./collector";
+        unsigned senders = 300, records = 200;
+        unsigned long long total = 0, written = 0, partial = 0, writes = 0;
+        unsigned long long seen, lastSeen = 0, bad = 0, misattr = 0, lost = 0, dups = 0;
+        unsigned long long archived = 0;
+        unsigned *order, i, j, t, port, k, sIdx;
+        struct termios tio;
+        time_t lastMove;
+        pid_t pid;
+        FILE *out;
+        ssize_t w;
+        size_t chunk;
+        int pfd[2], status, fail, pos;
+
+        for (i = 1; i < (unsigned)argc; i++)
+        {
+                if (strcmp(argv[i], "-n") == 0 && i + 1 < (unsigned)argc)
+                        senders = (unsigned)atoi(argv[++i]);
+                else if (strcmp(argv[i], "-r") == 0 && i + 1 < (unsigned)argc)
+                        records = (unsigned)atoi(argv[++i]);
+                else if (strcmp(argv[i], "-x") == 0 && i + 1 < (unsigned)argc)
+                        collector = argv[++i];
+                else
+                        break;
+        }
+        if (i < (unsigned)argc || senders == 0 || senders > LOAD_SENDERS_MAX || records == 0)
+        {
+                fprintf(stderr, "usage: %s [-n senders] [-r records] [-x collector_path]\n",
+                        argv[0]);
+                return 2;
+        }
+
+        snd = calloc(senders, sizeof(*snd));
+        order = malloc(senders * sizeof(*order));
+        if (snd == NULL || order == NULL || mkdtemp(dir) == NULL || pipe(pfd) != 0)
+        {
+                perror("init");
+                return 1;
+        }
+        snprintf(prefix, sizeof(prefix), "%s/arch", dir);
+        snprintf(stats, sizeof(stats), "%s/stats", dir);
+        snprintf(arg, sizeof(arg), "%u", senders);
+
+        //----------------------------------------------------------
+        // Collector with one pty per sender; its port list comes
+        // on stdout, its periodic stats go to the stats file only
+        //----------------------------------------------------------
+        if ((pid = fork()) < 0)
+        {
+                perror("fork");
+                return 1;
+        }
+        if (pid == 0)
+        {
+                dup2(pfd[1], STDOUT_FILENO);
+                close(pfd[0]);
+                close(pfd[1]);
+                if ((pos = open("/dev/null", O_WRONLY)) >= 0)
+                        dup2(pos, STDERR_FILENO);
+                execl(collector, collector, "-p", arg, "-o", prefix, "-i", "1",
+                      "-S", stats, (char *)NULL);
+                _exit(127);
+        }
+        close(pfd[1]);
+        out = fdopen(pfd[0], "r");
+
+        for (i = 0; i < senders; i++)
+        {
+                if (out == NULL || fgets(line, sizeof(line), out) == NULL ||
+                    sscanf(line, "port %u: %127s", &port, path) != 2 || port != i)
+                {
+                        fprintf(stderr, "%s: no port %u\n", collector, i);
+                        kill(pid, SIGKILL);
+                        return 1;
+                }
+                snd[i].fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+                if (snd[i].fd < 0 || BuildStream(&snd[i], i, records) != 0)
+                {
+                        perror(path);
+                        kill(pid, SIGKILL);
+                        return 1;
+                }
+                if (tcgetattr(snd[i].fd, &tio) == 0)
+                {
+                        cfmakeraw(&tio);
+                        tcsetattr(snd[i].fd, TCSANOW, &tio);
+                }
+                total += snd[i].len;
+                order[i] = i;
+        }
+
+        //----------------------------------------------------------
+        // All senders at once, chunks of random length in a new
+        // random order each round. Anything the collector sends
+        // back (a NAK) is read and dropped; its count is checked.
+        //----------------------------------------------------------
+        srand(1);
+        while (written < total)
+        {
+                for (i = senders - 1; i > 0; i--)
+                {
+                        j = (unsigned)rand() % (i + 1);
+                        t = order[i];
+                        order[i] = order[j];
+                        order[j] = t;
+                }
+                for (i = 0; i < senders; i++)
+                {
+                        Sender *s = &snd[order[i]];
+
+                        while (read(s->fd, junk, sizeof(junk)) > 0)
+                                ;
+                        if (s->off == s->len)
+                                continue;
+                        chunk = 1 + (size_t)rand() % LOAD_CHUNK_MAX;
+                        if (chunk > s->len - s->off)
+                                chunk = s->len - s->off;
+                        w = write(s->fd, s->buf + s->off, chunk);
+                        if (w <= 0)
+                                continue;
+                        writes++;
+                        s->off += w;
+                        written += w;
+                        if (s->buf[s->off - 1] != '\n')
+                                partial++;
+                }
+                usleep(LOAD_ROUND_US);
+        }
+
+        //----------------------------------------------------------
+        // Wait until the collector has read every byte, then stop
+        // it; shutdown archives the unterminated lines
+        //----------------------------------------------------------
+        lastMove = time(NULL);
+        for (;;)
+        {
+                seen = ReadStats(stats, line, sizeof(line)) ? StatValue(line, "bytes_in") : 0;
+                if (seen == total)
+                        break;
+                if (seen != lastSeen)
+                {
+                        lastSeen = seen;
+                        lastMove = time(NULL);
+                }
+                if (time(NULL) - lastMove > LOAD_IDLE_S)
+                {
+                        fprintf(stderr, "collector read %llu of %llu bytes\n", seen, total);
+                        bad++;
+                        break;
+                }
+                usleep(100000);
+        }
+        kill(pid, SIGTERM);
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+                fprintf(stderr, "%s: did not exit cleanly\n", collector);
+                bad++;
+        }
+        if (!ReadStats(stats, line, sizeof(line)))
+                line[0] = 0;
+
+        //----------------------------------------------------------
+        // Archive: "<unix time ms> <port index> <record text>"
+        //----------------------------------------------------------
+        for (i = 0; ; i++)
+        {
+                FILE *f;
+                char rec[LOAD_LINE_LEN];
+
+                snprintf(name, sizeof(name), "%s.%06u.log", prefix, i);
+                if ((f = fopen(name, "r")) == NULL)
+                        break;
+                while (fgets(rec, sizeof(rec), f) != NULL)
+                {
+                        archived++;
+                        if (sscanf(rec, "%*u %u %n", &port, &pos) != 1 || port >= senders)
+                        {
+                                if (bad++ < 5)
+                                        fprintf(stderr, "bad archive line: %s", rec);
+                                continue;
+                        }
+                        if (sscanf(rec + pos, "[INFO] S%u n:%u ", &sIdx, &k) == 2)
+                        {
+                                if (sIdx != port)
+                                {
+                                        if (misattr++ < 5)
+                                                fprintf(stderr, "port %u has: %s", port, rec + pos);
+                                }
+                                else if (k > snd[port].next)
+                                        lost += k - snd[port].next;
+                                else if (k < snd[port].next)
+                                        dups++;
+                                if (sIdx == port && k >= snd[port].next)
+                                        snd[port].next = k + 1;
+                        }
+                        else if (sscanf(rec + pos, "[INFO] S%u end", &sIdx) == 1 &&
+                                 strchr(rec + pos, '#') == NULL)
+                        {
+                                if (sIdx != port)
+                                        misattr++;
+                                else
+                                        snd[port].tail++;
+                        }
+                        else if (bad++ < 5)
+                                fprintf(stderr, "port %u has: %s", port, rec + pos);
+                }
+                fclose(f);
+                unlink(name);
+        }
+        unlink(stats);
+        rmdir(dir);
+
+        for (i = 0; i < senders; i++)
+        {
+                lost += records - (snd[i].next < records ? snd[i].next : records);
+                if (snd[i].tail != 1)
+                        bad++;
+        }
+
+        printf("senders    %u x %u records, %llu bytes in %llu writes (%llu end mid-line)\n",
+               senders, records, total, writes, partial);
+        printf("archived   %llu lines: %llu lost, %llu duplicated, %llu misattributed, %llu bad\n",
+               archived, lost, dups, misattr, bad);
+        printf("collector  %s", line[0] ? line : "no stats\n");
+
+        fail = bad || lost || dups || misattr ||
+               archived != (unsigned long long)senders * (records + 1) ||
+               StatValue(line, "crc_errors") != 0 || StatValue(line, "gaps") != 0 ||
+               StatValue(line, "naks") != 0 || StatValue(line, "lost") != 0 ||
+               StatValue(line, "dups") != 0;
+        printf("%s\n", fail ? "FAIL" : "PASS");
+
+        return fail ? 1 : 0;
+}
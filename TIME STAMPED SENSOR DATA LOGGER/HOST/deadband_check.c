@@ -0,0 +1,306 @@
+//deadband_check.c
+/*------------------------------------------------------------
+File: deadband_check.c
+Purpose:
+Host check of deadband logging and of the expand tool.
+
+Runs the firmware's main loop work (DisplayInformation(),
+linked as in soak.c) with the default configuration for a
+stable room, 25.0 C for days on end, and writes every UART
+line to a log file. Deadband logging should then send one
+period record per heartbeat, 1 in 15 at the defaults.
+
+The rate scheduler starts at its fastest level and steps
+down to the slowest within a few minutes; its [RATE] records
+state each log period. The log is then expanded twice by the
+expand tool: as sent, and cut after the last [RATE] record,
+where expand has to find the period from the record stamps.
+
+Checks:
+- Period records sent are no more than DB_SENT_MAX_PCT of
+  the period records built
+- From the last rate change on, each expansion has one line
+  per period up to the last record, on the period boundaries
+- Each expanded value is within the deadband of the input
+
+Exit status is 1 if any check failed.
+
+Build (expand built first, as ./expand):
+cc -O2 -Wall -Wno-pointer-sign -DHOST_BUILD -I. -I../TYPES -I../DEFINES -I../MACROS -I../PT -I../RTC -I../STATS -I../PIPELINE -I../ADC -I../LM35 -I../TIMER -I../UART -I../LCD -I../KEYPAD -I../CONFIG -I../CLOCK -I../BUS -I../SEQLOG -I../CRC -I../RATE -I../SENSOR -I../TREND -I../BLKLOG -I../DISPLAYINFORMATION -o deadband_check deadband_check.c ../DISPLAYINFORMATION/DisplayInformation.c ../BUS/bus.c ../SEQLOG/seqlog.c ../CRC/crc.c ../UART/uart.c ../UART/uart_sim.c ../LCD/lcd_sim.c ../KEYPAD/keypad_sim.c ../CONFIG/config_sim.c ../CLOCK/clock_sim.c ../RTC/rtc_cal.c ../RTC/rtc_sim.c ../STATS/stats.c ../PIPELINE/pipeline.c ../LM35/lm35.c ../ADC/adc_sim.c ../TIMER/timer_sim.c ../RATE/rate.c ../SENSOR/sensor.c ../TREND/trend.c
+
+Usage:
+deadband_check [-d days] [-x expand_path]
+  days : simulated days (default 3)
+------------------------------------------------------------*/
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LPC214X_SIM_DEFINE
+#include <lpc214x.h>              // Register stand-ins, defined here
+
+#include "types.h"
+#include "rtc.h"
+#include "stats.h"
+#include "adc.h"
+#include "adc_defines.h"
+#include "pipeline.h"
+#include "timer.h"
+#include "uart.h"
+#include "lcd.h"
+#include "bus.h"
+#include "seqlog.h"
+#include "rate.h"
+#include "sensor.h"
+#include "trend.h"
+#include "config.h"
+#include "clock.h"
+#include "lm35.h"
+#include "DisplayInformation.h"
+
+#define DB_INPUT_T      250       // Room temperature (0.1 C)
+#define DB_POLL_MS      250       // Main loop period
+#define DB_SENT_MAX_PCT 7.0       // 1 in 15 at the defaults is 6.7%
+#define DB_LINE_LEN     512
+#define EPOCH_2000      946684800LL  // 01/01/2000 00:00:00 in Unix time
+
+//------------------------------------------------------------
+// Set by project.c on the target
+//------------------------------------------------------------
+u32 edit_flag;
+
+static FILE *logFile;
+static unsigned long long sent;
+static u32 rateSec, firstSec, lastSec;
+
+//------------------------------------------------------------
+// Function: OnLine
+// Purpose : UART line hook: keep every line in the log and
+//           note when the rate last changed
+//------------------------------------------------------------
+static void OnLine(u32 port, const s8 *line, u32 len)
+{
+        RTCStamp st;
+
+        if (strncmp((const char *)line, "[RATE] ", 7) == 0)
+        {
+                GetRTCStamp(&st);
+                rateSec = st.sec;
+        }
+        fprintf(logFile, "%s\n", (const char *)line);
+}
+
+//------------------------------------------------------------
+// Function: SentSink
+// Purpose : Count the period records the deadband let out,
+//           note the first since the last rate change and the
+//           last one
+//------------------------------------------------------------
+static void SentSink(const Sample *s)
+{
+        sent++;
+        if (firstSec < rateSec || sent == 1)
+                firstSec = s->at.sec;
+        lastSec = s->at.sec;
+}
+
+static const BusSink sentSink = { BUS_PERIOD, 0, 0, SentSink };
+
+/*------------------------------------------------------------
+Function: CheckExpand
+Purpose :
+Runs expand on a log and checks its output from second
+'from' on: one line per period, on the period boundaries,
+within the deadband of the input.
+Return  : number of failed lines, or 1 when expand failed
+------------------------------------------------------------*/
+static unsigned long long CheckExpand(const char *expand, const char *log, u32 periodSec,
+                                      u32 from, unsigned long long *lines)
+{
+        char cmd[DB_LINE_LEN], line[DB_LINE_LEN];
+        unsigned long long bad = 0;
+        long temp;
+        unsigned hh, mi, ss, ms, dd, mo, yy;
+        u32 sec, prev = 0;
+        struct tm tm;
+        FILE *p;
+
+        snprintf(cmd, sizeof(cmd), "%s %s", expand, log);
+        if ((p = popen(cmd, "r")) == NULL)
+                return 1;
+
+        *lines = 0;
+        while (fgets(line, sizeof(line), p) != NULL)
+        {
+                if (sscanf(line, "[INFO] Temp:%ldC @%2u:%2u:%2u.%3u %2u/%2u/%4u",
+                           &temp, &hh, &mi, &ss, &ms, &dd, &mo, &yy) != 8)
+                {
+                        bad++;
+                        continue;
+                }
+
+                memset(&tm, 0, sizeof(tm));
+                tm.tm_hour = hh;
+                tm.tm_min  = mi;
+                tm.tm_sec  = ss;
+                tm.tm_mday = dd;
+                tm.tm_mon  = mo - 1;
+                tm.tm_year = yy - 1900;
+                sec = (u32)(timegm(&tm) - EPOCH_2000);
+                if (sec < from)
+                        continue;
+
+                if (sec % periodSec != 0 || (*lines != 0 && sec - prev != periodSec))
+                {
+                        if (bad++ < 5)
+                                fprintf(stderr, "%s: off the period: %s", log, line);
+                }
+                if ((temp * 10 > DB_INPUT_T ? temp * 10 - DB_INPUT_T : DB_INPUT_T - temp * 10) >
+                    (long)config.deadband)
+                {
+                        if (bad++ < 5)
+                                fprintf(stderr, "%s: out of the deadband: %s", log, line);
+                }
+                prev = sec;
+                (*lines)++;
+        }
+        if (pclose(p) != 0)
+                bad++;
+        return bad;
+}
+
+int main(int argc, char **argv)
+{
+        char logName[] = "/tmp/deadbandXXXXXX", bareName[] = "/tmp/deadbandXXXXXX";
+        char line[DB_LINE_LEN];
+        const char *expand = "./expand";
+        unsigned days = 3;
+        unsigned long long simUs, endUs, built, want[2], lines[2], bad[2];
+        unsigned long long rates = 0, n = 0;
+        double pct;
+        u32 period, from;
+        FILE *bare;
+        int i, fd, fail;
+
+        for (i = 1; i < argc; i++)
+        {
+                if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+                        days = (unsigned)atoi(argv[++i]);
+                else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc)
+                        expand = argv[++i];
+                else
+                        break;
+        }
+        if (i < argc || days == 0)
+        {
+                fprintf(stderr, "usage: %s [-d days] [-x expand_path]\n", argv[0]);
+                return 2;
+        }
+
+        if ((fd = mkstemp(logName)) < 0 || (logFile = fdopen(fd, "w")) == NULL ||
+            (fd = mkstemp(bareName)) < 0 || (bare = fdopen(fd, "w")) == NULL)
+        {
+                perror("mkstemp");
+                return 1;
+        }
+
+        //----------------------------------------------------------
+        // Boot as project.c does, with the default deadband and
+        // heartbeat, from midnight on 01/01/2023 (a Sunday)
+        //----------------------------------------------------------
+        InitTimer1();
+        InitClock(CLK_PERF);
+        InitTimer0();
+        RTC_Init();
+        SetRTCTimeInfo(0, 0, 0);
+        SetRTCDateInfo(1, 1, 2023);
+        SetRTCDay(0);
+        InitRTCStamp();
+
+        InitConfig();
+        config.sampleHz = config.sampleHzMin = 1000 / DB_POLL_MS;
+
+        InitLCD(1);
+        InitUART();
+        UARTSimHook(OnLine);
+        InitSeqLog();
+
+        ADCSimInit(ADC_CONV_US);
+        ADCSimSet(LM35TenthsToCount(DB_INPUT_T));
+        InitSensors();
+        SensorSetPoint(0, config.setPoint * 10);
+
+        InitPipeline(sens.ch[0]);
+        InitRate(config.sampleHzMin, config.sampleHz);
+        PipelineSetTrigger(sens.setPoint[0]);
+        InitTrend();
+        InitStats();
+        InitSampleBus();
+        BusAttach(&sentSink);
+
+        endUs = (unsigned long long)days * 86400 * 1000000;
+        for (simUs = 0; simUs < endUs; simUs += DB_POLL_MS * 1000)
+        {
+                RTCSimAdvance(DB_POLL_MS * 1000);
+                TimerSimAdvance(DB_POLL_MS * 1000);
+                SeqLogPoll();
+                DisplayInformation();
+        }
+        period = rateStats.logSec;
+        built = pipeStats.minutes;
+        fclose(logFile);
+
+        //----------------------------------------------------------
+        // Same log from after the last [RATE] record on
+        //----------------------------------------------------------
+        if ((logFile = fopen(logName, "r")) == NULL)
+        {
+                perror(logName);
+                return 1;
+        }
+        while (fgets(line, sizeof(line), logFile) != NULL)
+                if (strstr(line, "[RATE] ") != NULL)
+                        rates++;
+        rewind(logFile);
+        while (fgets(line, sizeof(line), logFile) != NULL)
+        {
+                if (n >= rates)
+                        fputs(line, bare);
+                if (strstr(line, "[RATE] ") != NULL)
+                        n++;
+        }
+        fclose(logFile);
+        fclose(bare);
+
+        //----------------------------------------------------------
+        // Every boundary from the rate change to the last record
+        // sent; the records after it are held back by the
+        // deadband. The cut log starts at its first record.
+        //----------------------------------------------------------
+        from = (rateSec + period - 1) / period * period;
+        bad[0] = CheckExpand(expand, logName, period, from, &lines[0]);
+        bad[1] = CheckExpand(expand, bareName, period, from, &lines[1]);
+        unlink(logName);
+        unlink(bareName);
+
+        pct = built ? 100.0 * sent / built : 100.0;
+        want[0] = lastSec >= from ? (lastSec - from) / period + 1 : 0;
+        want[1] = lastSec >= firstSec ? (lastSec - firstSec) / period + 1 : 0;
+
+        printf("simulated  %u days, period %u s, deadband %u.%u C, heartbeat %u s\n",
+               days, period, config.deadband / 10, config.deadband % 10, config.heartbeat);
+        printf("records    built %llu  sent %llu (%.1f%%, limit %.1f%%)\n",
+               built, sent, pct, DB_SENT_MAX_PCT);
+        printf("expanded   as sent %llu lines (expected %llu), %llu bad\n", lines[0], want[0], bad[0]);
+        printf("expanded   cut     %llu lines (expected %llu), %llu bad\n", lines[1], want[1], bad[1]);
+
+        fail = pct > DB_SENT_MAX_PCT || want[0] == 0 || want[1] == 0 || bad[0] || bad[1] ||
+               lines[0] != want[0] || lines[1] != want[1];
+        printf("%s\n", fail ? "FAIL" : "PASS");
+
+        return fail ? 1 : 0;
+}
@@ -0,0 +1,466 @@
+//expand.c
+/*------------------------------------------------------------
+File: expand.c
+Purpose:
+Host tool that rebuilds the full [INFO] series from a log
+written with deadband logging (report by exception).
+
+With deadband logging the device only sends a period record
+when the temperature has moved by the deadband or when the
+heartbeat interval has passed, so a stable room produces a
+record every few minutes instead of every period. Between
+two records the temperature is known to have stayed within
+the deadband of the earlier one; this tool writes that value
+again at every period in between, giving the step function
+a non-deadband log would have shown.
+
+Features:
+- Works on raw captures and on collector / logmerge output;
+  the time is taken from the "HH:MM:SS[.mmm] DD/MM/YYYY"
+  stamp and the value from "Temp:NC"
+- The log period is taken from the [RATE] records ("log:Ns",
+  sent at start-up and on every rate change). Before the
+  first one, and after a [BOOT] line, it is the largest
+  period all the record stamps are multiples of (periods are
+  aligned on the RTC time base), or -p when given
+- Filled records fall on the period boundaries
+- Gaps longer than the heartbeat (device off, records lost)
+  are not filled, and are counted
+- Repeated records (resent after a NAK) are dropped
+- Other lines, including [INFO] records of the other
+  sensors ("[INFO] CH2 Temp:..."), are dropped, or passed
+  through with -a
+
+Output lines:
+[INFO] Temp:NC @HH:MM:SS.mmm DD/MM/YYYY
+
+Build:
+cc -O2 -Wall -o expand expand.c
+
+Usage:
+expand [-p period_s] [-H heartbeat_s] [-a] [file]
+  period_s    : log period where the log does not state it
+                (default: from the record stamps, else 60)
+  heartbeat_s : heartbeat interval of the device (default 900)
+
+NOTE: The whole log is read into memory, so that the period
+of a stretch without [RATE] records can be found before it
+is expanded.
+------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define LINE_LEN 4096
+#define PERIOD_DEF_MS   60000
+#define EPOCH_2000_MS   946684800000LL   // RTC time base, Unix ms
+
+//------------------------------------------------------------
+// Kinds of input line
+//------------------------------------------------------------
+#define LN_OTHER 0
+#define LN_INFO  1       // [INFO] record of the first sensor
+#define LN_RATE  2       // [RATE] record, states the period
+#define LN_BOOT  3       // [BOOT] line, period back to unknown
+
+//------------------------------------------------------------
+// One input line; t is the stamp (ms) of an [INFO] or [RATE]
+// line, period (ms) the period from a [RATE] or [BOOT] line on
+//------------------------------------------------------------
+typedef struct
+{
+        char *text;
+        int kind;
+        int stamped;
+        long long t;
+        long long period;
+        long temp;
+} Line;
+
+//------------------------------------------------------------
+// Options, input and counters
+//------------------------------------------------------------
+static long long periodMs, heartbeatMs = 900000;
+static int passOther;
+static Line *lines;
+static size_t nLines, capLines;
+static unsigned long long recsIn, linesOut, filled, gaps, repeats, unsorted;
+static unsigned long long periodsRate, periodsStamp, periodsDef;
+
+//------------------------------------------------------------
+// Function: DaysFromCivil / CivilFromDays
+// Purpose : Days since 01/01/1970 of a calendar date, and the
+//           inverse
+//------------------------------------------------------------
+static long long DaysFromCivil(int y, int m, int d)
+{
+        int era, yoe, doy, doe;
+
+        y -= (m <= 2);
+        era = (y >= 0 ? y : y - 399) / 400;
+        yoe = y - era * 400;
+        doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return (long long)era * 146097 + doe - 719468;
+}
+
+static void CivilFromDays(long long z, int *y, int *m, int *d)
+{
+        long long era, doe, yoe, doy, mp;
+
+        z += 719468;
+        era = (z >= 0 ? z : z - 146096) / 146097;
+        doe = z - era * 146097;
+        yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        mp = (5 * doy + 2) / 153;
+        *d = doy - (153 * mp + 2) / 5 + 1;
+        *m = mp < 10 ? mp + 3 : mp - 9;
+        *y = yoe + era * 400 + (*m <= 2);
+}
+
+static int Dig(const char *p, int n)
+{
+        int v = 0;
+
+        while (n--)
+        {
+                if (!isdigit((unsigned char)*p))
+                        return -1;
+                v = v * 10 + (*p++ - '0');
+        }
+        return v;
+}
+
+/*------------------------------------------------------------
+Function: ParseStamp
+Purpose :
+Finds "HH:MM:SS[.mmm] DD/MM/YYYY" in a line.
+Return  : 1 and the time in *ms, 0 when the line has no stamp
+------------------------------------------------------------*/
+static int ParseStamp(const char *l, long long *ms)
+{
+        const char *p, *q;
+        int hh, mi, ss, frac, dd, mo, yy;
+
+        for (p = strchr(l, ':'); p != NULL; p = strchr(p + 1, ':'))
+        {
+                if (p - l < 2 || p[3] != ':')
+                        continue;
+                hh = Dig(p - 2, 2);
+                mi = Dig(p + 1, 2);
+                ss = Dig(p + 4, 2);
+                if (hh < 0 || mi < 0 || ss < 0)
+                        continue;
+
+                q = p + 6;
+                frac = 0;
+                if (q[0] == '.' && Dig(q + 1, 3) >= 0)
+                {
+                        frac = Dig(q + 1, 3);
+                        q += 4;
+                }
+                while (*q == ' ')
+                        q++;
+
+                dd = Dig(q, 2);
+                mo = Dig(q + 3, 2);
+                yy = Dig(q + 6, 4);
+                if (dd < 0 || mo < 0 || yy < 0 || q[2] != '/' || q[5] != '/')
+                        continue;
+
+                *ms = ((DaysFromCivil(yy, mo, dd) * 86400LL) +
+                       hh * 3600 + mi * 60 + ss) * 1000 + frac;
+                return 1;
+        }
+        return 0;
+}
+
+//------------------------------------------------------------
+// Function: ParseInfo
+// Purpose : Time and value of an [INFO] record of the first
+//           sensor (records of the others name their input)
+// Return  : 1 -> found, 0 -> not such a record
+//------------------------------------------------------------
+static int ParseInfo(const char *l, long long *ms, long *temp)
+{
+        const char *p = strstr(l, "[INFO] Temp:");
+        char *end;
+
+        if (p == NULL)
+                return 0;
+        p += 7;
+        *temp = strtol(p + 5, &end, 10);
+        if (end == p + 5 || *end != 'C')
+                return 0;
+        return ParseStamp(end, ms);
+}
+
+//------------------------------------------------------------
+// Function: ParseRate
+// Purpose : Log period of a [RATE] record ("log:Ns")
+// Return  : 1 -> found, 0 -> not such a record
+//------------------------------------------------------------
+static int ParseRate(const char *l, long long *period)
+{
+        const char *p = strstr(l, "[RATE] ");
+        char *end;
+        long v;
+
+        if (p == NULL || (p = strstr(p, " log:")) == NULL)
+                return 0;
+        v = strtol(p + 5, &end, 10);
+        if (end == p + 5 || *end != 's' || v <= 0)
+                return 0;
+        *period = v * 1000LL;
+        return 1;
+}
+
+//------------------------------------------------------------
+// Function: Gcd
+//------------------------------------------------------------
+static long long Gcd(long long a, long long b)
+{
+        long long r;
+
+        while (b != 0)
+        {
+                r = a % b;
+                a = b;
+                b = r;
+        }
+        return a;
+}
+
+//------------------------------------------------------------
+// Function: ReadLines
+// Purpose : Read and classify every input line
+// Return  : 0 -> out of memory
+//------------------------------------------------------------
+static int ReadLines(FILE *f)
+{
+        char buf[LINE_LEN];
+        Line *ln;
+
+        while (fgets(buf, sizeof(buf), f) != NULL)
+        {
+                if (nLines == capLines)
+                {
+                        capLines = capLines ? capLines * 2 : 1024;
+                        if ((lines = realloc(lines, capLines * sizeof(Line))) == NULL)
+                                return 0;
+                }
+                ln = &lines[nLines];
+                memset(ln, 0, sizeof(Line));
+                if ((ln->text = strdup(buf)) == NULL)
+                        return 0;
+
+                if (ParseInfo(buf, &ln->t, &ln->temp))
+                        ln->kind = LN_INFO;
+                else if (ParseRate(buf, &ln->period))
+                {
+                        ln->kind = LN_RATE;
+                        ln->stamped = ParseStamp(strstr(buf, " log:"), &ln->t);
+                }
+                else if (strstr(buf, "[BOOT] ") != NULL)
+                        ln->kind = LN_BOOT;
+                nLines++;
+        }
+        return 1;
+}
+
+/*------------------------------------------------------------
+Function: StampPeriod
+Purpose :
+Period of the stretch of lines from 'from' up to the next
+[RATE] or [BOOT] line, for a stretch the log does not state
+it for: -p when given, else the largest period all record
+stamps are multiples of, else PERIOD_DEF_MS.
+NOTE: A stretch of heartbeat records only can give a multiple
+of the real period, so less is filled; -p fixes that.
+------------------------------------------------------------*/
+static long long StampPeriod(size_t from)
+{
+        long long g = 0;
+        size_t i, n = 0;
+
+        for (i = from; i < nLines && lines[i].kind != LN_RATE && lines[i].kind != LN_BOOT; i++)
+                if (lines[i].kind == LN_INFO)
+                {
+                        g = Gcd((lines[i].t - EPOCH_2000_MS) / 1000, g);
+                        n++;
+                }
+
+        if (n == 0)
+                return periodMs ? periodMs : PERIOD_DEF_MS;
+        if (periodMs || n < 2 || g <= 0)
+        {
+                periodsDef++;
+                return periodMs ? periodMs : PERIOD_DEF_MS;
+        }
+        periodsStamp++;
+        return (g < 0 ? -g : g) * 1000;
+}
+
+//------------------------------------------------------------
+// Function: Emit
+// Purpose : Write one [INFO] line for a time and value
+//------------------------------------------------------------
+static void Emit(long long t, long temp)
+{
+        long long days = (t >= 0 ? t : t - 86399999) / 86400000;
+        int y, m, d, sod = (int)((t - days * 86400000) / 1000);
+
+        CivilFromDays(days, &y, &m, &d);
+        printf("[INFO] Temp:%ldC @%02d:%02d:%02d.%03d %02d/%02d/%04d\n",
+               temp, sod / 3600, (sod / 60) % 60, sod % 60,
+               (int)(t % 1000 + 1000) % 1000, d, m, y);
+        linesOut++;
+}
+
+/*------------------------------------------------------------
+Function: Fill
+Purpose :
+Repeats temp at every boundary of the period after *from
+and not after until, keeping the milliseconds of the record
+it repeats; *from moves to the last one written.
+------------------------------------------------------------*/
+static void Fill(long long *from, long long until, long long period, long temp)
+{
+        long long ms = ((*from % 1000) + 1000) % 1000;
+        long long k = *from - ms - EPOCH_2000_MS;
+
+        k = (k >= 0 ? k / period : (k - period + 1) / period) * period + period;
+        for (k += EPOCH_2000_MS + ms; k <= until; k += period)
+        {
+                Emit(k, temp);
+                filled++;
+                *from = k;
+        }
+}
+
+/*------------------------------------------------------------
+Function: HeartbeatDue
+Purpose :
+Time of the heartbeat record after one sent at last: the
+first period boundary at or after the heartbeat interval.
+A later record means records were lost or the device was off.
+------------------------------------------------------------*/
+static long long HeartbeatDue(long long last, long long period)
+{
+        long long k = (last - EPOCH_2000_MS) / 1000 * 1000 + heartbeatMs;
+
+        k = (k + period - 1) / period * period;
+        return k + EPOCH_2000_MS + (last % 1000);
+}
+
+int main(int argc, char **argv)
+{
+        FILE *f = stdin;
+        long long last = 0, from = 0, period;
+        long lastTemp = 0;
+        size_t n;
+        Line *ln;
+        int i, have = 0;
+
+        for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++)
+        {
+                if (strcmp(argv[i], "-a") == 0)
+                        passOther = 1;
+                else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+                {
+                        periodMs = atoll(argv[++i]) * 1000;
+                        if (periodMs <= 0)
+                                break;
+                }
+                else if (strcmp(argv[i], "-H") == 0 && i + 1 < argc)
+                        heartbeatMs = atoll(argv[++i]) * 1000;
+                else
+                        break;
+        }
+        if (i < argc - 1 || (i < argc && argv[i][0] == '-' && argv[i][1]) ||
+            heartbeatMs < (periodMs ? periodMs : PERIOD_DEF_MS))
+        {
+                fprintf(stderr, "usage: %s [-p period_s] [-H heartbeat_s] [-a] [file]\n", argv[0]);
+                return 2;
+        }
+        if (i < argc && strcmp(argv[i], "-") != 0 && (f = fopen(argv[i], "r")) == NULL)
+        {
+                perror(argv[i]);
+                return 1;
+        }
+        if (!ReadLines(f))
+        {
+                fprintf(stderr, "%s: out of memory\n", argv[0]);
+                return 1;
+        }
+
+        period = StampPeriod(0);
+        for (n = 0; n < nLines; n++)
+        {
+                ln = &lines[n];
+
+                //--------------------------------------------------
+                // A [RATE] record ends the old period at its stamp
+                // and states the new one; after a [BOOT] line the
+                // period is found again
+                //--------------------------------------------------
+                if (ln->kind == LN_RATE)
+                {
+                        if (have && ln->stamped && ln->t <= HeartbeatDue(last, period))
+                                Fill(&from, ln->t - 1, period, lastTemp);
+                        period = ln->period;
+                        periodsRate++;
+                }
+                else if (ln->kind == LN_BOOT)
+                        period = StampPeriod(n + 1);
+
+                if (ln->kind != LN_INFO)
+                {
+                        if (passOther)
+                                fputs(ln->text, stdout);
+                        continue;
+                }
+                recsIn++;
+
+                if (have && ln->t <= last)
+                {
+                        if (ln->t == last)
+                                repeats++;
+                        else
+                                unsorted++;
+                        continue;
+                }
+
+                //--------------------------------------------------
+                // Repeat the previous value at every period up to
+                // this record, unless the silence was too long to
+                // be a deadband gap
+                //--------------------------------------------------
+                if (have)
+                {
+                        if (ln->t > HeartbeatDue(last, period))
+                                gaps++;
+                        else
+                                Fill(&from, ln->t - period / 2, period, lastTemp);
+                }
+
+                Emit(ln->t, ln->temp);
+                last = from = ln->t;
+                lastTemp = ln->temp;
+                have = 1;
+        }
+
+        fprintf(stderr, "records %llu, lines %llu (%llu filled), gaps %llu, repeats %llu, unsorted %llu",
+                recsIn, linesOut, filled, gaps, repeats, unsorted);
+        if (linesOut)
+                fprintf(stderr, ", records are %.1f%% of lines", 100.0 * (recsIn - repeats - unsorted) / linesOut);
+        fprintf(stderr, "\nperiods from [RATE] %llu, from stamps %llu, default %llu\n",
+                periodsRate, periodsStamp, periodsDef);
+
+        if (f != stdin)
+                fclose(f);
+        return 0;
+}
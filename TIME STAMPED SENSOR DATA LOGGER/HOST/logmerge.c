@@ -0,0 +1,439 @@
+//logmerge.c
+/*------------------------------------------------------------
+File: logmerge.c
+Purpose:
+Host tool that merges the UART logs of many loggers into one
+time-ordered stream.
+
+Features:
+- Each input is one device's log, already in time order
+- Heap-based k-way merge: O(log N) per line
+- Buffered streaming reads; memory grows with the number of
+  inputs, never with the size of the logs
+- Per-device clock offset correction; the timestamp written
+  in the line is rewritten to the corrected time, and the
+  " #seq*CRC" trailer of a numbered record is recomputed to
+  match (or dropped when it did not check to begin with)
+- Works on raw captures and on collector archives, since the
+  time is taken from the "HH:MM:SS[.mmm] DD/MM/YYYY" stamp
+  written by DisplayUARTTime/DisplayUARTDate
+
+Lines without a stamp (e.g. [BOOT]) keep the time of the
+previous line of the same device so they stay in place.
+
+Build:
+cc -O2 -Wall -o logmerge logmerge.c
+
+Usage:
+logmerge [-B buf_KB] [-n] file[,offset_s] ...
+  offset_s : seconds added to that device (e.g. -3.25)
+  -n       : do not prefix lines with the device name
+------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define LINE_LEN 4096
+
+//------------------------------------------------------------
+// One input stream
+//------------------------------------------------------------
+typedef struct
+{
+        FILE *f;
+        char *vbuf;                    // stdio buffer
+        const char *name;              // Label for output
+        long long offsetMs;            // Clock correction
+        long long t;                   // Corrected time of line (ms)
+        long long lastRaw;             // Last stamp seen (ms)
+        int  stampPos, stampLen;       // Where the stamp is in line
+        int  hasMs;                    // Stamp carries .mmm
+        char line[LINE_LEN];
+        unsigned long long lines, unsorted;
+} Stream;
+
+static Stream *streams;
+static int *heap, heapLen;
+
+//------------------------------------------------------------
+// Function: DaysFromCivil
+// Purpose : Days since 01/01/1970 of a calendar date
+//------------------------------------------------------------
+static long long DaysFromCivil(int y, int m, int d)
+{
+        int era, yoe, doy, doe;
+
+        y -= (m <= 2);
+        era = (y >= 0 ? y : y - 399) / 400;
+        yoe = y - era * 400;
+        doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return (long long)era * 146097 + doe - 719468;
+}
+
+//------------------------------------------------------------
+// Function: CivilFromDays
+// Purpose : Calendar date of a day count (inverse of above)
+//------------------------------------------------------------
+static void CivilFromDays(long long z, int *y, int *m, int *d)
+{
+        long long era, doe, yoe, doy, mp;
+
+        z += 719468;
+        era = (z >= 0 ? z : z - 146096) / 146097;
+        doe = z - era * 146097;
+        yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        mp = (5 * doy + 2) / 153;
+        *d = doy - (153 * mp + 2) / 5 + 1;
+        *m = mp < 10 ? mp + 3 : mp - 9;
+        *y = yoe + era * 400 + (*m <= 2);
+}
+
+static int Dig(const char *p, int n)
+{
+        int v = 0;
+
+        while (n--)
+        {
+                if (!isdigit((unsigned char)*p))
+                        return -1;
+                v = v * 10 + (*p++ - '0');
+        }
+        return v;
+}
+
+/*------------------------------------------------------------
+Function: ParseStamp
+Purpose :
+Finds "HH:MM:SS[.mmm] DD/MM/YYYY" in a line.
+Return  : 1 and the time in *ms, position and length of the
+          stamp; 0 when the line has no stamp
+------------------------------------------------------------*/
+static int ParseStamp(Stream *s, long long *ms)
+{
+        const char *l = s->line, *p, *q;
+        int hh, mi, ss, frac, dd, mo, yy;
+
+        for (p = strchr(l, ':'); p != NULL; p = strchr(p + 1, ':'))
+        {
+                if (p - l < 2 || p[3] != ':')
+                        continue;
+                hh = Dig(p - 2, 2);
+                mi = Dig(p + 1, 2);
+                ss = Dig(p + 4, 2);
+                if (hh < 0 || mi < 0 || ss < 0)
+                        continue;
+
+                q = p + 6;
+                frac = 0;
+                s->hasMs = 0;
+                if (q[0] == '.' && Dig(q + 1, 3) >= 0)
+                {
+                        frac = Dig(q + 1, 3);
+                        s->hasMs = 1;
+                        q += 4;
+                }
+                while (*q == ' ')
+                        q++;
+
+                dd = Dig(q, 2);
+                mo = Dig(q + 3, 2);
+                yy = Dig(q + 6, 4);
+                if (dd < 0 || mo < 0 || yy < 0 || q[2] != '/' || q[5] != '/')
+                        continue;
+
+                *ms = ((DaysFromCivil(yy, mo, dd) * 86400LL) +
+                       hh * 3600 + mi * 60 + ss) * 1000 + frac;
+                s->stampPos = (p - 2) - l;
+                s->stampLen = (q + 10) - (p - 2);
+                return 1;
+        }
+        return 0;
+}
+
+/*------------------------------------------------------------
+Function: Advance
+Purpose :
+Reads the next line of a stream and sets its merge key.
+Return  : 1 -> line available, 0 -> end of stream
+------------------------------------------------------------*/
+static int Advance(Stream *s)
+{
+        long long raw;
+        size_t n;
+
+        if (fgets(s->line, LINE_LEN, s->f) == NULL)
+                return 0;
+
+        n = strlen(s->line);
+        while (n > 0 && (s->line[n - 1] == '\n' || s->line[n - 1] == '\r'))
+                s->line[--n] = 0;
+        s->lines++;
+
+        if (ParseStamp(s, &raw))
+        {
+                if (raw < s->lastRaw)
+                        s->unsorted++;
+                s->lastRaw = raw;
+        }
+        else
+                s->stampLen = 0;
+
+        s->t = s->lastRaw + s->offsetMs;
+        return 1;
+}
+
+//------------------------------------------------------------
+// Function: Less
+// Purpose : Heap order: time, then input order (stable)
+//------------------------------------------------------------
+static int Less(int a, int b)
+{
+        if (streams[a].t != streams[b].t)
+                return streams[a].t < streams[b].t;
+        return a < b;
+}
+
+static void SiftDown(int i)
+{
+        int c, tmp;
+
+        for (;;)
+        {
+                c = 2 * i + 1;
+                if (c >= heapLen)
+                        return;
+                if (c + 1 < heapLen && Less(heap[c + 1], heap[c]))
+                        c++;
+                if (!Less(heap[c], heap[i]))
+                        return;
+                tmp = heap[c]; heap[c] = heap[i]; heap[i] = tmp;
+                i = c;
+        }
+}
+
+//------------------------------------------------------------
+// Function: Crc16
+// Purpose : CRC-16/CCITT (poly 0x1021, init 0xFFFF) of the
+//           record trailer, as in collector.c
+//------------------------------------------------------------
+static unsigned Crc16(const char *buf, int len)
+{
+        unsigned crc = 0xFFFF;
+        int i;
+
+        while (len--)
+        {
+                crc ^= (unsigned)(unsigned char)*buf++ << 8;
+                for (i = 0; i < 8; i++)
+                        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+        return crc & 0xFFFF;
+}
+
+/*------------------------------------------------------------
+Function: FindTrailer
+Purpose :
+Finds a " #<seq>*<XXXX>" trailer at the end of a line.
+Return  : Offset of the '*', or -1 when there is none
+------------------------------------------------------------*/
+static int FindTrailer(const char *l, int len)
+{
+        const char *p;
+        int i;
+
+        if (len < 8 || l[len - 5] != '*')
+                return -1;
+        for (i = len - 4; i < len; i++)
+                if (!isdigit((unsigned char)l[i]) && (l[i] < 'A' || l[i] > 'F'))
+                        return -1;
+
+        for (p = l + len - 5; p > l && isdigit((unsigned char)p[-1]); p--)
+                ;
+        if (p == l + len - 5 || p - l < 2 || p[-1] != '#' || p[-2] != ' ')
+                return -1;
+        return len - 5;
+}
+
+/*------------------------------------------------------------
+Function: RecordStart
+Purpose :
+Finds where the text covered by the trailer CRC begins: at
+the start of a raw capture line, or after the "<ms> <port> "
+prefix of a collector archive line.
+Return  : Offset of the record text, -1 when the CRC does not
+          match either way
+------------------------------------------------------------*/
+static int RecordStart(const char *l, int star)
+{
+        unsigned crc = (unsigned)strtoul(l + star + 1, NULL, 16);
+        int r = 0, f;
+
+        for (f = 0; f <= 2; f++)
+        {
+                if (Crc16(l + r, star - r) == crc)
+                        return r;
+                if (!isdigit((unsigned char)l[r]))
+                        return -1;
+                while (isdigit((unsigned char)l[r]))
+                        r++;
+                if (l[r] != ' ')
+                        return -1;
+                r++;
+        }
+        return -1;
+}
+
+/*------------------------------------------------------------
+Function: Emit
+Purpose :
+Writes one line, with the device label and, when the device
+has an offset, the stamp rewritten to the corrected time. A
+" #seq*CRC" trailer that covered the old stamp is recomputed
+over the new one, so the line still checks; one that did not
+check before is dropped rather than left stale.
+------------------------------------------------------------*/
+static void Emit(Stream *s, int label)
+{
+        char out[LINE_LEN + 32];
+        long long t, days;
+        int y, m, d, sod, len, star, rec;
+
+        if (label)
+        {
+                fputs(s->name, stdout);
+                putchar(' ');
+        }
+
+        if (s->stampLen == 0 || s->offsetMs == 0)
+        {
+                puts(s->line);
+                return;
+        }
+
+        len = (int)strlen(s->line);
+        star = FindTrailer(s->line, len);
+        rec = (star >= 0) ? RecordStart(s->line, star) : -1;
+
+        t = s->t;
+        days = (t >= 0 ? t : t - 86399999) / 86400000;
+        sod = (int)((t - days * 86400000) / 1000);
+        CivilFromDays(days, &y, &m, &d);
+
+        memcpy(out, s->line, s->stampPos);
+        len = s->stampPos;
+        len += sprintf(out + len, "%02d:%02d:%02d", sod / 3600, (sod / 60) % 60, sod % 60);
+        if (s->hasMs)
+                len += sprintf(out + len, ".%03d", (int)(t % 1000 + 1000) % 1000);
+        len += sprintf(out + len, " %02d/%02d/%04d", d, m, y);
+        strcpy(out + len, s->line + s->stampPos + s->stampLen);
+
+        //----------------------------------------------------------
+        // Trailer: it follows the stamp, so it moves by any
+        // change in the stamp's length
+        //----------------------------------------------------------
+        if (star >= 0 && star > s->stampPos)
+        {
+                star += len - (s->stampPos + s->stampLen);
+                if (rec >= 0 && rec <= s->stampPos)
+                        sprintf(out + star + 1, "%04X", Crc16(out + rec, star - rec));
+                else
+                {
+                        while (star > 0 && out[star] != '#')
+                                star--;
+                        out[star - 1] = 0;
+                }
+        }
+        puts(out);
+}
+
+int main(int argc, char **argv)
+{
+        size_t bufSize = 1 << 20;
+        int i, n = 0, label = 1;
+        char *comma;
+        Stream *s;
+
+        //----------------------------------------------------------
+        // Options before the file list
+        //----------------------------------------------------------
+        for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++)
+        {
+                if (strcmp(argv[i], "-n") == 0)
+                        label = 0;
+                else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc)
+                        bufSize = (size_t)atoi(argv[++i]) << 10;
+                else
+                        break;
+        }
+
+        if (i >= argc)
+        {
+                fprintf(stderr, "usage: %s [-B buf_KB] [-n] file[,offset_s] ...\n", argv[0]);
+                return 1;
+        }
+
+        streams = calloc(argc - i, sizeof(Stream));
+        heap = calloc(argc - i, sizeof(int));
+        if (streams == NULL || heap == NULL)
+                return 1;
+
+        //----------------------------------------------------------
+        // Open every input and load its first line
+        //----------------------------------------------------------
+        for (; i < argc; i++, n++)
+        {
+                s = &streams[n];
+                s->name = argv[i];
+                comma = strrchr(argv[i], ',');
+                if (comma != NULL)
+                {
+                        *comma = 0;
+                        s->offsetMs = (long long)(atof(comma + 1) * 1000.0 +
+                                                  (comma[1] == '-' ? -0.5 : 0.5));
+                }
+
+                s->f = fopen(s->name, "r");
+                if (s->f == NULL)
+                {
+                        perror(s->name);
+                        return 1;
+                }
+                s->vbuf = malloc(bufSize);
+                if (s->vbuf != NULL)
+                        setvbuf(s->f, s->vbuf, _IOFBF, bufSize);
+
+                if (Advance(s))
+                        heap[heapLen++] = n;
+        }
+
+        for (i = heapLen / 2 - 1; i >= 0; i--)
+                SiftDown(i);
+
+        //----------------------------------------------------------
+        // Merge: emit smallest, refill from the same stream
+        //----------------------------------------------------------
+        while (heapLen > 0)
+        {
+                s = &streams[heap[0]];
+                Emit(s, label);
+
+                if (!Advance(s))
+                        heap[0] = heap[--heapLen];
+                SiftDown(0);
+        }
+
+        for (i = 0; i < n; i++)
+        {
+                if (streams[i].unsorted)
+                        fprintf(stderr, "%s: %llu of %llu lines out of order\n",
+                                streams[i].name, streams[i].unsorted, streams[i].lines);
+                fclose(streams[i].f);
+                free(streams[i].vbuf);
+        }
+
+        return 0;
+}
@@ -0,0 +1,33 @@
+//lpc214x.h
+/*------------------------------------------------------------
+File: lpc214x.h
+Purpose:
+Stand-in for the Keil register header in host builds
+(HOST_BUILD), found through -I../HOST by modules that are
+linked into a host tool as they are.
+
+Only the registers those modules touch are declared, as
+plain variables; the tool defines them once with
+LPC214X_SIM_DEFINE before including this header.
+------------------------------------------------------------*/
+
+#ifndef __LPC214X_SIM_H__
+#define __LPC214X_SIM_H__
+
+#ifdef LPC214X_SIM_DEFINE
+#define LPC_SIM_REG   volatile unsigned long
+#else
+#define LPC_SIM_REG   extern volatile unsigned long
+#endif
+
+//------------------------------------------------------------
+// GPIO port 0 (LED, buzzer, switch)
+//------------------------------------------------------------
+LPC_SIM_REG IOPIN0, IOSET0, IOCLR0, IODIR0;
+
+//------------------------------------------------------------
+// RTC time counters (RTC edit menu)
+//------------------------------------------------------------
+LPC_SIM_REG SEC, MIN, HOUR, DOM, DOW, MONTH, YEAR;
+
+#endif
@@ -0,0 +1,169 @@
+//pipe_latency.c
+/*------------------------------------------------------------
+File: pipe_latency.c
+Purpose:
+Host benchmark for the start/collect ADC conversions of the
+sampling pipeline's FAST stage.
+
+Runs the firmware's pipeline (pipeline.c) against the
+virtual Timer0 (timer_sim.c) and ADC (adc_sim.c). Every main
+loop pass calls PipelineRun() and then spends a fixed time
+on other work (LCD, UART), as DisplayInformation() does.
+The same run is made twice:
+- overlap : the pipeline as built; a conversion started in
+            one pass is collected in a later one
+- blocking: after every PipelineRun() the loop waits for the
+            conversion it started, like Read_ADC did
+
+Reports, per run:
+- Samples taken and slots skipped at the fast rate
+- Time the main loop spent waiting on the ADC, in total and
+  per sample
+- Conversion time that ran during other work (hidden)
+- Mean and longest time from start to collect, i.e. the
+  latency a sample gains by being collected late
+
+Exit status is 1 if the overlap run waited on the ADC at all
+or took fewer samples than the blocking run.
+
+Build:
+cc -O2 -Wall -DHOST_BUILD -I../TYPES -I../PIPELINE -I../ADC -I../LM35 -I../RTC -I../TIMER -o pipe_latency pipe_latency.c ../PIPELINE/pipeline.c ../LM35/lm35.c ../ADC/adc_sim.c ../TIMER/timer_sim.c ../RTC/rtc_cal.c ../RTC/rtc_sim.c
+
+Usage:
+pipe_latency [-s seconds] [-r rate_hz] [-c conv_us] [-w work_us]
+  seconds : simulated time per run (default 60)
+  rate_hz : fast stage rate (default PIPE_FAST_HZ)
+  conv_us : ADC conversion time (default ADC_CONV_US)
+  work_us : other work per main loop pass (default 150)
+------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "types.h"
+#include "adc.h"
+#include "adc_defines.h"
+#include "pipeline.h"
+#include "rtc.h"
+#include "timer.h"
+
+//------------------------------------------------------------
+// Result of one run
+//------------------------------------------------------------
+typedef struct
+{
+        unsigned long samples, skipped, passes;
+        unsigned long blockedUs, hiddenUs, runUs, runMax;
+} RunResult;
+
+//------------------------------------------------------------
+// Function: Advance
+// Purpose : Move the virtual Timer0 and RTC together
+//------------------------------------------------------------
+static void Advance(u32 us)
+{
+        TimerSimAdvance(us);
+        RTCSimAdvance(us);
+}
+
+//------------------------------------------------------------
+// Function: Run
+// Purpose : Simulate the main loop for sec seconds
+//------------------------------------------------------------
+static void Run(RunResult *r, u32 sec, u32 hz, u32 convUs, u32 workUs, int blocking)
+{
+        u32 end, t0;
+
+        InitTimer0();
+        RTC_Init();
+        InitRTCStamp();
+        ADCSimInit(convUs);
+        ADCSimSet(310);                 // About 100.0 tenths
+        InitPipeline(1);
+        PipelineSetRate(hz);
+
+        memset(r, 0, sizeof(*r));
+        t0 = Timer0Now();
+        end = t0 + sec * 1000000;
+
+        while ((s32)(Timer0Now() - end) < 0)
+        {
+                PipelineRun();
+                if (blocking && ADCSimBusy())
+                {
+                        ADCSimWait();
+                        PipelineRun();
+                }
+                Advance(workUs);
+                r->passes++;
+        }
+
+        r->samples   = pipeStats.samples;
+        r->skipped   = pipeStats.skipped;
+        r->blockedUs = adcSimStats.blockedUs;
+        r->hiddenUs  = adcSimStats.hiddenUs;
+        r->runUs     = adcSimStats.runUs;
+        r->runMax    = adcSimStats.runMax;
+}
+
+//------------------------------------------------------------
+// Function: Report
+// Purpose : Print one run
+//------------------------------------------------------------
+static void Report(const char *name, const RunResult *r, u32 sec)
+{
+        unsigned long n = r->samples ? r->samples : 1;
+
+        printf("%-8s: %lu samples, %lu skipped, %lu passes\n",
+               name, r->samples, r->skipped, r->passes);
+        printf("          waiting on ADC %lu us (%.3f%% of the loop), %.2f us/sample\n",
+               r->blockedUs, r->blockedUs / (sec * 1e4), (double)r->blockedUs / n);
+        printf("          hidden %.2f us/sample, start->collect mean %.1f us, max %lu us\n",
+               (double)r->hiddenUs / n, (double)r->runUs / n, r->runMax);
+}
+
+//------------------------------------------------------------
+// Function: main
+//------------------------------------------------------------
+int main(int argc, char **argv)
+{
+        unsigned sec = 60, hz = PIPE_FAST_HZ, convUs = ADC_CONV_US, workUs = 150;
+        RunResult ovl, blk;
+        int i;
+
+        for (i = 1; i < argc; i++)
+        {
+                if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+                        sec = (unsigned)atoi(argv[++i]);
+                else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+                        hz = (unsigned)atoi(argv[++i]);
+                else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+                        convUs = (unsigned)atoi(argv[++i]);
+                else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+                        workUs = (unsigned)atoi(argv[++i]);
+                else
+                        break;
+        }
+        if (i < argc || sec == 0 || sec > 3600 || hz == 0 || hz > PIPE_FAST_HZ_MAX ||
+            convUs == 0 || convUs >= ADC_TIMEOUT_US || workUs == 0)
+        {
+                fprintf(stderr, "usage: %s [-s seconds] [-r rate_hz] [-c conv_us] [-w work_us]\n", argv[0]);
+                return 2;
+        }
+
+        printf("%u s at %u Hz, conversion %u us, other work %u us per pass\n",
+               sec, hz, convUs, workUs);
+
+        Run(&ovl, sec, hz, convUs, workUs, 0);
+        Run(&blk, sec, hz, convUs, workUs, 1);
+        Report("overlap", &ovl, sec);
+        Report("blocking", &blk, sec);
+
+        printf("hidden  : %.2f us per sample (%.3f%% of the loop) no longer spent waiting\n",
+               (double)blk.blockedUs / (blk.samples ? blk.samples : 1) -
+               (double)ovl.blockedUs / (ovl.samples ? ovl.samples : 1),
+               (blk.blockedUs - ovl.blockedUs) / (sec * 1e4));
+
+        return (ovl.blockedUs != 0 || ovl.samples < blk.samples) ? 1 : 0;
+}
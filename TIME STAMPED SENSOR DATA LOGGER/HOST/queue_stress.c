@@ -0,0 +1,203 @@
+//queue_stress.c
+/*------------------------------------------------------------
+File: queue_stress.c
+Purpose:
+Host stress test and throughput benchmark for the SPSC queue
+library (queue.c).
+
+A producer thread pushes numbered elements in batches of
+varying size and a consumer thread pops them in batches of a
+different size, on two cores, with no lock between them. This
+is the hand-off between an ISR and main() on the target, with
+real concurrency and a weaker memory order than ARM7 has.
+A side that finds the queue full or empty yields its core,
+so the test also completes on a single-core host.
+
+Checks, for every element popped:
+- Its number is one more than the last one (lost, duplicated
+  or reordered elements are counted)
+- Its check word matches its number (an element read before
+  the producer finished writing it, or after it was reused)
+
+Prints elements per second at the end.
+Exit status is 1 if any check failed.
+
+Build:
+cc -O2 -Wall -pthread -DHOST_BUILD -I../TYPES -I../QUEUE -o queue_stress queue_stress.c ../QUEUE/queue.c
+
+Usage:
+queue_stress [-n elements] [-c capacity]
+  elements : elements to pass (default 100000000)
+  capacity : queue length, power of two (default 64)
+------------------------------------------------------------*/
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "types.h"
+#include "queue.h"
+
+#define BATCH_MAX 16           // Largest push/pop batch
+
+//------------------------------------------------------------
+// Element: 16 bytes like a LogRec, number first and a word
+// derived from it last, so a half-copied element shows
+//------------------------------------------------------------
+typedef struct
+{
+        u32 seq;
+        u32 pad[2];
+        u32 check;
+} Elem;
+
+#define CHECK(seq)  ((seq) * 2654435761U ^ 0xA5A5A5A5U)
+
+static Queue q;
+static Elem *store;
+static unsigned long long total;
+
+//------------------------------------------------------------
+// Results (full: producer only, the rest: consumer only)
+//------------------------------------------------------------
+static unsigned long long outOfOrder, torn, pushFull, popEmpty;
+
+//------------------------------------------------------------
+// Function: WallSeconds
+// Purpose : Monotonic wall-clock time
+//------------------------------------------------------------
+static double WallSeconds(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//------------------------------------------------------------
+// Function: Producer
+// Purpose : Push elements 0..total-1, batch sizes 1..BATCH_MAX
+//------------------------------------------------------------
+static void *Producer(void *arg)
+{
+        Elem batch[BATCH_MAX];
+        unsigned long long sent = 0;
+        u32 n, i, done, want = 1;
+
+        (void)arg;
+        while (sent < total)
+        {
+                n = want;
+                if (n > total - sent)
+                        n = (u32)(total - sent);
+                for (i = 0; i < n; i++)
+                {
+                        batch[i].seq = (u32)(sent + i);
+                        batch[i].pad[0] = batch[i].pad[1] = 0;
+                        batch[i].check = CHECK(batch[i].seq);
+                }
+
+                done = 0;
+                while (done < n)
+                {
+                        i = QueuePushN(&q, batch + done, n - done);
+                        if (i == 0)
+                        {
+                                pushFull++;
+                                sched_yield();
+                        }
+                        done += i;
+                }
+                sent += n;
+                want = want % BATCH_MAX + 1;
+        }
+        return NULL;
+}
+
+//------------------------------------------------------------
+// Function: Consumer
+// Purpose : Pop and check every element, batch sizes
+//           BATCH_MAX..1
+//------------------------------------------------------------
+static void *Consumer(void *arg)
+{
+        Elem batch[BATCH_MAX];
+        unsigned long long got = 0;
+        u32 n, i, expect = 0, want = BATCH_MAX;
+
+        (void)arg;
+        while (got < total)
+        {
+                n = QueuePopN(&q, batch, want);
+                if (n == 0)
+                {
+                        popEmpty++;
+                        sched_yield();
+                        continue;
+                }
+                for (i = 0; i < n; i++)
+                {
+                        if (batch[i].check != CHECK(batch[i].seq))
+                                torn++;
+                        if (batch[i].seq != expect)
+                                outOfOrder++;
+                        expect = batch[i].seq + 1;
+                }
+                got += n;
+                want = (want == 1) ? BATCH_MAX : want - 1;
+        }
+        return NULL;
+}
+
+//------------------------------------------------------------
+// Function: main
+//------------------------------------------------------------
+int main(int argc, char **argv)
+{
+        unsigned long long n = 100000000ULL;
+        unsigned cap = 64;
+        pthread_t prod, cons;
+        double wall;
+        int i;
+
+        for (i = 1; i < argc; i++)
+        {
+                if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+                        n = strtoull(argv[++i], NULL, 10);
+                else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+                        cap = (unsigned)atoi(argv[++i]);
+                else
+                        break;
+        }
+
+        store = malloc((size_t)cap * sizeof(Elem));
+        if (i < argc || n == 0 || store == NULL || !QueueInit(&q, store, sizeof(Elem), cap))
+        {
+                fprintf(stderr, "usage: %s [-n elements] [-c capacity]\n", argv[0]);
+                return 2;
+        }
+        total = n;
+
+        wall = WallSeconds();
+        pthread_create(&cons, NULL, Consumer, NULL);
+        pthread_create(&prod, NULL, Producer, NULL);
+        pthread_join(prod, NULL);
+        pthread_join(cons, NULL);
+        wall = WallSeconds() - wall;
+
+        printf("elements     : %llu (capacity %u, %u-byte elements)\n",
+               total, cap, (unsigned)sizeof(Elem));
+        printf("out of order : %llu\n", outOfOrder);
+        printf("torn         : %llu\n", torn);
+        printf("queue full   : %llu pushes\n", pushFull);
+        printf("queue empty  : %llu pops\n", popEmpty);
+        printf("throughput   : %.1f M elements/s (%.3f s)\n",
+               total / wall / 1e6, wall);
+
+        free(store);
+        return (outOfOrder || torn || QueueCount(&q)) ? 1 : 0;
+}
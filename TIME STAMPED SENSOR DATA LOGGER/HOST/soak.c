@@ -0,0 +1,576 @@
+//soak.c
+/*------------------------------------------------------------
+File: soak.c
+Purpose:
+Host soak benchmark for the time-keeping and logging logic.
+
+Runs the firmware's main loop work, DisplayInformation() and
+SeqLogPoll(), set up as main() in project.c does, for as many
+simulated days as asked, at full CPU speed. The modules are
+the firmware's own (DisplayInformation.c, bus.c, seqlog.c,
+uart.c formatting, pipeline.c, rate.c, stats.c, sensor.c,
+trend.c, lm35.c, rtc_cal.c); the peripherals are the host
+stand-ins (rtc_sim.c, timer_sim.c, adc_sim.c, uart_sim.c,
+lcd_sim.c, keypad_sim.c, config_sim.c, clock_sim.c and
+HOST/lpc214x.h). Every UART line is checked as it is sent.
+
+Input: 25.0 C, except from 12:00 to 13:00 every day, when
+it ramps up to 50.0 C at 12:30 and back down, so each day
+crosses the 45 C set point once: the rate scheduler, the
+clock profile switch, alerts, warnings and a capture all
+run. The pipeline takes one sample per poll at every rate
+level, and deadband logging is off, so every log period
+gives one record.
+
+Checks, for every simulated second:
+- The time stamp is exactly one second after the last one
+  (missed / duplicated seconds are counted)
+- Time, date and day of week match the C library calendar
+  (leap days, month and year rollover)
+
+Checks, for every numbered UART record:
+- Its " #seq*CRC" trailer is present and its CRC matches
+- Its sequence number is one more than the last one on the
+  same port (gaps / repeats are counted)
+
+Checks, for every PERIOD record published on the sample bus
+(seen by a sink attached after the firmware's own):
+- Unless the log period changed during it: it comes exactly
+  one log period after the previous one and the RTC reads a
+  multiple of the period
+- Unless it is the first one after a change: it holds one
+  sample per poll
+- Unless it is an alert period: the [INFO] line just sent
+  carries its time stamp
+
+Checks, for every [STAT] window:
+- It comes one window length after the previous one of the
+  same length, on a multiple of the length, and holds one
+  sample per second (the first one may be partial)
+
+Checks, for every [RATE] record: the clock profile reported
+is CLK_LOW at level 0 and CLK_PERF above it.
+
+At the end: no sink of the bus lost a sample, and there was
+at least one [ALERT], [WARN], [CAPT] and clock switch.
+
+Prints simulated seconds per wall-clock second at the end.
+Exit status is 1 if any check failed.
+
+Build:
+cc -O2 -Wall -Wno-pointer-sign -DHOST_BUILD -I. -I../TYPES -I../DEFINES -I../MACROS -I../PT -I../RTC -I../STATS -I../PIPELINE -I../ADC -I../LM35 -I../TIMER -I../UART -I../LCD -I../KEYPAD -I../CONFIG -I../CLOCK -I../BUS -I../SEQLOG -I../CRC -I../RATE -I../SENSOR -I../TREND -I../BLKLOG -I../DISPLAYINFORMATION -o soak soak.c ../DISPLAYINFORMATION/DisplayInformation.c ../BUS/bus.c ../SEQLOG/seqlog.c ../CRC/crc.c ../UART/uart.c ../UART/uart_sim.c ../LCD/lcd_sim.c ../KEYPAD/keypad_sim.c ../CONFIG/config_sim.c ../CLOCK/clock_sim.c ../RTC/rtc_cal.c ../RTC/rtc_sim.c ../STATS/stats.c ../PIPELINE/pipeline.c ../LM35/lm35.c ../ADC/adc_sim.c ../TIMER/timer_sim.c ../RATE/rate.c ../SENSOR/sensor.c ../TREND/trend.c
+
+Usage:
+soak [-d days] [-s DD/MM/YYYY] [-p poll_ms]
+  days    : simulated days (default 731: 2023 and 2024)
+  poll_ms : main loop period, a divisor of 1000 up to 500
+            (default 250); slower loops cannot stream a capture
+            out before the sink backlogs fill
+------------------------------------------------------------*/
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LPC214X_SIM_DEFINE
+#include <lpc214x.h>              // Register stand-ins, defined here
+
+#include "types.h"
+#include "rtc.h"
+#include "stats.h"
+#include "adc.h"
+#include "adc_defines.h"
+#include "pipeline.h"
+#include "timer.h"
+#include "uart.h"
+#include "lcd.h"
+#include "bus.h"
+#include "crc.h"
+#include "seqlog.h"
+#include "rate.h"
+#include "sensor.h"
+#include "trend.h"
+#include "config.h"
+#include "clock.h"
+#include "lm35.h"
+#include "DisplayInformation.h"
+
+#define EPOCH_2000 946684800LL    // 01/01/2000 00:00:00 in Unix time
+
+//------------------------------------------------------------
+// Input profile (tenths of a degree, seconds of the day)
+//------------------------------------------------------------
+#define SOAK_BASE_T     250
+#define SOAK_PEAK_T     500
+#define SOAK_RAMP_FROM  (12 * 3600)
+#define SOAK_RAMP_S     1800
+
+//------------------------------------------------------------
+// Set by project.c on the target
+//------------------------------------------------------------
+u32 edit_flag;
+
+static const char *winName[STATS_NUM_WIN] = { "minute", "hour", "day" };
+static const u32 winLen[STATS_NUM_WIN] = { STATS_LEN_MIN, STATS_LEN_HOUR, STATS_LEN_DAY };
+
+//------------------------------------------------------------
+// Results
+//------------------------------------------------------------
+static unsigned long long secMissed, secDup, calBad;
+static unsigned long long winClosed[STATS_NUM_WIN], winMissed[STATS_NUM_WIN];
+static unsigned long long winDup[STATS_NUM_WIN], winShort[STATS_NUM_WIN];
+static unsigned long long winMisaligned[STATS_NUM_WIN];
+static unsigned leapDays;
+static unsigned long long perClosed, perMissed, perDup, perShort, perMisaligned;
+static unsigned long long perChanged, perAlert, infoMissing, infoLines;
+static unsigned long long recs, recBadCrc, recNoTrailer, seqGap, seqRepeat;
+static unsigned long long rateRecs, rateBadClk, alerts, warns, capts;
+
+//------------------------------------------------------------
+// State shared by the line hook, the bus sink and the loop
+//------------------------------------------------------------
+static u32 pollMs = 250;
+static u32 seqNextOf[UART_PORTS], seqSeen[UART_PORTS];
+static u32 infoSec, infoUs, haveInfo;
+static u32 winNext[STATS_NUM_WIN];
+static u32 perNext, perLog, perPartial, chgBefore, chgAtLast, logBefore;
+
+//------------------------------------------------------------
+// Function: WallSeconds
+// Purpose : Monotonic wall-clock time
+//------------------------------------------------------------
+static double WallSeconds(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//------------------------------------------------------------
+// Function: CheckCalendar
+// Purpose : Compare the RTC fields with the C library's view
+//           of the same second
+//------------------------------------------------------------
+static void CheckCalendar(u32 sec)
+{
+        time_t t = (time_t)(EPOCH_2000 + sec);
+        struct tm tm;
+        u32 h, m, s, dom, mon, yr, dow;
+
+        gmtime_r(&t, &tm);
+        GetRTCTimeInfo(&h, &m, &s);
+        GetRTCDateInfo(&dom, &mon, &yr);
+        GetRTCDay(&dow);
+
+        if (h != (u32)tm.tm_hour || m != (u32)tm.tm_min || s != (u32)tm.tm_sec ||
+            dom != (u32)tm.tm_mday || mon != (u32)tm.tm_mon + 1 ||
+            yr != (u32)tm.tm_year + 1900 || dow != (u32)tm.tm_wday)
+        {
+                if (calBad++ < 5)
+                        fprintf(stderr, "calendar: sec %u reads %02u:%02u:%02u %02u/%02u/%04u dow %u\n",
+                                sec, h, m, s, dom, mon, yr, dow);
+        }
+}
+
+//------------------------------------------------------------
+// Function: ParseStamp
+// Purpose : Time of a record's "@HH:MM:SS.mmm DD/MM/YYYY"
+// Return  : 1 -> *sec (since 01/01/2000) and *ms set
+//------------------------------------------------------------
+static int ParseStamp(const char *line, u32 *sec, u32 *ms)
+{
+        const char *at = strstr(line, " @");
+        unsigned hh, mi, ss, mm, dd, mo, yy;
+        struct tm tm;
+
+        if (at == NULL ||
+            sscanf(at + 2, "%2u:%2u:%2u.%3u %2u/%2u/%4u", &hh, &mi, &ss, &mm, &dd, &mo, &yy) != 7)
+                return 0;
+
+        memset(&tm, 0, sizeof(tm));
+        tm.tm_hour = hh;
+        tm.tm_min  = mi;
+        tm.tm_sec  = ss;
+        tm.tm_mday = dd;
+        tm.tm_mon  = mo - 1;
+        tm.tm_year = yy - 1900;
+        *sec = (u32)(timegm(&tm) - EPOCH_2000);
+        *ms = mm;
+        return 1;
+}
+
+/*------------------------------------------------------------
+Function: CheckTrailer
+Purpose :
+Checks the " #seq*CRC" trailer of a record against the text
+before the '*' and the sequence of its port.
+------------------------------------------------------------*/
+static void CheckTrailer(u32 port, const s8 *line, u32 len)
+{
+        const char *l = (const char *)line, *hash;
+        unsigned crc, seq;
+
+        recs++;
+        hash = strrchr(l, '#');
+        if (len < 8 || l[len - 5] != '*' || hash == NULL || hash == l || hash[-1] != ' ' ||
+            sscanf(hash + 1, "%u*%4X", &seq, &crc) != 2)
+        {
+                if (recNoTrailer++ < 5)
+                        fprintf(stderr, "no trailer: %s\n", l);
+                return;
+        }
+
+        if (Crc16((const u8 *)l, len - 5) != crc)
+        {
+                if (recBadCrc++ < 5)
+                        fprintf(stderr, "bad CRC: %s\n", l);
+        }
+
+        if (seqSeen[port])
+        {
+                if (seq > seqNextOf[port])
+                        seqGap += seq - seqNextOf[port];
+                else if (seq < seqNextOf[port])
+                        seqRepeat++;
+        }
+        seqSeen[port] = 1;
+        seqNextOf[port] = seq + 1;
+}
+
+//------------------------------------------------------------
+// Function: CheckStat
+// Purpose : Cadence, fill and boundary of one [STAT] window
+//------------------------------------------------------------
+static void CheckStat(const char *l)
+{
+        unsigned ch, len, n;
+        u32 w, sec, ms;
+
+        if (sscanf(l, "[STAT] CH%u %us n:%u", &ch, &len, &n) != 3 || !ParseStamp(l, &sec, &ms))
+                return;
+        for (w = 0; w < STATS_NUM_WIN; w++)
+                if (len == winLen[w])
+                        break;
+        if (w == STATS_NUM_WIN)
+                return;
+
+        winClosed[w]++;
+
+        //----------------------------------------------------------
+        // Closed by the first second of the next window, which
+        // is one window after the previous closing
+        //----------------------------------------------------------
+        if (sec % len != 0)
+                winMisaligned[w]++;
+        if (winNext[w] != 0)
+        {
+                if (sec > winNext[w])
+                        winMissed[w] += (sec - winNext[w]) / len;
+                else if (sec < winNext[w])
+                        winDup[w]++;
+        }
+        winNext[w] = sec - sec % len + len;
+
+        //----------------------------------------------------------
+        // The first window may be partial, every other one full
+        //----------------------------------------------------------
+        if (winClosed[w] > 1 && n != len)
+                winShort[w]++;
+}
+
+//------------------------------------------------------------
+// Function: CheckRate
+// Purpose : Clock profile reported with a rate level
+//------------------------------------------------------------
+static void CheckRate(const char *l)
+{
+        unsigned level;
+        const char *clk = strstr(l, " clk:");
+
+        rateRecs++;
+        if (sscanf(l, "[RATE] L:%u", &level) != 1 || clk == NULL ||
+            strncmp(clk + 5, level <= RATE_CLK_LOW_MAX ? "LOW " : "PERF ",
+                    level <= RATE_CLK_LOW_MAX ? 4 : 5) != 0)
+                rateBadClk++;
+}
+
+/*------------------------------------------------------------
+Function: OnLine
+Purpose :
+UART line hook: every line is a numbered record; the kinds
+with a cadence are checked further.
+------------------------------------------------------------*/
+static void OnLine(u32 port, const s8 *line, u32 len)
+{
+        const char *l = (const char *)line;
+        u32 ms;
+
+        CheckTrailer(port, line, len);
+
+        if (strncmp(l, "[INFO] ", 7) == 0)
+        {
+                infoLines++;
+                haveInfo = ParseStamp(l, &infoSec, &ms);
+                infoUs = ms * 1000;
+        }
+        else if (strncmp(l, "[STAT] ", 7) == 0)
+                CheckStat(l);
+        else if (strncmp(l, "[RATE] ", 7) == 0)
+                CheckRate(l);
+        else if (strncmp(l, "[ALERT] ", 8) == 0)
+                alerts++;
+        else if (strncmp(l, "[WARN] ", 7) == 0)
+                warns++;
+        else if (strncmp(l, "[CAPT] ", 7) == 0)
+                capts++;
+}
+
+/*------------------------------------------------------------
+Function: PeriodSink
+Purpose :
+Bus sink for PERIOD records, attached after the firmware's
+sinks, so the text sink has already sent the [INFO] line of
+the same record.
+------------------------------------------------------------*/
+static void PeriodSink(const Sample *s)
+{
+        u32 now = s->at.sec, logSec = logBefore;
+
+        perClosed++;
+
+        //----------------------------------------------------------
+        // Not an alert period: the [INFO] line went out for it
+        //----------------------------------------------------------
+        if (s->kind & BUS_ALERT)
+                perAlert++;
+        else if (!haveInfo || infoSec != now || infoUs / 1000 != s->at.us / 1000)
+                infoMissing++;
+        haveInfo = 0;
+
+        //----------------------------------------------------------
+        // A period change closes the open record early and the
+        // next one starts mid-period; the cadence restarts there
+        //----------------------------------------------------------
+        if (perClosed == 1 || chgBefore != chgAtLast || logSec != perLog)
+        {
+                chgAtLast = chgBefore;
+                perLog = logSec;
+                perChanged++;
+                perPartial = 1;
+                perNext = now - now % logSec + logSec;
+                return;
+        }
+
+        if (now % logSec != 0)
+                perMisaligned++;
+        if (now > perNext)
+                perMissed += (now - perNext) / logSec;
+        else if (now < perNext)
+                perDup++;
+        perNext = now - now % logSec + logSec;
+
+        if (perPartial)
+                perPartial = 0;
+        else if (s->rec.n != logSec * (1000 / pollMs))
+        {
+                if (perShort++ < 5)
+                        fprintf(stderr, "short period: sec %u n %u log %u\n", now, s->rec.n, logSec);
+        }
+}
+
+static const BusSink periodSink = { BUS_PERIOD, 0, 0, PeriodSink };
+
+//------------------------------------------------------------
+// Function: SoakCount
+// Purpose : ADC count of the input at a second of the day
+//------------------------------------------------------------
+static u32 SoakCount(u32 sod)
+{
+        s32 t = SOAK_BASE_T;
+        u32 d;
+
+        if (sod >= SOAK_RAMP_FROM && sod < SOAK_RAMP_FROM + 2 * SOAK_RAMP_S)
+        {
+                d = sod - SOAK_RAMP_FROM;
+                if (d > SOAK_RAMP_S)
+                        d = 2 * SOAK_RAMP_S - d;
+                t += (s32)((SOAK_PEAK_T - SOAK_BASE_T) * d / SOAK_RAMP_S);
+        }
+        return LM35TenthsToCount(t);
+}
+
+int main(int argc, char **argv)
+{
+        unsigned days = 731, dom = 1, mon = 1, yr = 2023;
+        unsigned long long simUs, endUs, dropped = 0, switches = 0;
+        RTCStamp st;
+        struct tm tm;
+        time_t t0;
+        u32 last, expect, i, d, mo, y, clk;
+        double wall;
+        int i0, fail;
+
+        for (i0 = 1; i0 < argc; i0++)
+        {
+                if (strcmp(argv[i0], "-d") == 0 && i0 + 1 < argc)
+                        days = (unsigned)atoi(argv[++i0]);
+                else if (strcmp(argv[i0], "-s") == 0 && i0 + 1 < argc &&
+                         sscanf(argv[++i0], "%u/%u/%u", &dom, &mon, &yr) == 3)
+                        ;
+                else if (strcmp(argv[i0], "-p") == 0 && i0 + 1 < argc)
+                        pollMs = (unsigned)atoi(argv[++i0]);
+                else
+                        break;
+        }
+        if (i0 < argc || days == 0 || pollMs == 0 || pollMs > 500 || 1000 % pollMs != 0 ||
+            yr < 2000 || mon < 1 || mon > 12 || dom < 1 || dom > GetMaxDays(mon, yr))
+        {
+                fprintf(stderr, "usage: %s [-d days] [-s DD/MM/YYYY] [-p poll_ms]\n", argv[0]);
+                return 2;
+        }
+
+        //----------------------------------------------------------
+        // Start the virtual clock at midnight of the start date
+        //----------------------------------------------------------
+        memset(&tm, 0, sizeof(tm));
+        tm.tm_mday = dom;
+        tm.tm_mon  = mon - 1;
+        tm.tm_year = yr - 1900;
+        t0 = timegm(&tm);
+        gmtime_r(&t0, &tm);
+
+        //----------------------------------------------------------
+        // Boot as project.c does; one sample per poll at every
+        // rate level, every period record sent
+        //----------------------------------------------------------
+        InitTimer1();
+        InitClock(CLK_PERF);
+        InitTimer0();
+        RTC_Init();
+        SetRTCTimeInfo(0, 0, 0);
+        SetRTCDateInfo(dom, mon, yr);
+        SetRTCDay(tm.tm_wday);
+        InitRTCStamp();
+
+        InitConfig();
+        config.sampleHz = config.sampleHzMin = 1000 / pollMs;
+        config.deadband = 0;
+
+        InitLCD(1);
+        InitUART();
+        UARTSimHook(OnLine);
+        InitSeqLog();
+
+        ADCSimInit(ADC_CONV_US);
+        ADCSimSet(SoakCount(0));
+        InitSensors();
+        SensorSetPoint(0, config.setPoint * 10);
+
+        InitPipeline(sens.ch[0]);
+        InitRate(config.sampleHzMin, config.sampleHz);
+        PipelineSetTrigger(sens.setPoint[0]);
+        InitTrend();
+        InitStats();
+        InitSampleBus();
+        BusAttach(&periodSink);
+
+        perLog = rateStats.logSec;
+        chgAtLast = rateStats.up + rateStats.down;
+
+        GetRTCStamp(&st);
+        last = st.sec;
+        expect = (u32)(t0 - EPOCH_2000);
+        if (last != expect)
+                calBad++;
+
+        //----------------------------------------------------------
+        // Main loop: one pass of the firmware's loop per poll
+        //----------------------------------------------------------
+        endUs = (unsigned long long)days * 86400 * 1000000;
+        clk = ClockProfile();
+        wall = WallSeconds();
+
+        for (simUs = 0; simUs < endUs; )
+        {
+                RTCSimAdvance(pollMs * 1000);
+                TimerSimAdvance(pollMs * 1000);
+                simUs += pollMs * 1000;
+                ADCSimSet(SoakCount((u32)(simUs / 1000000 % 86400)));
+
+                logBefore = rateStats.logSec;
+                chgBefore = rateStats.up + rateStats.down;
+
+                SeqLogPoll();
+                DisplayInformation();
+
+                if (ClockProfile() != clk)
+                {
+                        clk = ClockProfile();
+                        switches++;
+                }
+
+                GetRTCStamp(&st);
+                if (st.sec == last)
+                        continue;
+
+                if (st.sec < last)
+                        secDup++;
+                else if (st.sec > last + 1)
+                        secMissed += st.sec - last - 1;
+                last = st.sec;
+
+                expect = (u32)(t0 - EPOCH_2000 + simUs / 1000000);
+                if (st.sec != expect)
+                        calBad++;
+                CheckCalendar(st.sec);
+
+                GetRTCDateInfo(&d, &mo, &y);
+                if (d == 29 && mo == 2 && st.sec % 86400 == 0)
+                        leapDays++;
+        }
+
+        wall = WallSeconds() - wall;
+
+        for (i = 0; i < BUS_MAX_SINKS; i++)
+                dropped += busStats[i].dropped;
+
+        //----------------------------------------------------------
+        // Report
+        //----------------------------------------------------------
+        fail = secMissed || secDup || calBad;
+        printf("simulated  %u days from %02u/%02u/%04u, poll %u ms, %u leap day(s)\n",
+               days, dom, mon, yr, pollMs, leapDays);
+        printf("seconds    missed %llu  duplicated %llu  calendar errors %llu\n",
+               secMissed, secDup, calBad);
+        for (i = 0; i < STATS_NUM_WIN; i++)
+        {
+                printf("%-10s closed %llu  missed %llu  duplicated %llu  short %llu  misaligned %llu\n",
+                       winName[i], winClosed[i], winMissed[i], winDup[i], winShort[i], winMisaligned[i]);
+                fail |= winMissed[i] || winDup[i] || winShort[i] || winMisaligned[i];
+        }
+        printf("%-10s closed %llu  missed %llu  duplicated %llu  short %llu  misaligned %llu"
+               "  after a change %llu\n",
+               "period", perClosed, perMissed, perDup, perShort, perMisaligned, perChanged);
+        printf("info       lines %llu  missing %llu  alert periods %llu\n",
+               infoLines, infoMissing, perAlert);
+        printf("records    %llu  no trailer %llu  bad CRC %llu  seq gaps %llu  repeats %llu\n",
+               recs, recNoTrailer, recBadCrc, seqGap, seqRepeat);
+        printf("rate       records %llu  wrong clock %llu  clock switches %llu\n",
+               rateRecs, rateBadClk, switches);
+        printf("events     alerts %llu  warnings %llu  captures %llu  bus drops %llu\n",
+               alerts, warns, capts, dropped);
+
+        fail |= perMissed || perDup || perShort || perMisaligned || infoMissing;
+        fail |= recNoTrailer || recBadCrc || seqGap || seqRepeat || rateBadClk || dropped;
+        if (winClosed[STATS_WIN_DAY] + 1 < days || perClosed == 0 ||
+            alerts == 0 || warns == 0 || capts == 0 || switches == 0)
+                fail = 1;
+        printf("speed      %.0f simulated s / wall s (%.3f s wall)\n",
+               wall > 0 ? endUs / 1e6 / wall : 0.0, wall);
+        printf("%s\n", fail ? "FAIL" : "PASS");
+
+        return fail ? 1 : 0;
+}
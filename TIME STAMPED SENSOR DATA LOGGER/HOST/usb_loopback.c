@@ -0,0 +1,301 @@
+//usb_loopback.c
+/*------------------------------------------------------------
+File: usb_loopback.c
+Purpose:
+Host test of the USB CDC-ACM virtual COM port.
+
+Runs the firmware's CDC core (usbcdc.c) on the simulated
+device controller (usbhw_sim.c) and plays the USB host with
+the UsbSim* calls, the way a PC driver would talk to it.
+
+Checks:
+- Enumeration: device, configuration and string descriptors,
+  SET_ADDRESS, SET/GET_CONFIGURATION; an unknown request
+  stalls
+- Line coding and DTR: 115200 8N1 by default, a new coding
+  is kept, output is dropped until DTR is set
+- Bulk IN: 100000 bytes arrive complete and in order; the
+  transfer ends with a short packet, or a zero-length one
+  after a full last packet
+- Loopback: a line sent back into bulk OUT is read again
+  with UsbCdcRxChar
+- Flow control: bulk OUT is NAKed while the receive ring is
+  full, and nothing is lost once it is read
+- Endpoint halt: SET/CLEAR_FEATURE and GET_STATUS
+
+Prints the bulk IN rate at the end.
+Exit status is 1 if any check failed.
+
+Build:
+cc -O2 -Wall -DHOST_BUILD -I../TYPES -I../USB -I../QUEUE -o usb_loopback usb_loopback.c ../USB/usbcdc.c ../USB/usbhw_sim.c ../QUEUE/queue.c
+
+Usage:
+usb_loopback [-n bytes]
+  bytes : bulk IN transfer length (default 100000)
+------------------------------------------------------------*/
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "types.h"
+#include "usb_defines.h"
+#include "usbhw.h"
+#include "usbcdc.h"
+
+//------------------------------------------------------------
+// Failed checks
+//------------------------------------------------------------
+static unsigned fails;
+
+#define CHECK(c, what)  Check((c) != 0, what)
+
+static void Check(int ok, const char *what)
+{
+        printf("%-4s %s\n", ok ? "ok" : "FAIL", what);
+        if (!ok)
+                fails++;
+}
+
+//------------------------------------------------------------
+// Function: WallSeconds
+// Purpose : Monotonic wall-clock time
+//------------------------------------------------------------
+static double WallSeconds(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//------------------------------------------------------------
+// Function: Control
+// Purpose : Build a setup packet and run the transfer
+//------------------------------------------------------------
+static u32 Control(u8 type, u8 req, u16 value, u16 index, u16 len, u8 *data)
+{
+        u8 s[8];
+
+        s[0] = type;
+        s[1] = req;
+        s[2] = value;
+        s[3] = value >> 8;
+        s[4] = index;
+        s[5] = index >> 8;
+        s[6] = len;
+        s[7] = len >> 8;
+        return UsbSimControl(s, data);
+}
+
+#define STD_IN     (REQ_DIR_IN | REQ_TYPE_STANDARD | REQ_RCPT_DEVICE)
+#define STD_OUT    (REQ_TYPE_STANDARD | REQ_RCPT_DEVICE)
+#define EP_IN      (REQ_DIR_IN | REQ_TYPE_STANDARD | REQ_RCPT_ENDPOINT)
+#define EP_OUT     (REQ_TYPE_STANDARD | REQ_RCPT_ENDPOINT)
+#define CLASS_IN   (REQ_DIR_IN | REQ_TYPE_CLASS | REQ_RCPT_INTERFACE)
+#define CLASS_OUT  (REQ_TYPE_CLASS | REQ_RCPT_INTERFACE)
+
+//------------------------------------------------------------
+// Function: Enumerate
+// Purpose : What a host does after attach
+//------------------------------------------------------------
+static void Enumerate(void)
+{
+        u8 d[256];
+        u32 n;
+
+        UsbSimReset();
+
+        n = Control(STD_IN, REQ_GET_DESCRIPTOR, DESC_DEVICE << 8, 0, 64, d);
+        CHECK(n == 18 && d[1] == DESC_DEVICE && d[4] == 0x02 &&
+              (d[8] | (d[9] << 8)) == USB_VID && (d[10] | (d[11] << 8)) == USB_PID,
+              "device descriptor");
+
+        CHECK(Control(STD_OUT, REQ_SET_ADDRESS, 5, 0, 0, d) == 0, "set address");
+
+        n = Control(STD_IN, REQ_GET_DESCRIPTOR, DESC_CONFIGURATION << 8, 0, 9, d);
+        CHECK(n == 9 && d[1] == DESC_CONFIGURATION, "configuration header");
+        n = Control(STD_IN, REQ_GET_DESCRIPTOR, DESC_CONFIGURATION << 8, 0, 255, d);
+        CHECK(n == (u32)(d[2] | (d[3] << 8)) && d[4] == 2, "configuration, 2 interfaces");
+
+        n = Control(STD_IN, REQ_GET_DESCRIPTOR, DESC_STRING << 8, 0, 255, d);
+        CHECK(n == 4 && d[2] == 0x09 && d[3] == 0x04, "string 0: language");
+        n = Control(STD_IN, REQ_GET_DESCRIPTOR, (DESC_STRING << 8) | 2, 0x0409, 255, d);
+        CHECK(n == 2 + 2 * 18 && d[2] == 'S' && d[4] == 'e' && d[3] == 0, "string 2: product");
+
+        CHECK(Control(STD_IN, REQ_GET_DESCRIPTOR, 7 << 8, 0, 64, d) == USB_SIM_STALL,
+              "unknown descriptor stalls");
+
+        CHECK(Control(STD_OUT, REQ_SET_CONFIGURATION, 1, 0, 0, d) == 0, "set configuration 1");
+        n = Control(STD_IN, REQ_GET_CONFIGURATION, 0, 0, 1, d);
+        CHECK(n == 1 && d[0] == 1, "get configuration");
+}
+
+//------------------------------------------------------------
+// Function: LineCoding
+// Purpose : Coding kept, output dropped until DTR
+//------------------------------------------------------------
+static void LineCoding(void)
+{
+        static const u8 c9600[CDC_LINE_CODING_SIZE] = { 0x80, 0x25, 0, 0, 0, 0, 8 };
+        u8 d[CDC_LINE_CODING_SIZE], pkt[USB_BULK_SIZE];
+        u32 n, dropped;
+
+        n = Control(CLASS_IN, CDC_GET_LINE_CODING, 0, 0, CDC_LINE_CODING_SIZE, d);
+        CHECK(n == CDC_LINE_CODING_SIZE && (d[0] | (d[1] << 8) | (d[2] << 16)) == 115200 &&
+              d[4] == 0 && d[5] == 0 && d[6] == 8, "default line coding 115200 8N1");
+
+        memcpy(d, c9600, sizeof(d));
+        CHECK(Control(CLASS_OUT, CDC_SET_LINE_CODING, 0, 0, CDC_LINE_CODING_SIZE, d) ==
+              CDC_LINE_CODING_SIZE, "set line coding 9600 8N1");
+        memset(d, 0, sizeof(d));
+        Control(CLASS_IN, CDC_GET_LINE_CODING, 0, 0, CDC_LINE_CODING_SIZE, d);
+        CHECK(memcmp(d, c9600, sizeof(d)) == 0, "line coding kept");
+
+        dropped = usbCdcStats.dropped;
+        CHECK(!UsbCdcOpen() && UsbCdcTxChar('x') && UsbCdcTxIdle(), "port closed without DTR");
+        CHECK(usbCdcStats.dropped == dropped + 1 &&
+              UsbSimIn(USB_EP_BULK_IN, pkt) == USB_SIM_NAK, "output dropped without DTR");
+
+        Control(CLASS_OUT, CDC_SET_CONTROL_LINE_STATE, CDC_DTR, 0, 0, d);
+        CHECK(UsbCdcOpen(), "port open with DTR");
+}
+
+//------------------------------------------------------------
+// Function: BulkIn
+// Purpose : Send len bytes of a pattern, read them as the
+//           host, and check every one
+//------------------------------------------------------------
+static void BulkIn(u32 len)
+{
+        u8 pkt[USB_BULK_SIZE];
+        u32 sent = 0, got = 0, bad = 0, last = 0, lastData = 0, i, n;
+        double wall = WallSeconds();
+
+        while (got < len || !UsbCdcTxIdle())
+        {
+                while (sent < len && UsbCdcTxChar((u8)(sent * 7 + (sent >> 8))))
+                        sent++;
+
+                UsbCdcKick();
+                n = UsbSimIn(USB_EP_BULK_IN, pkt);
+                if (n == USB_SIM_NAK)
+                {
+                        if (sent == len && UsbCdcTxIdle())
+                                break;
+                        continue;
+                }
+                if (n != 0)
+                        lastData = n;
+                for (i = 0; i < n; i++, got++)
+                        if (got >= len || pkt[i] != (u8)(got * 7 + (got >> 8)))
+                                bad++;
+                last = n;
+        }
+        wall = WallSeconds() - wall;
+
+        printf("     bulk IN: %lu bytes in %.3f ms, %.1f MB/s, %lu packets\n",
+               (unsigned long)got, wall * 1e3, got / wall / 1e6,
+               (unsigned long)usbCdcStats.txPackets);
+        CHECK(got == len && bad == 0, "bulk IN complete and in order");
+        CHECK((lastData == USB_BULK_SIZE) == (last == 0),
+              "transfer ends with a short or zero-length packet");
+}
+
+//------------------------------------------------------------
+// Function: Loopback
+// Purpose : Send a line out, loop it back, read it in
+//------------------------------------------------------------
+static void Loopback(void)
+{
+        static const char line[] = "NAK 3 5\r\n";
+        char back[sizeof(line)];
+        u32 i, n = 0;
+        u8 c;
+
+        for (i = 0; line[i]; i++)
+                UsbCdcTxChar(line[i]);
+        UsbCdcKick();
+        UsbSimLoopback();
+
+        while (n < sizeof(back) - 1 && UsbCdcRxChar(&c))
+                back[n++] = c;
+        back[n] = 0;
+        CHECK(strcmp(back, line) == 0 && !UsbCdcRxReady(), "loopback of a NAK line");
+}
+
+//------------------------------------------------------------
+// Function: FlowControl
+// Purpose : Fill bulk OUT until NAK, then read everything
+//------------------------------------------------------------
+static void FlowControl(void)
+{
+        u8 pkt[USB_BULK_SIZE], c;
+        u32 sent = 0, got = 0, bad = 0, i;
+
+        for (;;)
+        {
+                for (i = 0; i < USB_BULK_SIZE; i++)
+                        pkt[i] = (u8)(sent + i);
+                if (!UsbSimOut(USB_EP_BULK_OUT, pkt, USB_BULK_SIZE))
+                        break;
+                sent += USB_BULK_SIZE;
+        }
+        CHECK(sent == USB_RXBUF + USB_BULK_BUFS * USB_BULK_SIZE,
+              "bulk OUT NAKed once ring and endpoint are full");
+
+        while (UsbCdcRxChar(&c))
+                if (c != (u8)got++)
+                        bad++;
+        CHECK(got == sent && bad == 0, "held packets read in order");
+}
+
+//------------------------------------------------------------
+// Function: Halt
+// Purpose : Halt and release bulk IN
+//------------------------------------------------------------
+static void Halt(void)
+{
+        u8 d[2], pkt[USB_BULK_SIZE];
+
+        CHECK(Control(EP_OUT, REQ_SET_FEATURE, FEATURE_ENDPOINT_HALT, USB_EP_BULK_IN, 0, d) == 0,
+              "set halt on bulk IN");
+        Control(EP_IN, REQ_GET_STATUS, 0, USB_EP_BULK_IN, 2, d);
+        UsbCdcTxChar('h');
+        UsbCdcKick();
+        CHECK(d[0] == 1 && UsbSimIn(USB_EP_BULK_IN, pkt) == USB_SIM_NAK, "halted endpoint NAKs");
+
+        Control(EP_OUT, REQ_CLEAR_FEATURE, FEATURE_ENDPOINT_HALT, USB_EP_BULK_IN, 0, d);
+        Control(EP_IN, REQ_GET_STATUS, 0, USB_EP_BULK_IN, 2, d);
+        CHECK(d[0] == 0 && UsbSimIn(USB_EP_BULK_IN, pkt) == 1 && pkt[0] == 'h',
+              "cleared halt resumes");
+}
+
+//------------------------------------------------------------
+// Function: main
+//------------------------------------------------------------
+int main(int argc, char **argv)
+{
+        unsigned long len = 100000;
+
+        if (argc == 3 && strcmp(argv[1], "-n") == 0)
+                len = strtoul(argv[2], NULL, 10);
+        else if (argc != 1)
+        {
+                fprintf(stderr, "usage: %s [-n bytes]\n", argv[0]);
+                return 2;
+        }
+
+        InitUsbCdc(&usbHwSim);
+        Enumerate();
+        LineCoding();
+        BulkIn(len);
+        Loopback();
+        FlowControl();
+        Halt();
+
+        printf("%u check(s) failed\n", fails);
+        return fails ? 1 : 0;
+}
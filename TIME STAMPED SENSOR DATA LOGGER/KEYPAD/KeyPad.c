@@ -9,10 +9,14 @@ This file provides:
 - Keypad initialization
 - Column status detection
 - Key value identification using row-column scanning
+- Non-blocking polling for a complete key stroke
 ------------------------------------------------------------*/
 
 #include <LPC21xx.h>        // LPC21xx/LPC214x register definitions
 #include "KeyPdDefines.h"  // Keypad row, column, and lookup table definitions
+#include "ramcode.h"       // RAMFUNC, code placement
+#include "timer.h"         // Deadlines for bounded waits
+#include "pt.h"            // Protothread for the key stroke
 
 /*------------------------------------------------------------
 Function: KeyPdInit
@@ -45,7 +49,8 @@ Return:
 1 -> No key pressed (all columns HIGH)
 0 -> Key pressed (any column LOW)
 ------------------------------------------------------------*/
-u8 ColStat(void)
+CODE_THUMB
+RAMFUNC u8 ColStat(void)
 {
         //----------------------------------------------------------
         // Read column pins P1.20  P1.23
@@ -55,6 +60,7 @@ u8 ColStat(void)
         else
                 return 0;     // Key pressed
 }
+CODE_END
 
 /*------------------------------------------------------------
 Function: KeyVal
@@ -69,7 +75,8 @@ Method:
 Return:
 Key value from LUT corresponding to pressed key
 ------------------------------------------------------------*/
-u8 KeyVal(void)
+CODE_THUMB
+RAMFUNC u8 KeyVal(void)
 {
         char row_val = 0, col_val = 0;
 
@@ -141,4 +148,71 @@ u8 KeyVal(void)
         //----------------------------------------------------------
         return (LUT[row_val][col_val]);
 }
+CODE_END
 
+//------------------------------------------------------------
+// Key stroke thread state and the last key read
+//------------------------------------------------------------
+static Pt keyPt;
+static u32 keyDl;
+static u8 keyLast, keyReady;
+
+/*------------------------------------------------------------
+Function: KeyThread
+Purpose :
+Follows one key stroke at a time without blocking.
+
+Method:
+- Waits for any column to go LOW
+- Debounces, then scans the key
+- Waits up to KEY_RELEASE_TIMEOUT_MS for the release; a key
+  held longer is treated as stuck and dropped (counted under
+  WAIT_KEY), so a shorted key cannot feed the same value
+  forever
+- A released key is left in keyLast for KeyPoll
+------------------------------------------------------------*/
+static u8 KeyThread(Pt *p)
+{
+        PT_BEGIN(p);
+
+        while (1)
+        {
+                PT_WAIT_WHILE(p, ColStat());
+
+                PT_DELAY_MS(p, keyDl, KEY_DEBOUNCE_MS);
+                keyLast = KeyVal();
+
+                keyDl = DeadlineSet(KEY_RELEASE_TIMEOUT_MS * 1000);
+                PT_WAIT_UNTIL(p, ColStat() || DeadlinePassed(keyDl));
+                if (!ColStat())
+                {
+                        WaitTimeout(WAIT_KEY);
+                        PT_WAIT_UNTIL(p, ColStat());
+                        continue;
+                }
+
+                keyReady = 1;
+        }
+
+        PT_END(p);
+}
+
+/*------------------------------------------------------------
+Function: KeyPoll
+Purpose :
+Advances the key stroke thread by one step.
+
+Return:
+1 -> *key holds the value of a completed key stroke
+0 -> no new key stroke yet
+------------------------------------------------------------*/
+u32 KeyPoll(u8 *key)
+{
+        KeyThread(&keyPt);
+
+        if (!keyReady)
+                return 0;
+        keyReady = 0;
+        *key = keyLast;
+        return 1;
+}
@@ -8,6 +8,7 @@ This file provides:
 - Keypad initialization
 - Column status check
 - Key value reading using row-column scanning
+- Polling for a complete key press and release
 ------------------------------------------------------------*/
 
 #include "types.h"   // User-defined data types
@@ -43,3 +44,14 @@ u8 ColStat(void);
 // - Use lookup table to map row-column to key
 //------------------------------------------------------------
 u8 KeyVal(void);
+
+//------------------------------------------------------------
+// Function: KeyPoll
+// Purpose : Follow key strokes without blocking: debounce,
+//           scan and wait for release across calls; call it
+//           on every pass of a waiting loop
+// Return  : 1 -> *key holds the key value of a stroke
+//           0 -> none completed yet; a key not released in
+//                time is dropped (stuck, counted under WAIT_KEY)
+//------------------------------------------------------------
+u32 KeyPoll(u8 *key);
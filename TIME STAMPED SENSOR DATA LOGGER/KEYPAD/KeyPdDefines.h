@@ -30,6 +30,12 @@ This file provides:
 #define C2 22     // P1.22
 #define C3 23     // P1.23
 
+//------------------------------------------------------------
+// Key timing
+//------------------------------------------------------------
+#define KEY_DEBOUNCE_MS          10     // Settle time after press
+#define KEY_RELEASE_TIMEOUT_MS   2000   // Longer -> key is stuck
+
 //------------------------------------------------------------
 // Keypad Lookup Table (LUT)
 // Maps rowcolumn combination to key values
@@ -0,0 +1,36 @@
+//keypad_sim.c
+/*------------------------------------------------------------
+File: keypad_sim.c
+Purpose:
+Virtual keypad for host builds (HOST_BUILD).
+
+Stands in for KeyPad.c so the edit menus can be linked on a
+PC. No key is ever pressed.
+------------------------------------------------------------*/
+
+#ifdef HOST_BUILD
+
+#include "types.h"       // User-defined data types
+#include "KeyPd.h"       // Keypad prototypes
+
+void KeyPdInit(void)
+{
+}
+
+u8 ColStat(void)
+{
+        return 1;       // All columns high: no key down
+}
+
+u8 KeyVal(void)
+{
+        return 0;
+}
+
+u32 KeyPoll(u8 *key)
+{
+        (void)key;
+        return 0;
+}
+
+#endif
@@ -30,6 +30,16 @@ This file provides:
 #define RW 6             // Read/Write pin connected to P0.9
 #define EN 7             // Enable pin connected to P0.10
 
+//------------------------------------------------------------
+// HD44780 timing minimums (datasheet), with small margins
+//------------------------------------------------------------
+#define LCD_POWER_ON_MS  15     // Vcc up to first command
+#define LCD_FSET1_US     4100   // After first function set
+#define LCD_FSET2_US     100    // After second function set
+#define LCD_EN_US        1      // Enable pulse (>= 450 ns)
+#define LCD_CMD_US       40     // Most commands (37 us)
+#define LCD_HOME_US      1600   // Clear / return home (1.52 ms)
+
 /*------------------------------------------------------------
 Function: InitLCD
 Purpose :
@@ -39,8 +49,12 @@ This function:
 - Configures GPIO pins for LCD
 - Sends initialization command sequence
 - Sets display and cursor configuration
+
+Parameter:
+coldStart : 1 after power-on; 0 after a reset with the LCD
+            already powered, which skips the power-on wait
 ------------------------------------------------------------*/
-void InitLCD(void)
+void InitLCD(u32 coldStart)
 {
         //----------------------------------------------------------
         // Configure P0.0  P0.10 as output pins for LCD
@@ -51,19 +65,19 @@ void InitLCD(void)
         //----------------------------------------------------------
         // Initial power-on delay (minimum 15 ms required)
         //----------------------------------------------------------
-        delay_ms(20);
+        if (coldStart)
+                delay_ms(LCD_POWER_ON_MS);
 
         //----------------------------------------------------------
         // LCD reset and initialization sequence
         //----------------------------------------------------------
         CmdLCD(0x30);          // Function set (8-bit mode)
-        delay_ms(10);          // Minimum 5 ms delay
+        delay_us(LCD_FSET1_US); // Minimum 4.1 ms delay
 
         CmdLCD(0x30);          // Repeat function set
-        delay_ms(1);           // Minimum 160 s delay
+        delay_us(LCD_FSET2_US); // Minimum 100 s delay
 
         CmdLCD(0x30);          // Repeat function set
-        delay_ms(1);           // Minimum 160 s delay
 
         //----------------------------------------------------------
         // LCD configuration commands
@@ -84,6 +98,10 @@ void CmdLCD(u8 cmd)
 {
         IOCLR0 = 1 << RS;       // Clear RS (command mode)
         DispLCD(cmd);          // Send command to LCD
+
+        // Clear display and return home take much longer
+        if (cmd == 0x01 || cmd == 0x02 || cmd == 0x03)
+                delay_us(LCD_HOME_US);
 }
 
 /*------------------------------------------------------------
@@ -107,9 +125,9 @@ void DispLCD(u8 val)
         IOCLR0 = 1 << RW;       // Clear RW (write operation)
         WRITEBYTE(IOPIN0, 8, val); // Write data to P0.8  P0.15
         IOSET0 = 1 << EN;       // Set Enable pin
-        delay_ms(2);           // Enable pulse width delay
+        delay_us(LCD_EN_US);   // Enable pulse width delay
         IOCLR0 = 1 << EN;       // Clear Enable pin
-        delay_ms(5);           // Command execution delay
+        delay_us(LCD_CMD_US);  // Command execution delay
 }
 
 /*------------------------------------------------------------
@@ -20,8 +20,10 @@ This file contains:
 // Function: InitLCD
 // Purpose : Initialize LCD module
 //           Configures LCD in required mode (8-bit/4-bit)
+// Input   : coldStart - 1 after power-on (waits for the LCD
+//           to power up), 0 after a warm reset
 //------------------------------------------------------------
-void InitLCD(void);
+void InitLCD(u32);
 
 //------------------------------------------------------------
 // Function: CmdLCD
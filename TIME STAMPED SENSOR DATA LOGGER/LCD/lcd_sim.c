@@ -0,0 +1,71 @@
+//lcd_sim.c
+/*------------------------------------------------------------
+File: lcd_sim.c
+Purpose:
+Virtual LCD for host builds (HOST_BUILD).
+
+Stands in for lcd.c so the display code can be linked and
+run on a PC. Every call is accepted and nothing is shown;
+lcdSimWrites counts the commands and characters sent, so a
+test can see that the display is kept up to date.
+------------------------------------------------------------*/
+
+#ifdef HOST_BUILD
+
+#include "types.h"       // User-defined data types
+#include "lcd.h"         // LCD function prototypes
+
+u32 lcdSimWrites;
+
+void InitLCD(u32 coldStart)
+{
+        (void)coldStart;
+        lcdSimWrites = 0;
+}
+
+void CmdLCD(u8 cmd)
+{
+        (void)cmd;
+        lcdSimWrites++;
+}
+
+void CharLCD(u8 ch)
+{
+        (void)ch;
+        lcdSimWrites++;
+}
+
+void DispLCD(u8 ch)
+{
+        CharLCD(ch);
+}
+
+void StrLCD(u8 *s)
+{
+        while (*s)
+                CharLCD(*s++);
+}
+
+void IntLCD(s32 n)
+{
+        (void)n;
+        lcdSimWrites++;
+}
+
+void FltLCD(f32 f)
+{
+        (void)f;
+        lcdSimWrites++;
+}
+
+void StoreCustCharFont(void)
+{
+}
+
+void TempDisplay(u32 t)
+{
+        (void)t;
+        lcdSimWrites++;
+}
+
+#endif
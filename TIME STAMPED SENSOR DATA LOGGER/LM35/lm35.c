@@ -8,12 +8,31 @@ LPC214x ARM7 microcontroller using ADC.
 This file provides:
 - Functions to read temperature from LM35
 - Temperature output in Celsius or Fahrenheit
+- Differential reading with both inputs sampled at once
+
+Differential wiring:
+- LM35 output on AIN0 (P0.27, converter AD0)
+- Reference leg on AIN1 (P0.28); the two inputs are
+  converted one after the other
+Define LM35_NP_AD1 for boards with the reference leg moved
+to AD1.7 (P0.22, converter AD1); the two inputs are then
+converted together.
 ------------------------------------------------------------*/
 
 #include "types.h"         // User-defined data types
 #include "adc.h"          // ADC driver functions
 #include "adc_defines.h"   // ADC channel definitions
 
+//------------------------------------------------------------
+// Differential inputs
+//------------------------------------------------------------
+#define LM35_NP_PLUS    CH0
+#ifdef LM35_NP_AD1
+#define LM35_NP_MINUS   AD1_CH7
+#else
+#define LM35_NP_MINUS   CH1
+#endif
+
 /*------------------------------------------------------------
 Function: Read_LM35
 Purpose :
@@ -52,11 +71,29 @@ f32 Read_LM35(u8 tType)
         return tDeg;       // Return temperature value
 }
 
+/*------------------------------------------------------------
+Function: Init_LM35_NP
+Purpose :
+Configures the two ADC inputs of the differential reading.
+------------------------------------------------------------*/
+void Init_LM35_NP(void)
+{
+#ifdef LM35_NP_AD1
+        Init_ADC_Pair(LM35_NP_PLUS, LM35_NP_MINUS);
+#else
+        Init_ADC(LM35_NP_PLUS);
+        Init_ADC(LM35_NP_MINUS);
+#endif
+}
+
 /*------------------------------------------------------------
 Function: Read_LM35_NP
 Purpose :
 Reads temperature from LM35 using differential (non-polarized)
-ADC input configuration.
+ADC input configuration. With LM35_NP_AD1 both inputs are
+converted at the same instant on the two ADC blocks, so a
+changing signal adds no skew error and the reading takes
+one conversion time.
 
 Parameter:
 tType : Temperature type
@@ -74,8 +111,14 @@ f32 Read_LM35_NP(u8 tType)
         //------------------------------------------------------
         // Read ADC channels for differential measurement
         //------------------------------------------------------
-        Read_ADC(CH0, &eAR1, &adcDVal1);
-        Read_ADC(CH1, &eAR2, &adcDVal2);
+#ifdef LM35_NP_AD1
+        Read_ADC_Pair(&adcDVal1, &adcDVal2);
+        eAR1 = adcDVal1 * (3.3 / 1023);
+        eAR2 = adcDVal2 * (3.3 / 1023);
+#else
+        Read_ADC(LM35_NP_PLUS, &eAR1, &adcDVal1);
+        Read_ADC(LM35_NP_MINUS, &eAR2, &adcDVal2);
+#endif
 
         //------------------------------------------------------
         // Calculate temperature from voltage difference
@@ -91,3 +134,31 @@ f32 Read_LM35_NP(u8 tType)
 
         return tDeg;       // Return temperature value
 }
+
+/*------------------------------------------------------------
+Function: LM35CountToTenths
+Purpose :
+Converts a raw 10-bit ADC count from the LM35 channel to
+tenths of a degree Celsius using integer arithmetic only.
+
+With Vref = 3.3 V and 10 mV per C, one millivolt equals
+one tenth of a degree, so the result is the input in mV.
+------------------------------------------------------------*/
+s32 LM35CountToTenths(u32 adcDVal)
+{
+        return (s32)((adcDVal * 3300) / 1023);
+}
+
+/*------------------------------------------------------------
+Function: LM35TenthsToCount
+Purpose :
+Inverse of LM35CountToTenths, rounded up, so that a count
+compares against a temperature limit the same way its
+converted value would.
+------------------------------------------------------------*/
+u32 LM35TenthsToCount(s32 tenths)
+{
+        if (tenths <= 0)
+                return 0;
+        return ((u32)tenths * 1023 + 3299) / 3300;
+}
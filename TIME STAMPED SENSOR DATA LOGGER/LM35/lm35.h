@@ -22,9 +22,30 @@ This file contains:
 //------------------------------------------------------------
 f32 Read_LM35(u8 tType);
 
+//------------------------------------------------------------
+// Function: Init_LM35_NP
+// Purpose : Configure the inputs of Read_LM35_NP
+//------------------------------------------------------------
+void Init_LM35_NP(void);
+
 //------------------------------------------------------------
 // Function: Read_LM35_NP
 // Purpose : Read temperature using differential ADC method
-//           (non-polarized measurement)
+//           (non-polarized measurement); with LM35_NP_AD1
+//           both inputs are sampled together on AD0 and AD1
 //------------------------------------------------------------
 f32 Read_LM35_NP(u8 tType);
+
+//------------------------------------------------------------
+// Function: LM35CountToTenths
+// Purpose : Convert raw ADC count to tenths of a degree C
+//           without floating point (for fast sampling paths)
+//------------------------------------------------------------
+s32 LM35CountToTenths(u32 adcDVal);
+
+//------------------------------------------------------------
+// Function: LM35TenthsToCount
+// Purpose : Lowest raw ADC count that converts to at least
+//           the given tenths of a degree C
+//------------------------------------------------------------
+u32 LM35TenthsToCount(s32 tenths);
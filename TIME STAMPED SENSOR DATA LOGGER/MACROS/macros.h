@@ -10,6 +10,7 @@ set points, and global variables for LPC21xx project.
 
 //------------------------------------------------------------
 // Default Time and Date Values
+// (loaded only when the RTC was not running at boot)
 //------------------------------------------------------------
 #define HR       23       // Default hour (023)
 #define MINUTE    0       // Default minute (059)
@@ -24,6 +25,7 @@ set points, and global variables for LPC21xx project.
 // Project Control Macros
 //------------------------------------------------------------
 #define SET_POINT 45      // Default set point value for temperature control
+#define EDIT_IDLE_MS 30000  // Edit mode is left after 30 s without a key
 
 //------------------------------------------------------------
 // Global Variables
@@ -31,5 +33,4 @@ set points, and global variables for LPC21xx project.
 u32 hour, min, sec;       // Variables to hold current time
 u32 date, month, year;    // Variables to hold current date
 u32 day;                  // Variable to hold day of week
-u32 check = 0;            // General-purpose flag/check variable
 static u32 temp;           // Static variable for storing temperature readings
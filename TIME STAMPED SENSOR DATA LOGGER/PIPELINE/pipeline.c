@@ -0,0 +1,441 @@
+//pipeline.c
+/*------------------------------------------------------------
+File: pipeline.c
+Purpose:
+Implements a three stage multi-rate sampling pipeline on top
+of interrupt driven ADC conversions and the Timer0
+microsecond time base.
+
+Features:
+- FAST stage: deadline-scheduled ADC conversions at a fixed
+  rate into a power-of-two ring buffer; a conversion is
+  started and collected on a later pass, so it runs while the
+  main loop updates the LCD or sends UART text
+- SEC stage : mean/min/max of the buffered samples, one
+  record per second for display and alerting
+- MIN stage : per-second records aggregated into one record
+  per log period (an RTC minute by default, shorter when the
+  rate scheduler asks for it) for the serial log
+- Each stage does a bounded amount of work per call
+- Alert capture: the trigger is tested only when the SEC
+  stage sees a new per-second maximum, and the pre-trigger
+  history is copied out of the raw ring, so the FAST stage
+  does no extra work for it
+
+NOTE:
+Min/max of the per-second record come from the raw samples,
+so a transient shorter than one second still reaches the
+alert check even though only one value per second is shown.
+------------------------------------------------------------*/
+
+#include "types.h"              // User-defined data types
+#include "adc.h"                // Read_ADC_Start/Read_ADC_Done
+#include "adc_defines.h"        // ADC_TIMEOUT_US
+#include "lm35.h"               // LM35CountToTenths
+#include "rtc.h"                // GetRTCSeconds
+#include "timer.h"              // Timer0Now, deadlines
+#include "pipeline.h"           // Pipeline prototypes and records
+#include "pipeline_defines.h"   // Rates, buffer size and budgets
+
+//------------------------------------------------------------
+// Stage counters
+//------------------------------------------------------------
+PipeStats pipeStats;
+
+//------------------------------------------------------------
+// FAST stage state
+//------------------------------------------------------------
+static u32 pipeCh;                    // ADC channel sampled
+static u32 fastPeriod;                // Sample period in us
+static u32 fastNext;                  // Next sample deadline
+static u16 fastBuf[PIPE_BUF_LEN];     // Raw ADC counts
+static u32 fastHead, fastTail;        // Ring write/read indexes
+static u32 fastBusy;                  // Conversion in progress
+static u32 fastDeadline;              // Give up on it after this
+
+//------------------------------------------------------------
+// SEC stage accumulator and output
+//------------------------------------------------------------
+static u32 secStart;                  // Start of current second
+static u32 secSum, secN, secMin, secMax;
+static PipeRec secRec;
+static u32 secReady;
+
+//------------------------------------------------------------
+// MIN stage accumulator and output
+//------------------------------------------------------------
+static u32 minPeriod;                 // Log period in seconds
+static u32 minIndex;                  // RTC period being built
+static s32 minSum, minMin, minMax;
+static u32 minN, minSamples;
+static PipeRec minRec;
+static u32 minReady;
+
+//------------------------------------------------------------
+// Alert capture
+//------------------------------------------------------------
+#define CAP_ARMED   0         // Waiting for the trigger
+#define CAP_POST    1         // Collecting samples after it
+#define CAP_READY   2         // Complete, not yet released
+#define CAP_REARM   3         // Released, waiting for a quiet second
+
+static u32 capState;
+static u32 capLevel = 0xFFFFFFFF;     // Off until a level is set
+static u32 capNext;                   // Ring index of next post sample
+static PipeCapture cap;
+
+/*------------------------------------------------------------
+Function: InitPipeline
+Purpose :
+Resets all stages and starts sampling the given channel.
+------------------------------------------------------------*/
+void InitPipeline(u32 chNo)
+{
+        pipeCh = chNo;
+        fastHead = fastTail = 0;
+        fastBusy = 0;
+        secN = 0;
+        minN = 0;
+        secReady = minReady = 0;
+        capState = CAP_ARMED;
+        cap.id = 0;
+
+        pipeStats.samples = pipeStats.skipped = pipeStats.overflow = 0;
+        pipeStats.seconds = pipeStats.minutes = 0;
+        pipeStats.overlapped = pipeStats.firstUs = 0;
+
+        PipelineSetRate(PIPE_FAST_HZ);
+        secStart = fastNext;
+        minPeriod = PIPE_MIN_SEC;
+        minIndex = GetRTCSeconds() / minPeriod;
+}
+
+/*------------------------------------------------------------
+Function: PipelineSetRate
+Purpose :
+Sets the fast stage sample rate; out of range values are
+clamped to 1 .. PIPE_FAST_HZ_MAX.
+------------------------------------------------------------*/
+void PipelineSetRate(u32 hz)
+{
+        if (hz == 0)
+                hz = 1;
+        if (hz > PIPE_FAST_HZ_MAX)
+                hz = PIPE_FAST_HZ_MAX;
+
+        fastPeriod = PIPE_SEC_US / hz;
+        fastNext = Timer0Now();
+}
+
+/*------------------------------------------------------------
+Function: PipelineSetLogPeriod
+Purpose :
+Sets the aggregation period in seconds (0 is taken as 1).
+Periods are aligned to multiples of their length on the RTC
+time base; a change closes the open record at the next
+second, so one record may be shorter than either period.
+------------------------------------------------------------*/
+void PipelineSetLogPeriod(u32 sec)
+{
+        minPeriod = sec ? sec : 1;
+}
+
+/*------------------------------------------------------------
+Function: PipelineSetTrigger
+Purpose :
+Converts the capture level to an ADC count and arms the
+trigger. A capture being collected or sent is kept.
+------------------------------------------------------------*/
+void PipelineSetTrigger(s32 tenths)
+{
+        capLevel = LM35TenthsToCount(tenths);
+        if (capState == CAP_REARM)
+                capState = CAP_ARMED;
+}
+
+/*------------------------------------------------------------
+Function: CapTrigger
+Purpose :
+Starts a capture at ring index idx. The samples before it
+are copied from the part of the ring already decimated, as
+far back as it has not been overwritten (up to
+PIPE_CAP_PRE).
+------------------------------------------------------------*/
+static void CapTrigger(u32 idx)
+{
+        u32 pre = PIPE_CAP_PRE, i;
+
+        if (pre > PIPE_BUF_LEN - (fastHead - idx))
+                pre = PIPE_BUF_LEN - (fastHead - idx);
+        if (pre > idx)
+                pre = idx;
+
+        for (i = 0; i < pre; i++)
+                cap.buf[i] = fastBuf[(idx - pre + i) & PIPE_BUF_MASK];
+
+        cap.id++;
+        cap.ch = pipeCh;
+        cap.hz = PIPE_SEC_US / fastPeriod;
+        cap.pre = pre;
+        cap.len = pre;
+        cap.level = capLevel;
+        GetRTCStamp(&cap.at);
+
+        capNext = idx;
+        capState = CAP_POST;
+}
+
+//------------------------------------------------------------
+// Function: CapCollect
+// Purpose : Copy decimated samples from the trigger on into
+//           the capture until it is full
+//------------------------------------------------------------
+static void CapCollect(void)
+{
+        while (capNext != fastTail && cap.len < PIPE_CAP_LEN)
+                cap.buf[cap.len++] = fastBuf[capNext++ & PIPE_BUF_MASK];
+
+        if (cap.len == PIPE_CAP_LEN)
+                capState = CAP_READY;
+}
+
+/*------------------------------------------------------------
+Function: PipeFast
+Purpose :
+Collects the conversion started on an earlier call and starts
+the next one when its deadline has passed. At most
+PIPE_FAST_BUDGET conversions are handled per call. When the
+loop has fallen more than one budget behind, missed slots are
+skipped and counted instead of being sampled late in a burst.
+A conversion that has not completed within ADC_TIMEOUT_US is
+dropped and counted under WAIT_ADC, so a stuck ADC costs
+samples but never stops the stage.
+------------------------------------------------------------*/
+static void PipeFast(void)
+{
+        u32 budget = PIPE_FAST_BUDGET;
+        u32 adcDVal;
+
+        for (;;)
+        {
+                if (fastBusy)
+                {
+                        // Still converting: leave it to overlap with
+                        // whatever the caller does next
+                        if (!Read_ADC_Done(&adcDVal))
+                        {
+                                if (!DeadlinePassed(fastDeadline))
+                                {
+                                        pipeStats.overlapped++;
+                                        return;
+                                }
+                                WaitTimeout(WAIT_ADC);
+                                fastBusy = 0;
+                        }
+                        else
+                        {
+                                fastBusy = 0;
+                                if (pipeStats.samples++ == 0)
+                                        pipeStats.firstUs = Timer0Now();
+
+                                if (fastHead - fastTail < PIPE_BUF_LEN)
+                                        fastBuf[fastHead++ & PIPE_BUF_MASK] = adcDVal;
+                                else
+                                        pipeStats.overflow++;
+                        }
+                }
+
+                if ((s32)(Timer0Now() - fastNext) < 0 || budget == 0)
+                        return;
+                budget--;
+
+                // Far behind: drop to the latest passed deadline
+                if (Timer0Now() - fastNext >= PIPE_FAST_BUDGET * fastPeriod)
+                {
+                        while ((s32)(Timer0Now() - (fastNext + fastPeriod)) >= 0)
+                        {
+                                fastNext += fastPeriod;
+                                pipeStats.skipped++;
+                        }
+                }
+
+                Read_ADC_Start(pipeCh);
+                fastDeadline = DeadlineSet(ADC_TIMEOUT_US);
+                fastBusy = 1;
+                fastNext += fastPeriod;
+        }
+}
+
+/*------------------------------------------------------------
+Function: PipeMinute
+Purpose :
+Folds one per-second record into the log period aggregate,
+closing the aggregate when the period changes.
+------------------------------------------------------------*/
+static void PipeMinute(PipeRec *sr)
+{
+        u32 idx = GetRTCSeconds() / minPeriod;
+
+        if (minN != 0 && idx != minIndex)
+        {
+                minRec.mean = minSum / (s32)minN;
+                minRec.min  = minMin;
+                minRec.max  = minMax;
+                minRec.n    = minSamples;
+                minReady = 1;
+                pipeStats.minutes++;
+                minN = 0;
+        }
+        minIndex = idx;
+
+        if (minN == 0)
+        {
+                minSum = 0;
+                minSamples = 0;
+                minMin = sr->min;
+                minMax = sr->max;
+        }
+
+        minSum += sr->mean;
+        minN++;
+        minSamples += sr->n;
+        if (sr->min < minMin) minMin = sr->min;
+        if (sr->max > minMax) minMax = sr->max;
+}
+
+/*------------------------------------------------------------
+Function: PipeSecond
+Purpose :
+Drains up to PIPE_DEC_BUDGET buffered samples into the
+running one-second accumulator and emits a record once the
+second has elapsed.
+------------------------------------------------------------*/
+static void PipeSecond(void)
+{
+        u32 budget = PIPE_DEC_BUDGET;
+        u32 v;
+
+        while (fastTail != fastHead && budget--)
+        {
+                v = fastBuf[fastTail++ & PIPE_BUF_MASK];
+
+                // secMax starts at 0 so the first sample of a
+                // second also takes the new-maximum branch
+                if (secN == 0)
+                {
+                        secSum = 0;
+                        secMin = v;
+                        secMax = 0;
+                }
+                secSum += v;
+                secN++;
+                if (v < secMin) secMin = v;
+                if (v > secMax)
+                {
+                        secMax = v;
+                        if (v >= capLevel && capState == CAP_ARMED)
+                                CapTrigger(fastTail - 1);
+                }
+        }
+
+        if (capState == CAP_POST)
+                CapCollect();
+
+        if ((s32)(Timer0Now() - secStart) < PIPE_SEC_US || secN == 0)
+                return;
+
+        //----------------------------------------------------------
+        // Keep whole-second spacing; resync after a long stall
+        // (e.g. edit mode) instead of emitting a burst of records
+        //----------------------------------------------------------
+        secStart += PIPE_SEC_US;
+        if ((s32)(Timer0Now() - secStart) >= PIPE_SEC_US)
+                secStart = Timer0Now();
+
+        secRec.mean = LM35CountToTenths(secSum / secN);
+        secRec.min  = LM35CountToTenths(secMin);
+        secRec.max  = LM35CountToTenths(secMax);
+        secRec.n    = secN;
+        secReady = 1;
+        pipeStats.seconds++;
+        secN = 0;
+
+        // Re-arm once a whole second stayed below the level
+        if (capState == CAP_REARM && secMax < capLevel)
+                capState = CAP_ARMED;
+
+        PipeMinute(&secRec);
+}
+
+/*------------------------------------------------------------
+Function: PipelineRun
+Purpose :
+Runs each stage once, fastest first.
+------------------------------------------------------------*/
+void PipelineRun(void)
+{
+        PipeFast();
+        PipeSecond();
+}
+
+/*------------------------------------------------------------
+Function: PipelineSecond
+Purpose :
+Hands the newest per-second record to the caller.
+------------------------------------------------------------*/
+u32 PipelineSecond(PipeRec *rec)
+{
+        if (!secReady)
+                return 0;
+
+        *rec = secRec;
+        secReady = 0;
+        return 1;
+}
+
+/*------------------------------------------------------------
+Function: PipelineMinute
+Purpose :
+Hands the newest per-minute record to the caller.
+------------------------------------------------------------*/
+u32 PipelineMinute(PipeRec *rec)
+{
+        if (!minReady)
+                return 0;
+
+        *rec = minRec;
+        minReady = 0;
+        return 1;
+}
+
+/*------------------------------------------------------------
+Function: PipelineCapture
+Purpose :
+Hands a completed capture to the caller; it stays valid
+until PipelineCaptureDone.
+------------------------------------------------------------*/
+const PipeCapture *PipelineCapture(void)
+{
+        return (capState == CAP_READY) ? &cap : 0;
+}
+
+/*------------------------------------------------------------
+Function: PipelineCaptureDone
+Purpose :
+Releases the capture; the trigger re-arms after the next
+second whose peak is below the level.
+------------------------------------------------------------*/
+void PipelineCaptureDone(void)
+{
+        if (capState == CAP_READY)
+                capState = CAP_REARM;
+}
+
+//------------------------------------------------------------
+// Function: PipelineCaptureBusy
+// Purpose : Capture between its trigger and its release
+//------------------------------------------------------------
+u32 PipelineCaptureBusy(void)
+{
+        return capState == CAP_POST || capState == CAP_READY;
+}
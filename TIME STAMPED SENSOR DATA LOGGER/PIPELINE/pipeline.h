@@ -0,0 +1,148 @@
+//pipeline.h
+/*------------------------------------------------------------
+File: pipeline.h
+Purpose:
+Header file for the multi-rate sampling pipeline.
+
+Stages:
+- FAST : samples the ADC at a fixed rate into a ring buffer
+- SEC  : decimates buffered samples to one record per second
+         (used for display and alerting)
+- MIN  : aggregates per-second records to one per log period
+         (one minute by default; used for the serial log)
+
+Alert capture: when a raw sample first reaches the trigger
+level, the samples before it (still in the raw ring) and the
+ones after it are frozen into a capture record, like an
+oscilloscope's single-shot trigger.
+------------------------------------------------------------*/
+
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#include "types.h"
+#include "pipeline_defines.h"
+#include "rtc.h"
+
+//------------------------------------------------------------
+// Decimated / aggregated record
+// Temperatures are in tenths of a degree Celsius
+//------------------------------------------------------------
+typedef struct
+{
+        s32 mean;      // Average over the period
+        s32 min;       // Lowest raw sample in the period
+        s32 max;       // Highest raw sample in the period
+        u32 n;         // Number of raw samples folded in
+} PipeRec;
+
+//------------------------------------------------------------
+// Stage counters (for diagnostics)
+//------------------------------------------------------------
+typedef struct
+{
+        u32 samples;    // Conversions done by the fast stage
+        u32 skipped;    // Fast slots dropped when running late
+        u32 overflow;   // Samples lost because the ring was full
+        u32 seconds;    // Per-second records produced
+        u32 minutes;    // Per-minute records produced
+        u32 overlapped; // Passes that left a conversion running
+        u32 firstUs;    // Timer0 time of the first sample
+} PipeStats;
+
+extern PipeStats pipeStats;
+
+//------------------------------------------------------------
+// Alert capture of raw ADC counts
+// buf[0..pre-1] precede the trigger sample buf[pre]
+//------------------------------------------------------------
+typedef struct
+{
+        u32 id;        // Captures taken since InitPipeline
+        u32 ch;        // ADC channel sampled
+        u32 hz;        // Fast stage rate at the trigger
+        u32 pre;       // Samples before the trigger
+        u32 len;       // Samples held
+        u32 level;     // Trigger level (ADC count)
+        RTCStamp at;   // When the trigger sample was seen
+        u16 buf[PIPE_CAP_LEN];
+} PipeCapture;
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: InitPipeline
+// Purpose : Reset all stages and start sampling a channel
+// Parameter:
+//   chNo -> ADC channel of the sensor
+// Note    : Timer0 must already be running (InitTimer0) and
+//           the ADC interrupt enabled (Init_ADC_Irq)
+//------------------------------------------------------------
+void InitPipeline(u32 chNo);
+
+//------------------------------------------------------------
+// Function: PipelineSetRate
+// Purpose : Change the fast sampling rate (samples/second)
+//------------------------------------------------------------
+void PipelineSetRate(u32 hz);
+
+//------------------------------------------------------------
+// Function: PipelineSetLogPeriod
+// Purpose : Change the aggregation period of the MIN stage
+//           (seconds, PIPE_MIN_SEC by default)
+//------------------------------------------------------------
+void PipelineSetLogPeriod(u32 sec);
+
+//------------------------------------------------------------
+// Function: PipelineSetTrigger
+// Purpose : Set the alert capture level (tenths of a degree)
+//           and arm the trigger
+//------------------------------------------------------------
+void PipelineSetTrigger(s32 tenths);
+
+//------------------------------------------------------------
+// Function: PipelineCapture
+// Purpose : Fetch a completed capture
+// Return  : Capture, or 0 while none is complete
+// Note    : The trigger stays disarmed until
+//           PipelineCaptureDone and a second below the level
+//------------------------------------------------------------
+const PipeCapture *PipelineCapture(void);
+
+//------------------------------------------------------------
+// Function: PipelineCaptureDone
+// Purpose : Release a capture fetched by PipelineCapture
+//------------------------------------------------------------
+void PipelineCaptureDone(void);
+
+//------------------------------------------------------------
+// Function: PipelineCaptureBusy
+// Return  : 1 -> a capture is being collected or has not been
+//           released yet
+//------------------------------------------------------------
+u32 PipelineCaptureBusy(void);
+
+//------------------------------------------------------------
+// Function: PipelineRun
+// Purpose : Run every stage once within its work budget
+//           Call as often as possible from the main loop
+//------------------------------------------------------------
+void PipelineRun(void);
+
+//------------------------------------------------------------
+// Function: PipelineSecond
+// Purpose : Fetch the newest per-second record
+// Return  : 1 -> new record copied to rec, 0 -> none pending
+//------------------------------------------------------------
+u32 PipelineSecond(PipeRec *rec);
+
+//------------------------------------------------------------
+// Function: PipelineMinute
+// Purpose : Fetch the newest per-log-period record
+// Return  : 1 -> new record copied to rec, 0 -> none pending
+//------------------------------------------------------------
+u32 PipelineMinute(PipeRec *rec);
+
+#endif
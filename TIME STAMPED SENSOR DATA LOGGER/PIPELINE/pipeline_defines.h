@@ -0,0 +1,55 @@
+//pipeline_defines.h
+/*------------------------------------------------------------
+File: pipeline_defines.h
+Purpose:
+Contains macros for the multi-rate sampling pipeline.
+
+This file defines:
+- Default fast sampling rate
+- Raw sample buffer size
+- Pre-trigger capture lengths
+- Per-call work budget of each stage
+------------------------------------------------------------*/
+
+#ifndef PIPELINE_DEFINES_H
+#define PIPELINE_DEFINES_H
+
+//------------------------------------------------------------
+// Fast stage sampling rate limits (samples per second)
+//------------------------------------------------------------
+#define PIPE_FAST_HZ      1000   // Default rate (1 kHz)
+#define PIPE_FAST_HZ_MAX  10000  // Highest accepted rate
+
+//------------------------------------------------------------
+// Raw sample ring (must be a power of two)
+// Samples already decimated stay in it until overwritten, so
+// it also holds the pre-trigger history of a capture; it is
+// sized for PIPE_CAP_PRE plus the decimation backlog.
+//------------------------------------------------------------
+#define PIPE_BUF_LEN      512
+#define PIPE_BUF_MASK     (PIPE_BUF_LEN-1)
+
+//------------------------------------------------------------
+// Stage budgets per PipelineRun() call
+// FAST : ADC conversions at most
+// DEC  : buffered samples folded into the 1 s record at most
+//------------------------------------------------------------
+#define PIPE_FAST_BUDGET  8
+#define PIPE_DEC_BUDGET   64
+
+//------------------------------------------------------------
+// Decimated and aggregated periods
+//------------------------------------------------------------
+#define PIPE_SEC_US       1000000  // Decimation period (1 s)
+#define PIPE_MIN_SEC      60       // Default aggregation period (1 min)
+
+//------------------------------------------------------------
+// Alert capture: raw samples kept before the trigger sample
+// and from it on (PIPE_CAP_PRE must stay well below
+// PIPE_BUF_LEN)
+//------------------------------------------------------------
+#define PIPE_CAP_PRE      200
+#define PIPE_CAP_POST     200
+#define PIPE_CAP_LEN      (PIPE_CAP_PRE + PIPE_CAP_POST)
+
+#endif
@@ -28,6 +28,19 @@ This program:
 #include "DisplayInformation.h"  // LCD display routines
 #include "defines.h"             // Common macros and definitions
 #include "KeyPd.h"               // Keypad driver
+#include "stats.h"               // Streaming window statistics
+#include "timer.h"               // Timer0 microsecond time base
+#include "pipeline.h"            // Multi-rate sampling pipeline
+#include "rate.h"                // Adaptive sampling rate
+#include "sensor.h"              // Per-channel sensor table
+#include "trend.h"               // Time-to-threshold forecast
+#include "blklog.h"              // SPI flash append log
+#include "seqlog.h"              // Numbered UART records, resend on NAK
+#include "vic.h"                 // Vectored interrupt controller
+#include "config.h"              // Set point and rate kept in flash
+#include "clock.h"               // PLL, VPB divider and MAM
+#include "ramcode.h"             // SRAM code placement benchmark
+#include "usbcdc.h"              // USB virtual COM port
 
 //------------------------------------------------------------
 // Macro definitions
@@ -36,8 +49,12 @@ This program:
 // Switch connected to P0.18
 #define SW 18
 
-// Default temperature set point
-#define SET_POINT 45
+// Reset source identification register (RSIR) bits
+#define RSIR_POR  (1 << 0)      // Power-on reset
+#define RSIR_EXTR (1 << 1)      // External reset pin
+#define RSIR_WDTR (1 << 2)      // Watchdog reset
+#define RSIR_BODR (1 << 3)      // Brown-out reset
+#define RSIR_ALL  0x0F
 
 //------------------------------------------------------------
 // Global variables
@@ -46,8 +63,84 @@ This program:
 // Flag to indicate EDIT mode status
 u32 edit_flag = 0;
 
-// Variable to store temperature set point
-u32 set_point = SET_POINT;
+// Boot path taken (reported on UART)
+static u32 resetCause, rtcKept, cfgRestored, bootTimed;
+
+//------------------------------------------------------------
+// Function: ReportBoot
+// Purpose : Send how the system came up, via UART
+// Format  : [BOOT] LOG sector:N seq:M reset:EXT rtc:kept
+//           cfg:flash (LOG part with SPI_FLASH_LOG only)
+//------------------------------------------------------------
+static void ReportBoot(void)
+{
+        SeqLogBegin();
+#ifdef SPI_FLASH_LOG
+        UARTTxStr("[BOOT] LOG sector:");
+        UARTTxU32(blkLogStats.head);
+        UARTTxStr(" seq:");
+        UARTTxU32(blkLogStats.seq);
+        UARTTxStr(" reset:");
+#else
+        UARTTxStr("[BOOT] reset:");
+#endif
+        if (resetCause & RSIR_POR)       UARTTxStr("POR");
+        else if (resetCause & RSIR_BODR) UARTTxStr("BOD");
+        else if (resetCause & RSIR_WDTR) UARTTxStr("WDT");
+        else                             UARTTxStr("EXT");
+
+        UARTTxStr(rtcKept ? " rtc:kept" : " rtc:set");
+        UARTTxStr(cfgRestored ? " cfg:flash" : " cfg:default");
+        SeqLogEnd();
+}
+
+//------------------------------------------------------------
+// Function: ReportBootTime
+// Purpose : Send the time from reset to the first sample
+// Format  : [BOOT] first sample:N us
+// Note    : Counted from Timer0 start, the first statement
+//           of main(); startup code before main is not included
+//------------------------------------------------------------
+static void ReportBootTime(void)
+{
+        SeqLogBegin();
+        UARTTxStr("[BOOT] first sample:");
+        UARTTxU32(pipeStats.firstUs);
+        UARTTxStr(" us");
+        SeqLogEnd();
+}
+
+//------------------------------------------------------------
+// Function: ReportConfigSave
+// Purpose : Save a changed configuration and report a failure
+// Format  : [CFG] not saved
+//------------------------------------------------------------
+static void ReportConfigSave(void)
+{
+        if (ConfigSave())
+                return;
+
+        SeqLogBegin();
+        UARTTxStr("[CFG] not saved");
+        SeqLogEnd();
+}
+
+//------------------------------------------------------------
+// Function: ReportDiff
+// Purpose : Send one differential LM35 reading, so the wiring
+//           of the reference leg can be checked at start-up
+// Format  : [BOOT] lm35 diff:N.NNNNNNC
+//------------------------------------------------------------
+static void ReportDiff(void)
+{
+        Init_LM35_NP();
+
+        SeqLogBegin();
+        UARTTxStr("[BOOT] lm35 diff:");
+        UARTTxF32(Read_LM35_NP('C'));
+        UARTTxChar('C');
+        SeqLogEnd();
+}
 
 //------------------------------------------------------------
 // Function: main
@@ -55,6 +148,26 @@ u32 set_point = SET_POINT;
 //------------------------------------------------------------
 int main()
 {
+        //--------------------------------------------------------
+        // Start the Timer1 delay/deadline counter, then set up
+        // the clocks before any other peripheral, since every
+        // driver derives its dividers from them
+        //--------------------------------------------------------
+        InitTimer1();
+        InitClock(CLK_PERF);
+
+        //--------------------------------------------------------
+        // Start the microsecond time base next, so the time to
+        // the first sample can be measured
+        //--------------------------------------------------------
+        InitTimer0();
+
+        //--------------------------------------------------------
+        // Note why we were reset, then clear the flags
+        //--------------------------------------------------------
+        resetCause = RSIR;
+        RSIR = RSIR_ALL;
+
         //--------------------------------------------------------
         // Configure P0.16 and P0.17 as output pins
         // P0.16 -> LED
@@ -68,24 +181,82 @@ int main()
         IOSET0 = (1 << 16);
 
         //--------------------------------------------------------
-        // Initialize Real Time Clock (RTC)
+        // Interrupt controller to a known state
+        //--------------------------------------------------------
+        InitVIC();
+
+        //--------------------------------------------------------
+        // Initialize Real Time Clock (RTC), keeping a clock that
+        // is still running; load the default time only if the
+        // RTC lost it, before anything below reads the clock.
+        // Then latch its second edges for sub-second time stamps
+        //--------------------------------------------------------
+        rtcKept = RTC_Init();
+        if (!rtcKept)
+                SetInformation();
+        InitRTCStamp();
+
+        //--------------------------------------------------------
+        // Set point and sample rate from flash
         //--------------------------------------------------------
-        RTC_Init();
+        cfgRestored = InitConfig();
 
         //--------------------------------------------------------
-        // Initialize LCD module
+        // Initialize LCD module; after a warm reset the LCD is
+        // already powered and its power-on wait is skipped
         //--------------------------------------------------------
-        InitLCD();
+        InitLCD((resetCause & (RSIR_POR | RSIR_BODR)) != 0);
 
         //--------------------------------------------------------
         // Initialize UART for serial communication
         //--------------------------------------------------------
         InitUART();
 
+#ifdef USB_CDC
+        //--------------------------------------------------------
+        // USB virtual COM port for the bulk records; enumeration
+        // runs from its interrupt
+        //--------------------------------------------------------
+        InitUsbCdc(&usbHwLpc);
+#endif
+
         //--------------------------------------------------------
-        // Initialize ADC channel 1 for LM35 temperature sensor
+        // Number UART log records from 0 (host sees a reset)
         //--------------------------------------------------------
-        Init_ADC(CH1);
+        InitSeqLog();
+
+#ifdef SPI_FLASH_LOG
+        //--------------------------------------------------------
+        // Attach the SPI flash log and recover its write position
+        //--------------------------------------------------------
+        InitBlkDevSpi();
+        InitBlkLog(&blkDevSpi);
+#endif
+        ReportBoot();
+
+        //--------------------------------------------------------
+        // Differential reading once, before the first sensor
+        // takes AD0 over with its conversion interrupt
+        //--------------------------------------------------------
+        ReportDiff();
+
+#ifdef RAMCODE_BENCH
+        //--------------------------------------------------------
+        // Compare flash and SRAM code placement
+        //--------------------------------------------------------
+        RamCodeBench();
+#endif
+
+        //--------------------------------------------------------
+        // Sensor table; the first sensor (LM35 on CH1) takes
+        // its set point from flash and is converted with the
+        // conversion-complete interrupt, the others are
+        // scanned together
+        //--------------------------------------------------------
+        InitSensors();
+        SensorSetPoint(0, config.setPoint * 10);
+        Init_ADC(sens.ch[0]);
+        Init_ADC_Irq();
 
         //--------------------------------------------------------
         // Initialize Keypad
@@ -93,15 +264,62 @@ int main()
         KeyPdInit();
 
         //--------------------------------------------------------
-        // Display initial information on LCD
+        // Start the sampling pipeline (1 s display); the rate
+        // scheduler moves the raw rate and log period between
+        // the configured limits, raw samples around the
+        // first one over the set point are captured, and the
+        // trend of the readings forecasts when it is reached
+        //--------------------------------------------------------
+        InitPipeline(sens.ch[0]);
+        InitRate(config.sampleHzMin, config.sampleHz);
+        PipelineSetTrigger(sens.setPoint[0]);
+        InitTrend();
+
+        //--------------------------------------------------------
+        // Clear minute/hour/day statistics windows
+        //--------------------------------------------------------
+        InitStats();
+
+        //--------------------------------------------------------
+        // Attach the display and logging sinks to the sample bus
         //--------------------------------------------------------
-        SetInformation();
+        InitSampleBus();
 
         //--------------------------------------------------------
         // Infinite loop
         //--------------------------------------------------------
   while (1)
         {
+#ifdef SPI_FLASH_LOG
+                //----------------------------------------------------
+                // Start queued flash log writes when the SPI is free
+                //----------------------------------------------------
+                BlkLogService();
+#endif
+
+                //----------------------------------------------------
+                // Resend UART records the host reported missing
+                //----------------------------------------------------
+                SeqLogPoll();
+
+                //----------------------------------------------------
+                // Save a changed configuration while no capture
+                // and no resend is in progress: the flash calls
+                // mask every interrupt, for up to 400 ms when the
+                // sector is erased
+                //----------------------------------------------------
+                if (ConfigPending() && !PipelineCaptureBusy() && !SeqLogResending())
+                        ReportConfigSave();
+
+                //----------------------------------------------------
+                // Report boot time once the first sample is in
+                //----------------------------------------------------
+                if (!bootTimed && pipeStats.samples != 0)
+                {
+                        ReportBootTime();
+                        bootTimed = 1;
+                }
+
                 //----------------------------------------------------
                 // Check if switch (SW) is pressed
                 // Active LOW: pressed when logic level is 0
@@ -113,25 +331,15 @@ int main()
                 }
 
                 //----------------------------------------------------
-                // If EDIT mode is enabled
+                // Sampling, display and logging go on in EDIT mode
                 //----------------------------------------------------
-                if (edit_flag == 1)
-                {
-                        // Clear LCD screen
-                        CmdLCD(0x01);
+                DisplayInformation();
 
-                        // Call EDIT mode routine
+                //----------------------------------------------------
+                // One step of the EDIT menu; it never waits here
+                // and clears edit_flag when it is left
+                //----------------------------------------------------
+                if (edit_flag == 1)
                         EditMode();
-
-                        // Clear LCD again after editing
-                        CmdLCD(0x01);
-                }
-                else
-                {
-                        //------------------------------------------------
-                        // Normal display mode
-                        //------------------------------------------------
-                        DisplayInformation();
-                }
         }
 }
@@ -0,0 +1,128 @@
+//pt.h
+/*------------------------------------------------------------
+File: pt.h
+Purpose:
+Protothreads: stackless coroutines built from a switch
+statement, for flows that wait on keys or time.
+
+A protothread is a function taking a Pt. It is written as
+straight-line code between PT_BEGIN and PT_END; every wait
+macro stores the current line in the Pt and returns, and the
+next call jumps back to that line. The caller keeps calling
+it from the main loop until it has exited, so a wait costs
+one check per pass instead of holding the CPU.
+
+Rules (the switch is hidden in PT_BEGIN):
+- Locals are lost at every wait; keep state in statics
+- No wait macro inside a switch statement of the thread
+- At most one wait macro per source line (the line number
+  is the resume label)
+- A nested thread is started with PT_SPAWN and needs its
+  own Pt
+
+Example:
+static Pt blinkPt;
+static u32 blinkDl;
+
+static u8 Blink(Pt *p)
+{
+        PT_BEGIN(p);
+        while (1)
+        {
+                IOSET0 = LED;
+                PT_DELAY_MS(p, blinkDl, 500);
+                IOCLR0 = LED;
+                PT_DELAY_MS(p, blinkDl, 500);
+        }
+        PT_END(p);
+}
+
+NOTE:
+PT_DELAY_MS uses the Timer1 deadlines of timer.h.
+------------------------------------------------------------*/
+
+#ifndef __PT_H__
+#define __PT_H__
+
+#include "types.h"
+
+//------------------------------------------------------------
+// Thread state: line to resume at, 0 -> start
+//------------------------------------------------------------
+typedef struct
+{
+        u16 lc;
+} Pt;
+
+//------------------------------------------------------------
+// Return values of a protothread
+//------------------------------------------------------------
+#define PT_WAITING  0       // Blocked in a wait
+#define PT_YIELDED  1       // Gave up the CPU for one pass
+#define PT_EXITED   2       // Left with PT_EXIT
+#define PT_ENDED    3       // Reached PT_END
+
+//------------------------------------------------------------
+// Macro: PT_INIT
+// Purpose: Restart a thread from PT_BEGIN on its next call
+//------------------------------------------------------------
+#define PT_INIT(p)            ((p)->lc = 0)
+
+//------------------------------------------------------------
+// Macro: PT_BEGIN / PT_END
+// Purpose: Enclose the body of a thread; reaching PT_END
+//          restarts it
+//------------------------------------------------------------
+#define PT_BEGIN(p)           { u8 ptYield = 1; (void)ptYield; \
+                                switch ((p)->lc) { case 0:
+
+#define PT_END(p)             } PT_INIT(p); return PT_ENDED; }
+
+//------------------------------------------------------------
+// Macro: PT_WAIT_UNTIL / PT_WAIT_WHILE
+// Purpose: Return until the condition holds / stops holding;
+//          it is tested again on every call
+//------------------------------------------------------------
+#define PT_WAIT_UNTIL(p, c)   do { (p)->lc = __LINE__; case __LINE__: \
+                                   if (!(c)) return PT_WAITING; } while (0)
+
+#define PT_WAIT_WHILE(p, c)   PT_WAIT_UNTIL(p, !(c))
+
+//------------------------------------------------------------
+// Macro: PT_YIELD
+// Purpose: Return once, carry on at the next call
+//------------------------------------------------------------
+#define PT_YIELD(p)           do { ptYield = 0; (p)->lc = __LINE__; case __LINE__: \
+                                   if (ptYield == 0) return PT_YIELDED; } while (0)
+
+//------------------------------------------------------------
+// Macro: PT_EXIT
+// Purpose: Leave the thread; the next call starts it again
+//------------------------------------------------------------
+#define PT_EXIT(p)            do { PT_INIT(p); return PT_EXITED; } while (0)
+
+//------------------------------------------------------------
+// Macro: PT_SPAWN
+// Purpose: Start a child thread and wait until it has exited
+//          or ended; call is the child's call with its Pt
+//------------------------------------------------------------
+#define PT_SPAWN(p, child, call) \
+                              do { PT_INIT(child); \
+                                   PT_WAIT_UNTIL(p, (call) >= PT_EXITED); } while (0)
+
+//------------------------------------------------------------
+// Macro: PT_DELAY_MS
+// Purpose: Wait ms milliseconds; dl is a static u32 of the
+//          thread holding the deadline
+//------------------------------------------------------------
+#define PT_DELAY_MS(p, dl, ms) \
+                              do { (dl) = DeadlineSet((ms) * 1000); \
+                                   PT_WAIT_UNTIL(p, DeadlinePassed(dl)); } while (0)
+
+//------------------------------------------------------------
+// Macro: PT_RUNNING
+// Purpose: 1 while a thread call has not exited or ended
+//------------------------------------------------------------
+#define PT_RUNNING(call)      ((call) < PT_EXITED)
+
+#endif
@@ -0,0 +1,141 @@
+//queue.c
+/*------------------------------------------------------------
+File: queue.c
+Purpose:
+Implements a lock-free single-producer/single-consumer ring
+of fixed-size elements.
+
+Features:
+- Power-of-two capacity, index wrap by mask
+- Free-running 32-bit head/tail, so full and empty need no
+  spare slot: count = head - tail
+- Each side reads the other side's index once per call and
+  publishes its own index once, after a barrier
+- Batch push/pop copy in at most two pieces (before and
+  after the wrap)
+------------------------------------------------------------*/
+
+#include <string.h>           // memcpy
+#include "types.h"            // User-defined data types
+#include "queue.h"            // Queue descriptor and prototypes
+#include "queue_defines.h"    // QUEUE_BARRIER
+
+/*------------------------------------------------------------
+Function: QueueInit
+Purpose :
+Sets up an empty queue over caller storage.
+------------------------------------------------------------*/
+u32 QueueInit(Queue *q, void *buf, u32 elemSize, u32 capacity)
+{
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0 || elemSize == 0)
+                return 0;
+
+        q->buf = (u8 *)buf;
+        q->elemSize = elemSize;
+        q->mask = capacity - 1;
+        q->head = 0;
+        q->tail = 0;
+        return 1;
+}
+
+//------------------------------------------------------------
+// Function: CopyIn / CopyOut
+// Purpose : Copy n elements to/from the ring at index idx,
+//           splitting at the end of the storage
+//------------------------------------------------------------
+static void CopyIn(Queue *q, u32 idx, const u8 *src, u32 n)
+{
+        u32 pos = idx & q->mask;
+        u32 first = q->mask + 1 - pos;
+
+        if (first > n)
+                first = n;
+        memcpy(q->buf + pos * q->elemSize, src, first * q->elemSize);
+        memcpy(q->buf, src + first * q->elemSize, (n - first) * q->elemSize);
+}
+
+static void CopyOut(Queue *q, u32 idx, u8 *dst, u32 n)
+{
+        u32 pos = idx & q->mask;
+        u32 first = q->mask + 1 - pos;
+
+        if (first > n)
+                first = n;
+        memcpy(dst, q->buf + pos * q->elemSize, first * q->elemSize);
+        memcpy(dst + first * q->elemSize, q->buf, (n - first) * q->elemSize);
+}
+
+/*------------------------------------------------------------
+Function: QueuePushN
+Purpose :
+Producer side. Stores the elements only after the tail has
+been read (the slots may still be read by the consumer until
+then), and publishes them with a single head update.
+------------------------------------------------------------*/
+u32 QueuePushN(Queue *q, const void *elems, u32 n)
+{
+        u32 head = q->head;
+        u32 space = q->mask + 1 - (head - q->tail);
+
+        if (n > space)
+                n = space;
+        if (n == 0)
+                return 0;
+
+        QUEUE_BARRIER();
+        CopyIn(q, head, (const u8 *)elems, n);
+        QUEUE_BARRIER();
+        q->head = head + n;
+        return n;
+}
+
+/*------------------------------------------------------------
+Function: QueuePopN
+Purpose :
+Consumer side. Reads the elements first, then frees their
+slots with a single tail update.
+------------------------------------------------------------*/
+u32 QueuePopN(Queue *q, void *elems, u32 n)
+{
+        u32 tail = q->tail;
+        u32 count = q->head - tail;
+
+        if (n > count)
+                n = count;
+        if (n == 0)
+                return 0;
+
+        QUEUE_BARRIER();
+        CopyOut(q, tail, (u8 *)elems, n);
+        QUEUE_BARRIER();
+        q->tail = tail + n;
+        return n;
+}
+
+//------------------------------------------------------------
+// Function: QueuePush / QueuePop
+// Purpose : Single element forms of the above
+//------------------------------------------------------------
+u32 QueuePush(Queue *q, const void *elem)
+{
+        return QueuePushN(q, elem, 1);
+}
+
+u32 QueuePop(Queue *q, void *elem)
+{
+        return QueuePopN(q, elem, 1);
+}
+
+//------------------------------------------------------------
+// Function: QueueCount / QueueSpace
+// Purpose : Elements waiting / free slots
+//------------------------------------------------------------
+u32 QueueCount(Queue *q)
+{
+        return q->head - q->tail;
+}
+
+u32 QueueSpace(Queue *q)
+{
+        return q->mask + 1 - (q->head - q->tail);
+}
@@ -0,0 +1,92 @@
+//queue.h
+/*------------------------------------------------------------
+File: queue.h
+Purpose:
+Header file for a lock-free single-producer/single-consumer
+(SPSC) ring of fixed-size elements.
+
+Intended for hand-off between an ISR and main(): one side
+only pushes, the other only pops, and neither has to mask
+interrupts.
+
+Rules:
+- Capacity is a power of two; the storage is provided by the
+  caller (elemSize * capacity bytes)
+- head is written only by the producer, tail only by the
+  consumer; both run freely and wrap at 2^32
+- Only the QueuePush* side may be called from the producer,
+  only the QueuePop* side from the consumer
+------------------------------------------------------------*/
+
+#ifndef __QUEUE_H__
+#define __QUEUE_H__
+
+#include "types.h"
+
+//------------------------------------------------------------
+// Queue descriptor
+//------------------------------------------------------------
+typedef struct
+{
+        volatile u32 head;   // Elements ever pushed
+        volatile u32 tail;   // Elements ever popped
+        u32 mask;            // capacity - 1
+        u32 elemSize;        // Bytes per element
+        u8  *buf;            // capacity * elemSize bytes
+} Queue;
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: QueueInit
+// Purpose : Set up an empty queue over caller storage
+// Parameters:
+//   q        -> queue descriptor
+//   buf      -> storage of capacity * elemSize bytes
+//   elemSize -> bytes per element
+//   capacity -> number of elements, power of two
+// Return  : 1 -> ready, 0 -> capacity not a power of two
+// Note    : Call before either side uses the queue
+//------------------------------------------------------------
+u32 QueueInit(Queue *q, void *buf, u32 elemSize, u32 capacity);
+
+//------------------------------------------------------------
+// Function: QueuePush (producer)
+// Purpose : Append one element
+// Return  : 1 -> pushed, 0 -> queue full
+//------------------------------------------------------------
+u32 QueuePush(Queue *q, const void *elem);
+
+//------------------------------------------------------------
+// Function: QueuePushN (producer)
+// Purpose : Append up to n elements with one index update
+// Return  : Number of elements pushed
+//------------------------------------------------------------
+u32 QueuePushN(Queue *q, const void *elems, u32 n);
+
+//------------------------------------------------------------
+// Function: QueuePop (consumer)
+// Purpose : Remove the oldest element
+// Return  : 1 -> *elem filled, 0 -> queue empty
+//------------------------------------------------------------
+u32 QueuePop(Queue *q, void *elem);
+
+//------------------------------------------------------------
+// Function: QueuePopN (consumer)
+// Purpose : Remove up to n elements with one index update
+// Return  : Number of elements removed
+//------------------------------------------------------------
+u32 QueuePopN(Queue *q, void *elems, u32 n);
+
+//------------------------------------------------------------
+// Function: QueueCount / QueueSpace
+// Purpose : Elements waiting / free slots
+// Note    : Exact for the calling side, a lower bound seen
+//           from the other side
+//------------------------------------------------------------
+u32 QueueCount(Queue *q);
+u32 QueueSpace(Queue *q);
+
+#endif
@@ -0,0 +1,36 @@
+//queue_defines.h
+/*------------------------------------------------------------
+File: queue_defines.h
+Purpose:
+Contains macros for the single-producer/single-consumer
+queue library.
+
+This file defines:
+- The ordering barrier used between element data and the
+  head/tail indexes
+------------------------------------------------------------*/
+
+#ifndef QUEUE_DEFINES_H
+#define QUEUE_DEFINES_H
+
+//------------------------------------------------------------
+// QUEUE_BARRIER
+// Element bytes must be stored before the index that
+// publishes them (and read before the index that frees them).
+//
+// ARM7TDMI is a single in-order core without a data cache,
+// so only the compiler has to be stopped from reordering.
+// Host builds run the two sides on different cores and need
+// a real memory barrier.
+//------------------------------------------------------------
+#if defined(HOST_BUILD)
+#define QUEUE_BARRIER()   __sync_synchronize()
+#elif defined(__CC_ARM)
+#define QUEUE_BARRIER()   __memory_changed()
+#elif defined(__GNUC__)
+#define QUEUE_BARRIER()   __asm__ __volatile__("" ::: "memory")
+#else
+#error "QUEUE_BARRIER not defined for this compiler"
+#endif
+
+#endif
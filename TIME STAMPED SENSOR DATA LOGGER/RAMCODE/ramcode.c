@@ -0,0 +1,112 @@
+//ramcode.c
+/*------------------------------------------------------------
+File: ramcode.c
+Purpose:
+Benchmark of code placement: the same loop kernel is built
+three times, in flash, in SRAM as ARM code and in SRAM as
+Thumb code, and each copy is timed.
+
+The kernel is a bitwise CRC-16 over a buffer: short loops,
+a data-dependent branch and register-only work, like the
+polled driver loops and ISRs that are moved to SRAM.
+
+Only built with RAMCODE_BENCH defined.
+------------------------------------------------------------*/
+
+#ifdef RAMCODE_BENCH
+
+#include <lpc214x.h>          // LPC214x register definitions
+#include "types.h"            // User-defined data types
+#include "ramcode.h"          // RAMFUNC, CODE_ARM, CODE_THUMB
+#include "clock.h"            // CCLK for cycle conversion
+#include "seqlog.h"           // Numbered UART record
+#include "uart.h"             // UART output
+
+#define BENCH_BYTES   256     // Buffer size per kernel call
+#define BENCH_RUNS    64      // Calls per measurement
+
+static u8 benchBuf[BENCH_BYTES];
+
+//------------------------------------------------------------
+// Kernel body, identical in all three copies
+//------------------------------------------------------------
+#define BENCH_KERNEL(buf, len)                                  \
+{                                                               \
+        u32 i, bit, crc = 0xFFFF;                               \
+                                                                \
+        for (i = 0; i < (len); i++)                             \
+        {                                                       \
+                crc ^= (u32)(buf)[i] << 8;                      \
+                for (bit = 0; bit < 8; bit++)                   \
+                        crc = (crc & 0x8000) ?                  \
+                              ((crc << 1) ^ 0x1021) : (crc << 1); \
+        }                                                       \
+        return crc & 0xFFFF;                                    \
+}
+
+static u32 KernelFlash(const u8 *buf, u32 len)
+BENCH_KERNEL(buf, len)
+
+CODE_ARM
+RAMFUNC static u32 KernelRamArm(const u8 *buf, u32 len)
+BENCH_KERNEL(buf, len)
+CODE_END
+
+CODE_THUMB
+RAMFUNC static u32 KernelRamThumb(const u8 *buf, u32 len)
+BENCH_KERNEL(buf, len)
+CODE_END
+
+/*------------------------------------------------------------
+Function: BenchCycles
+Purpose :
+Runs a kernel BENCH_RUNS times and returns CPU cycles per
+call, from the Timer0 microsecond count and the current CCLK.
+------------------------------------------------------------*/
+static u32 BenchCycles(u32 (*kernel)(const u8 *, u32))
+{
+        u32 i, t0, us, sum = 0;
+
+        t0 = T0TC;
+        for (i = 0; i < BENCH_RUNS; i++)
+                sum += kernel(benchBuf, BENCH_BYTES);
+        us = T0TC - t0;
+
+        benchBuf[0] ^= (u8)sum;   // Keep the result live
+        return us * (ClockCclk() / 1000000) / BENCH_RUNS;
+}
+
+/*------------------------------------------------------------
+Function: RamCodeBench
+Purpose :
+Times the three copies of the kernel with interrupts masked
+and sends one [BENCH] record.
+------------------------------------------------------------*/
+void RamCodeBench(void)
+{
+        u32 i, irq, flash, ramArm, ramThumb;
+
+        for (i = 0; i < BENCH_BYTES; i++)
+                benchBuf[i] = (u8)(i * 37 + 11);
+
+        irq = VICIntEnable;
+        VICIntEnClr = 0xFFFFFFFF;
+
+        flash    = BenchCycles(KernelFlash);
+        ramArm   = BenchCycles(KernelRamArm);
+        ramThumb = BenchCycles(KernelRamThumb);
+
+        VICIntEnable = irq;
+
+        SeqLogBegin();
+        UARTTxStr("[BENCH] flash:");
+        UARTTxU32(flash);
+        UARTTxStr(" ram-arm:");
+        UARTTxU32(ramArm);
+        UARTTxStr(" ram-thumb:");
+        UARTTxU32(ramThumb);
+        UARTTxStr(" cycles");
+        SeqLogEnd();
+}
+
+#endif
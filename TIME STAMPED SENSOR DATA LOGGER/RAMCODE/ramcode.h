@@ -0,0 +1,75 @@
+//ramcode.h
+/*------------------------------------------------------------
+File: ramcode.h
+Purpose:
+Placement of hot code in on-chip SRAM and per-function
+choice of ARM or Thumb instruction set.
+
+Flash is read through the MAM, which adds wait states on
+every fetch that misses its prefetch buffers (branches,
+literal loads). SRAM is read in one cycle, so short polled
+loops and ISRs run faster and with steadier timing from RAM.
+
+Usage:
+
+CODE_ARM
+RAMFUNC void ADC_ISR(void) __irq
+{
+        ...
+}
+CODE_END
+
+RAMFUNC puts the function in the "ramfunc" section. The
+scatter file (PROJECT/project.sct) gives that section a load
+address in flash and an execution address in SRAM; the
+C library start-up copies it before main(). Calls between
+flash and RAM are too far for a plain BL, the linker adds
+long-branch veneers.
+
+CODE_ARM / CODE_THUMB ... CODE_END choose the instruction
+set for the functions between them: ARM for ISRs and tight
+loops (32-bit SRAM fetches one ARM instruction per cycle),
+Thumb where code size matters more.
+
+Define RAMCODE_BENCH to build RamCodeBench().
+------------------------------------------------------------*/
+
+#ifndef __RAMCODE_H__
+#define __RAMCODE_H__
+
+#include "types.h"
+
+#if defined(__CC_ARM)
+#define RAMFUNC     __attribute__((section("ramfunc")))
+#define CODE_ARM    _Pragma("push") _Pragma("arm")
+#define CODE_THUMB  _Pragma("push") _Pragma("thumb")
+#define CODE_END    _Pragma("pop")
+#elif defined(__GNUC__) && defined(__arm__)
+// GCC: build with -mlong-calls, and copy .ramfunc in start-up
+#define RAMFUNC     __attribute__((section(".ramfunc"), noinline))
+#define CODE_ARM    _Pragma("GCC push_options") _Pragma("GCC target(\"arm\")")
+#define CODE_THUMB  _Pragma("GCC push_options") _Pragma("GCC target(\"thumb\")")
+#define CODE_END    _Pragma("GCC pop_options")
+#else
+#define RAMFUNC
+#define CODE_ARM
+#define CODE_THUMB
+#define CODE_END
+#endif
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+#ifdef RAMCODE_BENCH
+//------------------------------------------------------------
+// Function: RamCodeBench
+// Purpose : Time one loop kernel run from flash and from
+//           SRAM (ARM and Thumb) and report over UART
+// Format  : [BENCH] flash:N ram-arm:N ram-thumb:N cycles
+// Note    : Runs with interrupts masked; call after InitUART
+//------------------------------------------------------------
+void RamCodeBench(void);
+#endif
+
+#endif
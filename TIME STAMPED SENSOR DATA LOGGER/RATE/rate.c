@@ -0,0 +1,172 @@
+//rate.c
+/*------------------------------------------------------------
+File: rate.c
+Purpose:
+Implements the adaptive sampling rate scheduler.
+
+Operation (once per second):
+- The slope of the per-second mean is smoothed into a Q4
+  running average
+- The distance from the per-second peak to the set point is
+  projected RATE_LOOKAHEAD_S ahead while the reading rises
+- The projected distance maps linearly onto a target level
+  between RATE_FAR_T (level 0) and RATE_NEAR_T (top level)
+- A higher target is taken at once; a lower one only after
+  it has held for RATE_HOLD_S, and one level at a time, so
+  a noisy reading does not make the rate hunt
+
+The chosen level sets the pipeline's fast stage rate and
+its log record period.
+------------------------------------------------------------*/
+
+#include "types.h"          // User-defined data types
+#include "pipeline.h"       // PipelineSetRate, PipelineSetLogPeriod
+#include "rate.h"           // Scheduler prototypes and counters
+#include "rate_defines.h"   // Levels, distances, hold time
+
+//------------------------------------------------------------
+// Decision counters
+//------------------------------------------------------------
+RateStats rateStats;
+
+//------------------------------------------------------------
+// Rate and log period of each level
+//------------------------------------------------------------
+static u32 levelHz[RATE_LEVELS];
+static const u32 levelLog[RATE_LEVELS] = RATE_LOG_PERIODS;
+
+//------------------------------------------------------------
+// Slope estimate and step-down hold
+//------------------------------------------------------------
+static s32 prevMean;
+static u32 havePrev;
+static s32 slopeAcc;            // Slope << RATE_SLOPE_SHIFT
+static u32 holdSecs;
+
+//------------------------------------------------------------
+// Function: RateApply
+// Purpose : Switch the pipeline to a level; the fast stage
+//           schedule restarts only when its rate changes
+//------------------------------------------------------------
+static void RateApply(u32 level)
+{
+        if (levelHz[level] != rateStats.hz)
+                PipelineSetRate(levelHz[level]);
+        PipelineSetLogPeriod(levelLog[level]);
+
+        rateStats.level  = level;
+        rateStats.hz     = levelHz[level];
+        rateStats.logSec = levelLog[level];
+}
+
+/*------------------------------------------------------------
+Function: InitRate
+Purpose :
+Builds the level table from the rate limits: level 0 runs at
+minHz, every level above doubles up to maxHz at the top.
+Clears the counters and starts at the top level.
+------------------------------------------------------------*/
+void InitRate(u32 minHz, u32 maxHz)
+{
+        u32 i;
+
+        if (maxHz < minHz)
+                maxHz = minHz;
+
+        for (i = 0; i < RATE_LEVELS; i++)
+        {
+                levelHz[i] = maxHz >> (RATE_LEVELS - 1 - i);
+                if (levelHz[i] < minHz)
+                        levelHz[i] = minHz;
+        }
+        levelHz[0] = minHz;
+
+        rateStats.decisions = rateStats.up = rateStats.down = rateStats.held = 0;
+        for (i = 0; i < RATE_LEVELS; i++)
+                rateStats.secs[i] = 0;
+        rateStats.slope = 0;
+        slopeAcc = 0;
+        rateStats.hz = 0;
+        havePrev = 0;
+        holdSecs = 0;
+
+        RateApply(RATE_LEVELS - 1);
+}
+
+//------------------------------------------------------------
+// Function: RateTarget
+// Purpose : Level wanted for a projected distance (tenths)
+//------------------------------------------------------------
+static u32 RateTarget(s32 margin)
+{
+        s32 span = RATE_FAR_T - RATE_NEAR_T;
+
+        if (margin <= RATE_NEAR_T)
+                return RATE_LEVELS - 1;
+        if (margin >= RATE_FAR_T)
+                return 0;
+
+        // Round up: between two levels take the faster one
+        return ((RATE_LEVELS - 1) * (RATE_FAR_T - margin) + span - 1) / span;
+}
+
+/*------------------------------------------------------------
+Function: RateUpdate
+Purpose :
+Updates the slope, works out the target level and moves
+towards it.
+------------------------------------------------------------*/
+u32 RateUpdate(const PipeRec *rec, s32 setPoint)
+{
+        s32 diff, margin;
+        u32 target, level = rateStats.level;
+
+        //----------------------------------------------------------
+        // Smoothed slope of the mean, Q4 tenths per second
+        //----------------------------------------------------------
+        if (havePrev)
+        {
+                diff = (rec->mean - prevMean) * (1 << RATE_SLOPE_FRAC);
+                slopeAcc += diff - slopeAcc / (1 << RATE_SLOPE_SHIFT);
+                rateStats.slope = slopeAcc / (1 << RATE_SLOPE_SHIFT);
+        }
+        prevMean = rec->mean;
+        havePrev = 1;
+
+        //----------------------------------------------------------
+        // Distance of the peak to the set point, projected ahead
+        // while rising
+        //----------------------------------------------------------
+        margin = setPoint - rec->max;
+        if (rateStats.slope > 0)
+                margin -= (rateStats.slope * RATE_LOOKAHEAD_S) / (1 << RATE_SLOPE_FRAC);
+
+        target = RateTarget(margin);
+
+        rateStats.decisions++;
+        rateStats.secs[level]++;
+
+        if (target > level)
+        {
+                holdSecs = 0;
+                rateStats.up++;
+                RateApply(target);
+                return 1;
+        }
+
+        if (target < level)
+        {
+                if (++holdSecs < RATE_HOLD_S)
+                {
+                        rateStats.held++;
+                        return 0;
+                }
+                holdSecs = 0;
+                rateStats.down++;
+                RateApply(level - 1);
+                return 1;
+        }
+
+        holdSecs = 0;
+        return 0;
+}
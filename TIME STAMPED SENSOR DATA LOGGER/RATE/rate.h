@@ -0,0 +1,70 @@
+//rate.h
+/*------------------------------------------------------------
+File: rate.h
+Purpose:
+Header file for the adaptive sampling rate scheduler.
+
+Once per second the scheduler looks at how far the reading
+is from the set point and how fast it is moving towards it,
+and picks a rate level: the pipeline's fast stage rate and
+its log record period. Far below the set point and stable,
+the logger samples at the minimum rate and logs once a
+minute; close to it, or rising fast, it samples at the
+maximum rate and logs every few seconds.
+
+With the minimum rate equal to the maximum only the log
+period adapts.
+------------------------------------------------------------*/
+
+#ifndef __RATE_H__
+#define __RATE_H__
+
+#include "types.h"
+#include "pipeline.h"
+#include "rate_defines.h"
+
+//------------------------------------------------------------
+// Decision counters
+//------------------------------------------------------------
+typedef struct
+{
+        u32 level;              // Current level (0 = slowest)
+        u32 hz;                 // Current fast stage rate
+        u32 logSec;             // Current log record period
+        s32 slope;              // Smoothed slope, Q4 tenths/s
+        u32 decisions;          // Seconds evaluated
+        u32 up;                 // Level raised
+        u32 down;               // Level lowered
+        u32 held;               // Lower target kept back by the hold
+        u32 secs[RATE_LEVELS];  // Seconds spent at each level
+} RateStats;
+
+extern RateStats rateStats;
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: InitRate
+// Purpose : Set the rate limits and start at the top level
+//           until the slope estimate has settled
+// Parameters:
+//   minHz -> Rate far from the set point
+//   maxHz -> Rate near the set point
+// Note    : Call after InitPipeline
+//------------------------------------------------------------
+void InitRate(u32 minHz, u32 maxHz);
+
+//------------------------------------------------------------
+// Function: RateUpdate
+// Purpose : Pick the level for the next second from a
+//           per-second record and apply it to the pipeline
+// Parameters:
+//   rec      -> Newest per-second record (tenths of a degree)
+//   setPoint -> Temperature limit (tenths of a degree)
+// Return  : 1 -> level changed, 0 -> unchanged
+//------------------------------------------------------------
+u32 RateUpdate(const PipeRec *rec, s32 setPoint);
+
+#endif
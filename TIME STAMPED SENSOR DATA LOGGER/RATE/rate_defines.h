@@ -0,0 +1,59 @@
+//rate_defines.h
+/*------------------------------------------------------------
+File: rate_defines.h
+Purpose:
+Contains macros for the adaptive sampling rate scheduler.
+
+This file defines:
+- Number of rate levels and the log period of each
+- Distances to the set point that map to the lowest and
+  highest level
+- Slope smoothing and look-ahead
+- Hold time before stepping down
+- Highest level run with the low-power clock
+------------------------------------------------------------*/
+
+#ifndef RATE_DEFINES_H
+#define RATE_DEFINES_H
+
+//------------------------------------------------------------
+// Rate levels: level 0 samples at the configured minimum
+// rate, the top level at the maximum; levels in between
+// halve the maximum rate per step down.
+// Log periods (seconds) divide a minute, so records stay
+// aligned to the RTC minute at every level.
+//------------------------------------------------------------
+#define RATE_LEVELS       5
+#define RATE_LOG_PERIODS  { 60, 30, 20, 15, 10 }
+
+//------------------------------------------------------------
+// Distance from the per-second peak to the set point, in
+// tenths of a degree: at or below NEAR -> top level, at or
+// above FAR -> level 0, linear in between
+//------------------------------------------------------------
+#define RATE_NEAR_T       20      // 2.0 C
+#define RATE_FAR_T        100     // 10.0 C
+
+//------------------------------------------------------------
+// Slope of the per-second mean, smoothed with a 1/8 weight
+// per second and kept in Q4 tenths per second. The distance
+// used is the one expected RATE_LOOKAHEAD_S from now, so a
+// fast rise raises the rate before the reading gets close.
+//------------------------------------------------------------
+#define RATE_SLOPE_FRAC   4
+#define RATE_SLOPE_SHIFT  3
+#define RATE_LOOKAHEAD_S  60
+
+//------------------------------------------------------------
+// Rate goes up at once; it comes down one level after the
+// target has stayed lower for this many seconds
+//------------------------------------------------------------
+#define RATE_HOLD_S       30
+
+//------------------------------------------------------------
+// Levels up to this one run with the low-power clock profile
+// (CLK_LOW); the levels above need CLK_PERF
+//------------------------------------------------------------
+#define RATE_CLK_LOW_MAX  0
+
+#endif
@@ -9,12 +9,24 @@ This file provides:
 - RTC initialization
 - Setting and getting time, date, and day
 - Displaying RTC information on LCD
+- Sub-second time stamps: the second edge is latched on
+  Timer0 by the RTC increment interrupt, and the clock tick
+  counter (CTC) removes the interrupt latency from it
+
+Calendar arithmetic lives in rtc_cal.c; host builds replace
+this file with the virtual RTC in rtc_sim.c.
 ------------------------------------------------------------*/
 
+#ifndef HOST_BUILD
+
 #include <LPC21xx.H>      // LPC21xx/LPC214x register definitions
 #include "rtc_defines.h"  // RTC register macros and constants
 #include "types.h"        // User-defined data types
 #include "lcd.h"          // LCD interface functions
+#include "rtc.h"          // RTC prototypes and RTCStamp
+#include "vic.h"          // Interrupt registration and ISR macros
+#include "clock.h"        // Current PCLK
+#include "ramcode.h"      // RAMFUNC, code placement
 
 //------------------------------------------------------------
 // Array holding abbreviated names of days of the week
@@ -22,18 +34,61 @@ This file provides:
 //------------------------------------------------------------
 u8 week[][4] = {"SUN","MON","TUE","WED","THU","FRI","SAT"};
 
+//------------------------------------------------------------
+// Second edge latched by RTC_ISR
+//------------------------------------------------------------
+static volatile u32 edgeCount;        // Edges seen (0 -> none yet)
+static volatile u32 edgeUs;           // Timer0 time of the edge
+static volatile u32 edgeCtime0, edgeCtime1;
+
+//------------------------------------------------------------
+// Conversion cache and monotonic guard for GetRTCStamp
+//------------------------------------------------------------
+static u32 cacheCtime0, cacheCtime1, cacheSec;
+static u32 lastSec, lastUs;
+
+/*------------------------------------------------------------
+Function: RTCIsValid
+Purpose :
+Checks that the RTC is enabled and every time and date field
+is in range, i.e. it has kept running since it was last set.
+------------------------------------------------------------*/
+static u32 RTCIsValid(void)
+{
+        u32 t0 = CTIME0, t1 = CTIME1;
+        u32 yr = (t1 >> 16) & 0xFFF, mon = (t1 >> 8) & 0x0F, dom = t1 & 0x1F;
+
+        return (CCR & RTC_ENABLE) &&
+               (t0 & 0x3F) < 60 && ((t0 >> 8) & 0x3F) < 60 &&
+               ((t0 >> 16) & 0x1F) < 24 && ((t0 >> 24) & 0x07) < 7 &&
+               yr >= RTC_YEAR_MIN && yr <= RTC_YEAR_MAX &&
+               mon >= 1 && mon <= 12 && dom >= 1 && dom <= 31;
+}
+
 /*------------------------------------------------------------
 Function: RTC_Init
 Purpose :
 Initializes the Real-Time Clock (RTC).
 
 This function:
-- Resets and disables RTC
-- Sets prescaler values (if required)
-- Enables RTC with appropriate clock source
+- Keeps a clock that is already running with a valid time
+  (warm reset, or battery backed); its counters are left as
+  they are, but the prescaler is reloaded for the current
+  PCLK, which may differ from the one of the last run
+- Otherwise resets the RTC, sets prescaler values (if
+  required) and enables it with the appropriate clock source
+
+Return  : 1 -> running clock kept, 0 -> clock restarted and
+          must be set
 ------------------------------------------------------------*/
-void RTC_Init(void)
+u32 RTC_Init(void)
 {
+        if (RTCIsValid())
+        {
+                RTCSetPclk(ClockPclk());
+                return 1;
+        }
+
   //----------------------------------------------------------
   // Disable and reset the RTC
   //----------------------------------------------------------
@@ -48,14 +103,32 @@ void RTC_Init(void)
   //----------------------------------------------------------
   // Configure prescaler values for RTC clock generation
   //----------------------------------------------------------
-        PREINT  = PREINT_VAL;
-        PREFRAC = PREFRAC_VAL;
+        RTCSetPclk(ClockPclk());
 
   //----------------------------------------------------------
   // Enable the RTC
   //----------------------------------------------------------
         CCR = RTC_ENABLE;
 #endif
+
+        return 0;
+}
+
+/*------------------------------------------------------------
+Function: RTCSetPclk
+Purpose :
+Recomputes the prescaler after a change of PCLK when the RTC
+runs from PCLK. With the 32.768 kHz crystal (LPC2148) the
+RTC does not depend on PCLK and nothing is done.
+------------------------------------------------------------*/
+void RTCSetPclk(u32 pclk)
+{
+#ifdef _LPC2148
+        (void)pclk;
+#else
+        PREINT  = PREINT_VAL(pclk);
+        PREFRAC = PREFRAC_VAL(pclk);
+#endif
 }
 
 /*------------------------------------------------------------
@@ -192,7 +265,7 @@ Reads the current day of the week from RTC.
 Parameter:
 day : Pointer to store day of week (0  6)
 ------------------------------------------------------------*/
-void GetRTCDay(s32 *day)
+void GetRTCDay(u32 *day)
 {
         *day = DOW;
 }
@@ -210,3 +283,147 @@ void DisplayRTCDay(u32 dow)
         CmdLCD(0xCB);            // Set LCD cursor position
         StrLCD(week[dow]);       // Display day string
 }
+
+/*------------------------------------------------------------
+Function: GetRTCSeconds
+Purpose :
+Returns the current RTC time as seconds elapsed since
+00:00:00 on 01/01/2000.
+
+The consolidated time registers (CTIME0/CTIME1) are read so
+that all fields belong to the same second, which gives a
+monotonic counter suitable for interval and window checks.
+CTIME0 is read again after CTIME1 and the pair retaken if it
+changed, so a midnight rollover between the two reads cannot
+pair the new time with the old date.
+------------------------------------------------------------*/
+u32 GetRTCSeconds(void)
+{
+        u32 t0, t1;
+
+        do
+        {
+                t0 = CTIME0;
+                t1 = CTIME1;
+        } while (t0 != CTIME0);
+
+        return RTCToSeconds(t0, t1);
+}
+
+/*------------------------------------------------------------
+Function: RTC_ISR
+Purpose :
+Counter increment interrupt, once per second. Latches the
+Timer0 time of the second edge; the ticks already counted
+by CTC since the edge are subtracted, so the latch does not
+depend on how long the interrupt waited.
+------------------------------------------------------------*/
+CODE_ARM
+RAMFUNC void RTC_ISR(void) __irq
+{
+        u32 ticks;
+
+        VIC_ISR_ENTER();
+
+        ticks = CTC_TICKS(CTC);
+        edgeUs = T0TC - TICKS_TO_US(ticks);
+        edgeCtime0 = CTIME0;
+        edgeCtime1 = CTIME1;
+        edgeCount++;
+        ILR = RTC_CIF;
+
+        VIC_ISR_LATENCY(VIC_SRC_RTC, edgeUs);
+        VIC_ISR_EXIT(VIC_SRC_RTC);
+}
+CODE_END
+
+/*------------------------------------------------------------
+Function: InitRTCStamp
+Purpose :
+Enables the once-per-second RTC interrupt used to latch
+second edges on Timer0. Until the first edge GetRTCStamp
+works from CTC alone.
+------------------------------------------------------------*/
+void InitRTCStamp(void)
+{
+        edgeCount = 0;
+        lastSec = lastUs = 0;
+        cacheCtime0 = cacheCtime1 = 0xFFFFFFFF;
+
+        ILR = RTC_CIF;
+        CIIR = RTC_IMSEC;
+        VICRegister(VIC_SRC_RTC, VIC_PRIO_RTC, (u32)RTC_ISR);
+}
+
+//------------------------------------------------------------
+// Function: RTCSecondCount
+// Purpose : Edges counted by RTC_ISR
+//------------------------------------------------------------
+u32 RTCSecondCount(void)
+{
+        return edgeCount;
+}
+
+/*------------------------------------------------------------
+Function: GetRTCStamp
+Purpose :
+Fills a time stamp with microsecond resolution.
+
+- After the first edge: seconds of the latched edge plus
+  Timer0 time since it, capped at RTC_US_MAX so a late
+  interrupt never lets the fraction run into the next second
+- Before it: CTC ticks (30.5 us steps), with CTIME0 read
+  twice to catch a rollover between the two registers
+
+Stamps never go backwards within a second. Across seconds
+they follow the RTC, so they also follow clock edits.
+------------------------------------------------------------*/
+void GetRTCStamp(RTCStamp *ts)
+{
+        u32 n, us, t0, t1;
+
+        if (edgeCount != 0)
+        {
+                do
+                {
+                        n  = edgeCount;
+                        t0 = edgeCtime0;
+                        t1 = edgeCtime1;
+                        us = T0TC - edgeUs;
+                } while (n != edgeCount);
+        }
+        else
+        {
+                do
+                {
+                        t0 = CTIME0;
+                        us = TICKS_TO_US(CTC_TICKS(CTC));
+                        t1 = CTIME1;
+                } while (t0 != CTIME0);
+        }
+
+        if (us > RTC_US_MAX)
+                us = RTC_US_MAX;
+
+        //----------------------------------------------------------
+        // Full conversion only when the second has changed
+        //----------------------------------------------------------
+        if (t0 != cacheCtime0 || t1 != cacheCtime1)
+        {
+                cacheSec = RTCToSeconds(t0, t1);
+                cacheCtime0 = t0;
+                cacheCtime1 = t1;
+        }
+
+        if (cacheSec == lastSec && us < lastUs)
+                us = lastUs;
+        lastSec = cacheSec;
+        lastUs = us;
+
+        ts->sec = cacheSec;
+        ts->us = us;
+        ts->ctime0 = t0;
+        ts->ctime1 = t1;
+}
+
+#endif
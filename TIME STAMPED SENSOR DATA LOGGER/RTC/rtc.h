@@ -7,7 +7,12 @@ Header file for Real Time Clock (RTC) module.
 This file contains:
 - Function prototypes for RTC initialization
 - Functions to get, set, and display time, date, and day
+- Calendar helpers (leap years, days per month, conversion
+  to seconds) shared with the edit menu
 - Uses 32-bit unsigned integers for RTC parameters
+
+Host builds (HOST_BUILD) get a virtual RTC (rtc_sim.c) that
+advances only when told to, so long runs take no real time.
 ------------------------------------------------------------*/
 
 #ifndef RTC_H
@@ -18,6 +23,20 @@ This file contains:
 //------------------------------------------------------------
 #include "types.h"
 
+//------------------------------------------------------------
+// High resolution time stamp
+// ctime0/ctime1 are the consolidated RTC registers of the
+// same second, so the calendar fields can be printed without
+// converting sec back
+//------------------------------------------------------------
+typedef struct
+{
+        u32 sec;       // Seconds since 01/01/2000 00:00:00
+        u32 us;        // Microseconds within the second (0-999999)
+        u32 ctime0;    // CTIME0: sec [5:0], min [13:8], hour [20:16]
+        u32 ctime1;    // CTIME1: dom [4:0], month [11:8], year [27:16]
+} RTCStamp;
+
 //------------------------------------------------------------
 // Function Prototypes
 //------------------------------------------------------------
@@ -25,9 +44,19 @@ This file contains:
 //------------------------------------------------------------
 // Function: RTC_Init
 // Purpose : Initialize the RTC peripheral
-//           Configures clock source and enables RTC
+//           Keeps a running clock with a valid time, else
+//           configures clock source and enables RTC
+// Return  : 1 -> time kept, 0 -> time must be set
+//------------------------------------------------------------
+u32 RTC_Init(void);
+
+//------------------------------------------------------------
+// Function: RTCSetPclk
+// Purpose : Recompute the RTC prescaler after a change of
+//           peripheral clock (Hz); no effect on LPC2148
+//           where the RTC runs from its own crystal
 //------------------------------------------------------------
-void RTC_Init(void);
+void RTCSetPclk(u32 pclk);
 
 //------------------------------------------------------------
 // Function: GetRTCTimeInfo
@@ -92,4 +121,71 @@ void DisplayRTCDay(u32);
 //------------------------------------------------------------
 void SetRTCDay(u32);
 
+//------------------------------------------------------------
+// Function: GetRTCSeconds
+// Purpose : Return current RTC time as seconds since
+//           01/01/2000 00:00:00 (monotonic time base)
+//------------------------------------------------------------
+u32 GetRTCSeconds(void);
+
+//------------------------------------------------------------
+// Function: InitRTCStamp
+// Purpose : Enable the per-second RTC interrupt that latches
+//           second edges on Timer0
+// Note    : Call after RTC_Init, InitVIC and InitTimer0
+//------------------------------------------------------------
+void InitRTCStamp(void);
+
+//------------------------------------------------------------
+// Function: GetRTCStamp
+// Purpose : Current time with microsecond resolution,
+//           monotonic across second rollovers
+//------------------------------------------------------------
+void GetRTCStamp(RTCStamp *ts);
+
+//------------------------------------------------------------
+// Function: RTCSecondCount
+// Purpose : Second edges seen since InitRTCStamp; a cheap
+//           1 s tick that clock edits do not move
+//------------------------------------------------------------
+u32 RTCSecondCount(void);
+
+//------------------------------------------------------------
+// Function: IsLeapYear
+// Purpose : Check if a given year is a leap year
+// Parameter:
+//   y -> Year (4-digit)
+// Return : 1 -> Leap year, 0 -> Not a leap year
+//------------------------------------------------------------
+u8 IsLeapYear(u32 y);
+
+//------------------------------------------------------------
+// Function: GetMaxDays
+// Purpose : Return maximum days in a given month considering
+//           leap year
+// Parameters:
+//   m -> Month (112)
+//   y -> Year (4-digit)
+// Return : Maximum number of days in the month
+//------------------------------------------------------------
+u8 GetMaxDays(u32 m, u32 y);
+
+//------------------------------------------------------------
+// Function: RTCToSeconds
+// Purpose : Convert CTIME0/CTIME1 values to seconds since
+//           01/01/2000 00:00:00
+//------------------------------------------------------------
+u32 RTCToSeconds(u32 t0, u32 t1);
+
+#ifdef HOST_BUILD
+//------------------------------------------------------------
+// Function: RTCSimAdvance
+// Purpose : Move the virtual RTC forward, rolling every field
+//           over like the RTC counters do
+// Parameter:
+//   us -> Microseconds to advance
+//------------------------------------------------------------
+void RTCSimAdvance(u32 us);
+#endif
+
 #endif
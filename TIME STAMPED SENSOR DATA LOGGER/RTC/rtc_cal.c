@@ -0,0 +1,81 @@
+//rtc_cal.c
+/*------------------------------------------------------------
+File: rtc_cal.c
+Purpose:
+Calendar arithmetic shared by the RTC drivers and the RTC
+edit menu.
+
+This file provides:
+- Leap year and days-per-month rules (Gregorian)
+- Conversion of the consolidated RTC registers to seconds
+  since 01/01/2000 00:00:00
+
+NOTE:
+No register access here: the same code runs on the target
+(rtc.c) and against the virtual RTC of host builds
+(rtc_sim.c), so long-run checks exercise the real rules.
+------------------------------------------------------------*/
+
+#include "types.h"        // User-defined data types
+#include "rtc.h"          // Calendar prototypes
+
+//------------------------------------------------------------
+// Function: IsLeapYear
+// Purpose : Check if given year is a leap year
+// Return  : 1 -> Leap year, 0 -> Not a leap year
+//------------------------------------------------------------
+u8 IsLeapYear(u32 y)
+{
+        if((y % 400) == 0) return 1;
+        if((y % 100) == 0) return 0;
+        if((y % 4) == 0)   return 1;
+        return 0;
+}
+
+//------------------------------------------------------------
+// Function: GetMaxDays
+// Purpose : Return maximum days in a month considering leap year
+//------------------------------------------------------------
+u8 GetMaxDays(u32 m, u32 y)
+{
+        switch(m)
+        {
+                case 1: case 3: case 5: case 7:
+                case 8: case 10: case 12: return 31;
+                case 4: case 6: case 9: case 11: return 30;
+                case 2: return IsLeapYear(y) ? 29 : 28;
+                default: return 31;
+        }
+}
+
+/*------------------------------------------------------------
+Function: RTCToSeconds
+Purpose :
+Converts a CTIME0/CTIME1 pair to seconds elapsed since
+00:00:00 on 01/01/2000.
+------------------------------------------------------------*/
+u32 RTCToSeconds(u32 t0, u32 t1)
+{
+        u32 y, m, days;
+        u32 year = (t1 >> 16) & 0xFFF, month = (t1 >> 8) & 0x0F;
+
+        //----------------------------------------------------------
+        // Whole days in the years since 2000
+        //----------------------------------------------------------
+        days = 0;
+        for (y = 2000; y < year; y++)
+                days += IsLeapYear(y) ? 366 : 365;
+
+        //----------------------------------------------------------
+        // Whole days in the elapsed months of this year
+        //----------------------------------------------------------
+        for (m = 1; m < month; m++)
+                days += GetMaxDays(m, year);
+
+        days += (t1 & 0x1F) - 1;
+
+        return (days * 86400) +
+               (((t0 >> 16) & 0x1F) * 3600) +
+               (((t0 >> 8) & 0x3F) * 60) +
+               (t0 & 0x3F);
+}
@@ -7,28 +7,20 @@ controlling the Real-Time Clock (RTC) of LPC21xx/LPC214x
 microcontrollers.
 
 This file defines:
-- System and peripheral clock values
-- RTC prescaler calculation values
+- RTC prescaler calculation from PCLK
 - RTC control register bit definitions
 ------------------------------------------------------------*/
 
 #ifndef RTC_DEFINES_H
 #define RTC_DEFINES_H
 
-//------------------------------------------------------------
-// System Clock and Peripheral Clock Macros
-//------------------------------------------------------------
-#define FOSC 12000000        // External oscillator frequency = 12 MHz
-#define CCLK (5*FOSC)        // CPU clock frequency using PLL (5  FOSC)
-#define PCLK (CCLK/4)        // Peripheral clock frequency
-
 //------------------------------------------------------------
 // RTC Prescaler Values
 //------------------------------------------------------------
 // RTC requires a 32.768 kHz clock.
 // PREINT and PREFRAC are used to derive this clock from PCLK.
-#define PREINT_VAL  ((PCLK/32768)-1)                  // Integer prescaler value
-#define PREFRAC_VAL (PCLK-(PREINT_VAL+1)*32768)       // Fractional prescaler value
+#define PREINT_VAL(pclk)  (((pclk)/32768)-1)                      // Integer prescaler value
+#define PREFRAC_VAL(pclk) ((pclk)-(PREINT_VAL(pclk)+1)*32768)     // Fractional prescaler value
 
 //------------------------------------------------------------
 // RTC Control Register (CCR) Bit Definitions
@@ -37,6 +29,21 @@ This file defines:
 #define RTC_RESET   (1<<1)   // Bit 1: Reset RTC counter and prescaler
 #define RTC_CLKSRC  (1<<4)   // Bit 4: Select RTC clock source (for LPC2148)
 
+//------------------------------------------------------------
+// Oldest and newest year accepted as a valid running clock
+//------------------------------------------------------------
+#define RTC_YEAR_MIN 2000
+#define RTC_YEAR_MAX 2099
+
+//------------------------------------------------------------
+// Sub-second time stamps
+//------------------------------------------------------------
+#define RTC_IMSEC   (1<<0)   // CIIR bit 0: interrupt on every second
+#define RTC_CIF     (1<<0)   // ILR bit 0: counter increment flag
+#define CTC_TICKS(ctc)  (((ctc) >> 1) & 0x7FFF)   // 1/32768 s ticks
+#define TICKS_TO_US(t)  (((t) * 15625) >> 9)      // t * 1e6 / 32768
+#define RTC_US_MAX  999999   // Last microsecond of a second
+
 //------------------------------------------------------------
 // Uncomment this macro if using LPC2148 device
 // This enables alternate RTC clock source configuration
@@ -0,0 +1,221 @@
+//rtc_sim.c
+/*------------------------------------------------------------
+File: rtc_sim.c
+Purpose:
+Virtual Real Time Clock for host builds (HOST_BUILD).
+
+Stands in for rtc.c so time-keeping and logging code can run
+on a PC at full speed: the clock only moves when
+RTCSimAdvance() is called, so a year of seconds passes in
+however long the caller takes to process them.
+
+Features:
+- Same fields as the RTC counters (sec, min, hour, dow, dom,
+  month, year), rolled over one at a time like the hardware,
+  with month lengths from GetMaxDays()
+- GetRTCStamp with the same monotonic rules as on the target;
+  the sub-second part is the virtual microsecond counter
+
+NOTE:
+The display functions (DisplayRTC*) draw nothing.
+------------------------------------------------------------*/
+
+#ifdef HOST_BUILD
+
+#include "types.h"        // User-defined data types
+#include "rtc.h"          // RTC prototypes and RTCStamp
+
+//------------------------------------------------------------
+// Virtual counters
+//------------------------------------------------------------
+static u32 simUs, simSec, simMin, simHour, simDow;
+static u32 simDom = 1, simMonth = 1, simYear = 2000;
+static u32 simEdges;          // Seconds advanced (RTCSecondCount)
+
+//------------------------------------------------------------
+// Conversion cache and monotonic guard for GetRTCStamp
+//------------------------------------------------------------
+static u32 cacheCtime0, cacheCtime1, cacheSec;
+static u32 lastSec, lastUs;
+
+//------------------------------------------------------------
+// Function: Ctime0 / Ctime1
+// Purpose : Consolidated register values of the counters
+//------------------------------------------------------------
+static u32 Ctime0(void)
+{
+        return simSec | (simMin << 8) | (simHour << 16) | (simDow << 24);
+}
+
+static u32 Ctime1(void)
+{
+        return simDom | (simMonth << 8) | (simYear << 16);
+}
+
+//------------------------------------------------------------
+// Function: TickSecond
+// Purpose : One counter increment, carried up through the
+//           calendar fields
+//------------------------------------------------------------
+static void TickSecond(void)
+{
+        simEdges++;
+        if (++simSec < 60)
+                return;
+        simSec = 0;
+        if (++simMin < 60)
+                return;
+        simMin = 0;
+        if (++simHour < 24)
+                return;
+        simHour = 0;
+
+        simDow = (simDow + 1) % 7;
+        if (++simDom <= GetMaxDays(simMonth, simYear))
+                return;
+        simDom = 1;
+        if (++simMonth <= 12)
+                return;
+        simMonth = 1;
+        simYear++;
+}
+
+//------------------------------------------------------------
+// Function: RTCSimAdvance
+// Purpose : Move the virtual clock forward by us microseconds
+//------------------------------------------------------------
+void RTCSimAdvance(u32 us)
+{
+        simUs += us;
+        while (simUs >= 1000000)
+        {
+                simUs -= 1000000;
+                TickSecond();
+        }
+}
+
+//------------------------------------------------------------
+// Function: RTC_Init
+// Purpose : Start the virtual clock at 01/01/2000 00:00:00
+// Return  : 0 -> time must be set
+//------------------------------------------------------------
+u32 RTC_Init(void)
+{
+        simUs = simSec = simMin = simHour = simDow = 0;
+        simDom = simMonth = 1;
+        simYear = 2000;
+        return 0;
+}
+
+void RTCSetPclk(u32 pclk)
+{
+        (void)pclk;
+}
+
+//------------------------------------------------------------
+// Function: Set / Get functions
+// Purpose : Same meaning as in rtc.c
+//------------------------------------------------------------
+void SetRTCTimeInfo(u32 hour, u32 minute, u32 second)
+{
+        simHour = hour;
+        simMin  = minute;
+        simSec  = second;
+}
+
+void SetRTCDateInfo(u32 date, u32 month, u32 year)
+{
+        simDom   = date;
+        simMonth = month;
+        simYear  = year;
+}
+
+void SetRTCDay(u32 day)
+{
+        simDow = day;
+}
+
+void GetRTCTimeInfo(u32 *hour, u32 *minute, u32 *second)
+{
+        *hour   = simHour;
+        *minute = simMin;
+        *second = simSec;
+}
+
+void GetRTCDateInfo(u32 *date, u32 *month, u32 *year)
+{
+        *date  = simDom;
+        *month = simMonth;
+        *year  = simYear;
+}
+
+void GetRTCDay(u32 *day)
+{
+        *day = simDow;
+}
+
+u32 GetRTCSeconds(void)
+{
+        return RTCToSeconds(Ctime0(), Ctime1());
+}
+
+void DisplayRTCTime(u32 hour, u32 minute, u32 second)
+{
+        (void)hour; (void)minute; (void)second;
+}
+
+void DisplayRTCDate(u32 date, u32 month, u32 year)
+{
+        (void)date; (void)month; (void)year;
+}
+
+void DisplayRTCDay(u32 dow)
+{
+        (void)dow;
+}
+
+void InitRTCStamp(void)
+{
+        lastSec = lastUs = 0;
+        cacheCtime0 = cacheCtime1 = 0xFFFFFFFF;
+}
+
+/*------------------------------------------------------------
+Function: GetRTCStamp
+Purpose :
+Fills a time stamp from the virtual counters. As on the
+target, the full conversion only runs when the second has
+changed and stamps never go backwards within a second.
+------------------------------------------------------------*/
+void GetRTCStamp(RTCStamp *ts)
+{
+        u32 t0 = Ctime0(), t1 = Ctime1(), us = simUs;
+
+        if (t0 != cacheCtime0 || t1 != cacheCtime1)
+        {
+                cacheSec = RTCToSeconds(t0, t1);
+                cacheCtime0 = t0;
+                cacheCtime1 = t1;
+        }
+
+        if (cacheSec == lastSec && us < lastUs)
+                us = lastUs;
+        lastSec = cacheSec;
+        lastUs = us;
+
+        ts->sec = cacheSec;
+        ts->us = us;
+        ts->ctime0 = t0;
+        ts->ctime1 = t1;
+}
+
+//------------------------------------------------------------
+// Function: RTCSecondCount
+// Purpose : Seconds the virtual clock has advanced
+//------------------------------------------------------------
+u32 RTCSecondCount(void)
+{
+        return simEdges;
+}
+
+#endif
@@ -0,0 +1,221 @@
+//sensor.c
+/*------------------------------------------------------------
+File: sensor.c
+Purpose:
+Implements the sensor table: configuration, one-burst
+scanning of every scanned sensor, conversion, alarms with
+hysteresis and per-sensor logging intervals.
+
+Features:
+- All scanned inputs of AD0 and AD1 are converted by one
+  Read_ADC_Scan per SENS_SCAN_US, whatever their number
+- Each pass over the table is one loop per step over
+  consecutive array elements: no per-sensor calls, no
+  floating point
+- An alarm is published once, when it is raised
+- Logging intervals are aligned to multiples of their length
+  on the RTC time base, like the pipeline's log period
+
+NOTE:
+Sensor 0 is skipped by the scan; the pipeline samples it at
+the fast rate and DisplayInformation() checks it with
+SensorAlarm().
+------------------------------------------------------------*/
+
+#include "types.h"              // User-defined data types
+#include "adc.h"                // Init_ADC, Init_ADC1, Read_ADC_Scan
+#include "adc_defines.h"        // Channel numbers, scan layout
+#include "rtc.h"                // GetRTCSeconds, GetRTCStamp
+#include "timer.h"              // Timer0Now
+#include "bus.h"                // Sample publishing
+#include "sensor.h"             // Table and prototypes
+#include "sensor_defines.h"     // Defaults and scan period
+
+//------------------------------------------------------------
+// Sensor table
+//------------------------------------------------------------
+SensorTab sens;
+
+//------------------------------------------------------------
+// Default configuration columns
+//------------------------------------------------------------
+static const u8  defCh[SENS_MAX]     = SENS_DEF_CH;
+static const s16 defGain[SENS_MAX]   = SENS_DEF_GAIN;
+static const s16 defOffset[SENS_MAX] = SENS_DEF_OFFSET;
+static const s16 defSet[SENS_MAX]    = SENS_DEF_SET;
+static const s16 defHyst[SENS_MAX]   = SENS_DEF_HYST;
+static const u16 defLogSec[SENS_MAX] = SENS_DEF_LOG_S;
+
+//------------------------------------------------------------
+// Scan state: channel sets of both blocks, raw results and
+// the next scan time
+//------------------------------------------------------------
+static u32 scanSel0, scanSel1;
+static u16 scanRaw[ADC_SCAN_LEN];
+static u32 scanNext;
+static u32 scanSec;             // RTC second of the last log check
+
+/*------------------------------------------------------------
+Function: InitSensors
+Purpose :
+Copies the default columns into the table, selects the ADC
+inputs of sensors 1 and up and builds the channel sets of
+the scan. Logging intervals start at the next boundary.
+------------------------------------------------------------*/
+void InitSensors(void)
+{
+        u32 i, now = GetRTCSeconds();
+
+        sens.count = SENS_DEF_COUNT;
+        sens.alarms = 0;
+        scanSel0 = scanSel1 = 0;
+
+        for (i = 0; i < SENS_MAX; i++)
+        {
+                sens.ch[i]       = defCh[i];
+                sens.gain[i]     = defGain[i];
+                sens.offset[i]   = defOffset[i];
+                sens.setPoint[i] = defSet[i];
+                sens.hyst[i]     = defHyst[i];
+                sens.logSec[i]   = defLogSec[i] ? defLogSec[i] : 1;
+                sens.value[i]    = 0;
+                sens.n[i]        = 0;
+                sens.logEnd[i]   = now - now % sens.logSec[i] + sens.logSec[i];
+        }
+
+        for (i = 1; i < sens.count; i++)
+        {
+                if (sens.ch[i] & SENS_AD1)
+                {
+                        Init_ADC1(sens.ch[i] & ~SENS_AD1);
+                        scanSel1 |= 1 << (sens.ch[i] & ~SENS_AD1);
+                }
+                else
+                {
+                        Init_ADC(sens.ch[i]);
+                        scanSel0 |= 1 << sens.ch[i];
+                }
+        }
+
+        scanNext = Timer0Now();
+        scanSec = now;
+}
+
+//------------------------------------------------------------
+// Function: SensorSetPoint
+// Purpose : Set the alarm level of sensor i, within range
+//------------------------------------------------------------
+void SensorSetPoint(u32 i, u32 tenths)
+{
+        sens.setPoint[i] = (tenths > SENS_SET_MAX) ? SENS_SET_MAX : tenths;
+}
+
+/*------------------------------------------------------------
+Function: SensorAlarm
+Purpose :
+Raises the alarm of sensor i at or above its set point and
+clears it only once the reading is below the set point by
+more than the hysteresis, so a reading hovering at the limit
+does not toggle it.
+------------------------------------------------------------*/
+u32 SensorAlarm(u32 i, s32 v)
+{
+        u32 bit = 1 << i;
+
+        if (v >= sens.setPoint[i])
+                sens.alarms |= bit;
+        else if (v < sens.setPoint[i] - sens.hyst[i])
+                sens.alarms &= ~bit;
+
+        return (sens.alarms & bit) != 0;
+}
+
+//------------------------------------------------------------
+// Function: SensorPublish
+// Purpose : Publish a record of sensor i on the sample bus
+//------------------------------------------------------------
+static void SensorPublish(u32 i, u32 kind, s32 mean, s32 min, s32 max, u32 n)
+{
+        Sample s;
+
+        if (sens.alarms & (1 << i))
+                kind |= BUS_ALERT;
+
+        s.kind = kind;
+        s.ch = sens.ch[i];
+        GetRTCStamp(&s.at);
+        s.rec.mean = mean;
+        s.rec.min = min;
+        s.rec.max = max;
+        s.rec.n = n;
+        BusPublish(&s);
+}
+
+/*------------------------------------------------------------
+Function: SensorRun
+Purpose :
+Once per SENS_SCAN_US: converts every scanned sensor in one
+burst, updates its reading, alarm and interval aggregate,
+and once per RTC second closes the intervals that have
+ended.
+------------------------------------------------------------*/
+void SensorRun(void)
+{
+        u32 i, now, was;
+        s32 v;
+
+        if (sens.count < 2 || (s32)(Timer0Now() - scanNext) < 0)
+                return;
+
+        // Resync after a long stall instead of scanning in a burst
+        scanNext += SENS_SCAN_US;
+        if ((s32)(Timer0Now() - scanNext) >= 0)
+                scanNext = Timer0Now() + SENS_SCAN_US;
+
+        Read_ADC_Scan(scanSel0, scanSel1, scanRaw);
+
+        //----------------------------------------------------------
+        // Convert, check and aggregate
+        //----------------------------------------------------------
+        for (i = 1; i < sens.count; i++)
+        {
+                v = ((s32)scanRaw[sens.ch[i]] * sens.gain[i] >> 10) + sens.offset[i];
+                sens.value[i] = v;
+
+                was = sens.alarms & (1 << i);
+                if (SensorAlarm(i, v) && !was)
+                        SensorPublish(i, 0, v, v, v, 1);
+
+                if (sens.n[i] == 0)
+                {
+                        sens.sum[i] = 0;
+                        sens.min[i] = v;
+                        sens.max[i] = v;
+                }
+                sens.sum[i] += v;
+                sens.n[i]++;
+                if (v < sens.min[i]) sens.min[i] = v;
+                if (v > sens.max[i]) sens.max[i] = v;
+        }
+
+        //----------------------------------------------------------
+        // Close the logging intervals that ended
+        //----------------------------------------------------------
+        now = GetRTCSeconds();
+        if (now == scanSec)
+                return;
+        scanSec = now;
+
+        for (i = 1; i < sens.count; i++)
+        {
+                if ((s32)(now - sens.logEnd[i]) < 0)
+                        continue;
+                sens.logEnd[i] = now - now % sens.logSec[i] + sens.logSec[i];
+
+                if (sens.n[i] == 0)
+                        continue;
+                SensorPublish(i, BUS_PERIOD, sens.sum[i] / (s32)sens.n[i],
+                              sens.min[i], sens.max[i], sens.n[i]);
+                sens.n[i] = 0;
+        }
+}
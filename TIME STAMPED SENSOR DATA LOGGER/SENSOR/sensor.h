@@ -0,0 +1,91 @@
+//sensor.h
+/*------------------------------------------------------------
+File: sensor.h
+Purpose:
+Header file for the sensor table.
+
+Up to SENS_MAX sensors, each with its own input, linear
+conversion, set point, hysteresis and logging interval. The
+table is kept as one array per field (structure of arrays),
+so the scan loop walks each field in order and its cost
+grows by one array element per sensor.
+
+Sensor 0 is the pipeline's channel. The others are scanned
+together in one ADC burst every SENS_SCAN_US; their readings
+are checked against their set points and folded into one
+record per logging interval, and both alarms and records are
+published on the sample bus with the sensor's input in ch.
+
+Alarm with hysteresis: raised at or above the set point,
+cleared only below set point - hysteresis.
+------------------------------------------------------------*/
+
+#ifndef __SENSOR_H__
+#define __SENSOR_H__
+
+#include "types.h"
+#include "sensor_defines.h"
+
+//------------------------------------------------------------
+// Sensor table, one array per field
+// Values are in tenths of a degree C
+//------------------------------------------------------------
+typedef struct
+{
+        u32 count;                  // Sensors in use
+        u32 alarms;                 // Bit n set while sensor n alarms
+
+        // Configuration
+        u8  ch[SENS_MAX];           // Input (CHn, SENS_AD1 | n)
+        s16 gain[SENS_MAX];         // Conversion slope, Q10
+        s16 offset[SENS_MAX];       // Conversion offset
+        s16 setPoint[SENS_MAX];     // Alarm level
+        s16 hyst[SENS_MAX];         // Alarm clear margin
+        u16 logSec[SENS_MAX];       // Logging interval (s)
+
+        // State
+        s16 value[SENS_MAX];        // Latest reading
+        s16 min[SENS_MAX];          // Interval minimum
+        s16 max[SENS_MAX];          // Interval maximum
+        s32 sum[SENS_MAX];          // Interval sum
+        u32 n[SENS_MAX];            // Readings in the interval
+        u32 logEnd[SENS_MAX];       // RTC second closing it
+} SensorTab;
+
+extern SensorTab sens;
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: InitSensors
+// Purpose : Load the default table and prepare the ADC
+//           inputs of the scanned sensors
+// Note    : Call after RTC_Init; the input of sensor 0 is
+//           set up by the caller (Init_ADC, InitPipeline)
+//------------------------------------------------------------
+void InitSensors(void);
+
+//------------------------------------------------------------
+// Function: SensorSetPoint
+// Purpose : Set the alarm level of sensor i (tenths of a
+//           degree, limited to 0 .. SENS_SET_MAX)
+//------------------------------------------------------------
+void SensorSetPoint(u32 i, u32 tenths);
+
+//------------------------------------------------------------
+// Function: SensorAlarm
+// Purpose : Update the alarm of sensor i with a reading
+// Return  : 1 while the sensor alarms
+//------------------------------------------------------------
+u32 SensorAlarm(u32 i, s32 v);
+
+//------------------------------------------------------------
+// Function: SensorRun
+// Purpose : Scan, check and log the scanned sensors when the
+//           scan period is due; call from the main loop
+//------------------------------------------------------------
+void SensorRun(void);
+
+#endif
@@ -0,0 +1,66 @@
+//sensor_defines.h
+/*------------------------------------------------------------
+File: sensor_defines.h
+Purpose:
+Contains macros for the sensor table.
+
+This file defines:
+- Table size and how AD1 inputs are named
+- Scan period of the scanned channels
+- Conversion constants
+- The default sensor configuration, one column per sensor
+------------------------------------------------------------*/
+
+#ifndef SENSOR_DEFINES_H
+#define SENSOR_DEFINES_H
+
+#include "adc_defines.h"
+
+//------------------------------------------------------------
+// Table size: AIN0-AIN3 on AD0 plus one input on AD1
+//------------------------------------------------------------
+#define SENS_MAX          5
+
+//------------------------------------------------------------
+// Input of a sensor: CHn for AD0, SENS_AD1 | n for AD1 (the
+// index of its result in a Read_ADC_Scan)
+//------------------------------------------------------------
+#define SENS_AD1          ADC_SCAN_AD1
+
+//------------------------------------------------------------
+// Scanned channels (all but sensor 0) are converted together
+// once per period (us)
+//------------------------------------------------------------
+#define SENS_SCAN_US      100000   // 10 Hz
+
+//------------------------------------------------------------
+// Conversion: value = ((count * gain) >> 10) + offset, in
+// tenths of a degree C
+// LM35 : 10 mV/C, 3.3 V over 1023 counts -> 3300/1023 in Q10
+// TMP36: same slope, 500 mV at 0 C -> offset -500
+//------------------------------------------------------------
+#define SENS_GAIN_LM35    3303
+#define SENS_OFS_TMP36    (-500)
+
+//------------------------------------------------------------
+// Highest set point accepted (LM35 range, 0.1 C)
+//------------------------------------------------------------
+#define SENS_SET_MAX      1500
+
+//------------------------------------------------------------
+// Default configuration
+// Sensor 0 is the pipeline's channel: it is sampled, logged
+// and alerted on by the pipeline; its set point comes from
+// the flash configuration and the keypad. Only the first
+// SENS_DEF_COUNT columns are used.
+//------------------------------------------------------------
+#define SENS_DEF_COUNT    1
+#define SENS_DEF_CH       { CH1, CH2, CH3, CH0, SENS_AD1 | AD1_CH6 }
+#define SENS_DEF_GAIN     { SENS_GAIN_LM35, SENS_GAIN_LM35, SENS_GAIN_LM35, \
+                            SENS_GAIN_LM35, SENS_GAIN_LM35 }
+#define SENS_DEF_OFFSET   { 0, 0, 0, 0, 0 }
+#define SENS_DEF_SET      { 450, 450, 450, 450, 450 }   // 0.1 C
+#define SENS_DEF_HYST     { 10, 10, 10, 10, 10 }        // 0.1 C
+#define SENS_DEF_LOG_S    { 60, 60, 60, 60, 60 }        // Seconds
+
+#endif
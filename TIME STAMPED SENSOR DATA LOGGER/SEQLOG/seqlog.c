@@ -0,0 +1,320 @@
+//seqlog.c
+/*------------------------------------------------------------
+File: seqlog.c
+Purpose:
+Implements sequence-numbered, CRC-protected log records and
+a retransmit buffer for lossless capture over UART0.
+
+Features:
+- Monotonic 32-bit sequence number per record and per port,
+  so a host reading one port sees no gaps for records sent
+  on the other
+- Record bytes captured while they are transmitted, so no
+  second formatting pass is needed
+- Last SEQ_SLOTS records of all ports kept in a shared ring
+  of slots, each tagged with its port and sequence number
+- Non-blocking parser for "NAK a [b]" requests from the host
+  on every port; records are resent on the port asking, one
+  per poll
+------------------------------------------------------------*/
+
+#include "types.h"            // User-defined data types
+#include "uart.h"             // UART transmit/receive and capture
+#include "seqlog.h"           // Prototypes and counters
+#include "seqlog_defines.h"   // Buffer sizes
+
+//------------------------------------------------------------
+// Counters
+//------------------------------------------------------------
+SeqLogStats seqLogStats;
+
+//------------------------------------------------------------
+// Retransmit slots
+//------------------------------------------------------------
+static u8  slotBuf[SEQ_SLOTS][SEQ_LINE_MAX];
+static u8  slotLen[SEQ_SLOTS];     // 0 -> record cannot be resent
+static u8  slotPort[SEQ_SLOTS];
+static u16 slotCrc[SEQ_SLOTS];
+static u32 slotSeq[SEQ_SLOTS];
+static u32 slotNext;               // Slot of the next record
+static u32 seqNext[UART_PORTS];    // Sequence of the next record
+
+//------------------------------------------------------------
+// Record being sent
+//------------------------------------------------------------
+static u32 recSlot, recPort;
+
+//------------------------------------------------------------
+// Request line being received, per port
+//------------------------------------------------------------
+static u8  cmdBuf[UART_PORTS][SEQ_CMD_MAX];
+static u32 cmdLen[UART_PORTS];
+
+//------------------------------------------------------------
+// Resend in progress, per port: next and last record
+//------------------------------------------------------------
+static u32 resNext[UART_PORTS], resLast[UART_PORTS];
+static u8  resBusy[UART_PORTS];
+
+/*------------------------------------------------------------
+Function: InitSeqLog
+Purpose :
+Restarts numbering at 0. The host treats a drop back to 0
+as a device reset rather than as missing records.
+------------------------------------------------------------*/
+void InitSeqLog(void)
+{
+        u32 i;
+
+        slotNext = 0;
+        for (i = 0; i < UART_PORTS; i++)
+        {
+                seqNext[i] = cmdLen[i] = 0;
+                resBusy[i] = 0;
+        }
+        for (i = 0; i < SEQ_SLOTS; i++)
+                slotLen[i] = 0;
+
+        seqLogStats.naks = seqLogStats.resent = seqLogStats.gone = 0;
+}
+
+//------------------------------------------------------------
+// Function: TxTrailer
+// Purpose : Send "*XXXX\r\n" for a CRC value
+//------------------------------------------------------------
+static void TxTrailer(u16 crc)
+{
+        static const s8 hex[] = "0123456789ABCDEF";
+
+        UARTTxChar('*');
+        UARTTxChar(hex[(crc >> 12) & 15]);
+        UARTTxChar(hex[(crc >> 8) & 15]);
+        UARTTxChar(hex[(crc >> 4) & 15]);
+        UARTTxChar(hex[crc & 15]);
+        UARTTxStr("\r\n");
+}
+
+/*------------------------------------------------------------
+Function: SeqLogBegin
+Purpose :
+Takes the oldest slot for the next record on the selected
+port and points the UART capture at it.
+------------------------------------------------------------*/
+void SeqLogBegin(void)
+{
+        recPort = UARTGetPort();
+
+        recSlot = slotNext++ & SEQ_SLOT_MASK;
+        slotLen[recSlot] = 0;
+        UARTCaptureStart(slotBuf[recSlot], SEQ_LINE_MAX);
+}
+
+/*------------------------------------------------------------
+Function: SeqLogEnd
+Purpose :
+Sends the sequence number, closes the capture and sends the
+CRC trailer. Records longer than a slot are still sent with
+a valid CRC but are marked as not resendable.
+------------------------------------------------------------*/
+void SeqLogEnd(void)
+{
+        u32 slot = recSlot;
+        u32 len;
+        u16 crc;
+
+        UARTTxStr(" #");
+        UARTTxU32(seqNext[recPort]);
+        len = UARTCaptureStop(&crc);
+
+        slotLen[slot] = (len < SEQ_LINE_MAX) ? len : 0;
+        slotCrc[slot] = crc;
+        slotSeq[slot] = seqNext[recPort];
+        slotPort[slot] = recPort;
+        TxTrailer(crc);
+
+        seqNext[recPort]++;
+}
+
+//------------------------------------------------------------
+// Function: TxGone
+// Purpose : Tell the host records first..last are lost
+//------------------------------------------------------------
+static void TxGone(u32 first, u32 last)
+{
+        UARTTxStr("[GONE] #");
+        UARTTxU32(first);
+        UARTTxChar('-');
+        UARTTxU32(last);
+        UARTTxStr("\r\n");
+        seqLogStats.gone += last - first + 1;
+}
+
+//------------------------------------------------------------
+// Function: FindSlot
+// Purpose : Slot holding record seq of a port, SEQ_SLOTS if
+//           it is no longer held
+//------------------------------------------------------------
+static u32 FindSlot(u32 port, u32 seq)
+{
+        u32 i;
+
+        for (i = 0; i < SEQ_SLOTS; i++)
+                if (slotLen[i] && slotSeq[i] == seq && slotPort[i] == port)
+                        return i;
+        return SEQ_SLOTS;
+}
+
+/*------------------------------------------------------------
+Function: Resend
+Purpose :
+Queues records first..last of a port to be sent again, on
+that port, one per SeqLogPoll() pass. The part of the range
+that is older than the buffer can hold is answered at once
+with one [GONE] line, so a request never costs more than
+SEQ_SLOTS records. A new request replaces the one still
+being served on that port.
+------------------------------------------------------------*/
+static void Resend(u32 port, u32 first, u32 last)
+{
+        u32 oldest, next = seqNext[port];
+
+        resBusy[port] = 0;
+
+        if (next == 0 || first >= next)
+                return;
+        if (last >= next)
+                last = next - 1;
+
+        oldest = (next > SEQ_SLOTS) ? next - SEQ_SLOTS : 0;
+        if (first < oldest)
+        {
+                TxGone(first, (last < oldest) ? last : oldest - 1);
+                if (last < oldest)
+                        return;
+                first = oldest;
+        }
+
+        resNext[port] = first;
+        resLast[port] = last;
+        resBusy[port] = 1;
+}
+
+//------------------------------------------------------------
+// Function: ResendNext
+// Purpose : Send the next queued record of the selected port
+//           again, or [GONE] if its slot has been reused
+//------------------------------------------------------------
+static void ResendNext(u32 port)
+{
+        u32 i, slot;
+
+        if (!resBusy[port])
+                return;
+
+        slot = FindSlot(port, resNext[port]);
+        if (slot == SEQ_SLOTS)
+                TxGone(resNext[port], resNext[port]);
+        else
+        {
+                for (i = 0; i < slotLen[slot]; i++)
+                        UARTTxChar(slotBuf[slot][i]);
+                TxTrailer(slotCrc[slot]);
+                seqLogStats.resent++;
+        }
+
+        if (resNext[port]++ == resLast[port])
+                resBusy[port] = 0;
+}
+
+//------------------------------------------------------------
+// Function: ParseU32
+// Purpose : Read a decimal number, advancing *p past it
+//------------------------------------------------------------
+static u32 ParseU32(u8 **p, u32 *val)
+{
+        u32 n = 0, digits = 0;
+
+        while (**p == ' ')
+                (*p)++;
+        while (**p >= '0' && **p <= '9')
+        {
+                n = n * 10 + (*(*p)++ - '0');
+                digits++;
+        }
+
+        *val = n;
+        return digits;
+}
+
+/*------------------------------------------------------------
+Function: PollPort
+Purpose :
+Collects characters of a host request on the selected port
+without blocking and acts on "NAK a" / "NAK a b" once CR or
+LF arrives. Anything else is ignored.
+------------------------------------------------------------*/
+static void PollPort(u32 port)
+{
+        u8 c, *p, *buf = cmdBuf[port];
+        u32 first, last;
+
+        while (UARTRxReady())
+        {
+                c = UARTRxChar();
+
+                if (c != '\r' && c != '\n')
+                {
+                        if (cmdLen[port] < SEQ_CMD_MAX - 1)
+                                buf[cmdLen[port]++] = c;
+                        continue;
+                }
+
+                buf[cmdLen[port]] = 0;
+                p = buf + 3;
+
+                if (cmdLen[port] > 3 && buf[0] == 'N' && buf[1] == 'A' &&
+                    buf[2] == 'K' && ParseU32(&p, &first))
+                {
+                        if (!ParseU32(&p, &last) || last < first)
+                                last = first;
+                        seqLogStats.naks++;
+                        Resend(port, first, last);
+                }
+                cmdLen[port] = 0;
+        }
+}
+
+/*------------------------------------------------------------
+Function: SeqLogPoll
+Purpose :
+Serves host requests on every port and sends at most one
+requested record per port, so a long resend is spread over
+passes of the main loop. The selected port is restored
+afterwards.
+------------------------------------------------------------*/
+void SeqLogPoll(void)
+{
+        u32 port, prev = UARTSelect(UART_CONSOLE);
+
+        for (port = 0; port < UART_PORTS; port++)
+        {
+                UARTSelect(port);
+                PollPort(port);
+                ResendNext(port);
+        }
+        UARTSelect(prev);
+}
+
+//------------------------------------------------------------
+// Function: SeqLogResending
+// Purpose : Check for a NAK still being served on any port
+//------------------------------------------------------------
+u32 SeqLogResending(void)
+{
+        u32 port;
+
+        for (port = 0; port < UART_PORTS; port++)
+                if (resBusy[port])
+                        return 1;
+        return 0;
+}
@@ -0,0 +1,78 @@
+//seqlog.h
+/*------------------------------------------------------------
+File: seqlog.h
+Purpose:
+Header file for sequence-numbered log records with
+selective retransmit.
+
+Every record sent between SeqLogBegin and SeqLogEnd gets a
+trailer " #<seq>*<CRC>" before its CR LF, for example:
+
+[INFO] Temp:31C @12:00:00 13/05/2025 #42*1A2B
+
+The CRC-16/CCITT (4 hex digits) covers everything from the
+first character up to and including the sequence digits.
+A host that sees a gap or a bad CRC sends "NAK a b" (or
+"NAK a") and gets records a..b again, byte for byte. Records
+no longer held are answered with "[GONE] #a-b".
+
+Each port (UART_CONSOLE, UART_BULK, UART_USB) numbers its
+own records; a record goes to the port selected at
+SeqLogBegin, and a NAK is answered on the port it arrived on.
+------------------------------------------------------------*/
+
+#ifndef __SEQLOG_H__
+#define __SEQLOG_H__
+
+#include "types.h"
+#include "seqlog_defines.h"
+
+//------------------------------------------------------------
+// Counters
+//------------------------------------------------------------
+typedef struct
+{
+        u32 naks;      // Requests received
+        u32 resent;    // Records sent again
+        u32 gone;      // Requested records no longer held
+} SeqLogStats;
+
+extern SeqLogStats seqLogStats;
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: InitSeqLog
+// Purpose : Restart numbering at 0 and clear the buffer
+//------------------------------------------------------------
+void InitSeqLog(void);
+
+//------------------------------------------------------------
+// Function: SeqLogBegin
+// Purpose : Start a record; UART output until SeqLogEnd is
+//           kept for retransmission
+//------------------------------------------------------------
+void SeqLogBegin(void);
+
+//------------------------------------------------------------
+// Function: SeqLogEnd
+// Purpose : Append " #seq*CRC\r\n" and store the record
+//------------------------------------------------------------
+void SeqLogEnd(void);
+
+//------------------------------------------------------------
+// Function: SeqLogPoll
+// Purpose : Read host requests on every port without waiting
+//           and resend the next asked-for record of each
+//------------------------------------------------------------
+void SeqLogPoll(void);
+
+//------------------------------------------------------------
+// Function: SeqLogResending
+// Return  : 1 -> a port still has requested records to send
+//------------------------------------------------------------
+u32 SeqLogResending(void);
+
+#endif
@@ -0,0 +1,25 @@
+//seqlog_defines.h
+/*------------------------------------------------------------
+File: seqlog_defines.h
+Purpose:
+Contains macros for sequence-numbered log records and the
+retransmit buffer.
+------------------------------------------------------------*/
+
+#ifndef SEQLOG_DEFINES_H
+#define SEQLOG_DEFINES_H
+
+//------------------------------------------------------------
+// Retransmit buffer: last SEQ_SLOTS records are kept
+// (must be a power of two)
+//------------------------------------------------------------
+#define SEQ_SLOTS      32
+#define SEQ_SLOT_MASK  (SEQ_SLOTS-1)
+#define SEQ_LINE_MAX   128     // Longest record kept for resend
+
+//------------------------------------------------------------
+// Host request line, e.g. "NAK 120 125\r"
+//------------------------------------------------------------
+#define SEQ_CMD_MAX    24
+
+#endif
@@ -0,0 +1,159 @@
+//stats.c
+/*------------------------------------------------------------
+File: stats.c
+Purpose:
+Implements streaming statistics over tumbling windows.
+
+Features:
+- Integer Welford mean/variance, min and max per window
+- One, sixty and 1440 minute windows per ADC channel
+- Constant work per sample, no sample history stored
+
+NOTE:
+Windows are aligned to multiples of their length on the
+GetRTCSeconds() time base, so a 1 minute window always
+starts at second 0 and a 24 hour window at midnight.
+------------------------------------------------------------*/
+
+#include "types.h"          // User-defined data types
+#include "stats.h"          // Statistics prototypes and summary type
+#include "stats_defines.h"  // Window sizes and fixed-point scale
+
+//------------------------------------------------------------
+// Running state of one window
+//------------------------------------------------------------
+typedef struct
+{
+        u32 start;     // Aligned start time of the open window
+        u32 n;         // Samples accumulated so far
+        s32 min;       // Smallest sample so far
+        s32 max;       // Largest sample so far
+        s32 mean;      // Running mean, Q8 fixed point
+        u64 m2;        // Sum of squared deviations, Q16
+} StatWin;
+
+//------------------------------------------------------------
+// Window lengths (seconds) and running state per channel
+//------------------------------------------------------------
+u32 statsLen[STATS_NUM_WIN];
+StatWin statsWin[STATS_MAX_CH][STATS_NUM_WIN];
+
+/*------------------------------------------------------------
+Function: InitStats
+Purpose :
+Clears every window and restores default window lengths.
+------------------------------------------------------------*/
+void InitStats(void)
+{
+        u32 ch, w;
+
+        statsLen[STATS_WIN_MIN]  = STATS_LEN_MIN;
+        statsLen[STATS_WIN_HOUR] = STATS_LEN_HOUR;
+        statsLen[STATS_WIN_DAY]  = STATS_LEN_DAY;
+
+        for (ch = 0; ch < STATS_MAX_CH; ch++)
+                for (w = 0; w < STATS_NUM_WIN; w++)
+                        statsWin[ch][w].n = 0;
+}
+
+/*------------------------------------------------------------
+Function: StatsSetWindow
+Purpose :
+Sets the length of one window and discards its open data.
+------------------------------------------------------------*/
+void StatsSetWindow(u32 win, u32 len)
+{
+        u32 ch;
+
+        if (win >= STATS_NUM_WIN)
+                return;
+
+        statsLen[win] = len;
+
+        for (ch = 0; ch < STATS_MAX_CH; ch++)
+                statsWin[ch][win].n = 0;
+}
+
+/*------------------------------------------------------------
+Function: StatsAddSample
+Purpose :
+Adds one sample to all windows of a channel.
+
+Operation:
+- If the sample falls into a later window, the open window
+  is summarised into out[] and restarted
+- The sample is folded into min/max and the Welford sums
+
+Return:
+Number of summaries written to out[]
+------------------------------------------------------------*/
+u32 StatsAddSample(u32 ch, s32 x, u32 now, StatSummary *out)
+{
+        StatWin *sw;
+        s32 delta, xq;
+        s64 dm2;
+        u32 w, start, closed = 0;
+
+        if (ch >= STATS_MAX_CH)
+                return 0;
+
+        xq = x << STATS_MEAN_FRAC;
+
+        for (w = 0; w < STATS_NUM_WIN; w++)
+        {
+                if (statsLen[w] == 0)
+                        continue;
+
+                sw = &statsWin[ch][w];
+                start = now - (now % statsLen[w]);
+
+                //------------------------------------------------------
+                // Close the open window when time moved past it
+                //------------------------------------------------------
+                if (sw->n != 0 && start != sw->start)
+                {
+                        out[closed].ch    = ch;
+                        out[closed].len   = statsLen[w];
+                        out[closed].start = sw->start;
+                        out[closed].n     = sw->n;
+                        out[closed].min   = sw->min;
+                        out[closed].max   = sw->max;
+                        out[closed].mean  = sw->mean;
+                        out[closed].var   = (u32)((sw->m2 / sw->n) >> (2 * STATS_MEAN_FRAC));
+                        closed++;
+
+                        sw->n = 0;
+                }
+
+                //------------------------------------------------------
+                // First sample of a window seeds all fields
+                //------------------------------------------------------
+                if (sw->n == 0)
+                {
+                        sw->start = start;
+                        sw->n     = 1;
+                        sw->min   = x;
+                        sw->max   = x;
+                        sw->mean  = xq;
+                        sw->m2    = 0;
+                        continue;
+                }
+
+                //------------------------------------------------------
+                // Welford update:
+                //   mean += (x - mean) / n
+                //   m2   += (x - mean_old) * (x - mean_new)
+                //------------------------------------------------------
+                sw->n++;
+                if (x < sw->min) sw->min = x;
+                if (x > sw->max) sw->max = x;
+
+                delta = xq - sw->mean;
+                sw->mean += delta / (s32)sw->n;
+                dm2 = (s64)delta * (xq - sw->mean);
+                if (dm2 > 0)              // Rounding can make it -1
+                        sw->m2 += (u64)dm2;
+        }
+
+        return closed;
+}
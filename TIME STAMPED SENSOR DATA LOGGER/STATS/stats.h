@@ -0,0 +1,67 @@
+//stats.h
+/*------------------------------------------------------------
+File: stats.h
+Purpose:
+Header file for the streaming statistics module.
+
+This file provides:
+- Per-channel min/max/mean/variance over tumbling windows
+- O(1) integer update for every sample
+- Summary record returned when a window closes
+------------------------------------------------------------*/
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include "types.h"
+#include "stats_defines.h"
+
+//------------------------------------------------------------
+// Summary of one closed window
+// Values are in the same unit as the samples passed in
+//------------------------------------------------------------
+typedef struct
+{
+        u32 ch;        // ADC channel number
+        u32 len;       // Window length in seconds
+        u32 start;     // Window start (seconds since 01/01/2000)
+        u32 n;         // Number of samples in the window
+        s32 min;       // Smallest sample
+        s32 max;       // Largest sample
+        s32 mean;      // Mean, Q8 fixed point (STATS_MEAN_FRAC)
+        u32 var;       // Population variance (sample unit squared)
+} StatSummary;
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: InitStats
+// Purpose : Clear all windows and load default lengths
+//           (1 minute, 1 hour, 24 hours)
+//------------------------------------------------------------
+void InitStats(void);
+
+//------------------------------------------------------------
+// Function: StatsSetWindow
+// Purpose : Change the length of one window (all channels)
+// Parameters:
+//   win -> Window index (STATS_WIN_MIN/HOUR/DAY)
+//   len -> Window length in seconds (0 disables the window)
+//------------------------------------------------------------
+void StatsSetWindow(u32 win, u32 len);
+
+//------------------------------------------------------------
+// Function: StatsAddSample
+// Purpose : Add one sample to every window of a channel
+// Parameters:
+//   ch  -> ADC channel number
+//   x   -> Sample value
+//   now -> Sample time (seconds since 01/01/2000)
+//   out -> Array of STATS_NUM_WIN summaries to fill
+// Return : Number of windows closed by this sample
+//------------------------------------------------------------
+u32 StatsAddSample(u32 ch, s32 x, u32 now, StatSummary *out);
+
+#endif
@@ -0,0 +1,39 @@
+//stats_defines.h
+/*------------------------------------------------------------
+File: stats_defines.h
+Purpose:
+Contains macros for the streaming statistics module.
+
+This file defines:
+- Number of channels and windows tracked
+- Default tumbling window lengths
+- Fixed-point scaling used for the running mean
+------------------------------------------------------------*/
+
+#ifndef STATS_DEFINES_H
+#define STATS_DEFINES_H
+
+//------------------------------------------------------------
+// Table sizes
+//------------------------------------------------------------
+#define STATS_MAX_CH    4      // ADC channels tracked (CH0CH3)
+#define STATS_NUM_WIN   3      // Windows kept per channel
+
+//------------------------------------------------------------
+// Window indexes and default lengths (seconds)
+//------------------------------------------------------------
+#define STATS_WIN_MIN   0
+#define STATS_WIN_HOUR  1
+#define STATS_WIN_DAY   2
+
+#define STATS_LEN_MIN   60     // 1 minute
+#define STATS_LEN_HOUR  3600   // 1 hour
+#define STATS_LEN_DAY   86400  // 24 hours
+
+//------------------------------------------------------------
+// Running mean is kept in Q8 fixed point so the Welford
+// update does not lose the fractional part of each step
+//------------------------------------------------------------
+#define STATS_MEAN_FRAC 8
+
+#endif
@@ -0,0 +1,141 @@
+//timer.c
+/*------------------------------------------------------------
+File: timer.c
+Purpose:
+Implements a free-running microsecond time base on Timer0
+of the LPC21xx microcontroller, and delays and deadlines on
+Timer1.
+
+Features:
+- Timer0 and Timer1 prescaled to 1 MHz
+- No match or interrupt, counters simply wrap at 2^32
+- Timer1 is only read by delays and bounded waits, so they
+  stay exact whatever the CPU clock or the optimiser does
+- Per-source counters of waits that hit their timeout
+------------------------------------------------------------*/
+
+#include <LPC21xx.h>          // LPC21xx register definitions
+#include "types.h"            // User-defined data types
+#include "timer_defines.h"    // Timer clock and bit definitions
+#include "timer.h"            // Timer prototypes
+#include "clock.h"            // Current PCLK
+
+//------------------------------------------------------------
+// Timeouts seen per wait source
+//------------------------------------------------------------
+volatile u32 waitTimeouts[WAIT_SOURCES];
+
+/*------------------------------------------------------------
+Function: InitTimer0
+Purpose :
+Configures Timer0 as a free-running 1 us counter.
+------------------------------------------------------------*/
+void InitTimer0(void)
+{
+        //----------------------------------------------------------
+        // Hold counter in reset while configuring
+        //----------------------------------------------------------
+        T0TCR = TCR_RESET;
+
+        //----------------------------------------------------------
+        // PCLK / (PR + 1) = 1 MHz, no match actions
+        //----------------------------------------------------------
+        Timer0SetPclk(ClockPclk());
+        T0MCR = 0;
+
+        //----------------------------------------------------------
+        // Release reset and start counting
+        //----------------------------------------------------------
+        T0TCR = TCR_ENABLE;
+}
+
+/*------------------------------------------------------------
+Function: Timer0SetPclk
+Purpose :
+Keeps Timer0 at 1 MHz after a change of PCLK. The count is
+not touched, so time stamps stay continuous; the prescale
+counter is restarted so it cannot sit above the new limit.
+------------------------------------------------------------*/
+void Timer0SetPclk(u32 pclk)
+{
+        T0PR = pclk / TICK_HZ - 1;
+        T0PC = 0;
+}
+
+/*------------------------------------------------------------
+Function: Timer0Now
+Purpose :
+Returns the current Timer0 count (microseconds).
+------------------------------------------------------------*/
+u32 Timer0Now(void)
+{
+        return T0TC;
+}
+
+/*------------------------------------------------------------
+Function: InitTimer1
+Purpose :
+Configures Timer1 as a free-running 1 us counter for delays
+and deadlines.
+------------------------------------------------------------*/
+void InitTimer1(void)
+{
+        T1TCR = TCR_RESET;
+        Timer1SetPclk(ClockPclk());
+        T1MCR = 0;
+        T1TCR = TCR_ENABLE;
+}
+
+/*------------------------------------------------------------
+Function: Timer1SetPclk
+Purpose :
+Keeps Timer1 at 1 MHz after a change of PCLK.
+------------------------------------------------------------*/
+void Timer1SetPclk(u32 pclk)
+{
+        T1PR = pclk / TICK_HZ - 1;
+        T1PC = 0;
+}
+
+/*------------------------------------------------------------
+Function: Timer1Now
+Purpose :
+Returns the current Timer1 count (microseconds).
+------------------------------------------------------------*/
+u32 Timer1Now(void)
+{
+        return T1TC;
+}
+
+/*------------------------------------------------------------
+Function: DeadlineSet
+Purpose :
+Returns the Timer1 count us microseconds from now.
+------------------------------------------------------------*/
+u32 DeadlineSet(u32 us)
+{
+        return T1TC + us;
+}
+
+/*------------------------------------------------------------
+Function: DeadlinePassed
+Purpose :
+Returns 1 once Timer1 has reached the deadline. The signed
+difference keeps this correct across the counter wrap.
+------------------------------------------------------------*/
+u32 DeadlinePassed(u32 deadline)
+{
+        return (s32)(T1TC - deadline) >= 0;
+}
+
+/*------------------------------------------------------------
+Function: WaitTimeout
+Purpose :
+Counts a wait that gave up. Each source is only waited on
+from one context, so a plain increment is enough.
+------------------------------------------------------------*/
+void WaitTimeout(u32 src)
+{
+        if (src < WAIT_SOURCES)
+                waitTimeouts[src]++;
+}
@@ -0,0 +1,102 @@
+//timer.h
+/*------------------------------------------------------------
+File: timer.h
+Purpose:
+Header file for the hardware timer time base.
+
+This file provides:
+- Timer0 initialization as a free-running 1 us counter
+- Reading the current tick count
+- Timer1 as a second 1 us counter for delays and deadlines,
+  so polls of peripherals can be bounded in time:
+
+u32 dl = DeadlineSet(ADC_TIMEOUT_US);
+
+while (!done)
+        if (DeadlinePassed(dl))
+        {
+                WaitTimeout(WAIT_ADC);
+                break;
+        }
+------------------------------------------------------------*/
+
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+#include "types.h"
+#include "timer_defines.h"
+
+//------------------------------------------------------------
+// Timeouts seen per wait source (WAIT_xxx)
+//------------------------------------------------------------
+extern volatile u32 waitTimeouts[WAIT_SOURCES];
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: InitTimer0
+// Purpose : Start Timer0 counting microseconds from zero
+//------------------------------------------------------------
+void InitTimer0(void);
+
+//------------------------------------------------------------
+// Function: Timer0SetPclk
+// Purpose : Keep the 1 us tick after a change of PCLK (Hz)
+//------------------------------------------------------------
+void Timer0SetPclk(u32 pclk);
+
+//------------------------------------------------------------
+// Function: Timer0Now
+// Purpose : Return current Timer0 count in microseconds
+// Note    : Wraps every ~71 minutes, compare with signed
+//           differences: (s32)(a - b) >= 0
+//------------------------------------------------------------
+u32 Timer0Now(void);
+
+//------------------------------------------------------------
+// Function: InitTimer1
+// Purpose : Start Timer1 counting microseconds
+// Note    : Call before the first delay or deadline
+//------------------------------------------------------------
+void InitTimer1(void);
+
+//------------------------------------------------------------
+// Function: Timer1SetPclk
+// Purpose : Keep the 1 us tick after a change of PCLK (Hz)
+//------------------------------------------------------------
+void Timer1SetPclk(u32 pclk);
+
+//------------------------------------------------------------
+// Function: Timer1Now
+// Purpose : Return current Timer1 count in microseconds
+//------------------------------------------------------------
+u32 Timer1Now(void);
+
+//------------------------------------------------------------
+// Function: DeadlineSet / DeadlinePassed
+// Purpose : Deadline us microseconds from now; 1 once that
+//           time has been reached
+// Note    : Valid for waits up to ~35 minutes
+//------------------------------------------------------------
+u32 DeadlineSet(u32 us);
+u32 DeadlinePassed(u32 deadline);
+
+//------------------------------------------------------------
+// Function: WaitTimeout
+// Purpose : Count a timed-out wait of a source (WAIT_xxx)
+//------------------------------------------------------------
+void WaitTimeout(u32 src);
+
+#ifdef HOST_BUILD
+//------------------------------------------------------------
+// Function: TimerSimAdvance
+// Purpose : Move the virtual Timer0/Timer1 counters forward
+// Parameter:
+//   us -> Microseconds to advance
+//------------------------------------------------------------
+void TimerSimAdvance(u32 us);
+#endif
+
+#endif
@@ -0,0 +1,40 @@
+//timer_defines.h
+/*------------------------------------------------------------
+File: timer_defines.h
+Purpose:
+Contains macros for configuring the LPC21xx timers as
+free-running time bases.
+
+This file defines:
+- Timer tick rate (prescaler follows the current PCLK)
+- Timer control register bit definitions
+- Sources of bounded waits (timeout counters)
+------------------------------------------------------------*/
+
+#ifndef TIMER_DEFINES_H
+#define TIMER_DEFINES_H
+
+//------------------------------------------------------------
+// Timer tick: 1 count = 1 microsecond
+//------------------------------------------------------------
+#define TICK_HZ      1000000
+
+//------------------------------------------------------------
+// TCR (Timer Control Register) Bit Definitions
+//------------------------------------------------------------
+#define TCR_ENABLE   (1<<0)    // Bit 0: Counter enable
+#define TCR_RESET    (1<<1)    // Bit 1: Counter reset
+
+//------------------------------------------------------------
+// Bounded waits: one timeout counter per polled peripheral
+//------------------------------------------------------------
+#define WAIT_ADC       0       // ADC conversion done
+#define WAIT_UART_TX   1       // UART0 transmitter empty
+#define WAIT_UART_RX   2       // UART0 receive data
+#define WAIT_SSP       3       // SSP FIFO / busy
+#define WAIT_KEY       4       // Keypad key not released
+#define WAIT_PLL       5       // PLL lock
+#define WAIT_USB       6       // USB SIE handshake / TX space
+#define WAIT_SOURCES   7
+
+#endif
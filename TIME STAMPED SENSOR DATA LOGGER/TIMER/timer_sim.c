@@ -0,0 +1,91 @@
+//timer_sim.c
+/*------------------------------------------------------------
+File: timer_sim.c
+Purpose:
+Virtual Timer0/Timer1 time base for host builds (HOST_BUILD).
+
+Stands in for timer.c so scheduling code (the sampling
+pipeline, deadlines of bounded waits) can run on a PC: the
+counters only move when TimerSimAdvance() is called, so a
+test program decides exactly how long each step takes.
+
+Features:
+- Timer0 and Timer1 read the same virtual microsecond
+  counter, wrapping at 2^32 like the hardware
+- Deadlines and wait timeout counters as in timer.c
+
+NOTE:
+Delay functions are not provided; they would never return.
+------------------------------------------------------------*/
+
+#ifdef HOST_BUILD
+
+#include "types.h"            // User-defined data types
+#include "timer_defines.h"    // WAIT_xxx sources
+#include "timer.h"            // Timer prototypes
+
+//------------------------------------------------------------
+// Timeouts seen per wait source
+//------------------------------------------------------------
+volatile u32 waitTimeouts[WAIT_SOURCES];
+
+//------------------------------------------------------------
+// Virtual counter (microseconds)
+//------------------------------------------------------------
+static u32 simTc;
+
+//------------------------------------------------------------
+// Function: TimerSimAdvance
+// Purpose : Move both counters forward by us microseconds
+//------------------------------------------------------------
+void TimerSimAdvance(u32 us)
+{
+        simTc += us;
+}
+
+void InitTimer0(void)
+{
+        simTc = 0;
+}
+
+void Timer0SetPclk(u32 pclk)
+{
+        (void)pclk;
+}
+
+u32 Timer0Now(void)
+{
+        return simTc;
+}
+
+void InitTimer1(void)
+{
+}
+
+void Timer1SetPclk(u32 pclk)
+{
+        (void)pclk;
+}
+
+u32 Timer1Now(void)
+{
+        return simTc;
+}
+
+u32 DeadlineSet(u32 us)
+{
+        return simTc + us;
+}
+
+u32 DeadlinePassed(u32 deadline)
+{
+        return (s32)(simTc - deadline) >= 0;
+}
+
+void WaitTimeout(u32 src)
+{
+        if (src < WAIT_SOURCES)
+                waitTimeouts[src]++;
+}
+
+#endif
@@ -0,0 +1,130 @@
+//trend.c
+/*------------------------------------------------------------
+File: trend.c
+Purpose:
+Implements the time-to-threshold trend estimator: a
+least-squares line through the last TREND_WIN per-second
+readings, kept up to date in O(1) per reading.
+
+Operation (once per second):
+- The window holds y[0..N-1] at x = 0..N-1, oldest first.
+  Sum(y) and Sum(x*y) are updated in place: when y[0]
+  leaves and a new reading enters at x = N, every x drops by
+  one, which takes Sum(y) of the new window off Sum(x*y)
+- Sum(x) and the denominator only depend on N
+  (TREND_SX, TREND_DEN), so the slope is
+  (N*Sum(xy) - Sum(x)*Sum(y)) / TREND_DEN
+- The line is evaluated at the newest second and extended to
+  the set point; the seconds to get there are the forecast
+- A warning is raised once when the forecast drops to
+  TREND_WARN_S, and re-armed once it has gone past
+  TREND_CLEAR_S or the rise has stopped
+
+NOTE:
+The slope is kept as a numerator over TREND_DEN; 64-bit
+integers are only used where the numerator is scaled.
+------------------------------------------------------------*/
+
+#include "types.h"            // User-defined data types
+#include "trend.h"            // Estimator prototypes and state
+#include "trend_defines.h"    // Window and warning limits
+
+//------------------------------------------------------------
+// Estimator state
+//------------------------------------------------------------
+TrendStats trendStats;
+
+//------------------------------------------------------------
+// Sliding window and its running sums
+//------------------------------------------------------------
+static s16 win[TREND_WIN];    // Readings, ring
+static u32 winHead;           // Oldest reading (once full)
+static u32 winN;              // Readings held
+static s32 sumY, sumXY;
+
+/*------------------------------------------------------------
+Function: InitTrend
+Purpose :
+Empties the window; the first forecast comes TREND_WIN
+seconds later.
+------------------------------------------------------------*/
+void InitTrend(void)
+{
+        winHead = winN = 0;
+        sumY = sumXY = 0;
+
+        trendStats.rise = trendStats.fit = 0;
+        trendStats.eta = TREND_NONE;
+        trendStats.warned = 0;
+        trendStats.warnings = 0;
+}
+
+/*------------------------------------------------------------
+Function: TrendUpdate
+Purpose :
+Slides the window by one reading, refits the line and works
+out the seconds until it reaches the set point.
+------------------------------------------------------------*/
+u32 TrendUpdate(s32 tenths, s32 setPoint)
+{
+        s32 num;
+        s64 fitQ, gap;
+
+        //----------------------------------------------------------
+        // Slide the window
+        //----------------------------------------------------------
+        if (winN < TREND_WIN)
+        {
+                sumXY += (s32)winN * tenths;
+                sumY += tenths;
+                winN++;
+        }
+        else
+        {
+                sumY += tenths - win[winHead];
+                sumXY += TREND_WIN * tenths - sumY;
+        }
+        win[winHead] = tenths;
+        winHead = (winHead + 1) & TREND_MASK;
+
+        if (winN < TREND_WIN)
+                return 0;
+
+        //----------------------------------------------------------
+        // Fit: slope numerator, and the line at the newest
+        // second (x = N-1) scaled by TREND_DEN
+        //----------------------------------------------------------
+        num = TREND_WIN * sumXY - TREND_SX * sumY;
+        fitQ = (s64)sumY * TREND_DEN / TREND_WIN + (s64)num * (TREND_WIN - 1) / 2;
+
+        trendStats.rise = (s32)((s64)num * 60 / TREND_DEN);
+        trendStats.fit = (s32)(fitQ / TREND_DEN);
+
+        //----------------------------------------------------------
+        // Seconds until the line reaches the set point
+        //----------------------------------------------------------
+        if (trendStats.rise < TREND_MIN_RISE)
+                trendStats.eta = TREND_NONE;
+        else
+        {
+                gap = (s64)setPoint * TREND_DEN - fitQ;
+                trendStats.eta = (gap <= 0) ? 0 : (u32)(gap / num);
+        }
+
+        //----------------------------------------------------------
+        // Warn once per approach
+        //----------------------------------------------------------
+        if (!trendStats.warned)
+        {
+                if (trendStats.eta <= TREND_WARN_S)
+                {
+                        trendStats.warned = 1;
+                        trendStats.warnings++;
+                        return 1;
+                }
+        }
+        else if (trendStats.eta > TREND_CLEAR_S)
+                trendStats.warned = 0;
+
+        return 0;
+}
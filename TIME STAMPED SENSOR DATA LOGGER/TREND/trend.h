@@ -0,0 +1,61 @@
+//trend.h
+/*------------------------------------------------------------
+File: trend.h
+Purpose:
+Header file for the time-to-threshold trend estimator.
+
+Once per second the newest reading enters a sliding window
+of the last TREND_WIN readings, and a least-squares line is
+fitted through them. Where that line crosses the set point
+gives the time left before an over-temperature alert; when
+it drops to TREND_WARN_S or less a warning is raised, well
+before the reading itself reaches the limit.
+
+The fit is kept as running sums that are updated in place
+when a reading enters and the oldest one leaves, so each
+second costs the same few integer operations whatever the
+window length; there is no floating point and no
+allocation.
+------------------------------------------------------------*/
+
+#ifndef __TREND_H__
+#define __TREND_H__
+
+#include "types.h"
+#include "trend_defines.h"
+
+//------------------------------------------------------------
+// Estimator state (for diagnostics and the [WARN] record)
+//------------------------------------------------------------
+typedef struct
+{
+        s32 rise;       // Fitted slope, tenths per minute
+        s32 fit;        // Fitted value of the newest second, tenths
+        u32 eta;        // Seconds until the set point, TREND_NONE
+        u32 warned;     // 1 from a warning until re-armed
+        u32 warnings;   // Warnings raised
+} TrendStats;
+
+extern TrendStats trendStats;
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: InitTrend
+// Purpose : Empty the window and clear the counters
+//------------------------------------------------------------
+void InitTrend(void);
+
+//------------------------------------------------------------
+// Function: TrendUpdate
+// Purpose : Add one per-second reading and renew the forecast
+// Parameters:
+//   tenths   -> Reading (tenths of a degree)
+//   setPoint -> Temperature limit (tenths of a degree)
+// Return  : 1 -> a warning has just been raised
+//------------------------------------------------------------
+u32 TrendUpdate(s32 tenths, s32 setPoint);
+
+#endif
@@ -0,0 +1,50 @@
+//trend_defines.h
+/*------------------------------------------------------------
+File: trend_defines.h
+Purpose:
+Contains macros for the time-to-threshold trend estimator.
+
+This file defines:
+- Length of the sliding regression window
+- Forecast horizon that raises a warning, and the one that
+  re-arms it
+- Least rise worth a forecast
+------------------------------------------------------------*/
+
+#ifndef TREND_DEFINES_H
+#define TREND_DEFINES_H
+
+//------------------------------------------------------------
+// Sliding window: per-second readings in the fit (power of
+// two). Sums stay within 32 bits for readings up to
+// +/-1500 tenths (LM35 range).
+//------------------------------------------------------------
+#define TREND_WIN         64
+#define TREND_MASK        (TREND_WIN-1)
+
+//------------------------------------------------------------
+// Fit constants for x = 0 .. TREND_WIN-1:
+// sum of x, and N * sum(x^2) - (sum x)^2 = N^2 (N^2 - 1) / 12
+//------------------------------------------------------------
+#define TREND_SX          (TREND_WIN * (TREND_WIN - 1) / 2)
+#define TREND_DEN         ((s64)TREND_WIN * TREND_WIN * (TREND_WIN * TREND_WIN - 1) / 12)
+
+//------------------------------------------------------------
+// Warn when the fitted line reaches the set point within
+// WARN seconds; warn again only after the forecast has gone
+// past CLEAR seconds (or stopped rising)
+//------------------------------------------------------------
+#define TREND_WARN_S      600      // 10 minutes
+#define TREND_CLEAR_S     1200     // 20 minutes
+
+//------------------------------------------------------------
+// Slower rises are treated as flat (0.1 C per minute)
+//------------------------------------------------------------
+#define TREND_MIN_RISE    2
+
+//------------------------------------------------------------
+// Forecast when there is none (flat, falling, window filling)
+//------------------------------------------------------------
+#define TREND_NONE        0xFFFFFFFF
+
+#endif
@@ -33,11 +33,28 @@ typedef signed short int s16;
 // 32-bit data types
 //------------------------------------------------------------
 
+// Host builds (HOST_BUILD) run on LP64 machines where long
+// is 64 bits wide, so int is used there instead
+#ifdef HOST_BUILD
+typedef unsigned int u32;
+typedef signed int s32;
+#else
 // Unsigned 32-bit integer (0 to 4,294,967,295)
 typedef unsigned long int u32;
 
 // Signed 32-bit integer (-2,147,483,648 to +2,147,483,647)
 typedef signed long int s32;
+#endif
+
+//------------------------------------------------------------
+// 64-bit data types
+//------------------------------------------------------------
+
+// Unsigned 64-bit integer (0 to 18,446,744,073,709,551,615)
+typedef unsigned long long int u64;
+
+// Signed 64-bit integer
+typedef signed long long int s64;
 
 //------------------------------------------------------------
 // Floating-point data types
@@ -2,90 +2,449 @@
 /*------------------------------------------------------------
 File: uart.c
 Purpose:
-Source file for UART0 communication on LPC21xx/LPC214x
+Source file for UART0/UART1 communication on LPC21xx/LPC214x
 ARM7 microcontroller.
 
 This file provides:
 - UART initialization
 - Character, string, integer, and float transmission
 - Display of date and time via serial terminal
+- Millisecond time stamps taken from an RTCStamp
+- Interrupt driven transmission: every port has its own
+  buffer and baud rate, so a slow or busy port never holds
+  up output to the other one
+- With USB_CDC, the USB virtual COM port as one more port
+
+All UARTTx* functions write to the port chosen with
+UARTSelect (UART_CONSOLE after reset).
+
+Host builds (HOST_BUILD) keep the formatting and capture
+functions and take the port functions from uart_sim.c.
 ------------------------------------------------------------*/
 
+#ifndef HOST_BUILD
 #include <LPC21xx.h>     // LPC21xx/LPC214x register definitions
 #include "defines.h"     // Bit manipulation macros
+#include "clock.h"       // Current PCLK
+#include "timer.h"       // Deadlines for bounded waits
+#include "queue.h"       // Transmit buffers
+#include "vic.h"         // Interrupt registration and ISR macros
+#include "usbcdc.h"      // USB virtual COM port
+#endif
 #include "types.h"       // User-defined data types
+#include "crc.h"         // CRC of captured records
+#include "rtc.h"         // RTCStamp
+#include "uart_defines.h" // Ports, baud rates, buffer sizes
+#include "uart.h"        // UART prototypes
 
 //------------------------------------------------------------
 // Array holding abbreviated names of days (for UART display)
 //------------------------------------------------------------
 char week1[][4] = {"SUN","MON","TUE","WED","THU","FRI","SAT"};
 
+#ifndef HOST_BUILD
+//------------------------------------------------------------
+// Port descriptor: UART0 and UART1 have the same register
+// layout, so one set of routines serves both
+//------------------------------------------------------------
+typedef struct
+{
+        volatile u32 *thr;     // THR / RBR / DLL
+        volatile u32 *ier;     // IER / DLM
+        volatile u32 *iir;     // IIR / FCR
+        volatile u32 *lcr;
+        volatile u32 *lsr;
+        volatile u32 *fdr;     // Fractional divider
+        u32 baud;
+        u32 vicSrc;
+        Queue tx;
+} UartPort;
+
+static u8 tx0Buf[UART0_TXBUF];
+#ifdef UART1_BULK
+static u8 tx1Buf[UART1_TXBUF];
+#endif
+
+static UartPort ports[UART_HW_PORTS] =
+{
+        { (volatile u32 *)&U0THR, (volatile u32 *)&U0IER, (volatile u32 *)&U0IIR,
+          (volatile u32 *)&U0LCR, (volatile u32 *)&U0LSR, (volatile u32 *)&U0FDR,
+          UART0_BAUD, VIC_SRC_UART0 },
+#ifdef UART1_BULK
+        { (volatile u32 *)&U1THR, (volatile u32 *)&U1IER, (volatile u32 *)&U1IIR,
+          (volatile u32 *)&U1LCR, (volatile u32 *)&U1LSR, (volatile u32 *)&U1FDR,
+          UART1_BAUD, VIC_SRC_UART1 },
+#endif
+};
+
+static UartPort *cur = &ports[UART_CONSOLE];   // UART used by UARTTx*
+static u32 curPort = UART_CONSOLE;             // May also be UART_USB
+#endif
+
+//------------------------------------------------------------
+// Record capture: while capBuf is set, every transmitted
+// character is also copied to capBuf and folded into capCrc
+//------------------------------------------------------------
+static u8 *capBuf;
+static u32 capLen, capMax;
+static u16 capCrc;
+
+#ifndef HOST_BUILD
+
+//------------------------------------------------------------
+// Function: TxPump
+// Purpose : Move buffered bytes into an empty TX FIFO
+// Note    : Called from the port ISR, or from main() with the
+//           port interrupt disabled (one consumer at a time)
+//------------------------------------------------------------
+static void TxPump(UartPort *p)
+{
+        u32 n;
+        u8 c;
+
+        if (!(*p->lsr & LSR_THRE))
+                return;
+
+        for (n = 0; n < UART_FIFO_DEPTH && QueuePop(&p->tx, &c); n++)
+                *p->thr = c;
+}
+
+//------------------------------------------------------------
+// Function: TxKick
+// Purpose : Start sending from main() when the port is idle
+//------------------------------------------------------------
+static void TxKick(UartPort *p)
+{
+        *p->ier = 0;
+        TxPump(p);
+        *p->ier = IER_THRE;
+}
+
+/*------------------------------------------------------------
+Function: UART0_ISR / UART1_ISR
+Purpose :
+Transmit holding register empty: refill the FIFO from the
+port buffer. Reading IIR clears the request.
+------------------------------------------------------------*/
+void UART0_ISR(void) __irq
+{
+        VIC_ISR_ENTER();
+        (void)U0IIR;
+        TxPump(&ports[0]);
+        VIC_ISR_EXIT(VIC_SRC_UART0);
+}
+
+#ifdef UART1_BULK
+void UART1_ISR(void) __irq
+{
+        VIC_ISR_ENTER();
+        (void)U1IIR;
+        TxPump(&ports[1]);
+        VIC_ISR_EXIT(VIC_SRC_UART1);
+}
+#endif
+
+/*------------------------------------------------------------
+Function: SetDivisor
+Purpose :
+Programs the baud rate of one port. The rate is
+PCLK / (16 * div * (1 + DIVADDVAL / MULVAL)); every
+MULVAL/DIVADDVAL pair is tried with div rounded to the
+nearest value, and the pair with the smallest error wins
+(div alone gives 98 and 0.35% for 9600 at 15 MHz, but 3
+and 8.5% for 115200 at 6 MHz, which 1/12 brings to 0.16%).
+A port whose best error is over UART_BAUD_ERR_PCT % keeps
+its old setting rather than send garbage.
+------------------------------------------------------------*/
+static void SetDivisor(UartPort *p, u32 pclk)
+{
+        u32 mul, add, div, want, err;
+        u32 bestDiv = 0, bestMul = 1, bestAdd = 0, bestErr = 0;
+
+        for (mul = 1; mul <= FDR_MUL_MAX; mul++)
+        {
+                for (add = 0; add < mul; add++)
+                {
+                        // pclk * mul = baud * 16 * div * (mul + add)
+                        want = 16 * p->baud * (mul + add);
+                        div = (pclk * mul + want / 2) / want;
+                        if (div == 0 || div > 0xFFFF || (add && div < FDR_DIV_MIN))
+                                continue;
+
+                        want *= div;
+                        err = (want > pclk * mul) ? want - pclk * mul : pclk * mul - want;
+
+                        // Compare err / (pclk * mul) across pairs
+                        if (bestDiv == 0 || err * bestMul < bestErr * mul)
+                        {
+                                bestDiv = div;
+                                bestMul = mul;
+                                bestAdd = add;
+                                bestErr = err;
+                        }
+                }
+        }
+
+        if (bestDiv == 0 || bestErr > pclk / 100 * bestMul * UART_BAUD_ERR_PCT)
+                return;
+
+        *p->lcr = LCR_8N1 | LCR_DLAB;   // DLL/DLM replace THR/IER
+        p->thr[0] = bestDiv & 0xFF;     // DLL
+        p->ier[0] = bestDiv >> 8;       // DLM
+        *p->fdr = (bestMul << 4) | bestAdd;
+        *p->lcr = LCR_8N1;
+}
+
 /*------------------------------------------------------------
 Function: InitUART
 Purpose :
-Initializes UART0 for serial communication.
+Initializes the serial ports.
 
 Configuration:
-- TXD0 on P0.0
-- RXD0 on P0.1
-- 8-bit data, 1 stop bit
-- Baud rate configured using DLL and DLM
+- TXD0 on P0.0, RXD0 on P0.1 (UART0)
+- TXD1 on P0.8, RXD1 on P0.9 (UART1, with UART1_BULK only)
+- 8-bit data, 1 stop bit, FIFOs on
+- Baud rate of each port from the current PCLK
+- Transmission driven by the THRE interrupt
 ------------------------------------------------------------*/
 void InitUART(void)
 {
-        //----------------------------------------------------------
-        // Select UART function for P0.0 (TXD0) and P0.1 (RXD0)
-        //----------------------------------------------------------
-        PINSEL0 |= 0x00000001;
-        //CfgPinFunc(0,0,1);   // P0.0 for TXD0
-        //CfgPinFunc(0,1,1);   // P0.1 for RXD0
+        u32 i;
 
         //----------------------------------------------------------
-        // Line Control Register configuration
+        // Select UART function for the port pins
         //----------------------------------------------------------
-        U0LCR = 0x03;          // 8-bit word length, 1 stop bit
-        U0LCR |= 1 << 7;       // Enable DLAB to access baud rate registers
+        PINSEL0 |= UART0_PINSEL;
+#ifdef UART1_BULK
+        PINSEL0 = (PINSEL0 & ~UART1_PINMASK) | UART1_PINSEL;
+#endif
 
-        //----------------------------------------------------------
-        // Baud rate configuration (example: 9600 bps @ 15 MHz PCLK)
-        //----------------------------------------------------------
-        U0DLL = 97;
-        U0DLM = 0;
+        QueueInit(&ports[0].tx, tx0Buf, 1, UART0_TXBUF);
+#ifdef UART1_BULK
+        QueueInit(&ports[1].tx, tx1Buf, 1, UART1_TXBUF);
+#endif
 
-        //----------------------------------------------------------
-        // Disable DLAB after baud rate setup
-        //----------------------------------------------------------
-        U0LCR &= ~(1 << 7);
+        for (i = 0; i < UART_HW_PORTS; i++)
+        {
+                SetDivisor(&ports[i], ClockPclk());
+                *ports[i].iir = FCR_ENABLE;
+                *ports[i].ier = IER_THRE;
+        }
+
+        VICRegister(VIC_SRC_UART0, VIC_PRIO_UART0, (u32)UART0_ISR);
+#ifdef UART1_BULK
+        VICRegister(VIC_SRC_UART1, VIC_PRIO_UART1, (u32)UART1_ISR);
+#endif
+}
+
+/*------------------------------------------------------------
+Function: UARTSetPclk
+Purpose :
+Sets the divisor of every port for a given PCLK. Call with
+the ports flushed (UARTFlush), or characters in the shift
+register go out at a mixed rate.
+------------------------------------------------------------*/
+void UARTSetPclk(u32 pclk)
+{
+        u32 i;
+
+        for (i = 0; i < UART_HW_PORTS; i++)
+                SetDivisor(&ports[i], pclk);
+}
+
+/*------------------------------------------------------------
+Function: UARTSelect
+Purpose :
+Chooses the port used by the UARTTx* and UARTRx* functions.
+Return  : The previously selected port
+------------------------------------------------------------*/
+u32 UARTSelect(u32 port)
+{
+        u32 prev = curPort;
+
+        if (port < UART_HW_PORTS)
+                cur = &ports[port];
+        if (port < UART_PORTS)
+                curPort = port;
+        return prev;
+}
+
+/*------------------------------------------------------------
+Function: UARTGetPort
+Purpose :
+Returns the port selected for UARTTx* / UARTRx*.
+------------------------------------------------------------*/
+u32 UARTGetPort(void)
+{
+        return curPort;
+}
+
+/*------------------------------------------------------------
+Function: UARTFlush
+Purpose :
+Sends everything buffered on every port and waits for the
+transmitters to go idle, at most UART_FLUSH_TIMEOUT_US.
+Works with interrupts masked, since the buffers are pumped
+from here too.
+------------------------------------------------------------*/
+void UARTFlush(void)
+{
+        u32 i, dl = DeadlineSet(UART_FLUSH_TIMEOUT_US);
+
+        for (i = 0; i < UART_HW_PORTS; i++)
+                while (QueueCount(&ports[i].tx) || !(*ports[i].lsr & LSR_TEMT))
+                {
+                        TxKick(&ports[i]);
+                        if (DeadlinePassed(dl))
+                        {
+                                WaitTimeout(WAIT_UART_TX);
+                                return;
+                        }
+                }
+
+#ifdef USB_CDC
+        while (!UsbCdcTxIdle())
+        {
+                UsbCdcKick();
+                if (DeadlinePassed(dl))
+                {
+                        WaitTimeout(WAIT_USB);
+                        return;
+                }
+        }
+#endif
 }
 
 /*------------------------------------------------------------
 Function: UARTRxChar
 Purpose :
-Receives a single character from UART.
+Receives a single character from the selected port.
+Return  : The character, or 0 when none arrives within
+          UART_RX_TIMEOUT_US (counted under WAIT_UART_RX)
 ------------------------------------------------------------*/
 s8 UARTRxChar(void)
 {
+        u32 dl = DeadlineSet(UART_RX_TIMEOUT_US);
+
         //----------------------------------------------------------
         // Wait until data is available in receiver buffer
         //----------------------------------------------------------
-        while (!READBIT(U0LSR, 0));
+        while (!UARTRxReady())
+                if (DeadlinePassed(dl))
+                {
+                        WaitTimeout(WAIT_UART_RX);
+                        return 0;
+                }
+
+#ifdef USB_CDC
+        if (curPort == UART_USB)
+        {
+                u8 c = 0;
 
-        return (U0RBR);        // Return received character
+                UsbCdcRxChar(&c);
+                return c;
+        }
+#endif
+        return (*cur->thr);    // RBR: return received character
 }
 
+/*------------------------------------------------------------
+Function: UARTRxReady
+Purpose :
+Returns 1 when a received character is waiting (non-blocking).
+------------------------------------------------------------*/
+u32 UARTRxReady(void)
+{
+#ifdef USB_CDC
+        if (curPort == UART_USB)
+                return UsbCdcRxReady();
+#endif
+        return (*cur->lsr & LSR_RDR) != 0;
+}
+
+#ifdef USB_CDC
+//------------------------------------------------------------
+// Function: UsbTxChar
+// Purpose : UARTTxChar on UART_USB; a full ring is waited on
+//           at most USB_TX_TIMEOUT_US (counted under WAIT_USB)
+//------------------------------------------------------------
+static void UsbTxChar(u8 c)
+{
+        u32 dl;
+
+        if (UsbCdcTxChar(c))
+                return;
+
+        dl = DeadlineSet(USB_TX_TIMEOUT_US);
+        do
+        {
+                UsbCdcKick();
+                if (DeadlinePassed(dl))
+                {
+                        WaitTimeout(WAIT_USB);
+                        return;
+                }
+        } while (!UsbCdcTxChar(c));
+}
+#endif
+
+//------------------------------------------------------------
+// Function: PortTxChar
+// Purpose : Queue a character on the selected port; a full
+//           buffer is waited on at most UART_TX_TIMEOUT_US
+//------------------------------------------------------------
+static void PortTxChar(s8 ch)
+{
+        u32 dl;
+
+#ifdef USB_CDC
+        if (curPort == UART_USB)
+        {
+                UsbTxChar(ch);
+                return;
+        }
+#endif
+
+        if (!QueuePush(&cur->tx, &ch))
+        {
+                dl = DeadlineSet(UART_TX_TIMEOUT_US);
+                do
+                {
+                        TxKick(cur);   // Progress even with IRQs masked
+                        if (DeadlinePassed(dl))
+                        {
+                                WaitTimeout(WAIT_UART_TX);
+                                return;
+                        }
+                } while (!QueuePush(&cur->tx, &ch));
+        }
+
+        TxKick(cur);
+}
+#endif
+
 /*------------------------------------------------------------
 Function: UARTTxChar
 Purpose :
-Transmits a single character via UART.
+Queues a single character on the selected port and returns;
+the port interrupt sends it. When the buffer is full the
+caller waits for space, at most UART_TX_TIMEOUT_US, then the
+character is dropped and counted under WAIT_UART_TX.
 ------------------------------------------------------------*/
 void UARTTxChar(s8 ch)
 {
-        U0THR = ch;            // Load character into transmit register
+        if (capBuf)
+        {
+                if (capLen < capMax)
+                        capBuf[capLen++] = ch;
+                capCrc = Crc16Update(capCrc, ch);
+        }
 
-        //----------------------------------------------------------
-        // Wait until transmission is complete
-        //----------------------------------------------------------
-        while (!READBIT(U0LSR, 6));
+#ifdef HOST_BUILD
+        UARTSimTx(ch);
+#else
+        PortTxChar(ch);
+#endif
 }
 
 /*------------------------------------------------------------
@@ -202,3 +561,67 @@ void DisplayUARTTime(u32 hour, u32 minute, u32 second)
         UARTTxChar((second % 10) + 48);
         UARTTxChar(' ');
 }
+
+//------------------------------------------------------------
+// Function: UARTTx2
+// Purpose : Send a value 0-99 as two digits
+//------------------------------------------------------------
+static void UARTTx2(u32 v)
+{
+        UARTTxChar((v / 10) + 48);
+        UARTTxChar((v % 10) + 48);
+}
+
+/*------------------------------------------------------------
+Function: DisplayUARTStamp
+Purpose :
+Displays "HH:MM:SS.mmm DD/MM/YYYY" via UART. The fields are
+taken straight from the CTIME registers saved in the stamp,
+so no date conversion is needed.
+------------------------------------------------------------*/
+void DisplayUARTStamp(const RTCStamp *ts)
+{
+        u32 ms = ts->us / 1000;
+
+        UARTTx2((ts->ctime0 >> 16) & 0x1F);
+        UARTTxChar(':');
+        UARTTx2((ts->ctime0 >> 8) & 0x3F);
+        UARTTxChar(':');
+        UARTTx2(ts->ctime0 & 0x3F);
+        UARTTxChar('.');
+        UARTTxChar((ms / 100) + 48);
+        UARTTx2(ms % 100);
+        UARTTxChar(' ');
+        UARTTx2(ts->ctime1 & 0x1F);
+        UARTTxChar('/');
+        UARTTx2((ts->ctime1 >> 8) & 0x0F);
+        UARTTxChar('/');
+        UARTTxU32((ts->ctime1 >> 16) & 0xFFF);
+}
+
+/*------------------------------------------------------------
+Function: UARTCaptureStart
+Purpose :
+Starts copying transmitted characters into buf (up to max
+bytes) and computing their CRC-16.
+------------------------------------------------------------*/
+void UARTCaptureStart(u8 *buf, u32 max)
+{
+        capLen = 0;
+        capMax = max;
+        capCrc = CRC16_INIT;
+        capBuf = buf;
+}
+
+/*------------------------------------------------------------
+Function: UARTCaptureStop
+Purpose :
+Stops capturing. Returns the number of bytes stored and the
+CRC of every byte sent since UARTCaptureStart.
+------------------------------------------------------------*/
+u32 UARTCaptureStop(u16 *crc)
+{
+        capBuf = 0;
+        *crc = capCrc;
+        return capLen;
+}
@@ -9,12 +9,18 @@ This file provides:
 - Character and string transmission functions
 - Number (integer and float) transmission functions
 - Date and time display utilities over UART
+- A console port and, with UART1_BULK, a separate bulk port;
+  each has its own transmit buffer and baud rate
+- With USB_CDC, the USB virtual COM port (UART_USB) behind
+  the same functions
 ------------------------------------------------------------*/
 
 #ifndef __UART_H__
 #define __UART_H__
 
 #include "types.h"
+#include "rtc.h"
+#include "uart_defines.h"
 
 //------------------------------------------------------------
 // Function Prototypes
@@ -26,12 +32,56 @@ Purpose : Initializes UART peripheral
           - Configures baud rate
           - Sets data frame format (8N1 typically)
           - Enables transmitter
+          - Registers the transmit interrupt of each port
+Note    : Call after InitVIC
 ------------------------------------------------------------*/
 void InitUART(void);
 
+/*------------------------------------------------------------
+Function: UARTSelect
+Purpose : Chooses the port (UART_CONSOLE / UART_BULK /
+          UART_USB) used by the UARTTx* and UARTRx* functions
+Return  : Previously selected port, for restoring it
+------------------------------------------------------------*/
+u32 UARTSelect(u32 port);
+
+/*------------------------------------------------------------
+Function: UARTGetPort
+Purpose : Returns the port currently selected
+------------------------------------------------------------*/
+u32 UARTGetPort(void);
+
+/*------------------------------------------------------------
+Function: UARTFlush
+Purpose : Sends all buffered output and waits until every
+          port is idle (bounded, safe with IRQs masked)
+------------------------------------------------------------*/
+void UARTFlush(void);
+
+/*------------------------------------------------------------
+Function: UARTSetPclk
+Purpose : Recomputes the baud rate divisor after a change
+          of peripheral clock (Hz)
+------------------------------------------------------------*/
+void UARTSetPclk(u32 pclk);
+
+/*------------------------------------------------------------
+Function: UARTRxReady
+Purpose : Checks for a received character without waiting
+Return  : 1 -> character available, 0 -> none
+------------------------------------------------------------*/
+u32 UARTRxReady(void);
+
+/*------------------------------------------------------------
+Function: UARTRxChar
+Purpose : Waits for and returns one received character
+------------------------------------------------------------*/
+s8 UARTRxChar(void);
+
 /*------------------------------------------------------------
 Function: UARTTxChar
-Purpose : Transmits a single character via UART
+Purpose : Queues a single character for transmission on the
+          selected port
 Input   : s8 - character to transmit
 ------------------------------------------------------------*/
 void UARTTxChar(s8);
@@ -78,6 +128,14 @@ Input   : hour   - hours
 ------------------------------------------------------------*/
 void DisplayUARTTime(u32 hour, u32 minute, u32 second);
 
+/*------------------------------------------------------------
+Function: DisplayUARTStamp
+Purpose : Displays a high resolution time stamp over UART
+Format  : HH:MM:SS.mmm DD/MM/YYYY
+Input   : ts - stamp from GetRTCStamp
+------------------------------------------------------------*/
+void DisplayUARTStamp(const RTCStamp *ts);
+
 /*------------------------------------------------------------
 Function: DisplayUARTDay
 Purpose : Displays day of week over UART
@@ -99,4 +157,37 @@ Purpose : General UART display handler function
 ------------------------------------------------------------*/
 void DisplayUART(void);
 
+/*------------------------------------------------------------
+Function: UARTCaptureStart
+Purpose : Copy every transmitted character into a buffer and
+          accumulate its CRC-16 until UARTCaptureStop
+Input   : buf - capture buffer
+          max - buffer size (extra characters are only CRCed)
+------------------------------------------------------------*/
+void UARTCaptureStart(u8 *buf, u32 max);
+
+/*------------------------------------------------------------
+Function: UARTCaptureStop
+Purpose : End capture
+Output  : crc - CRC-16 of all characters sent while capturing
+Return  : Number of characters stored in the buffer
+------------------------------------------------------------*/
+u32 UARTCaptureStop(u16 *crc);
+
+#ifdef HOST_BUILD
+//------------------------------------------------------------
+// Function: UARTSimTx
+// Purpose : Take one character of the selected port
+//           (uart_sim.c; called by UARTTxChar)
+//------------------------------------------------------------
+void UARTSimTx(s8 ch);
+
+//------------------------------------------------------------
+// Function: UARTSimHook
+// Purpose : Have every completed line (CR LF removed) passed
+//           to fn with the port it was sent on
+//------------------------------------------------------------
+void UARTSimHook(void (*fn)(u32 port, const s8 *line, u32 len));
+#endif
+
 #endif
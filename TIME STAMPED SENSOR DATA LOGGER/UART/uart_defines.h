@@ -0,0 +1,101 @@
+//uart_defines.h
+/*------------------------------------------------------------
+File: uart_defines.h
+Purpose:
+Contains macros for the buffered UART output layer of the
+LPC214x microcontroller.
+
+This file defines:
+- Serial ports and the traffic each one carries
+- Baud rates and transmit buffer sizes
+- UART register bit definitions
+
+Two ports are used when UART1_BULK is defined:
+- UART_CONSOLE (UART0): edit mode, boot and alert records
+- UART_BULK    (UART1): periodic INFO/STAT records and any
+                        other high-volume output
+Without it both names refer to UART0.
+
+With USB_CDC the USB virtual COM port is added as UART_USB
+and carries the bulk traffic instead.
+
+NOTE:
+TXD1/RXD1 are on P0.8/P0.9, which the LCD data bus uses on
+this board. Define UART1_BULK only on hardware where the LCD
+has been moved off those pins.
+------------------------------------------------------------*/
+
+#ifndef UART_DEFINES_H
+#define UART_DEFINES_H
+
+//------------------------------------------------------------
+// Ports
+//------------------------------------------------------------
+#define UART_CONSOLE     0
+#ifdef UART1_BULK
+#define UART_HW_PORTS    2       // UART0, UART1
+#else
+#define UART_HW_PORTS    1       // UART0
+#endif
+
+#ifdef USB_CDC
+#define UART_USB         UART_HW_PORTS
+#define UART_BULK        UART_USB
+#define UART_PORTS       (UART_HW_PORTS+1)
+#elif defined(UART1_BULK)
+#define UART_BULK        1
+#define UART_PORTS       UART_HW_PORTS
+#else
+#define UART_BULK        UART_CONSOLE
+#define UART_PORTS       UART_HW_PORTS
+#endif
+
+//------------------------------------------------------------
+// Baud rates
+//------------------------------------------------------------
+#define UART0_BAUD       9600
+#define UART1_BAUD       115200
+
+//------------------------------------------------------------
+// Transmit buffers (bytes, power of two)
+//------------------------------------------------------------
+#define UART0_TXBUF      256
+#define UART1_TXBUF      1024
+#define UART_FIFO_DEPTH  16      // Hardware TX FIFO
+
+//------------------------------------------------------------
+// Longest waits: one character takes ~1.04 ms at 9600 baud
+//------------------------------------------------------------
+#define UART_TX_TIMEOUT_US     5000      // For buffer space
+#define UART_RX_TIMEOUT_US     1000000
+#define UART_FLUSH_TIMEOUT_US  300000    // Full UART0 buffer
+
+//------------------------------------------------------------
+// Register bits
+//------------------------------------------------------------
+#define LCR_8N1          0x03    // 8-bit word, 1 stop bit
+#define LCR_DLAB         (1<<7)  // Divisor latch access
+#define LSR_RDR          (1<<0)  // Receive data ready
+#define LSR_THRE         (1<<5)  // TX holding register empty
+#define LSR_TEMT         (1<<6)  // Transmitter empty
+#define IER_THRE         (1<<1)  // THRE interrupt enable
+#define FCR_ENABLE       0x07    // FIFOs on and cleared
+
+//------------------------------------------------------------
+// Fractional divider (UxFDR = MULVAL << 4 | DIVADDVAL). With
+// DIVADDVAL > 0 the divisor latch must be 3 or more. Pairs
+// further off the wanted rate than UART_BAUD_ERR_PCT are not
+// used.
+//------------------------------------------------------------
+#define FDR_MUL_MAX      15
+#define FDR_DIV_MIN      3
+#define UART_BAUD_ERR_PCT 2
+
+//------------------------------------------------------------
+// Pin selection (PINSEL0)
+//------------------------------------------------------------
+#define UART0_PINSEL     0x00000005  // P0.0 TXD0, P0.1 RXD0
+#define UART1_PINSEL     0x00050000  // P0.8 TXD1, P0.9 RXD1
+#define UART1_PINMASK    0x000F0000
+
+#endif
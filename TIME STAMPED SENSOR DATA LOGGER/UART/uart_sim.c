@@ -0,0 +1,129 @@
+//uart_sim.c
+/*------------------------------------------------------------
+File: uart_sim.c
+Purpose:
+Virtual UART ports for host builds (HOST_BUILD).
+
+Stands in for the port half of uart.c (initialization,
+port selection, transmit and receive), so the logging code
+and the formatting functions of uart.c can run on a PC: the
+characters of each port are collected into a line, and
+every line ended by CR LF is handed to the hook set with
+UARTSimHook().
+
+Features:
+- One line buffer per port (UART_PORTS), so lines sent on
+  different ports do not mix
+- Lines longer than UART_SIM_LINE are cut, never overrun
+- Nothing is ever received; flushing returns at once
+
+NOTE:
+The caller's hook sees each line once; nothing is kept.
+------------------------------------------------------------*/
+
+#ifdef HOST_BUILD
+
+#include "types.h"        // User-defined data types
+#include "uart_defines.h" // Ports
+#include "uart.h"         // UART prototypes
+
+#define UART_SIM_LINE  512
+
+//------------------------------------------------------------
+// Line being sent on each port, and the selected port
+//------------------------------------------------------------
+static s8 simLine[UART_PORTS][UART_SIM_LINE];
+static u32 simLen[UART_PORTS];
+static u32 simPort = UART_CONSOLE;
+static void (*simHook)(u32 port, const s8 *line, u32 len);
+
+//------------------------------------------------------------
+// Function: InitUART / UARTSetPclk / UARTFlush
+// Purpose : Empty the line buffers / nothing to do
+//------------------------------------------------------------
+void InitUART(void)
+{
+        u32 i;
+
+        for (i = 0; i < UART_PORTS; i++)
+                simLen[i] = 0;
+        simPort = UART_CONSOLE;
+}
+
+void UARTSetPclk(u32 pclk)
+{
+        (void)pclk;
+}
+
+void UARTFlush(void)
+{
+}
+
+//------------------------------------------------------------
+// Function: UARTSelect / UARTGetPort
+// Purpose : Choose / read the port used by UARTTx*
+//------------------------------------------------------------
+u32 UARTSelect(u32 port)
+{
+        u32 prev = simPort;
+
+        if (port < UART_PORTS)
+                simPort = port;
+        return prev;
+}
+
+u32 UARTGetPort(void)
+{
+        return simPort;
+}
+
+//------------------------------------------------------------
+// Function: UARTRxReady / UARTRxChar
+// Purpose : No input on the virtual ports
+//------------------------------------------------------------
+u32 UARTRxReady(void)
+{
+        return 0;
+}
+
+s8 UARTRxChar(void)
+{
+        return 0;
+}
+
+//------------------------------------------------------------
+// Function: UARTSimHook
+// Purpose : Set the function that takes completed lines
+//------------------------------------------------------------
+void UARTSimHook(void (*fn)(u32 port, const s8 *line, u32 len))
+{
+        simHook = fn;
+}
+
+/*------------------------------------------------------------
+Function: UARTSimTx
+Purpose :
+Adds a character to the line of the selected port; CR is
+dropped and LF ends the line.
+------------------------------------------------------------*/
+void UARTSimTx(s8 ch)
+{
+        u32 p = simPort;
+
+        if (ch == '\r')
+                return;
+
+        if (ch == '\n')
+        {
+                simLine[p][simLen[p]] = 0;
+                if (simHook)
+                        simHook(p, simLine[p], simLen[p]);
+                simLen[p] = 0;
+                return;
+        }
+
+        if (simLen[p] < UART_SIM_LINE - 1)
+                simLine[p][simLen[p]++] = ch;
+}
+
+#endif
@@ -0,0 +1,174 @@
+//usb_defines.h
+/*------------------------------------------------------------
+File: usb_defines.h
+Purpose:
+Contains macros for the USB CDC-ACM virtual COM port.
+
+This file defines:
+- Endpoint addresses and packet sizes
+- Transmit / receive buffer sizes
+- USB standard and CDC class request codes
+- LPC214x USB device controller and SIE command values
+- USB clock (PLL1) and pin selection values
+------------------------------------------------------------*/
+
+#ifndef USB_DEFINES_H
+#define USB_DEFINES_H
+
+//------------------------------------------------------------
+// Endpoints (USB addresses, bit 7 set -> IN)
+// Logical EP2 is a double-buffered bulk endpoint on the
+// LPC214x: one packet can go out while the next is loaded.
+//------------------------------------------------------------
+#define USB_EP0_OUT        0x00
+#define USB_EP0_IN         0x80
+#define USB_EP_NOTIFY      0x81    // CDC interrupt IN (unused)
+#define USB_EP_BULK_OUT    0x02
+#define USB_EP_BULK_IN     0x82
+
+#define USB_EP0_SIZE       64
+#define USB_NOTIFY_SIZE    16
+#define USB_BULK_SIZE      64
+#define USB_BULK_BUFS      2       // Double-buffered
+
+#define USB_EP_IN          0x80
+#define USB_EP_NUM(ep)     ((ep) & 0x0F)
+
+//------------------------------------------------------------
+// Buffers (bytes, power of two)
+// The transmit buffer takes a full log record burst while
+// the host is between polls; the receive buffer only carries
+// NAK requests.
+//------------------------------------------------------------
+#define USB_TXBUF          2048
+#define USB_RXBUF          128
+
+//------------------------------------------------------------
+// Longest wait for transmit buffer space once the host has
+// opened the port (a full buffer drains in ~2 ms)
+//------------------------------------------------------------
+#define USB_TX_TIMEOUT_US  20000
+
+//------------------------------------------------------------
+// Setup packet fields
+//------------------------------------------------------------
+#define REQ_DIR_IN         0x80
+#define REQ_TYPE_MASK      0x60
+#define REQ_TYPE_STANDARD  0x00
+#define REQ_TYPE_CLASS     0x20
+#define REQ_RCPT_MASK      0x1F
+#define REQ_RCPT_DEVICE    0
+#define REQ_RCPT_INTERFACE 1
+#define REQ_RCPT_ENDPOINT  2
+
+//------------------------------------------------------------
+// Standard requests (USB 2.0, chapter 9)
+//------------------------------------------------------------
+#define REQ_GET_STATUS        0
+#define REQ_CLEAR_FEATURE     1
+#define REQ_SET_FEATURE       3
+#define REQ_SET_ADDRESS       5
+#define REQ_GET_DESCRIPTOR    6
+#define REQ_GET_CONFIGURATION 8
+#define REQ_SET_CONFIGURATION 9
+#define REQ_GET_INTERFACE     10
+#define REQ_SET_INTERFACE     11
+
+#define FEATURE_ENDPOINT_HALT 0
+
+#define DESC_DEVICE           1
+#define DESC_CONFIGURATION    2
+#define DESC_STRING           3
+#define DESC_INTERFACE        4
+#define DESC_ENDPOINT         5
+#define DESC_CS_INTERFACE     0x24
+
+//------------------------------------------------------------
+// CDC-ACM class requests
+//------------------------------------------------------------
+#define CDC_SET_LINE_CODING        0x20
+#define CDC_GET_LINE_CODING        0x21
+#define CDC_SET_CONTROL_LINE_STATE 0x22
+#define CDC_SEND_BREAK             0x23
+
+#define CDC_LINE_CODING_SIZE       7
+#define CDC_DTR                    (1<<0)
+
+//------------------------------------------------------------
+// Device identity
+//------------------------------------------------------------
+#define USB_VID            0x1FC9  // NXP
+#define USB_PID            0x2047
+#define USB_BCD_DEVICE     0x0100
+
+//------------------------------------------------------------
+// USBDevIntSt / USBDevIntEn / USBDevIntClr bits
+//------------------------------------------------------------
+#define DEV_EP_SLOW        (1<<2)
+#define DEV_STAT           (1<<3)
+#define DEV_CCEMPTY        (1<<4)
+#define DEV_CDFULL         (1<<5)
+#define DEV_EP_RLZED       (1<<8)
+
+//------------------------------------------------------------
+// USBCtrl and USBRxPLen bits
+//------------------------------------------------------------
+#define CTRL_RD_EN         (1<<0)
+#define CTRL_WR_EN         (1<<1)
+#define CTRL_LOG_EP(n)     ((n)<<2)
+#define RXPLEN_LEN         0x3FF
+#define RXPLEN_PKT_RDY     (1<<11)
+
+//------------------------------------------------------------
+// SIE (Serial Interface Engine) commands
+//------------------------------------------------------------
+#define SIE_PHASE_CMD      0x0500
+#define SIE_PHASE_WRITE    0x0100
+#define SIE_PHASE_READ     0x0200
+
+#define SIE_SET_ADDRESS    0xD0
+#define SIE_CONFIGURE      0xD8
+#define SIE_SET_MODE       0xF3
+#define SIE_DEV_STATUS     0xFE
+#define SIE_SELECT_EP      0x00    // + physical endpoint
+#define SIE_SET_EP_STATUS  0x40    // + physical endpoint
+#define SIE_CLEAR_BUFFER   0xF2
+#define SIE_VALIDATE       0xFA
+
+#define SIE_ADDR_EN        (1<<7)  // Set Address: device enable
+#define SIE_MODE_INAK_BI   (1<<5)  // Set Mode: NAK interrupts, bulk IN
+#define SIE_STAT_CON       (1<<0)  // Device status: connect
+#define SIE_STAT_RST       (1<<4)  //                bus reset
+#define SIE_EP_FE          (1<<0)  // Select EP: full / empty
+#define SIE_EP_STP         (1<<2)  //            setup packet
+#define SIE_EP_B1_FULL     (1<<5)
+#define SIE_EP_B2_FULL     (1<<6)
+#define SIE_EP_ST          (1<<0)  // Set EP status: stall
+
+//------------------------------------------------------------
+// Physical endpoint of a USB address: 2 * number + direction
+// Double-buffered logical endpoints: 2, 3, 5, 6, 8, 9, ...
+//------------------------------------------------------------
+#define USB_EP_PHYS(ep)    ((USB_EP_NUM(ep) << 1) | ((ep) >> 7))
+#define USB_EP_DOUBLE(ep)  (USB_EP_NUM(ep) % 3 != 1 && USB_EP_NUM(ep) != 0)
+
+//------------------------------------------------------------
+// USB clock: PLL1 x4 from the 12 MHz crystal -> 48 MHz
+// (Fcco = 48 MHz * 2 * P = 192 MHz with P = 2)
+//------------------------------------------------------------
+#define PLL1CFG_VAL        0x23    // M-1 = 3, PSEL = 01 (P = 2)
+#define PLL1_LOCK          (1<<10)
+#define PLL1_ENABLE        (1<<0)
+#define PLL1_CONNECT       (1<<1)
+#define PLL1_LOCK_TIMEOUT_US 2000
+#define USB_SIE_TIMEOUT_US 100
+
+#define PCONP_PCUSB        (1<<31)
+
+//------------------------------------------------------------
+// Pins (PINSEL1): P0.23 VBUS sense, P0.31 soft-connect
+//------------------------------------------------------------
+#define USB_PINSEL1        0x80004000
+#define USB_PINMASK1       0xC000C000
+
+#endif
@@ -0,0 +1,600 @@
+//usbcdc.c
+/*------------------------------------------------------------
+File: usbcdc.c
+Purpose:
+Implements a USB CDC-ACM virtual COM port on top of a
+device controller backend (usbhw.h).
+
+Features:
+- Enumeration: standard requests of USB chapter 9, device,
+  configuration and string descriptors
+- CDC-ACM class requests: line coding (kept, not used) and
+  DTR, which tells whether a host program has the port open
+- Output queued in a ring and moved to the bulk IN endpoint
+  in 64-byte packets, keeping both endpoint buffers loaded;
+  a zero-length packet ends a transfer that filled its last
+  packet, so the host read returns at once
+- Input taken from the bulk OUT endpoint into a ring; when
+  the ring is full the packet stays in the endpoint and the
+  host is NAKed until main() makes room
+
+Only packet moves go through the backend, so the same code
+runs on the target (usbHwLpc) and on a PC (usbHwSim).
+------------------------------------------------------------*/
+
+#include "types.h"          // User-defined data types
+#include "queue.h"          // Transmit / receive rings
+#include "usb_defines.h"    // Endpoints, requests, sizes
+#include "usbhw.h"          // Device controller backends
+#include "usbcdc.h"         // Prototypes and counters
+
+//------------------------------------------------------------
+// Counters
+//------------------------------------------------------------
+UsbCdcStats usbCdcStats;
+
+//------------------------------------------------------------
+// Descriptors
+//------------------------------------------------------------
+static const u8 deviceDesc[] =
+{
+        18, DESC_DEVICE,
+        0x10, 0x01,                     // USB 1.1
+        0x02, 0x00, 0x00,               // Class: CDC
+        USB_EP0_SIZE,
+        USB_VID & 0xFF, USB_VID >> 8,
+        USB_PID & 0xFF, USB_PID >> 8,
+        USB_BCD_DEVICE & 0xFF, USB_BCD_DEVICE >> 8,
+        1, 2, 3,                        // Manufacturer, product, serial
+        1                               // Configurations
+};
+
+#define CONFIG_DESC_LEN  67
+
+static const u8 configDesc[CONFIG_DESC_LEN] =
+{
+        9, DESC_CONFIGURATION, CONFIG_DESC_LEN, 0,
+        2, 1, 0,                        // Interfaces, value, no string
+        0xC0, 50,                       // Self powered, 100 mA
+
+        // Interface 0: communication class, abstract control
+        9, DESC_INTERFACE, 0, 0, 1, 0x02, 0x02, 0x01, 0,
+        5, DESC_CS_INTERFACE, 0x00, 0x10, 0x01,        // Header, CDC 1.10
+        5, DESC_CS_INTERFACE, 0x01, 0x00, 1,           // Call management
+        4, DESC_CS_INTERFACE, 0x02, 0x02,              // ACM: line coding, DTR
+        5, DESC_CS_INTERFACE, 0x06, 0, 1,              // Union: 0 controls 1
+        7, DESC_ENDPOINT, USB_EP_NOTIFY, 0x03, USB_NOTIFY_SIZE, 0, 255,
+
+        // Interface 1: data class, bulk IN / OUT
+        9, DESC_INTERFACE, 1, 0, 2, 0x0A, 0x00, 0x00, 0,
+        7, DESC_ENDPOINT, USB_EP_BULK_IN, 0x02, USB_BULK_SIZE, 0, 0,
+        7, DESC_ENDPOINT, USB_EP_BULK_OUT, 0x02, USB_BULK_SIZE, 0, 0
+};
+
+//------------------------------------------------------------
+// Strings 1..3, sent as UTF-16 (string 0 is the language)
+//------------------------------------------------------------
+static const char *strings[] = { "LPC214x", "Sensor Data Logger", "0001" };
+
+#define STRING_COUNT  (sizeof(strings) / sizeof(strings[0]))
+
+//------------------------------------------------------------
+// Control transfer state
+//------------------------------------------------------------
+#define CTRL_IDLE       0
+#define CTRL_DATA_IN    1      // Reply being sent
+#define CTRL_DATA_OUT   2      // Waiting for host data
+#define CTRL_STATUS_IN  3      // Zero-length status sent
+
+static UsbHw *usb;
+static u8  setup[8];
+static u8  ctrlBuf[USB_EP0_SIZE];
+static const u8 *ctrlPtr;
+static u32 ctrlLeft, ctrlZlp, ctrlState;
+static u32 addrPending, newAddr;
+
+//------------------------------------------------------------
+// Device and CDC state
+//------------------------------------------------------------
+static volatile u32 configured, lineState;
+static u32 halted;                     // Halt bit per physical EP
+static u8  lineCoding[CDC_LINE_CODING_SIZE] =
+        { 0x00, 0xC2, 0x01, 0x00, 0, 0, 8 };   // 115200 8N1
+
+//------------------------------------------------------------
+// Data rings and the packets moved to / from the endpoints
+//------------------------------------------------------------
+static Queue txQ, rxQ;
+static u8 txBuf[USB_TXBUF], rxBuf[USB_RXBUF];
+static u8 txPkt[USB_BULK_SIZE], rxPkt[USB_BULK_SIZE];
+static volatile u32 txInFlight;        // IN buffers loaded, not yet taken
+static u32 txZlp;                      // Last packet was full
+static volatile u32 rxHeld;            // OUT packet left for lack of room
+
+// Little-endian setup fields, as u32 so they compare with lengths
+#define WVALUE   ((u32)setup[2] | ((u32)setup[3] << 8))
+#define WINDEX   ((u32)setup[4] | ((u32)setup[5] << 8))
+#define WLENGTH  ((u32)setup[6] | ((u32)setup[7] << 8))
+
+/*------------------------------------------------------------
+Function: TxPump
+Purpose :
+Fills free bulk IN buffers from the transmit ring. Called
+from the endpoint event, or from main() with events masked.
+------------------------------------------------------------*/
+static void TxPump(void)
+{
+        u32 n, room;
+
+        if (!configured)
+                return;
+
+        for (room = usb->avail(USB_EP_BULK_IN); room; room--)
+        {
+                n = QueuePopN(&txQ, txPkt, USB_BULK_SIZE);
+                if (n == 0 && !txZlp)
+                        break;
+
+                usb->write(USB_EP_BULK_IN, txPkt, n);
+                txZlp = (n == USB_BULK_SIZE);
+                usbCdcStats.txPackets++;
+        }
+
+        // Two completions may raise one event, so the count is
+        // taken from the endpoint rather than from events
+        txInFlight = USB_BULK_BUFS - room;
+}
+
+/*------------------------------------------------------------
+Function: RxPump
+Purpose :
+Moves received bulk OUT packets into the receive ring while
+a whole packet fits.
+------------------------------------------------------------*/
+static void RxPump(void)
+{
+        u32 n;
+
+        rxHeld = 0;
+        while (usb->avail(USB_EP_BULK_OUT))
+        {
+                if (QueueSpace(&rxQ) < USB_BULK_SIZE)
+                {
+                        rxHeld = 1;
+                        return;
+                }
+                n = usb->read(USB_EP_BULK_OUT, rxPkt, USB_BULK_SIZE);
+                QueuePushN(&rxQ, rxPkt, n);
+                usbCdcStats.rxPackets++;
+        }
+}
+
+//------------------------------------------------------------
+// Function: CtrlIn
+// Purpose : Send the next packet of a control reply
+//------------------------------------------------------------
+static void CtrlIn(void)
+{
+        u32 n = (ctrlLeft < USB_EP0_SIZE) ? ctrlLeft : USB_EP0_SIZE;
+
+        usb->write(USB_EP0_IN, ctrlPtr, n);
+        ctrlPtr += n;
+        ctrlLeft -= n;
+
+        // A full packet is followed by more data or by a ZLP
+        if (n == USB_EP0_SIZE && (ctrlLeft || ctrlZlp))
+                ctrlState = CTRL_DATA_IN;
+        else
+                ctrlState = CTRL_IDLE;
+}
+
+//------------------------------------------------------------
+// Function: Reply
+// Purpose : Start the data stage of an IN request, cut to
+//           the length the host asked for
+//------------------------------------------------------------
+static void Reply(const u8 *data, u32 len)
+{
+        if (len > WLENGTH)
+                len = WLENGTH;
+
+        ctrlPtr = data;
+        ctrlLeft = len;
+        ctrlZlp = (len < WLENGTH && len % USB_EP0_SIZE == 0);
+        CtrlIn();
+}
+
+//------------------------------------------------------------
+// Function: Status
+// Purpose : Zero-length status stage of a no-data request
+//------------------------------------------------------------
+static void Status(void)
+{
+        usb->write(USB_EP0_IN, ctrlBuf, 0);
+        ctrlState = CTRL_STATUS_IN;
+}
+
+//------------------------------------------------------------
+// Function: StringDesc
+// Purpose : Build string descriptor idx in ctrlBuf
+// Return  : 1 -> built, 0 -> no such string
+//------------------------------------------------------------
+static u32 StringDesc(u32 idx)
+{
+        const char *s;
+        u32 n = 2;
+
+        if (idx == 0)
+        {
+                ctrlBuf[2] = 0x09;             // English (US)
+                ctrlBuf[3] = 0x04;
+                n = 4;
+        }
+        else if (idx <= STRING_COUNT)
+        {
+                for (s = strings[idx - 1]; *s && n < USB_EP0_SIZE; s++)
+                {
+                        ctrlBuf[n++] = *s;
+                        ctrlBuf[n++] = 0;
+                }
+        }
+        else
+                return 0;
+
+        ctrlBuf[0] = n;
+        ctrlBuf[1] = DESC_STRING;
+        Reply(ctrlBuf, n);
+        return 1;
+}
+
+//------------------------------------------------------------
+// Function: Descriptor
+// Purpose : Answer GET_DESCRIPTOR
+//------------------------------------------------------------
+static u32 Descriptor(u32 type, u32 idx)
+{
+        switch (type)
+        {
+        case DESC_DEVICE:
+                Reply(deviceDesc, sizeof(deviceDesc));
+                return 1;
+        case DESC_CONFIGURATION:
+                Reply(configDesc, sizeof(configDesc));
+                return 1;
+        case DESC_STRING:
+                return StringDesc(idx);
+        }
+        return 0;
+}
+
+/*------------------------------------------------------------
+Function: Configure
+Purpose :
+SET_CONFIGURATION 1 turns the data endpoints on, 0 turns
+them off. The port counts as closed until the host sets DTR.
+------------------------------------------------------------*/
+static void Configure(u32 on)
+{
+        usb->configure(on);
+        configured = on;
+        lineState = 0;
+        halted = 0;
+        txInFlight = 0;
+        txZlp = 0;
+        if (on)
+                RxPump();
+}
+
+//------------------------------------------------------------
+// Function: Halt
+// Purpose : Set / clear the halt of a data endpoint
+//------------------------------------------------------------
+static void Halt(u32 ep, u32 on)
+{
+        usb->stall(ep, on);
+        if (on)
+                halted |= 1 << USB_EP_PHYS(ep);
+        else
+                halted &= ~(1 << USB_EP_PHYS(ep));
+}
+
+//------------------------------------------------------------
+// Function: StandardRequest
+// Purpose : Chapter 9 requests
+// Return  : 1 -> handled, 0 -> stall
+//------------------------------------------------------------
+static u32 StandardRequest(void)
+{
+        u32 rcpt = setup[0] & REQ_RCPT_MASK;
+
+        switch (setup[1])
+        {
+        case REQ_GET_STATUS:
+                ctrlBuf[0] = ctrlBuf[1] = 0;
+                if (rcpt == REQ_RCPT_DEVICE)
+                        ctrlBuf[0] = 1;                // Self powered
+                else if (rcpt == REQ_RCPT_ENDPOINT)
+                        ctrlBuf[0] = (halted >> USB_EP_PHYS(WINDEX)) & 1;
+                Reply(ctrlBuf, 2);
+                return 1;
+
+        case REQ_CLEAR_FEATURE:
+        case REQ_SET_FEATURE:
+                if (rcpt == REQ_RCPT_ENDPOINT)
+                {
+                        if (WVALUE != FEATURE_ENDPOINT_HALT || USB_EP_NUM(WINDEX) == 0)
+                                return 0;
+                        Halt(WINDEX & 0xFF, setup[1] == REQ_SET_FEATURE);
+                }
+                Status();                              // Remote wakeup: ignored
+                return 1;
+
+        case REQ_SET_ADDRESS:
+                newAddr = WVALUE & 0x7F;               // Applied after status
+                addrPending = 1;
+                Status();
+                return 1;
+
+        case REQ_GET_DESCRIPTOR:
+                return Descriptor(WVALUE >> 8, WVALUE & 0xFF);
+
+        case REQ_GET_CONFIGURATION:
+                ctrlBuf[0] = configured;
+                Reply(ctrlBuf, 1);
+                return 1;
+
+        case REQ_SET_CONFIGURATION:
+                if (WVALUE > 1)
+                        return 0;
+                Configure(WVALUE);
+                Status();
+                return 1;
+
+        case REQ_GET_INTERFACE:
+                ctrlBuf[0] = 0;
+                Reply(ctrlBuf, 1);
+                return 1;
+
+        case REQ_SET_INTERFACE:
+                if (WVALUE != 0)
+                        return 0;
+                Status();
+                return 1;
+        }
+        return 0;
+}
+
+//------------------------------------------------------------
+// Function: ClassRequest
+// Purpose : CDC-ACM requests
+// Return  : 1 -> handled, 0 -> stall
+//------------------------------------------------------------
+static u32 ClassRequest(void)
+{
+        switch (setup[1])
+        {
+        case CDC_SET_LINE_CODING:
+                ctrlState = CTRL_DATA_OUT;             // 7 bytes follow
+                return 1;
+
+        case CDC_GET_LINE_CODING:
+                Reply(lineCoding, CDC_LINE_CODING_SIZE);
+                return 1;
+
+        case CDC_SET_CONTROL_LINE_STATE:
+                lineState = WVALUE;
+                Status();
+                return 1;
+
+        case CDC_SEND_BREAK:
+                Status();
+                return 1;
+        }
+        return 0;
+}
+
+/*------------------------------------------------------------
+Function: Setup
+Purpose :
+Decodes a setup packet. A request that is not supported
+stalls EP0; the stall ends with the next setup packet.
+------------------------------------------------------------*/
+static void Setup(void)
+{
+        u32 ok = 0;
+
+        usb->read(USB_EP0_OUT, setup, sizeof(setup));
+        ctrlState = CTRL_IDLE;
+        addrPending = 0;
+
+        switch (setup[0] & REQ_TYPE_MASK)
+        {
+        case REQ_TYPE_STANDARD:
+                ok = StandardRequest();
+                break;
+        case REQ_TYPE_CLASS:
+                ok = ClassRequest();
+                break;
+        }
+
+        if (!ok)
+                usb->stall(USB_EP0_IN, 1);
+}
+
+/*------------------------------------------------------------
+Function: UsbBusReset
+Purpose :
+Called by the backend on a USB bus reset: the device is back
+to address 0, unconfigured.
+------------------------------------------------------------*/
+void UsbBusReset(void)
+{
+        configured = 0;
+        lineState = 0;
+        halted = 0;
+        ctrlState = CTRL_IDLE;
+        addrPending = 0;
+        txInFlight = 0;
+        txZlp = 0;
+        rxHeld = 0;
+        usbCdcStats.resets++;
+}
+
+/*------------------------------------------------------------
+Function: UsbEndpointEvent
+Purpose :
+Called by the backend for every endpoint event (its ISR on
+the target).
+------------------------------------------------------------*/
+void UsbEndpointEvent(u32 ep, u32 ev)
+{
+        u32 n;
+
+        switch (ep)
+        {
+        case USB_EP0_OUT:
+                if (ev == USB_EV_SETUP)
+                        Setup();
+                else if (ctrlState == CTRL_DATA_OUT)
+                {
+                        n = usb->read(USB_EP0_OUT, ctrlBuf, sizeof(ctrlBuf));
+                        if (setup[1] == CDC_SET_LINE_CODING && n >= CDC_LINE_CODING_SIZE)
+                                for (n = 0; n < CDC_LINE_CODING_SIZE; n++)
+                                        lineCoding[n] = ctrlBuf[n];
+                        Status();
+                }
+                else
+                        usb->read(USB_EP0_OUT, ctrlBuf, sizeof(ctrlBuf));   // Status stage
+                break;
+
+        case USB_EP0_IN:
+                if (ctrlState == CTRL_DATA_IN)
+                        CtrlIn();
+                else if (ctrlState == CTRL_STATUS_IN)
+                {
+                        if (addrPending)
+                                usb->setAddress(newAddr);
+                        addrPending = 0;
+                        ctrlState = CTRL_IDLE;
+                }
+                break;
+
+        case USB_EP_BULK_IN:
+                TxPump();
+                break;
+
+        case USB_EP_BULK_OUT:
+                RxPump();
+                break;
+        }
+}
+
+/*------------------------------------------------------------
+Function: InitUsbCdc
+Purpose :
+Sets up the rings and starts the backend, which connects to
+the bus; enumeration then runs from endpoint events.
+------------------------------------------------------------*/
+void InitUsbCdc(UsbHw *hw)
+{
+        usb = hw;
+        QueueInit(&txQ, txBuf, 1, USB_TXBUF);
+        QueueInit(&rxQ, rxBuf, 1, USB_RXBUF);
+
+        usbCdcStats.resets = usbCdcStats.txPackets = 0;
+        usbCdcStats.rxPackets = usbCdcStats.dropped = 0;
+        UsbBusReset();
+        usbCdcStats.resets = 0;
+
+        usb->init();
+}
+
+/*------------------------------------------------------------
+Function: UsbCdcOpen
+Purpose :
+Returns 1 while the host has the port open.
+------------------------------------------------------------*/
+u32 UsbCdcOpen(void)
+{
+        return configured && (lineState & CDC_DTR);
+}
+
+/*------------------------------------------------------------
+Function: UsbCdcKick
+Purpose :
+Loads queued output into free IN buffers from main(), with
+endpoint events masked so TxPump has one caller at a time.
+------------------------------------------------------------*/
+void UsbCdcKick(void)
+{
+        usb->irq(0);
+        TxPump();
+        usb->irq(1);
+}
+
+/*------------------------------------------------------------
+Function: UsbCdcTxChar
+Purpose :
+Queues one character. The endpoint is only kicked when no
+packet is in flight, or when a whole packet is waiting and a
+buffer is free; otherwise the next IN event picks the data
+up, so most characters cost no controller access.
+------------------------------------------------------------*/
+u32 UsbCdcTxChar(u8 c)
+{
+        if (!UsbCdcOpen())
+        {
+                usbCdcStats.dropped++;
+                return 1;
+        }
+
+        if (!QueuePush(&txQ, &c))
+                return 0;
+
+        if (txInFlight == 0 ||
+            (txInFlight < USB_BULK_BUFS && QueueCount(&txQ) >= USB_BULK_SIZE))
+                UsbCdcKick();
+        return 1;
+}
+
+/*------------------------------------------------------------
+Function: UsbCdcTxIdle
+Purpose :
+Returns 1 when all output has been taken by the host, or
+nobody is listening.
+------------------------------------------------------------*/
+u32 UsbCdcTxIdle(void)
+{
+        if (!UsbCdcOpen())
+                return 1;
+        return QueueCount(&txQ) == 0 && txInFlight == 0;
+}
+
+/*------------------------------------------------------------
+Function: UsbCdcRxReady
+Purpose :
+Returns 1 when a received character is waiting.
+------------------------------------------------------------*/
+u32 UsbCdcRxReady(void)
+{
+        return QueueCount(&rxQ) != 0;
+}
+
+/*------------------------------------------------------------
+Function: UsbCdcRxChar
+Purpose :
+Takes one received character. A packet left in the endpoint
+for lack of room is taken in once a whole packet fits.
+------------------------------------------------------------*/
+u32 UsbCdcRxChar(u8 *c)
+{
+        u32 got = QueuePop(&rxQ, c);
+
+        if (rxHeld && QueueSpace(&rxQ) >= USB_BULK_SIZE)
+        {
+                usb->irq(0);
+                RxPump();
+                usb->irq(1);
+        }
+        return got;
+}
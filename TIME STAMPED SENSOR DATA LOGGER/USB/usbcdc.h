@@ -0,0 +1,92 @@
+//usbcdc.h
+/*------------------------------------------------------------
+File: usbcdc.h
+Purpose:
+Header file for the USB CDC-ACM virtual COM port.
+
+The device enumerates as a standard CDC-ACM serial port
+(ttyACM / COMx, no driver needed) and carries the same text
+records as the UARTs, but at bulk USB rates: 64-byte packets
+on a double-buffered endpoint, well over 500 KB/s to a host
+that keeps reading.
+
+uart.c serves it as the port UART_USB (built with USB_CDC),
+so every UARTTx* / UARTRx* function works on it unchanged.
+Output is discarded while no host has the port open (DTR
+low), so an unplugged cable never stalls logging.
+
+NOTE:
+The USB controller needs CCLK >= 18 MHz; the port is only
+served under CLK_PERF.
+------------------------------------------------------------*/
+
+#ifndef __USBCDC_H__
+#define __USBCDC_H__
+
+#include "types.h"
+#include "usbhw.h"
+#include "usb_defines.h"
+
+//------------------------------------------------------------
+// Counters
+//------------------------------------------------------------
+typedef struct
+{
+        u32 resets;     // Bus resets seen
+        u32 txPackets;  // Bulk IN packets loaded
+        u32 rxPackets;  // Bulk OUT packets taken
+        u32 dropped;    // Bytes discarded with the port closed
+} UsbCdcStats;
+
+extern UsbCdcStats usbCdcStats;
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: InitUsbCdc
+// Purpose : Attach a device controller backend, start it and
+//           connect to the bus
+// Note    : Call after InitVIC
+//------------------------------------------------------------
+void InitUsbCdc(UsbHw *hw);
+
+//------------------------------------------------------------
+// Function: UsbCdcOpen
+// Purpose : 1 while the device is configured and a host
+//           program has the port open (DTR set)
+//------------------------------------------------------------
+u32 UsbCdcOpen(void);
+
+//------------------------------------------------------------
+// Function: UsbCdcTxChar
+// Purpose : Queue one character for the host
+// Return  : 1 -> queued (or discarded, port closed)
+//           0 -> buffer full, try again after UsbCdcKick
+//------------------------------------------------------------
+u32 UsbCdcTxChar(u8 c);
+
+//------------------------------------------------------------
+// Function: UsbCdcKick
+// Purpose : Load queued output into free IN buffers from
+//           main(); works with interrupts masked
+//------------------------------------------------------------
+void UsbCdcKick(void);
+
+//------------------------------------------------------------
+// Function: UsbCdcTxIdle
+// Purpose : 1 when nothing is queued or waiting in the
+//           endpoint buffers
+//------------------------------------------------------------
+u32 UsbCdcTxIdle(void);
+
+//------------------------------------------------------------
+// Function: UsbCdcRxReady / UsbCdcRxChar
+// Purpose : Check for / take one character sent by the host
+// Return  : UsbCdcRxChar -> 1 and *c filled, 0 -> none
+//------------------------------------------------------------
+u32 UsbCdcRxReady(void);
+u32 UsbCdcRxChar(u8 *c);
+
+#endif
@@ -0,0 +1,103 @@
+//usbhw.h
+/*------------------------------------------------------------
+File: usbhw.h
+Purpose:
+Endpoint interface between the USB CDC core and a device
+controller.
+
+The core only moves whole packets: write() loads one IN
+packet, read() takes one OUT packet, avail() tells how many
+buffers of an endpoint can be used right now (free IN
+buffers, full OUT buffers). write() is only called with a
+free buffer. Endpoints are given by their USB address
+(USB_EP_xxx).
+
+A backend reports bus events by calling UsbBusReset() and
+UsbEndpointEvent() (usbcdc.c), from its ISR on the target.
+
+Backends:
+- usbHwLpc : LPC214x USB device controller (target)
+- usbHwSim : simulated endpoints with a host side driven by
+             UsbSim* calls (HOST_BUILD only)
+------------------------------------------------------------*/
+
+#ifndef __USBHW_H__
+#define __USBHW_H__
+
+#include "types.h"
+
+//------------------------------------------------------------
+// Endpoint events
+//------------------------------------------------------------
+#define USB_EV_SETUP   0       // Setup packet in EP0 OUT
+#define USB_EV_OUT     1       // OUT packet received
+#define USB_EV_IN      2       // IN packet taken by the host
+
+//------------------------------------------------------------
+// Device controller operations
+//------------------------------------------------------------
+typedef struct
+{
+        void (*init)(void);                               // Clock, pins, connect
+        void (*setAddress)(u32 addr);                     // After SET_ADDRESS
+        void (*configure)(u32 on);                        // Data endpoints on/off
+        void (*stall)(u32 ep, u32 on);                    // Set / clear halt
+        void (*write)(u32 ep, const u8 *buf, u32 len);    // Load IN packet
+        u32  (*read)(u32 ep, u8 *buf, u32 max);           // Take OUT packet, length
+        u32  (*avail)(u32 ep);                            // Usable buffers
+        void (*irq)(u32 on);                              // Mask / unmask events
+} UsbHw;
+
+//------------------------------------------------------------
+// Called by a backend (implemented in usbcdc.c)
+//------------------------------------------------------------
+void UsbBusReset(void);
+void UsbEndpointEvent(u32 ep, u32 ev);
+
+//------------------------------------------------------------
+// Available backends
+//------------------------------------------------------------
+#ifdef HOST_BUILD
+extern UsbHw usbHwSim;
+
+//------------------------------------------------------------
+// Function: UsbSimReset
+// Purpose : Empty every endpoint and signal a bus reset
+//------------------------------------------------------------
+void UsbSimReset(void);
+
+//------------------------------------------------------------
+// Function: UsbSimControl
+// Purpose : Run one control transfer as the host
+// Parameters:
+//   setup -> 8-byte setup packet
+//   data  -> data stage (sent for OUT, filled for IN)
+// Return  : Bytes of data stage moved, USB_SIM_STALL if the
+//           device stalled the request
+//------------------------------------------------------------
+#define USB_SIM_STALL  0xFFFFFFFF
+u32 UsbSimControl(const u8 *setup, u8 *data);
+
+//------------------------------------------------------------
+// Function: UsbSimIn / UsbSimOut
+// Purpose : Take one IN packet from / put one OUT packet into
+//           an endpoint, as the host
+// Return  : UsbSimIn  -> packet length, USB_SIM_NAK if none
+//           UsbSimOut -> 1 -> accepted, 0 -> NAK (buffers full)
+//------------------------------------------------------------
+#define USB_SIM_NAK    0xFFFFFFFF
+u32 UsbSimIn(u32 ep, u8 *buf);
+u32 UsbSimOut(u32 ep, const u8 *buf, u32 len);
+
+//------------------------------------------------------------
+// Function: UsbSimLoopback
+// Purpose : Move packets from bulk IN back into bulk OUT
+//           while OUT has room
+// Return  : Packets moved
+//------------------------------------------------------------
+u32 UsbSimLoopback(void);
+#else
+extern UsbHw usbHwLpc;
+#endif
+
+#endif
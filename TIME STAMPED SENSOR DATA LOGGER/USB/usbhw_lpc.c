@@ -0,0 +1,340 @@
+//usbhw_lpc.c
+/*------------------------------------------------------------
+File: usbhw_lpc.c
+Purpose:
+USB device controller backend for the LPC214x (slave mode,
+no DMA).
+
+Features:
+- 48 MHz USB clock from PLL1, independent of the CPU clock
+  profile in PLL0
+- VBUS sense on P0.23, soft-connect on P0.31
+- Endpoints realized at SET_CONFIGURATION; the bulk pair is
+  logical EP2, which the controller double-buffers
+- Packet moves through USBRxData / USBTxData, buffer status
+  through the SIE; every SIE handshake is bounded and counted
+  under WAIT_USB
+- One ISR for bus reset and all endpoint events
+------------------------------------------------------------*/
+
+#ifndef HOST_BUILD
+
+#include <lpc214x.h>           // LPC214x registers incl. USB, PLL1
+#include "types.h"             // User-defined data types
+#include "timer.h"             // Deadlines for bounded waits
+#include "vic.h"               // Interrupt registration and ISR macros
+#include "usb_defines.h"       // Controller bits, SIE commands
+#include "usbhw.h"             // Backend interface
+
+//------------------------------------------------------------
+// Function: SieWait
+// Purpose : Wait for a USBDevIntSt handshake bit, bounded
+// Return  : 1 -> seen (and cleared), 0 -> timed out
+//------------------------------------------------------------
+static u32 SieWait(u32 bit)
+{
+        u32 dl = DeadlineSet(USB_SIE_TIMEOUT_US);
+
+        while (!(USBDevIntSt & bit))
+                if (DeadlinePassed(dl))
+                {
+                        WaitTimeout(WAIT_USB);
+                        return 0;
+                }
+        USBDevIntClr = bit;
+        return 1;
+}
+
+//------------------------------------------------------------
+// Function: SieCmd / SieWrite / SieRead
+// Purpose : SIE command with no data, one data byte written,
+//           one data byte read
+//------------------------------------------------------------
+static void SieCmd(u32 cmd)
+{
+        USBDevIntClr = DEV_CCEMPTY;
+        USBCmdCode = SIE_PHASE_CMD | (cmd << 16);
+        SieWait(DEV_CCEMPTY);
+}
+
+static void SieWrite(u32 cmd, u32 data)
+{
+        SieCmd(cmd);
+        USBCmdCode = SIE_PHASE_WRITE | (data << 16);
+        SieWait(DEV_CCEMPTY);
+}
+
+static u32 SieRead(u32 cmd)
+{
+        SieCmd(cmd);
+        USBDevIntClr = DEV_CDFULL;
+        USBCmdCode = SIE_PHASE_READ | (cmd << 16);
+        if (!SieWait(DEV_CDFULL))
+                return 0;
+        return USBCmdData;
+}
+
+//------------------------------------------------------------
+// Function: Realize
+// Purpose : Give an endpoint its buffer and enable it
+//------------------------------------------------------------
+static void Realize(u32 ep, u32 size)
+{
+        u32 phys = USB_EP_PHYS(ep);
+
+        USBDevIntClr = DEV_EP_RLZED;
+        USBReEp |= 1 << phys;
+        USBEpInd = phys;
+        USBMaxPSize = size;
+        SieWait(DEV_EP_RLZED);
+
+        USBEpIntEn |= 1 << phys;
+        SieWrite(SIE_SET_EP_STATUS + phys, 0);   // Enabled, toggle reset
+}
+
+//------------------------------------------------------------
+// Function: BusReset
+// Purpose : Back to EP0 only after a USB reset
+//------------------------------------------------------------
+static void BusReset(void)
+{
+        USBEpIntClr = 0xFFFFFFFF;
+        USBEpIntEn = (1 << 0) | (1 << 1);
+        UsbBusReset();
+}
+
+/*------------------------------------------------------------
+Function: USB_ISR
+Purpose :
+Device status (bus reset) and endpoint interrupts. Clearing
+an endpoint interrupt makes the SIE return the endpoint
+status, which tells a setup packet from an OUT packet.
+------------------------------------------------------------*/
+void USB_ISR(void) __irq
+{
+        u32 dev, pending, phys, st, ep;
+
+        VIC_ISR_ENTER();
+        dev = USBDevIntSt;
+
+        if (dev & DEV_STAT)
+        {
+                USBDevIntClr = DEV_STAT;
+                if (SieRead(SIE_DEV_STATUS) & SIE_STAT_RST)
+                        BusReset();
+        }
+
+        if (dev & DEV_EP_SLOW)
+        {
+                USBDevIntClr = DEV_EP_SLOW;
+                pending = USBEpIntSt & USBEpIntEn;
+
+                for (phys = 0; pending; phys++, pending >>= 1)
+                {
+                        if (!(pending & 1))
+                                continue;
+
+                        USBDevIntClr = DEV_CDFULL;
+                        USBEpIntClr = 1 << phys;
+                        SieWait(DEV_CDFULL);
+                        st = USBCmdData;
+
+                        ep = (phys >> 1) | ((phys & 1) << 7);
+                        if (phys & 1)
+                                UsbEndpointEvent(ep, USB_EV_IN);
+                        else
+                                UsbEndpointEvent(ep, (st & SIE_EP_STP) ? USB_EV_SETUP : USB_EV_OUT);
+                }
+        }
+
+        VIC_ISR_EXIT(VIC_SRC_USB);
+}
+
+/*------------------------------------------------------------
+Function: LpcInit
+Purpose :
+Powers the controller, starts the 48 MHz USB clock, selects
+the VBUS / CONNECT pins, realizes EP0 and connects. A PLL1
+that does not lock leaves the port disconnected.
+------------------------------------------------------------*/
+static void LpcInit(void)
+{
+        u32 dl;
+
+        PCONP |= PCONP_PCUSB;
+
+        PLL1CFG = PLL1CFG_VAL;
+        PLL1CON = PLL1_ENABLE;
+        PLL1FEED = 0xAA;
+        PLL1FEED = 0x55;
+
+        dl = DeadlineSet(PLL1_LOCK_TIMEOUT_US);
+        while (!(PLL1STAT & PLL1_LOCK))
+                if (DeadlinePassed(dl))
+                {
+                        WaitTimeout(WAIT_PLL);
+                        return;
+                }
+
+        PLL1CON = PLL1_ENABLE | PLL1_CONNECT;
+        PLL1FEED = 0xAA;
+        PLL1FEED = 0x55;
+
+        PINSEL1 = (PINSEL1 & ~USB_PINMASK1) | USB_PINSEL1;
+
+        Realize(USB_EP0_OUT, USB_EP0_SIZE);
+        Realize(USB_EP0_IN, USB_EP0_SIZE);
+        USBDevIntClr = 0xFFFFFFFF;
+        USBDevIntEn = DEV_EP_SLOW | DEV_STAT;
+
+        VICRegister(VIC_SRC_USB, VIC_PRIO_USB, (u32)USB_ISR);
+        SieWrite(SIE_DEV_STATUS, SIE_STAT_CON);
+}
+
+//------------------------------------------------------------
+// Function: LpcSetAddress
+// Purpose : Written twice, as in NXP's reference code, so the
+//           address is used from the next transaction on
+//------------------------------------------------------------
+static void LpcSetAddress(u32 addr)
+{
+        SieWrite(SIE_SET_ADDRESS, SIE_ADDR_EN | addr);
+        SieWrite(SIE_SET_ADDRESS, SIE_ADDR_EN | addr);
+}
+
+//------------------------------------------------------------
+// Function: LpcConfigure
+// Purpose : Realize the CDC endpoints, or drop back to EP0
+//------------------------------------------------------------
+static void LpcConfigure(u32 on)
+{
+        SieWrite(SIE_CONFIGURE, on);
+        if (on)
+        {
+                Realize(USB_EP_NOTIFY, USB_NOTIFY_SIZE);
+                Realize(USB_EP_BULK_OUT, USB_BULK_SIZE);
+                Realize(USB_EP_BULK_IN, USB_BULK_SIZE);
+        }
+        else
+                USBEpIntEn = (1 << 0) | (1 << 1);
+}
+
+//------------------------------------------------------------
+// Function: LpcStall
+// Purpose : Set or clear the stall of an endpoint; clearing
+//           also resets its data toggle
+//------------------------------------------------------------
+static void LpcStall(u32 ep, u32 on)
+{
+        SieWrite(SIE_SET_EP_STATUS + USB_EP_PHYS(ep), on ? SIE_EP_ST : 0);
+}
+
+/*------------------------------------------------------------
+Function: LpcWrite
+Purpose :
+Copies one IN packet into the endpoint buffer a word at a
+time and validates it. A zero-length packet still needs one
+(ignored) word written.
+------------------------------------------------------------*/
+static void LpcWrite(u32 ep, const u8 *buf, u32 len)
+{
+        u32 i = 0, w;
+
+        USBCtrl = CTRL_WR_EN | CTRL_LOG_EP(USB_EP_NUM(ep));
+        USBTxPLen = len;
+
+        do
+        {
+                w = 0;
+                if (i + 0 < len) w |= buf[i + 0];
+                if (i + 1 < len) w |= buf[i + 1] << 8;
+                if (i + 2 < len) w |= buf[i + 2] << 16;
+                if (i + 3 < len) w |= (u32)buf[i + 3] << 24;
+                USBTxData = w;
+                i += 4;
+        } while (i < len);
+
+        USBCtrl = 0;
+        SieCmd(SIE_SELECT_EP + USB_EP_PHYS(ep));
+        SieCmd(SIE_VALIDATE);
+}
+
+/*------------------------------------------------------------
+Function: LpcRead
+Purpose :
+Copies one OUT packet out of the endpoint buffer (bytes past
+max are read and dropped) and frees the buffer.
+Return  : Bytes stored
+------------------------------------------------------------*/
+static u32 LpcRead(u32 ep, u8 *buf, u32 max)
+{
+        u32 len, i, w = 0, dl;
+
+        USBCtrl = CTRL_RD_EN | CTRL_LOG_EP(USB_EP_NUM(ep));
+
+        dl = DeadlineSet(USB_SIE_TIMEOUT_US);
+        while (!((len = USBRxPLen) & RXPLEN_PKT_RDY))
+                if (DeadlinePassed(dl))
+                {
+                        USBCtrl = 0;
+                        WaitTimeout(WAIT_USB);
+                        return 0;
+                }
+        len &= RXPLEN_LEN;
+
+        for (i = 0; i < len; i++, w >>= 8)
+        {
+                if ((i & 3) == 0)
+                        w = USBRxData;
+                if (i < max)
+                        buf[i] = w;
+        }
+
+        USBCtrl = 0;
+        SieCmd(SIE_SELECT_EP + USB_EP_PHYS(ep));
+        SieCmd(SIE_CLEAR_BUFFER);
+        return (len < max) ? len : max;
+}
+
+//------------------------------------------------------------
+// Function: LpcAvail
+// Purpose : Free IN buffers / full OUT buffers of an endpoint
+//------------------------------------------------------------
+static u32 LpcAvail(u32 ep)
+{
+        u32 st = SieRead(SIE_SELECT_EP + USB_EP_PHYS(ep));
+        u32 full = ((st & SIE_EP_B1_FULL) != 0) + ((st & SIE_EP_B2_FULL) != 0);
+
+        if (ep & USB_EP_IN)
+                return (USB_EP_DOUBLE(ep) ? 2 : 1) - full;
+        return full;
+}
+
+//------------------------------------------------------------
+// Function: LpcIrq
+// Purpose : Mask / unmask the USB interrupt at the VIC
+//------------------------------------------------------------
+static void LpcIrq(u32 on)
+{
+        if (on)
+                VICEnable(VIC_SRC_USB);
+        else
+                VICDisable(VIC_SRC_USB);
+}
+
+//------------------------------------------------------------
+// LPC214x USB device controller
+//------------------------------------------------------------
+UsbHw usbHwLpc =
+{
+        LpcInit,
+        LpcSetAddress,
+        LpcConfigure,
+        LpcStall,
+        LpcWrite,
+        LpcRead,
+        LpcAvail,
+        LpcIrq
+};
+
+#endif
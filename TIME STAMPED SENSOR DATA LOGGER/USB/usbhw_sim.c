@@ -0,0 +1,272 @@
+//usbhw_sim.c
+/*------------------------------------------------------------
+File: usbhw_sim.c
+Purpose:
+Simulated USB device controller for host builds (HOST_BUILD).
+
+Lets the CDC core run unchanged on a PC: a test program plays
+the USB host with the UsbSim* calls, so enumeration, control
+requests, the double-buffered bulk data path and flow control
+can be checked without a board.
+
+Features:
+- Every endpoint has the same buffer depth as on the LPC214x
+  (two packets for the bulk pair, one otherwise)
+- UsbSimControl runs a whole control transfer: setup, data
+  stage in either direction, status stage
+- UsbSimLoopback sends what the device transmits straight
+  back to it, for end-to-end checks of the UART port layer
+
+NOTE:
+Events are delivered synchronously from the UsbSim* call
+that causes them; irq() has nothing to mask.
+------------------------------------------------------------*/
+
+#ifdef HOST_BUILD
+
+#include <string.h>            // memcpy, memset
+#include "types.h"             // User-defined data types
+#include "usb_defines.h"       // Endpoints and sizes
+#include "usbhw.h"             // Backend interface
+
+#define SIM_EPS  32            // Physical endpoints
+
+//------------------------------------------------------------
+// One endpoint: a ring of up to two packets
+//------------------------------------------------------------
+typedef struct
+{
+        u8  pkt[2][USB_EP0_SIZE];
+        u32 len[2];
+        u32 first, count;
+        u32 stalled;
+} SimEp;
+
+static SimEp eps[SIM_EPS];
+static u32 simAddr, simConfigured;
+
+//------------------------------------------------------------
+// Function: Ep / Depth
+// Purpose : Endpoint of a USB address, and its buffer count
+//------------------------------------------------------------
+static SimEp *Ep(u32 ep)
+{
+        return &eps[USB_EP_PHYS(ep)];
+}
+
+static u32 Depth(u32 ep)
+{
+        return USB_EP_DOUBLE(ep) ? 2 : 1;
+}
+
+//------------------------------------------------------------
+// Function: Put / Take
+// Purpose : Add a packet to / remove one from an endpoint
+//------------------------------------------------------------
+static void Put(SimEp *e, const u8 *buf, u32 len)
+{
+        u32 slot = (e->first + e->count) & 1;
+
+        memcpy(e->pkt[slot], buf, len);
+        e->len[slot] = len;
+        e->count++;
+}
+
+static u32 Take(SimEp *e, u8 *buf, u32 max)
+{
+        u32 len = e->len[e->first];
+
+        if (len > max)
+                len = max;
+        memcpy(buf, e->pkt[e->first], len);
+        e->first ^= 1;
+        e->count--;
+        return len;
+}
+
+//------------------------------------------------------------
+// Device side operations
+//------------------------------------------------------------
+static void SimInit(void)
+{
+        memset(eps, 0, sizeof(eps));
+        simAddr = simConfigured = 0;
+}
+
+static void SimSetAddress(u32 addr)
+{
+        simAddr = addr;
+}
+
+static void SimConfigure(u32 on)
+{
+        simConfigured = on;
+}
+
+static void SimStall(u32 ep, u32 on)
+{
+        Ep(ep)->stalled = on;
+}
+
+static void SimWrite(u32 ep, const u8 *buf, u32 len)
+{
+        if (Ep(ep)->count < Depth(ep))
+                Put(Ep(ep), buf, len);
+}
+
+static u32 SimRead(u32 ep, u8 *buf, u32 max)
+{
+        return Ep(ep)->count ? Take(Ep(ep), buf, max) : 0;
+}
+
+static u32 SimAvail(u32 ep)
+{
+        if (ep & USB_EP_IN)
+                return Depth(ep) - Ep(ep)->count;
+        return Ep(ep)->count;
+}
+
+static void SimIrq(u32 on)
+{
+        (void)on;
+}
+
+//------------------------------------------------------------
+// Simulated device controller
+//------------------------------------------------------------
+UsbHw usbHwSim =
+{
+        SimInit,
+        SimSetAddress,
+        SimConfigure,
+        SimStall,
+        SimWrite,
+        SimRead,
+        SimAvail,
+        SimIrq
+};
+
+/*------------------------------------------------------------
+Function: UsbSimReset
+Purpose :
+Drops every packet and stall and signals a bus reset, as a
+host does after attach.
+------------------------------------------------------------*/
+void UsbSimReset(void)
+{
+        SimInit();
+        UsbBusReset();
+}
+
+/*------------------------------------------------------------
+Function: UsbSimIn
+Purpose :
+Host IN token: takes the oldest packet and reports it sent.
+Return  : Packet length, USB_SIM_NAK when the endpoint has
+          nothing or is stalled
+------------------------------------------------------------*/
+u32 UsbSimIn(u32 ep, u8 *buf)
+{
+        u32 len;
+
+        if (Ep(ep)->stalled || Ep(ep)->count == 0)
+                return USB_SIM_NAK;
+
+        len = Take(Ep(ep), buf, USB_EP0_SIZE);
+        UsbEndpointEvent(ep, USB_EV_IN);
+        return len;
+}
+
+/*------------------------------------------------------------
+Function: UsbSimOut
+Purpose :
+Host OUT token: stores a packet and reports it received.
+Return  : 1 -> accepted, 0 -> NAK (buffers full or stalled)
+------------------------------------------------------------*/
+u32 UsbSimOut(u32 ep, const u8 *buf, u32 len)
+{
+        if (Ep(ep)->stalled || Ep(ep)->count == Depth(ep))
+                return 0;
+
+        Put(Ep(ep), buf, len);
+        UsbEndpointEvent(ep, USB_EV_OUT);
+        return 1;
+}
+
+/*------------------------------------------------------------
+Function: UsbSimControl
+Purpose :
+Runs a control transfer. A setup packet replaces whatever
+EP0 holds and clears its stall, like on the real controller.
+Return  : Data stage bytes, USB_SIM_STALL when the device
+          stalled or did not answer
+------------------------------------------------------------*/
+u32 UsbSimControl(const u8 *setup, u8 *data)
+{
+        SimEp *out = Ep(USB_EP0_OUT), *in = Ep(USB_EP0_IN);
+        u8 pkt[USB_EP0_SIZE];
+        u32 len = setup[6] | (setup[7] << 8), done = 0, n;
+
+        out->count = in->count = 0;
+        out->stalled = in->stalled = 0;
+        Put(out, setup, 8);
+        UsbEndpointEvent(USB_EP0_OUT, USB_EV_SETUP);
+
+        if (setup[0] & REQ_DIR_IN)
+        {
+                //--------------------------------------------------
+                // Data IN until a short packet or wLength
+                //--------------------------------------------------
+                do
+                {
+                        n = UsbSimIn(USB_EP0_IN, pkt);
+                        if (n == USB_SIM_NAK)
+                                return USB_SIM_STALL;
+                        if (n > len - done)
+                                n = len - done;
+                        memcpy(data + done, pkt, n);
+                        done += n;
+                } while (n == USB_EP0_SIZE && done < len);
+
+                UsbSimOut(USB_EP0_OUT, pkt, 0);         // Status
+                return done;
+        }
+
+        //----------------------------------------------------------
+        // Data OUT, then a zero-length IN status
+        //----------------------------------------------------------
+        for (; done < len; done += n)
+        {
+                n = (len - done < USB_EP0_SIZE) ? len - done : USB_EP0_SIZE;
+                if (!UsbSimOut(USB_EP0_OUT, data + done, n))
+                        return USB_SIM_STALL;
+        }
+
+        if (UsbSimIn(USB_EP0_IN, pkt) != 0)
+                return USB_SIM_STALL;
+        return done;
+}
+
+/*------------------------------------------------------------
+Function: UsbSimLoopback
+Purpose :
+Moves bulk IN packets into bulk OUT while it has room, so the
+device receives what it sent.
+------------------------------------------------------------*/
+u32 UsbSimLoopback(void)
+{
+        u8 pkt[USB_BULK_SIZE];
+        u32 n, moved = 0;
+
+        while (Ep(USB_EP_BULK_OUT)->count < Depth(USB_EP_BULK_OUT))
+        {
+                n = UsbSimIn(USB_EP_BULK_IN, pkt);
+                if (n == USB_SIM_NAK)
+                        break;
+                UsbSimOut(USB_EP_BULK_OUT, pkt, n);
+                moved++;
+        }
+        return moved;
+}
+
+#endif
@@ -0,0 +1,132 @@
+//vic.c
+/*------------------------------------------------------------
+File: vic.c
+Purpose:
+Implements the vectored interrupt controller (VIC) framework
+for the LPC214x microcontroller.
+
+Features:
+- One vectored slot per source; the slot number is the
+  priority, so the table in vic_defines.h is the single
+  place where priorities are decided
+- Default vector for requests without a slot
+- Per-source counters filled in by the VIC_ISR_* macros
+------------------------------------------------------------*/
+
+#include <lpc214x.h>          // LPC214x register definitions
+#include "types.h"            // User-defined data types
+#include "vic.h"              // VIC prototypes and ISR macros
+#include "vic_defines.h"      // Sources, priorities, bits
+#include "ramcode.h"          // RAMFUNC, code placement
+
+//------------------------------------------------------------
+// Vectored slot registers are consecutive words
+//------------------------------------------------------------
+#define VIC_VECT_ADDR(n)  (((volatile u32 *)&VICVectAddr0)[n])
+#define VIC_VECT_CNTL(n)  (((volatile u32 *)&VICVectCntl0)[n])
+
+//------------------------------------------------------------
+// Counters
+//------------------------------------------------------------
+VICSrcStats vicStats[VIC_SOURCES];
+u32 vicSpurious;
+
+//------------------------------------------------------------
+// Sources that own a vectored slot (bit per source)
+//------------------------------------------------------------
+static volatile u32 vicVectored;
+
+/*------------------------------------------------------------
+Function: VICDefaultISR
+Purpose :
+Serves requests from enabled sources that have no vectored
+slot. Such a source is masked so it cannot stall the CPU;
+vectored sources pending at the same time are left alone,
+their own ISRs run once this one returns.
+------------------------------------------------------------*/
+CODE_ARM
+RAMFUNC void VICDefaultISR(void) __irq
+{
+        VICIntEnClr = VICIRQStatus & ~vicVectored;
+        vicSpurious++;
+        VICVectAddr = 0;
+}
+CODE_END
+
+/*------------------------------------------------------------
+Function: VICClearStats
+Purpose :
+Resets the counters of every source.
+------------------------------------------------------------*/
+void VICClearStats(void)
+{
+        u32 i;
+
+        for (i = 0; i < VIC_SOURCES; i++)
+                vicStats[i].count = vicStats[i].maxService = vicStats[i].maxLatency = 0;
+        vicSpurious = 0;
+}
+
+/*------------------------------------------------------------
+Function: InitVIC
+Purpose :
+Puts the VIC in a known state: all sources masked and on
+IRQ (not FIQ), every slot free, default vector installed.
+------------------------------------------------------------*/
+void InitVIC(void)
+{
+        u32 i;
+
+        VICIntEnClr = 0xFFFFFFFF;
+        VICIntSelect = 0;
+
+        for (i = 0; i < VIC_SLOTS; i++)
+        {
+                VIC_VECT_CNTL(i) = 0;
+                VIC_VECT_ADDR(i) = 0;
+        }
+
+        vicVectored = 0;
+        VICDefVectAddr = (u32)VICDefaultISR;
+        VICClearStats();
+}
+
+/*------------------------------------------------------------
+Function: VICRegister
+Purpose :
+Installs an ISR for a source in slot prio and enables the
+source. Registering the same source again at the same
+priority just replaces the ISR.
+------------------------------------------------------------*/
+u32 VICRegister(u32 src, u32 prio, u32 isr)
+{
+        u32 cntl;
+
+        if (src >= VIC_SOURCES || prio >= VIC_SLOTS || isr == 0)
+                return 0;
+
+        cntl = VIC_VECT_CNTL(prio);
+        if ((cntl & VIC_CNTL_ENABLE) && (cntl & VIC_CNTL_SRC) != src)
+                return 0;
+
+        VICIntEnClr = 1 << src;
+        VIC_VECT_ADDR(prio) = isr;
+        VIC_VECT_CNTL(prio) = VIC_CNTL_ENABLE | src;
+        vicVectored |= 1 << src;
+        VICIntEnable = 1 << src;
+        return 1;
+}
+
+//------------------------------------------------------------
+// Function: VICEnable / VICDisable
+// Purpose : Unmask / mask one source
+//------------------------------------------------------------
+void VICEnable(u32 src)
+{
+        VICIntEnable = 1 << src;
+}
+
+void VICDisable(u32 src)
+{
+        VICIntEnClr = 1 << src;
+}
@@ -0,0 +1,118 @@
+//vic.h
+/*------------------------------------------------------------
+File: vic.h
+Purpose:
+Header file for the vectored interrupt controller (VIC)
+framework.
+
+This file provides:
+- Registering an ISR for a source at a fixed priority
+- Enabling and disabling sources
+- Per-source counters: interrupts served, worst service time
+  and worst entry latency (microseconds, from Timer0)
+
+ISR layout:
+
+void UART0_ISR(void) __irq
+{
+        VIC_ISR_ENTER();
+        ... device work ...
+        VIC_ISR_EXIT(VIC_SRC_UART0);
+}
+
+VIC_ISR_EXIT also acknowledges the VIC, so it must be the
+last statement. ISRs that know when their event was raised
+(e.g. a timer match value) add VIC_ISR_LATENCY(src, raised).
+------------------------------------------------------------*/
+
+#ifndef __VIC_H__
+#define __VIC_H__
+
+#include "types.h"
+#include "vic_defines.h"
+
+//------------------------------------------------------------
+// Per-source counters
+//------------------------------------------------------------
+typedef struct
+{
+        u32 count;       // Interrupts served
+        u32 maxService;  // Worst time spent in the ISR (us)
+        u32 maxLatency;  // Worst raise-to-entry time (us)
+} VICSrcStats;
+
+extern VICSrcStats vicStats[VIC_SOURCES];
+extern u32 vicSpurious;   // Requests that hit the default vector
+
+//------------------------------------------------------------
+// ISR prologue / epilogue macros
+// Only the entry time is kept on the stack; the bookkeeping
+// is inline so no call is made from the ISR.
+//------------------------------------------------------------
+#if VIC_STATS
+
+#define VIC_ISR_ENTER()  u32 vicEntry = T0TC
+
+#define VIC_ISR_LATENCY(src, raised)                            \
+        do {                                                    \
+                u32 vicLat = vicEntry - (raised);               \
+                if (vicLat > vicStats[src].maxLatency)          \
+                        vicStats[src].maxLatency = vicLat;      \
+        } while (0)
+
+#define VIC_ISR_EXIT(src)                                       \
+        do {                                                    \
+                u32 vicSvc = T0TC - vicEntry;                   \
+                vicStats[src].count++;                          \
+                if (vicSvc > vicStats[src].maxService)          \
+                        vicStats[src].maxService = vicSvc;      \
+                VICVectAddr = 0;                                \
+        } while (0)
+
+#else
+
+#define VIC_ISR_ENTER()
+#define VIC_ISR_LATENCY(src, raised)
+#define VIC_ISR_EXIT(src)  (VICVectAddr = 0)
+
+#endif
+
+//------------------------------------------------------------
+// Function Prototypes
+//------------------------------------------------------------
+
+//------------------------------------------------------------
+// Function: InitVIC
+// Purpose : Disable every source, route all to IRQ, free all
+//           slots, install the default vector, clear counters
+// Note    : Call first in main(), before any driver registers
+//------------------------------------------------------------
+void InitVIC(void);
+
+//------------------------------------------------------------
+// Function: VICRegister
+// Purpose : Put an ISR for a source in vectored slot prio
+//           and enable the source
+// Parameters:
+//   src  -> VIC_SRC_xxx
+//   prio -> VIC_PRIO_xxx (0 = highest, 15 = lowest)
+//   isr  -> address of an __irq function, e.g. (u32)SSP_ISR
+// Return  : 1 -> registered
+//           0 -> bad argument or slot used by another source
+//------------------------------------------------------------
+u32 VICRegister(u32 src, u32 prio, u32 isr);
+
+//------------------------------------------------------------
+// Function: VICEnable / VICDisable
+// Purpose : Unmask / mask one source without touching its slot
+//------------------------------------------------------------
+void VICEnable(u32 src);
+void VICDisable(u32 src);
+
+//------------------------------------------------------------
+// Function: VICClearStats
+// Purpose : Reset the counters of every source
+//------------------------------------------------------------
+void VICClearStats(void);
+
+#endif
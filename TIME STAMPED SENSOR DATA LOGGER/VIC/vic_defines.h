@@ -0,0 +1,78 @@
+//vic_defines.h
+/*------------------------------------------------------------
+File: vic_defines.h
+Purpose:
+Contains macros for the vectored interrupt controller (VIC)
+of the LPC214x microcontroller.
+
+This file defines:
+- VIC source (channel) numbers of the on-chip peripherals
+- The priority (vectored slot) given to each source
+- VIC control register bits
+------------------------------------------------------------*/
+
+#ifndef VIC_DEFINES_H
+#define VIC_DEFINES_H
+
+//------------------------------------------------------------
+// Interrupt sources (VIC channel numbers)
+//------------------------------------------------------------
+#define VIC_SRC_WDT      0
+#define VIC_SRC_TIMER0   4
+#define VIC_SRC_TIMER1   5
+#define VIC_SRC_UART0    6
+#define VIC_SRC_UART1    7
+#define VIC_SRC_PWM0     8
+#define VIC_SRC_I2C0     9
+#define VIC_SRC_SPI0     10
+#define VIC_SRC_SSP      11
+#define VIC_SRC_PLL      12
+#define VIC_SRC_RTC      13
+#define VIC_SRC_EINT0    14
+#define VIC_SRC_EINT1    15
+#define VIC_SRC_EINT2    16
+#define VIC_SRC_EINT3    17
+#define VIC_SRC_AD0      18
+#define VIC_SRC_I2C1     19
+#define VIC_SRC_BOD      20
+#define VIC_SRC_AD1      21
+#define VIC_SRC_USB      22
+
+#define VIC_SOURCES      32
+
+//------------------------------------------------------------
+// Priorities: vectored slot 0 is served first, slot 15 last.
+// One slot per source; keep the whole assignment here so
+// conflicts show up in one place.
+//------------------------------------------------------------
+#define VIC_PRIO_TIMER1  0     // Deadline timer
+#define VIC_PRIO_SSP     1     // SPI flash FIFO pump
+#define VIC_PRIO_ADC     2     // Conversion complete
+#define VIC_PRIO_UART0   3     // Serial log
+#define VIC_PRIO_UART1   4
+#define VIC_PRIO_RTC     5     // Second / alarm
+#define VIC_PRIO_TIMER0  6
+#define VIC_PRIO_EINT0   7     // External (switch / keypad)
+#define VIC_PRIO_EINT1   8
+#define VIC_PRIO_EINT2   9
+#define VIC_PRIO_EINT3   10
+#define VIC_PRIO_USB     11    // Virtual COM port (USB_CDC)
+
+#define VIC_SLOTS        16
+
+//------------------------------------------------------------
+// VICVectCntlN bit definitions
+//------------------------------------------------------------
+#define VIC_CNTL_ENABLE  (1<<5)   // Bit 5: slot enabled
+#define VIC_CNTL_SRC     0x1F     // Bits 0-4: source number
+
+//------------------------------------------------------------
+// 1 -> ISRs keep count, service time and latency per source
+//      (a few instructions each, using Timer0)
+// 0 -> the VIC_ISR_* macros only acknowledge the interrupt
+//------------------------------------------------------------
+#ifndef VIC_STATS
+#define VIC_STATS        1
+#endif
+
+#endif